@@ -1,10 +1,13 @@
 #include "active_item_cache.h"
 
 #include <algorithm>
+#include <array>
+#include <iterator>
 #include <numeric>
 #include <string>
 #include <utility>
 
+#include "calendar.h"
 #include "item.h"
 #include "item_pocket.h"
 #include "safe_reference.h"
@@ -27,6 +30,161 @@ bool item_reference::has_watertight_container() const
     } );
 }
 
+namespace
+{
+constexpr int slot_bits = 6;
+constexpr int slot_count = 1 << slot_bits;
+constexpr int slot_mask = slot_count - 1;
+} // namespace
+
+struct active_item_cache::schedule {
+    struct entry {
+        item_reference ref;
+        // The address the item had, to find its index entry once the item is gone.
+        item *address = nullptr;
+        // item::processing_speed() when the item was added.
+        int speed = 1;
+        int due = 0;
+    };
+
+    // Due before the cursor, returned by the next get_for_processing.
+    std::vector<entry> ready;
+    // Due in the block of the cursor, by turn.
+    std::array<std::vector<entry>, slot_count> turns;
+    // Due in one of the next blocks, by block.
+    std::array<std::vector<entry>, slot_count> blocks;
+    // Due after that.
+    std::vector<entry> later;
+    // The first turn not collected yet.
+    int cursor = 0;
+    size_t count = 0;
+    // Spreads the first wake of newly added items over their processing speed.
+    unsigned int stagger = 0;
+    std::unordered_map<item *, safe_reference<item>> index;
+
+    explicit schedule( int now ) : cursor( now ) {}
+
+    void insert( entry &&e ) {
+        const int block = e.due >> slot_bits;
+        const int cursor_block = cursor >> slot_bits;
+        if( e.due < cursor ) {
+            ready.emplace_back( std::move( e ) );
+        } else if( block == cursor_block ) {
+            turns[e.due & slot_mask].emplace_back( std::move( e ) );
+        } else if( block - cursor_block < slot_count ) {
+            blocks[block & slot_mask].emplace_back( std::move( e ) );
+        } else {
+            later.emplace_back( std::move( e ) );
+        }
+    }
+
+    template<typename F>
+    void for_each( F visit ) {
+        for( entry &e : ready ) {
+            visit( e );
+        }
+        for( std::vector<entry> &slot : turns ) {
+            for( entry &e : slot ) {
+                visit( e );
+            }
+        }
+        for( std::vector<entry> &slot : blocks ) {
+            for( entry &e : slot ) {
+                visit( e );
+            }
+        }
+        for( entry &e : later ) {
+            visit( e );
+        }
+    }
+
+    // Moves everything due up to and including now to out.
+    void collect_due( int now, std::vector<entry> &out ) {
+        out = std::move( ready );
+        ready.clear();
+        // If the player debug menu'd the time backward, everything is due right away.
+        const bool time_moved_back = now < cursor - 1;
+        if( time_moved_back || now - cursor > slot_count * slot_count ) {
+            // After a long time out of the reality bubble sorting everything again is cheaper
+            // than walking all the turns in between.
+            std::vector<entry> all;
+            for_each( [&all]( entry & e ) {
+                all.emplace_back( std::move( e ) );
+            } );
+            for( std::vector<entry> &slot : turns ) {
+                slot.clear();
+            }
+            for( std::vector<entry> &slot : blocks ) {
+                slot.clear();
+            }
+            later.clear();
+            cursor = now + 1;
+            for( entry &e : all ) {
+                if( time_moved_back || e.due <= now ) {
+                    out.emplace_back( std::move( e ) );
+                } else {
+                    insert( std::move( e ) );
+                }
+            }
+            return;
+        }
+        for( ; cursor <= now; ++cursor ) {
+            if( ( cursor & slot_mask ) == 0 ) {
+                enter_block( cursor >> slot_bits );
+            }
+            std::vector<entry> &slot = turns[cursor & slot_mask];
+            std::move( slot.begin(), slot.end(), std::back_inserter( out ) );
+            slot.clear();
+        }
+    }
+
+    // Spreads the entries due in the block the cursor enters over its turns.
+    void enter_block( int block ) {
+        std::vector<entry> arriving = std::move( blocks[block & slot_mask] );
+        blocks[block & slot_mask].clear();
+        for( auto it = later.begin(); it != later.end(); ) {
+            if( ( it->due >> slot_bits ) - block < slot_count ) {
+                arriving.emplace_back( std::move( *it ) );
+                it = later.erase( it );
+            } else {
+                ++it;
+            }
+        }
+        for( entry &e : arriving ) {
+            insert( std::move( e ) );
+        }
+    }
+
+    // Drops the index entry of an item that is gone.
+    void forget( const entry &e ) {
+        const auto it = index.find( e.address );
+        if( it != index.end() && !it->second ) {
+            index.erase( it );
+        }
+        --count;
+    }
+};
+
+active_item_cache::active_item_cache() = default;
+
+active_item_cache::active_item_cache( const active_item_cache &other ) :
+    items( other.items ? std::make_unique<schedule>( *other.items ) : nullptr ),
+    special_items( other.special_items ) {}
+
+active_item_cache::active_item_cache( active_item_cache && ) noexcept = default;
+active_item_cache::~active_item_cache() = default;
+
+active_item_cache &active_item_cache::operator=( const active_item_cache &other )
+{
+    if( this != &other ) {
+        items = other.items ? std::make_unique<schedule>( *other.items ) : nullptr;
+        special_items = other.special_items;
+    }
+    return *this;
+}
+
+active_item_cache &active_item_cache::operator=( active_item_cache && ) noexcept = default;
+
 bool active_item_cache::add( item &it, point_sm_ms location, item *parent,
                              std::vector<item_pocket const *> const &pocket_chain )
 {
@@ -48,20 +206,15 @@ bool active_item_cache::add( item &it, point_rel_ms location, item *parent,
     if( speed == item::NO_PROCESSING ) {
         return ret;
     }
-    std::unordered_map<item *, safe_reference<item>> &target_index = active_items_index[speed];
-    std::list<item_reference> &target_list = active_items[speed];
-    if( target_index.empty() && !target_index.empty() ) {
-        // If the index has been cleared, rebuild it first.
-        for( item_reference &iter : target_list ) {
-            // Omit those expired references
-            if( iter.item_ref ) {
-                target_index.emplace( iter.item_ref.get(), iter.item_ref );
-            }
-        }
+    // Added items were moved or loaded, the temperature around them may differ now.
+    it.unsettle_temperature();
+    const int now = to_turn<int>( calendar::turn );
+    if( !items ) {
+        items = std::make_unique<schedule>( now );
     }
     // If the item is already in the cache for some reason, don't add a second reference
-    auto iter = target_index.find( &it );
-    if( iter != target_index.end() ) {
+    auto iter = items->index.find( &it );
+    if( iter != items->index.end() ) {
         // Ensure it's really what we want, and hasn't expired
         if( iter->second && iter->second.get() == &it ) {
             return true;
@@ -74,31 +227,47 @@ bool active_item_cache::add( item &it, point_rel_ms location, item *parent,
     if( it.get_use( "explosion" ) ) {
         special_items[special_item_type::explosive].emplace_back( ref );
     }
-    target_list.emplace_back( std::move( ref ) );
-    target_index.emplace( &it, it.get_safe_reference() );
+    const unsigned int offset = items->stagger++ % static_cast<unsigned int>( speed );
+    const int due = now + static_cast<int>( offset );
+    items->insert( { std::move( ref ), &it, speed, due } );
+    items->index[&it] = it.get_safe_reference();
+    ++items->count;
     return true;
 }
 
 bool active_item_cache::empty() const
 {
-    return std::all_of( active_items.begin(), active_items.end(), []( const auto & active_queue ) {
-        return active_queue.second.empty();
-    } );
+    return !items;
 }
 
 std::vector<item_reference> active_item_cache::get()
 {
     std::vector<item_reference> all_cached_items;
-    for( std::pair<const int, std::list<item_reference>> &kv : active_items ) {
-        for( std::list<item_reference>::iterator it = kv.second.begin(); it != kv.second.end(); ) {
-            if( it->item_ref ) {
-                all_cached_items.emplace_back( *it );
-                ++it;
-            } else {
-                active_items_index[kv.first].clear();
-                it = kv.second.erase( it );
+    if( !items ) {
+        return all_cached_items;
+    }
+    all_cached_items.reserve( items->count );
+    const auto keep = [&]( std::vector<schedule::entry> &entries ) {
+        entries.erase( std::remove_if( entries.begin(), entries.end(),
+        [&]( const schedule::entry & e ) {
+            if( !e.ref.item_ref ) {
+                items->forget( e );
+                return true;
             }
-        }
+            all_cached_items.emplace_back( e.ref );
+            return false;
+        } ), entries.end() );
+    };
+    keep( items->ready );
+    for( std::vector<schedule::entry> &slot : items->turns ) {
+        keep( slot );
+    }
+    for( std::vector<schedule::entry> &slot : items->blocks ) {
+        keep( slot );
+    }
+    keep( items->later );
+    if( items->count == 0 ) {
+        items.reset();
     }
     return all_cached_items;
 }
@@ -106,28 +275,25 @@ std::vector<item_reference> active_item_cache::get()
 std::vector<item_reference> active_item_cache::get_for_processing()
 {
     std::vector<item_reference> items_to_process;
-    items_to_process.reserve( std::accumulate( active_items.begin(), active_items.end(), std::size_t{ 0 },
-    []( size_t prev, const auto & kv ) {
-        return prev + kv.second.size() / static_cast<size_t>( kv.first );
-    } ) );
-    for( std::pair<const int, std::list<item_reference>> &kv : active_items ) {
-        // Rely on iteration logic to make sure the number is sane.
-        int num_to_process = kv.second.size() / kv.first;
-        std::list<item_reference>::iterator it = kv.second.begin();
-        for( ; it != kv.second.end() && num_to_process >= 0; ) {
-            if( it->item_ref ) {
-                items_to_process.push_back( *it );
-                --num_to_process;
-                ++it;
-            } else {
-                // The item has been destroyed, so remove the reference from the cache
-                active_items_index[kv.first].clear();
-                it = kv.second.erase( it );
-            }
+    if( !items ) {
+        return items_to_process;
+    }
+    const int now = to_turn<int>( calendar::turn );
+    std::vector<schedule::entry> due;
+    items->collect_due( now, due );
+    items_to_process.reserve( due.size() );
+    for( schedule::entry &e : due ) {
+        if( !e.ref.item_ref ) {
+            // The item has been destroyed, so remove the reference from the cache
+            items->forget( e );
+            continue;
         }
-        // Rotate the returned items to the end of their list so that the items that weren't
-        // returned this time will be first in line on the next call
-        kv.second.splice( kv.second.end(), kv.second, kv.second.begin(), it );
+        items_to_process.push_back( e.ref );
+        e.due = now + std::max( e.speed, e.ref.item_ref->processing_delay() );
+        items->insert( std::move( e ) );
+    }
+    if( items->count == 0 ) {
+        items.reset();
     }
     return items_to_process;
 }
@@ -149,32 +315,35 @@ std::vector<item_reference> active_item_cache::get_special( special_item_type ty
 
 void active_item_cache::subtract_locations( const point_rel_ms &delta )
 {
-    for( std::pair<const int, std::list<item_reference>> &pair : active_items ) {
-        for( item_reference &ir : pair.second ) {
-            ir.location -= delta;
-        }
+    if( !items ) {
+        return;
     }
+    items->for_each( [&delta]( schedule::entry & e ) {
+        e.ref.location -= delta;
+    } );
 }
 
 void active_item_cache::rotate_locations( int turns, const point_rel_ms &dim )
 {
-    for( std::pair<const int, std::list<item_reference>> &pair : active_items ) {
-        for( item_reference &ir : pair.second ) {
-            // Should 'rotate' be propaged up to the typed coordinates?
-            ir.location = ir.location.rotate( turns, dim.raw() );
-        }
+    if( !items ) {
+        return;
     }
+    items->for_each( [&]( schedule::entry & e ) {
+        // Should 'rotate' be propaged up to the typed coordinates?
+        e.ref.location = e.ref.location.rotate( turns, dim.raw() );
+    } );
 }
 
 void active_item_cache::mirror( const point_rel_ms &dim, bool horizontally )
 {
-    for( std::pair<const int, std::list<item_reference>> &pair : active_items ) {
-        for( item_reference &ir : pair.second ) {
-            if( horizontally ) {
-                ir.location.x() = dim.x() - 1 - ir.location.x();
-            } else {
-                ir.location.y() = dim.y() - 1 - ir.location.y();
-            }
-        }
+    if( !items ) {
+        return;
     }
+    items->for_each( [&]( schedule::entry & e ) {
+        if( horizontally ) {
+            e.ref.location.x() = dim.x() - 1 - e.ref.location.x();
+        } else {
+            e.ref.location.y() = dim.y() - 1 - e.ref.location.y();
+        }
+    } );
 }
@@ -4,6 +4,7 @@
 
 #include <cstddef>
 #include <list>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -49,16 +50,34 @@ struct hash<special_item_type> {
 };
 } // namespace std
 
+/**
+ * The active items of a submap or vehicle, woken when they are next due for processing.
+ *
+ * Items wait in a hierarchical timing wheel keyed by the turn they are due: one slot per turn
+ * for the current block of 64 turns, one slot per block for the next 64 blocks and a list for
+ * anything later. A turn only touches the items due in it, so a base full of stored food costs
+ * nothing on the turns none of it is due. Items sleep for their @ref item::processing_delay,
+ * but at least for the @ref item::processing_speed they had when added.
+ */
 class active_item_cache
 {
     private:
-        std::unordered_map<int, std::list<item_reference>> active_items;
+        struct schedule;
+        // Null while there are no active items, most submaps never have any.
+        std::unique_ptr<schedule> items;
         std::unordered_map<special_item_type, std::list<item_reference>> special_items;
-        std::unordered_map<int, std::unordered_map<item *, safe_reference<item>>> active_items_index;
     public:
+        active_item_cache();
+        active_item_cache( const active_item_cache &other );
+        active_item_cache( active_item_cache && ) noexcept;
+        ~active_item_cache();
+        active_item_cache &operator=( const active_item_cache &other );
+        active_item_cache &operator=( active_item_cache && ) noexcept;
+
         /**
          * Adds the reference to the cache. Does nothing if the reference is already in the cache.
-         * Relies on the fact that item::processing_speed() is a constant.
+         * New items are due within their processing speed, spread over it in the order they are
+         * added so that a freshly loaded submap does not wake all of its food on the same turn.
          * These two operations are really the same, but tailored to their usages.
          * The submap coordinates are for submaps, and the relative ones are for vehicles.
          */
@@ -79,12 +98,10 @@ class active_item_cache
         std::vector<item_reference> get();
 
         /**
-         * Returns the first size() / processing_speed() elements of each list, rounded up.
-         * Items returned are rotated to the back of their respective lists, otherwise only the
-         * first n items will ever be processed.
+         * Returns the items due at or before the current turn and schedules when they are due
+         * next. Items added during this turn are due on the next call at the earliest.
          * Broken references encountered when collecting the items to be processed are removed from
          * the cache.
-         * Relies on the fact that item::processing_speed() is a constant.
          */
         std::vector<item_reference> get_for_processing();
 
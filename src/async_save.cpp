@@ -0,0 +1,326 @@
+#include "async_save.h"
+
+#ifdef _WIN32
+#include "platform_win.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32) && !defined(_MSC_VER)
+#   include "mingw.thread.h"
+#endif
+
+#include "cached_options.h"
+#include "debug.h"
+#include "output.h"
+#include "translations.h"
+
+namespace
+{
+// Makes what was written to the file or folder at @p path survive a crash of the system.
+// Best effort: failures only cost the durability, the data was written already.
+void sync_to_disk( const std::filesystem::path &path, bool is_folder )
+{
+#ifdef _WIN32
+    // Folders can't be flushed on Windows, the renames are journaled by NTFS.
+    if( is_folder ) {
+        return;
+    }
+    const HANDLE file = CreateFileW( path.native().c_str(), GENERIC_WRITE,
+                                     FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                     nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if( file != INVALID_HANDLE_VALUE ) {
+        FlushFileBuffers( file );
+        CloseHandle( file );
+    }
+#else
+    const int fd = open( path.c_str(), is_folder ? O_RDONLY | O_DIRECTORY : O_RDONLY );
+    if( fd >= 0 ) {
+        fsync( fd );
+        close( fd );
+    }
+#endif
+}
+
+// The files the job running on this thread wrote, null outside of the workers.
+thread_local std::vector<std::filesystem::path> *written_files = nullptr;
+
+// Jobs writing to one target, run in order by a single worker.
+struct job_batch {
+    std::string target;
+    std::vector<std::function<void()>> jobs;
+};
+
+class writer_pool
+{
+    public:
+        ~writer_pool() {
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                stopping = true;
+            }
+            wake.notify_all();
+            for( std::thread &worker : workers ) {
+                worker.join();
+            }
+        }
+
+        void start( std::vector<job_batch> &&batches, std::vector<job_batch> &&last_batches ) {
+            if( batches.empty() && last_batches.empty() ) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                if( workers.empty() ) {
+                    // Compression is the expensive part, leave a core to the game.
+                    const unsigned int cores = std::thread::hardware_concurrency();
+                    const size_t count = std::clamp<size_t>( cores > 1 ? cores - 1 : 1, 1, 4 );
+                    for( size_t i = 0; i < count; ++i ) {
+                        workers.emplace_back( [this]() {
+                            run();
+                        } );
+                    }
+                }
+                for( job_batch &batch : batches ) {
+                    queue.emplace_back( std::move( batch ) );
+                }
+                for( job_batch &batch : last_batches ) {
+                    held.emplace_back( std::move( batch ) );
+                }
+                release_held();
+            }
+            wake.notify_all();
+        }
+
+        bool busy() {
+            std::lock_guard<std::mutex> lock( mutex );
+            return !queue.empty() || !held.empty() || running != 0;
+        }
+
+        bool busy( const std::string &target ) {
+            std::lock_guard<std::mutex> lock( mutex );
+            return writes_to( target );
+        }
+
+        void wait( const std::string &target ) {
+            std::unique_lock<std::mutex> lock( mutex );
+            done.wait( lock, [&]() {
+                return !writes_to( target );
+            } );
+        }
+
+        std::vector<std::string> wait() {
+            std::unique_lock<std::mutex> lock( mutex );
+            done.wait( lock, [this]() {
+                return queue.empty() && held.empty() && running == 0;
+            } );
+            return std::exchange( errors, {} );
+        }
+
+    private:
+        bool writes_to( const std::string &target ) const {
+            if( running_targets.count( target ) != 0 ) {
+                return true;
+            }
+            const auto writes = [&]( const job_batch & batch ) {
+                return batch.target == target;
+            };
+            return std::any_of( queue.begin(), queue.end(), writes ) ||
+                   std::any_of( held.begin(), held.end(), writes );
+        }
+
+        // Queues the held batches once everything else is done.  Needs the mutex.
+        void release_held() {
+            if( held.empty() || !queue.empty() || running != 0 ) {
+                return;
+            }
+            std::move( held.begin(), held.end(), std::back_inserter( queue ) );
+            held.clear();
+            wake.notify_all();
+        }
+
+        void run() {
+            std::unique_lock<std::mutex> lock( mutex );
+            while( true ) {
+                wake.wait( lock, [this]() {
+                    return stopping || !queue.empty();
+                } );
+                if( queue.empty() ) {
+                    return;
+                }
+                job_batch batch = std::move( queue.front() );
+                queue.pop_front();
+                ++running;
+                running_targets.insert( batch.target );
+                lock.unlock();
+                std::vector<std::string> failures;
+                std::vector<std::filesystem::path> written;
+                written_files = &written;
+                for( std::function<void()> &job : batch.jobs ) {
+                    try {
+                        job();
+                    } catch( const std::exception &err ) {
+                        failures.emplace_back( err.what() );
+                    }
+                }
+                written_files = nullptr;
+                // Before the batch counts as done, so the barrier covers it.
+                std::set<std::filesystem::path> folders;
+                for( const std::filesystem::path &file : written ) {
+                    sync_to_disk( file, false );
+                    folders.insert( file.parent_path() );
+                }
+                // The folders hold the renames of the replaced files.
+                for( const std::filesystem::path &folder : folders ) {
+                    sync_to_disk( folder, true );
+                }
+                lock.lock();
+                --running;
+                running_targets.erase( running_targets.find( batch.target ) );
+                errors.insert( errors.end(), failures.begin(), failures.end() );
+                release_held();
+                done.notify_all();
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        std::deque<job_batch> queue;
+        // Batches that are queued once the queue is empty and nothing runs
+        std::vector<job_batch> held;
+        std::vector<std::string> errors;
+        int running = 0;
+        std::multiset<std::string> running_targets;
+        bool stopping = false;
+        std::vector<std::thread> workers;
+};
+
+writer_pool &get_pool()
+{
+    static writer_pool pool;
+    return pool;
+}
+
+// Jobs of the live scope, by target. Only touched by the main thread.
+std::map<std::string, std::vector<std::function<void()>>> collected;
+// Same for the jobs that run after all others.
+std::map<std::string, std::vector<std::function<void()>>> collected_last;
+
+std::vector<job_batch> take_batches( std::map<std::string, std::vector<std::function<void()>>>
+                                     &jobs )
+{
+    std::vector<job_batch> batches;
+    batches.reserve( jobs.size() );
+    for( auto &entry : jobs ) {
+        batches.push_back( { entry.first, std::move( entry.second ) } );
+    }
+    jobs.clear();
+    return batches;
+}
+int scope_depth = 0;
+} // namespace
+
+namespace async_save
+{
+
+bool enabled()
+{
+    return scope_depth > 0;
+}
+
+void submit( const std::string &target, std::function<void()> job )
+{
+    if( !enabled() ) {
+        // A background save may still be writing the same target.
+        wait_for( target );
+        job();
+        return;
+    }
+    collected[target].emplace_back( std::move( job ) );
+}
+
+void submit_last( const std::string &target, std::function<void()> job )
+{
+    if( !enabled() ) {
+        submit( target, std::move( job ) );
+        return;
+    }
+    collected_last[target].emplace_back( std::move( job ) );
+}
+
+void sync( const std::filesystem::path &path )
+{
+    if( written_files ) {
+        sync_to_disk( path, false );
+    }
+}
+
+void written( const std::filesystem::path &path )
+{
+    if( written_files ) {
+        written_files->push_back( path );
+    }
+}
+
+bool in_progress()
+{
+    return get_pool().busy();
+}
+
+bool in_progress( const std::string &target )
+{
+    return get_pool().busy( target );
+}
+
+void wait_for( const std::string &target )
+{
+    get_pool().wait( target );
+}
+
+bool wait()
+{
+    const std::vector<std::string> errors = get_pool().wait();
+    for( const std::string &error : errors ) {
+        if( test_mode ) {
+            DebugLog( D_ERROR, DC_ALL ) << "Failed to save: " << error;
+        } else {
+            popup( _( "Failed to save the game: %s" ), error );
+        }
+    }
+    return errors.empty();
+}
+
+scope::scope()
+{
+    if( scope_depth++ == 0 ) {
+        wait();
+    }
+}
+
+scope::~scope()
+{
+    if( --scope_depth != 0 ) {
+        return;
+    }
+    get_pool().start( take_batches( collected ), take_batches( collected_last ) );
+}
+
+} // namespace async_save
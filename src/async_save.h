@@ -0,0 +1,94 @@
+#pragma once
+#ifndef CATA_SRC_ASYNC_SAVE_H
+#define CATA_SRC_ASYNC_SAVE_H
+
+#include <filesystem>
+#include <functional>
+#include <string>
+
+/**
+ * Writing save files in the background.
+ *
+ * The save code serializes game state into strings on the main thread. Those strings
+ * are the snapshot: once they exist, the game may change the submaps and overmaps
+ * again. While a @ref async_save::scope is alive, the jobs that write the strings out
+ * (compression, zzip archives, temporary file + rename) are collected, and they are
+ * handed to a small pool of worker threads when the scope ends. Outside a scope,
+ * jobs run right away, exactly like the plain synchronous save.
+ *
+ * Jobs with the same target run one after another, in the order they were submitted.
+ * Jobs with different targets may run in parallel. A target is typically the file or
+ * archive the job writes to. Jobs queued with @ref submit_last start after all others.
+ *
+ * The files the jobs report with @ref written are flushed to disk, along with the
+ * folders holding them, before @ref wait returns. A save that has been waited for
+ * survives a crash of the system.
+ */
+namespace async_save
+{
+
+/** Whether a @ref scope is collecting jobs right now. */
+bool enabled();
+
+/**
+ * Queue a job that writes to @p target. Runs it immediately (and lets its exceptions
+ * through) when no @ref scope is alive, once earlier jobs for @p target are done.
+ */
+void submit( const std::string &target, std::function<void()> job );
+
+/**
+ * Queue a job that writes to @p target once every other job of the scope has finished,
+ * so what it writes never refers to data that may not be on disk yet. Runs it
+ * immediately when no @ref scope is alive, like @ref submit.
+ */
+void submit_last( const std::string &target, std::function<void()> job );
+
+/**
+ * Flushes the file at @p path to disk right away when the job running now is on a
+ * worker. Meant for temporary files about to replace the real one, so a crash right
+ * after the rename can't leave an empty file behind. Does nothing for jobs run right away.
+ */
+void sync( const std::filesystem::path &path );
+
+/**
+ * Records that the job running right now wrote the file @p path. The worker flushes it
+ * to disk once the jobs of its target are done. Does nothing for jobs run right away.
+ */
+void written( const std::filesystem::path &path );
+
+/** Whether some job handed to the workers has not finished yet. */
+bool in_progress();
+/** Whether some job handed to the workers that writes to @p target has not finished yet. */
+bool in_progress( const std::string &target );
+
+/**
+ * Blocks until all jobs handed to the workers have finished. This is the barrier
+ * for anything that reads save files, unloads the world or quits.
+ * Errors of the finished jobs are reported here.
+ * @return false if a job failed.
+ */
+bool wait();
+
+/**
+ * Blocks until the jobs handed to the workers that write to @p target have finished.
+ * Anything reading a single file or archive only needs to wait for that one. Errors
+ * are left to the next @ref wait.
+ */
+void wait_for( const std::string &target );
+
+/**
+ * Collects the jobs submitted during its lifetime and starts them when it ends.
+ * Waits for the previous background save first, so saves never overlap.
+ */
+class scope
+{
+    public:
+        scope();
+        ~scope();
+        scope( const scope & ) = delete;
+        scope &operator=( const scope & ) = delete;
+};
+
+} // namespace async_save
+
+#endif // CATA_SRC_ASYNC_SAVE_H
@@ -70,7 +70,6 @@ static const efftype_id effect_incorporeal( "incorporeal" );
 static const efftype_id effect_onfire( "onfire" );
 static const efftype_id effect_pet( "pet" );
 static const efftype_id effect_psi_stunned( "psi_stunned" );
-static const efftype_id effect_quadruped_full( "quadruped_full" );
 static const efftype_id effect_ridden( "ridden" );
 static const efftype_id effect_stunned( "stunned" );
 static const efftype_id effect_winded( "winded" );
@@ -195,16 +194,6 @@ bool avatar_action::move( avatar &you, map &m, const tripoint_rel_ms &d )
         return false;
     }
 
-    //TODO: Replace with dirtying vision_transparency_cache
-    //TODO: Really ugly bc we're not sure we're moving anywhere yet
-    const bool is_crouching = you.is_crouching();
-    const bool low_profile = you.has_effect( effect_quadruped_full ) &&
-                             you.is_running();
-    const bool is_prone = you.is_prone();
-    if( is_crouching || is_prone || low_profile ) {
-        m.set_transparency_cache_dirty( d.z() );
-    }
-
     // If any leg broken without crutches and not already on the ground topple over
     if( ( !you.enough_working_legs() && !you.is_prone() &&
           !( you.get_wielded_item() && you.get_wielded_item()->has_flag( flag_CRUTCHES ) ) ) ) {
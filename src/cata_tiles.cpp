@@ -74,6 +74,7 @@
 #include "overlay_ordering.h"
 #include "overmap.h"
 #include "path_info.h"
+#include "perf.h"
 #include "pixel_minimap.h"
 #include "rect_range.h"
 #include "scent_map.h"
@@ -1331,6 +1332,7 @@ void cata_tiles::draw( const point &dest, const tripoint_bub_ms &center, int wid
                        std::multimap<point, formatted_text> &overlay_strings,
                        color_block_overlay_container &color_blocks )
 {
+    CATA_PROFILE_ZONE( "cata_tiles::draw" );
     if( !g ) {
         return;
     }
@@ -1487,6 +1489,7 @@ void cata_tiles::draw( const point &dest, const tripoint_bub_ms &center, int wid
     }
 
     if( here.draw_points_cache_dirty ) {
+        CATA_PROFILE_ZONE( "cata_tiles::draw_points_cache" );
         here.draw_points_cache_dirty = false;
         // overlay_strings and color_blocks are generated with draw_points and thus are cleared together
         here.draw_points_cache.clear();
@@ -1765,6 +1768,7 @@ void cata_tiles::draw( const point &dest, const tripoint_bub_ms &center, int wid
     }
 
     if( max_draw_depth <= 0 ) {
+        CATA_PROFILE_ZONE( "cata_tiles::draw_layers" );
         // Legacy draw mode
         for( int row = min_row; row < max_row; row ++ ) {
             for( auto f : drawing_layers_legacy ) {
@@ -1782,6 +1786,7 @@ void cata_tiles::draw( const point &dest, const tripoint_bub_ms &center, int wid
             }
         }
     } else {
+        CATA_PROFILE_ZONE( "cata_tiles::draw_layers" );
         // Multi z-level draw mode
         // Start drawing from the lowest visible z-level (some off-screen tiles
         // are considered visible here to simplify the logic.)
@@ -1879,6 +1884,7 @@ void cata_tiles::draw( const point &dest, const tripoint_bub_ms &center, int wid
     void_monster_override();
 
     //Memorize everything the character just saw even if it wasn't displayed.
+    CATA_PROFILE_ZONE( "cata_tiles::memorize" );
     for( int mem_y = min_visible.y; mem_y <= max_visible.y; mem_y++ ) {
         for( int mem_x = min_visible.x; mem_x <= max_visible.x; mem_x++ ) {
             const point colrow = player_to_tile( { mem_x, mem_y } );
@@ -1988,6 +1994,7 @@ void cata_tiles::set_draw_cache_dirty()
 void cata_tiles::draw_minimap( const point &dest, const tripoint_bub_ms &center, int width,
                                int height )
 {
+    CATA_PROFILE_ZONE( "cata_tiles::draw_minimap" );
     minimap->set_type( is_isometric() ? pixel_minimap_type::iso : pixel_minimap_type::ortho );
     minimap->draw( SDL_Rect{ dest.x, dest.y, width, height }, center );
 }
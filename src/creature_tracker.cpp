@@ -4,6 +4,7 @@
 #include <limits>
 #include <ostream>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
@@ -13,12 +14,14 @@
 #include "flood_fill.h"
 #include "game.h"
 #include "map.h"
+#include "map_scale_constants.h"
 #include "mapdata.h"
 #include "maptile_fwd.h"
 #include "mongroup.h"
 #include "monster.h"
 #include "mtype.h"
 #include "npc.h"
+#include "perf.h"
 #include "point.h"
 #include "string_formatter.h"
 #include "submap.h"  // IWYU pragma: keep
@@ -93,7 +96,7 @@ bool creature_tracker::add( const shared_ptr_fast<monster> &critter_ptr )
     }
 
     monsters_list.emplace_back( critter_ptr );
-    monsters_by_location[critter.pos_abs()] = critter_ptr;
+    set_location( critter.pos_abs(), critter_ptr );
     return true;
 }
 
@@ -130,8 +133,8 @@ bool creature_tracker::update_pos( const monster &critter, const tripoint_abs_ms
         return ptr.get() == &critter;
     } );
     if( iter != monsters_list.end() ) {
-        monsters_by_location.erase( old_pos );
-        monsters_by_location[new_pos] = *iter;
+        erase_location( old_pos );
+        set_location( new_pos, *iter );
         return true;
     } else {
         // We're changing the x/y/z coordinates of a zombie that hasn't been added
@@ -148,7 +151,7 @@ void creature_tracker::remove_from_location_map( const monster &critter )
 {
     const auto pos_iter = monsters_by_location.find( critter.pos_abs() );
     if( pos_iter != monsters_by_location.end() && pos_iter->second.get() == &critter ) {
-        monsters_by_location.erase( pos_iter );
+        erase_location( critter.pos_abs() );
         return;
     }
 
@@ -159,10 +162,147 @@ void creature_tracker::remove_from_location_map( const monster &critter )
         return v.second.get() == &critter;
     } );
     if( iter != monsters_by_location.end() ) {
-        monsters_by_location.erase( iter );
+        const tripoint_abs_ms stale_pos = iter->first;
+        erase_location( stale_pos );
     }
 }
 
+void creature_tracker::set_location( const tripoint_abs_ms &pos,
+                                     const shared_ptr_fast<monster> &critter_ptr )
+{
+    shared_ptr_fast<monster> &entry = monsters_by_location[pos];
+    if( entry ) {
+        remove_from_submap_index( pos, entry.get() );
+    }
+    entry = critter_ptr;
+    monsters_by_submap[project_to<coords::sm>( pos )].push_back( critter_ptr.get() );
+}
+
+void creature_tracker::erase_location( const tripoint_abs_ms &pos )
+{
+    const auto iter = monsters_by_location.find( pos );
+    if( iter == monsters_by_location.end() ) {
+        return;
+    }
+    remove_from_submap_index( pos, iter->second.get() );
+    monsters_by_location.erase( iter );
+}
+
+void creature_tracker::remove_from_submap_index( const tripoint_abs_ms &pos,
+        const monster *critter )
+{
+    const auto cell = monsters_by_submap.find( project_to<coords::sm>( pos ) );
+    if( cell == monsters_by_submap.end() ) {
+        return;
+    }
+    std::vector<monster *> &bucket = cell->second;
+    // Plain erase keeps the bucket order stable, so queries stay deterministic.
+    const auto iter = std::find( bucket.begin(), bucket.end(), critter );
+    if( iter != bucket.end() ) {
+        bucket.erase( iter );
+    }
+    if( bucket.empty() ) {
+        monsters_by_submap.erase( cell );
+    }
+}
+
+bool creature_tracker::is_alive( const monster &critter )
+{
+    return !critter.is_dead();
+}
+
+void creature_tracker::collect_in_rect( const tripoint_abs_ms &min, const tripoint_abs_ms &max,
+                                        std::vector<monster *> &result ) const
+{
+    // Nothing lives outside the z-levels of the game.
+    const tripoint_abs_ms lo( min.xy(), std::max( min.z(), -OVERMAP_DEPTH ) );
+    const tripoint_abs_ms hi( max.xy(), std::min( max.z(), OVERMAP_HEIGHT ) );
+    if( lo.x() > hi.x() || lo.y() > hi.y() || lo.z() > hi.z() ) {
+        return;
+    }
+    const auto inside = [&]( const tripoint_abs_ms & p ) {
+        return p.x() >= lo.x() && p.x() <= hi.x() && p.y() >= lo.y() && p.y() <= hi.y() &&
+               p.z() >= lo.z() && p.z() <= hi.z();
+    };
+    const tripoint_abs_sm min_sm = project_to<coords::sm>( lo );
+    const tripoint_abs_sm max_sm = project_to<coords::sm>( hi );
+    const int64_t cells = int64_t( max_sm.x() - min_sm.x() + 1 ) * ( max_sm.y() - min_sm.y() + 1 ) *
+                          ( max_sm.z() - min_sm.z() + 1 );
+
+    // Buckets are visited by z, then y, then x of their submap, whichever way they are found.
+    std::vector<const std::vector<monster *> *> buckets;
+    if( cells > static_cast<int64_t>( monsters_by_submap.size() ) ) {
+        // More cells than populated buckets, pick the buckets inside the box instead.
+        std::vector<std::pair<tripoint_abs_sm, const std::vector<monster *> *>> found;
+        for( const auto &cell : monsters_by_submap ) {
+            const tripoint_abs_sm &p = cell.first;
+            if( p.x() >= min_sm.x() && p.x() <= max_sm.x() && p.y() >= min_sm.y() &&
+                p.y() <= max_sm.y() && p.z() >= min_sm.z() && p.z() <= max_sm.z() ) {
+                found.emplace_back( p, &cell.second );
+            }
+        }
+        std::sort( found.begin(), found.end(), []( const auto & a, const auto & b ) {
+            return std::make_tuple( a.first.z(), a.first.y(), a.first.x() ) <
+                   std::make_tuple( b.first.z(), b.first.y(), b.first.x() );
+        } );
+        for( const auto &cell : found ) {
+            buckets.push_back( cell.second );
+        }
+    } else {
+        for( int z = min_sm.z(); z <= max_sm.z(); ++z ) {
+            for( int y = min_sm.y(); y <= max_sm.y(); ++y ) {
+                for( int x = min_sm.x(); x <= max_sm.x(); ++x ) {
+                    const auto cell = monsters_by_submap.find( tripoint_abs_sm( x, y, z ) );
+                    if( cell != monsters_by_submap.end() ) {
+                        buckets.push_back( &cell->second );
+                    }
+                }
+            }
+        }
+    }
+
+    size_t looked_at = 0;
+    for( const std::vector<monster *> *bucket : buckets ) {
+        looked_at += bucket->size();
+        for( monster *critter : *bucket ) {
+            if( !critter->is_dead() && inside( critter->pos_abs() ) ) {
+                result.push_back( critter );
+            }
+        }
+    }
+    turn_counters::add( turn_counter::area_query_monsters, looked_at );
+}
+
+void creature_tracker::collect_in_radius( const tripoint_abs_ms &center, int radius,
+        std::vector<monster *> &result ) const
+{
+    if( radius < 0 ) {
+        return;
+    }
+    // rl_dist never undercuts the Chebyshev distance, so the cube holds every candidate.
+    const tripoint offset( radius, radius, radius );
+    const size_t first = result.size();
+    collect_in_rect( center - offset, center + offset, result );
+    result.erase( std::remove_if( result.begin() + first, result.end(),
+    [&]( const monster * critter ) {
+        return rl_dist( center, critter->pos_abs() ) > radius;
+    } ), result.end() );
+}
+
+std::vector<monster *> creature_tracker::nearest( const tripoint_abs_ms &center, size_t count,
+        int radius ) const
+{
+    std::vector<monster *> result;
+    collect_in_radius( center, radius, result );
+    std::stable_sort( result.begin(), result.end(), [&]( const monster * a, const monster * b ) {
+        return rl_dist( center, a->pos_abs() ) < rl_dist( center, b->pos_abs() );
+    } );
+    if( result.size() > count ) {
+        result.resize( count );
+    }
+    return result;
+}
+
 void creature_tracker::remove( const monster &critter )
 {
     const auto iter = std::find_if( monsters_list.begin(), monsters_list.end(),
@@ -183,6 +323,7 @@ void creature_tracker::clear()
 {
     monsters_list.clear();
     monsters_by_location.clear();
+    monsters_by_submap.clear();
     removed_this_turn_.clear();
     creatures_by_zone_and_faction_.clear();
     invalidate_reachability_cache();
@@ -191,8 +332,9 @@ void creature_tracker::clear()
 void creature_tracker::rebuild_cache()
 {
     monsters_by_location.clear();
+    monsters_by_submap.clear();
     for( const shared_ptr_fast<monster> &mon_ptr : monsters_list ) {
-        monsters_by_location[mon_ptr->pos_abs()] = mon_ptr;
+        set_location( mon_ptr->pos_abs(), mon_ptr );
     }
 }
 
@@ -228,20 +370,18 @@ void creature_tracker::swap_positions( monster &first, monster &second )
     }
 
     // Either of them may be invalid!
-    const auto first_iter = monsters_by_location.find( first.pos_abs() );
-    const auto second_iter = monsters_by_location.find( second.pos_abs() );
-    // implied: first_iter != second_iter
-
     shared_ptr_fast<monster> first_ptr;
-    if( first_iter != monsters_by_location.end() ) {
+    if( const auto first_iter = monsters_by_location.find( first.pos_abs() );
+        first_iter != monsters_by_location.end() ) {
         first_ptr = first_iter->second;
-        monsters_by_location.erase( first_iter );
+        erase_location( first.pos_abs() );
     }
 
     shared_ptr_fast<monster> second_ptr;
-    if( second_iter != monsters_by_location.end() ) {
+    if( const auto second_iter = monsters_by_location.find( second.pos_abs() );
+        second_iter != monsters_by_location.end() ) {
         second_ptr = second_iter->second;
-        monsters_by_location.erase( second_iter );
+        erase_location( second.pos_abs() );
     }
     // implied: (first_ptr != second_ptr) or (first_ptr == nullptr && second_ptr == nullptr)
 
@@ -251,10 +391,10 @@ void creature_tracker::swap_positions( monster &first, monster &second )
 
     // If the pointers have been taken out of the list, put them back in.
     if( first_ptr ) {
-        monsters_by_location[first.pos_abs()] = first_ptr;
+        set_location( first.pos_abs(), first_ptr );
     }
     if( second_ptr ) {
-        monsters_by_location[second.pos_abs()] = second_ptr;
+        set_location( second.pos_abs(), second_ptr );
     }
 }
 
@@ -119,6 +119,27 @@ class creature_tracker
         template<typename T = Creature>
         const T * creature_at( const tripoint_abs_ms &p, bool allow_hallucination = false ) const;
 
+        /**
+         * Visits all monsters inside the given box (both corners inclusive) using the given functor.
+         *  - VisitFn: void(monster&)
+         * Dead monsters are ignored and not visited. Monsters added by the functor are not visited.
+         */
+        template <typename VisitFn>
+        void for_each_in_rect( const tripoint_abs_ms &min, const tripoint_abs_ms &max,
+                               VisitFn &&visit_fn );
+        /**
+         * Visits all monsters within @p radius (as measured by @ref rl_dist) of @p center.
+         *  - VisitFn: void(monster&)
+         * Dead monsters are ignored and not visited. Monsters added by the functor are not visited.
+         */
+        template <typename VisitFn>
+        void for_each_in_radius( const tripoint_abs_ms &center, int radius, VisitFn &&visit_fn );
+        /**
+         * Returns up to @p count living monsters within @p radius of @p center, closest first.
+         * Monsters at the same distance keep the order the index yields them in.
+         */
+        std::vector<monster *> nearest( const tripoint_abs_ms &center, size_t count, int radius ) const;
+
         const std::vector<shared_ptr_fast<monster>> &get_monsters_list() const {
             return monsters_list;
         }
@@ -136,6 +157,20 @@ class creature_tracker
     private:
         /** Remove the monsters entry in @ref monsters_by_location */
         void remove_from_location_map( const monster &critter );
+        /** Puts the monster into @ref monsters_by_location and @ref monsters_by_submap */
+        void set_location( const tripoint_abs_ms &pos, const shared_ptr_fast<monster> &critter_ptr );
+        /** Removes whatever is stored at @p pos from both location indices */
+        void erase_location( const tripoint_abs_ms &pos );
+        void remove_from_submap_index( const tripoint_abs_ms &pos, const monster *critter );
+        /**
+         * Appends the living monsters inside the box. They come by submap, ordered by z,
+         * then y, then x, and within a submap in the order they arrived there.
+         */
+        void collect_in_rect( const tripoint_abs_ms &min, const tripoint_abs_ms &max,
+                              std::vector<monster *> &result ) const;
+        void collect_in_radius( const tripoint_abs_ms &center, int radius,
+                                std::vector<monster *> &result ) const;
+        static bool is_alive( const monster &critter );
 
         void flood_fill_zone( const Creature &origin );
 
@@ -148,6 +183,9 @@ class creature_tracker
         std::vector<shared_ptr_fast<monster>> monsters_list;
         // NOLINTNEXTLINE(cata-serialize)
         std::unordered_map<tripoint_abs_ms, shared_ptr_fast<monster>> monsters_by_location;
+        // The same monsters bucketed by the submap they stand on, for area queries.
+        // NOLINTNEXTLINE(cata-serialize)
+        std::unordered_map<tripoint_abs_sm, std::vector<monster *>> monsters_by_submap;
 
         /**
          * Creatures that get removed via @ref remove are stored here until the end of the turn.
@@ -171,6 +209,33 @@ creature_tracker &get_creature_tracker();
 
 // Implementation Details
 
+template <typename VisitFn>
+void creature_tracker::for_each_in_rect( const tripoint_abs_ms &min, const tripoint_abs_ms &max,
+        VisitFn &&visit_fn )
+{
+    // Collect first so the functor may move, add or kill monsters.
+    std::vector<monster *> found;
+    collect_in_rect( min, max, found );
+    for( monster *critter : found ) {
+        if( is_alive( *critter ) ) {
+            visit_fn( *critter );
+        }
+    }
+}
+
+template <typename VisitFn>
+void creature_tracker::for_each_in_radius( const tripoint_abs_ms &center, int radius,
+        VisitFn &&visit_fn )
+{
+    std::vector<monster *> found;
+    collect_in_radius( center, radius, found );
+    for( monster *critter : found ) {
+        if( is_alive( *critter ) ) {
+            visit_fn( *critter );
+        }
+    }
+}
+
 template <typename PredicateFn>
 Creature *creature_tracker::find_reachable( const Creature &origin, PredicateFn &&predicate_fn )
 {
@@ -80,6 +80,7 @@
 #include "map_extras.h"
 #include "map_iterator.h"
 #include "map_scale_constants.h"
+#include "mapbuffer.h"
 #include "mapgen.h"
 #include "mapgendata.h"
 #include "martialarts.h"
@@ -3119,6 +3120,9 @@ static void debug_menu_game_state()
     std::string s = _( "Location %d:%d in %d:%d, %s\n" );
     s += _( "Current turn: %d.\n" );
     s += n_gettext( "%d creature exists.\n", "%d creatures exist.\n", g->num_creatures() );
+    s += string_format( _( "%d submaps in memory using %d KiB, %d quads unloaded since the last save.\n" ),
+                        MAPBUFFER.submap_count(), MAPBUFFER.memory_usage() / 1024,
+                        MAPBUFFER.evicted_quad_count() );
 
     std::unordered_map<std::string, int> creature_counts;
     for( Creature &critter : g->all_creatures() ) {
@@ -19,6 +19,7 @@
 
 #include "action.h"
 #include "activity_type.h"
+#include "async_save.h"
 #include "avatar.h"
 #include "bionics.h"
 #include "cached_options.h"
@@ -56,6 +57,7 @@
 #include "output.h"
 #include "overmap_ui.h"
 #include "overmapbuffer.h"
+#include "perf.h"
 #include "pimpl.h"
 #include "player_activity.h"
 #include "point.h"
@@ -106,6 +108,8 @@ namespace turn_handler
 {
 bool cleanup_at_end()
 {
+    // Don't leave the world while an autosave is still being written.
+    async_save::wait();
     avatar &u = get_avatar();
     if( g->uquit == QUIT_DIED || g->uquit == QUIT_SUICIDE ) {
         // Put (non-hallucinations) into the overmap so they are not lost.
@@ -455,6 +459,7 @@ void overmap_npc_move()
 // Returns true if game is over (death, saved, quit, etc)
 bool do_turn()
 {
+    CATA_PROFILE_ZONE( "do_turn" );
     if( g->is_game_over() ) {
         return turn_handler::cleanup_at_end();
     }
@@ -472,7 +477,10 @@ bool do_turn()
             weather.set_nextweather( calendar::turn );
         }
     } else {
-        g->gamemode->per_turn();
+        // Headless drivers such as the turn benchmark never call start_game()
+        if( g->gamemode ) {
+            g->gamemode->per_turn();
+        }
         calendar::turn += 1_turns;
     }
 
@@ -485,9 +493,12 @@ bool do_turn()
         g->load_npcs();
     }
 
-    timed_event_manager &timed_events = get_timed_events();
-    timed_events.process();
-    mission::process_all();
+    {
+        CATA_PROFILE_ZONE( "timed_events" );
+        timed_event_manager &timed_events = get_timed_events();
+        timed_events.process();
+        mission::process_all();
+    }
     avatar &u = get_avatar();
     map &m = get_map();
     // If controlling a vehicle that is owned by someone else
@@ -536,6 +547,13 @@ bool do_turn()
         !u.is_dead_state() ) {
         g->autosave();
     }
+    // No tinymap is alive between turns, so the mapbuffer can unload submaps here.
+    if( calendar::once_every( 1_minutes ) ) {
+        const int map_memory_budget = get_option<int>( "MAPBUFFER_MEMORY_BUDGET" );
+        if( map_memory_budget > 0 ) {
+            MAPBUFFER.evict_to_budget( static_cast<size_t>( map_memory_budget ) * 1024 * 1024 );
+        }
+    }
 
     weather.update_weather();
     g->reset_light_level();
@@ -586,7 +604,12 @@ bool do_turn()
                     g->queue_screenshot = false;
                 }
 
-                if( g->handle_action() ) {
+                bool action_taken;
+                {
+                    CATA_PROFILE_ZONE( "handle_action" );
+                    action_taken = g->handle_action();
+                }
+                if( action_taken ) {
                     ++g->moves_since_last_save;
                     u.action_taken();
                 }
@@ -631,6 +654,9 @@ bool do_turn()
         }
     }
 
+    // Everything from here on is the world reacting to the player's turn
+    const uint64_t world_update_begin = cata_profiler::now_ticks();
+
     if( g->driving_view_offset.x() != 0 || g->driving_view_offset.y() != 0 ) {
         // Still have a view offset, but might not be driving anymore,
         // or the option has been deactivated,
@@ -646,26 +672,48 @@ bool do_turn()
         scent.set( u.pos_bub(), u.scent, u.get_type_of_scent() );
         overmap_buffer.set_scent( u.pos_abs_omt(),  u.scent );
     }
-    scent.update( u.pos_bub(), m );
+    {
+        CATA_PROFILE_ZONE( "scent_update" );
+        scent.update( u.pos_bub(), m );
+    }
 
     // We need floor cache before checking falling 'n stuff
     m.build_floor_caches();
 
     m.process_falling();
-    m.vehmove();
-    m.process_fields();
-    m.process_items();
+    {
+        scoped_turn_phase timer( turn_phase::vehmove );
+        m.vehmove();
+    }
+    {
+        scoped_turn_phase timer( turn_phase::process_fields );
+        m.process_fields();
+    }
+    {
+        scoped_turn_phase timer( turn_phase::process_items );
+        m.process_items();
+    }
     explosion_handler::process_explosions();
     m.creature_in_field( u );
 
     // Apply sounds from previous turn to monster and NPC AI.
-    sounds::process_sounds();
+    {
+        scoped_turn_phase timer( turn_phase::process_sounds );
+        sounds::process_sounds();
+    }
     const int levz = m.get_abs_sub().z();
     // Update vision caches for monsters. If this turns out to be expensive,
     // consider a stripped down cache just for monsters.
-    m.build_map_cache( levz, true );
-    monmove();
+    {
+        scoped_turn_phase timer( turn_phase::build_map_cache );
+        m.build_map_cache( levz, true );
+    }
+    {
+        scoped_turn_phase timer( turn_phase::monmove );
+        monmove();
+    }
     if( calendar::once_every( time_between_npc_OM_moves ) ) {
+        CATA_PROFILE_ZONE( "overmap_npc_move" );
         overmap_npc_move();
     }
     if( calendar::once_every( 10_seconds ) ) {
@@ -683,7 +731,10 @@ bool do_turn()
         }
     }
     g->mon_info_update();
-    u.process_turn();
+    {
+        CATA_PROFILE_ZONE( "avatar_process_turn" );
+        u.process_turn();
+    }
     if( u.get_moves() < 0 && get_option<bool>( "FORCE_REDRAW" ) ) {
         ui_manager::redraw();
         refresh_display();
@@ -771,6 +822,8 @@ bool do_turn()
     u.power_balance = u.get_power_level() - u.power_prev_turn;
     u.power_prev_turn = u.get_power_level();
 
+    cata_profiler::end_turn( world_update_begin );
+
 #if defined(EMSCRIPTEN)
     // This will cause a prompt to be shown if the window is closed, until the
     // game is saved.
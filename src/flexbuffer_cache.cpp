@@ -21,6 +21,7 @@
 
 #include "cata_utility.h"
 #include "filesystem.h"
+#include "flexbuffer_json.h"
 #include "json.h"
 #include "mmap_file.h"
 #include "options.h"
@@ -230,6 +231,28 @@ struct string_flexbuffer : parsed_flexbuffer {
         std::string source_;
 };
 
+struct binary_flexbuffer : parsed_flexbuffer {
+        explicit binary_flexbuffer( std::shared_ptr<flexbuffer_storage> &&storage )
+            : parsed_flexbuffer{ std::move( storage ) } {}
+
+        ~binary_flexbuffer() override = default;
+
+        bool is_stale() const override {
+            return false;
+        }
+
+        std::unique_ptr<std::istream> get_source_stream() const override {
+            // Only needed for error messages, so it's fine to rebuild the text here.
+            std::string source;
+            flexbuffer_root_from_storage( storage_ ).ToString( true, true, source );
+            return std::make_unique<std::istringstream>( std::move( source ) );
+        }
+
+        std::filesystem::path get_source_path() const noexcept override {
+            return {};
+        }
+};
+
 class flexbuffer_disk_cache
 {
     public:
@@ -505,3 +528,14 @@ std::shared_ptr<parsed_flexbuffer> flexbuffer_cache::parse_buffer( std::string b
     auto storage = std::make_shared<flexbuffer_vector_storage>( std::move( fb ) );
     return std::make_shared<string_flexbuffer>( std::move( storage ), std::move( buffer ) );
 }
+
+std::vector<uint8_t> flexbuffer_cache::parse_buffer_to_binary( const std::string &buffer )
+{
+    return parse_json_to_flexbuffer_( buffer.c_str(), nullptr );
+}
+
+std::shared_ptr<parsed_flexbuffer> flexbuffer_cache::wrap_binary(
+    std::shared_ptr<flexbuffer_storage> storage )
+{
+    return std::make_shared<binary_flexbuffer>( std::move( storage ) );
+}
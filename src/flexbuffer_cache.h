@@ -6,6 +6,7 @@
 #include <iosfwd>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <flatbuffers/flexbuffers.h>
 
@@ -64,6 +65,13 @@ class flexbuffer_cache
 
         static shared_flexbuffer parse_buffer( std::string buffer ) noexcept( false );
 
+        // Parse json text into raw FlexBuffer binary data, for embedding it in other files.
+        static std::vector<uint8_t> parse_buffer_to_binary( const std::string &buffer ) noexcept( false );
+
+        // Wrap FlexBuffer binary data that was embedded in another file. There is no json
+        // source for it, errors are reported against json text regenerated from the data.
+        static shared_flexbuffer wrap_binary( std::shared_ptr<flexbuffer_storage> storage );
+
     private:
         flexbuffer_cache( flexbuffer_cache && ) noexcept = default;
 
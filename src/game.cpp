@@ -11,6 +11,7 @@
 #include <ctime>
 #include <cwctype>
 #include <exception>
+#include <filesystem>
 #include <functional>
 #include <iomanip>
 #include <iostream>
@@ -24,6 +25,7 @@
 #include <queue>
 #include <set>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -42,6 +44,7 @@
 #include "activity_handlers.h"
 #include "activity_type.h"
 #include "ascii_art.h"
+#include "async_save.h"
 #include "auto_note.h"
 #include "auto_pickup.h"
 #include "avatar.h"
@@ -3215,12 +3218,18 @@ bool game::load( const std::string &world )
 
 bool game::load( const save_t &name )
 {
+    // The player data of the last save may still be on its way to the disk.
+    async_save::wait();
     map &here = get_map();
 
     const cata_path worldpath = PATH_INFO::world_base_save_path();
     const cata_path save_file_path = PATH_INFO::world_base_save_path() /
                                      ( name.base_path() + SAVE_EXTENSION );
 
+    if( world_generator->active_world->has_compression_enabled() ) {
+        world_generator->active_world->update_compression_dictionaries();
+    }
+
     bool abort = false;
 
     using named_entry = std::pair<std::string, std::function<void()>>;
@@ -3526,19 +3535,36 @@ bool game::save_player_data()
 {
     const cata_path playerfile = PATH_INFO::player_base_save_path();
 
-    bool saved_data;
-    if( world_generator->active_world->has_compression_enabled() ) {
-        std::stringstream save;
-        serialize_json( save );
-        std::shared_ptr<zzip> z = zzip::load( ( playerfile + SAVE_EXTENSION +
-                                                ".zzip" ).get_unrelative_path() );
-        saved_data = z->add_file( ( playerfile + SAVE_EXTENSION ).get_unrelative_path().filename(),
-                                  save.str() );
-        saved_data = saved_data && z->compact( 1.0 );
-    } else {
-        saved_data = write_to_file( playerfile + SAVE_EXTENSION, [&]( std::ostream & fout ) {
-            serialize_json( fout );
-        }, _( "player data" ) );
+    bool saved_data = true;
+    std::stringstream save;
+    serialize_json( save );
+    // The player data points into the maps, so it is written only once they are on disk.
+    const cata_path save_path = playerfile + SAVE_EXTENSION;
+    try {
+        if( world_generator->active_world->has_compression_enabled() ) {
+            const std::filesystem::path zzip_path = ( save_path + ".zzip" ).get_unrelative_path();
+            const std::filesystem::path file_name = save_path.get_unrelative_path().filename();
+            async_save::submit_last( zzip_path.generic_u8string(),
+            [zzip_path, file_name, contents = save.str()]() {
+                std::shared_ptr<zzip> z = zzip::load( zzip_path );
+                if( !z || !z->add_file( file_name, contents ) || !z->compact( 1.0 ) ) {
+                    throw std::runtime_error( "Failed to write player data to " +
+                                              zzip_path.generic_u8string() );
+                }
+                async_save::written( zzip_path );
+            } );
+        } else {
+            async_save::submit_last( save_path.generic_u8string(),
+            [save_path, contents = save.str()]() {
+                write_to_file( save_path, [&]( std::ostream & fout ) {
+                    fout << contents;
+                } );
+                async_save::written( save_path.get_unrelative_path() );
+            } );
+        }
+    } catch( const std::exception &err ) {
+        popup( _( "Failed to save the player data: %s" ), err.what() );
+        saved_data = false;
     }
     const bool saved_map_memory = u.save_map_memory();
     const bool saved_log = write_to_file( playerfile + SAVE_EXTENSION_LOG, [&](
@@ -12983,6 +13009,15 @@ point_rel_sm game::update_map( int &x, int &y, bool z_level_changed )
         remaining_shift -= this_shift;
     }
 
+    // Start reading what lies ahead while this turn goes on. Fast vehicles cross
+    // several submaps between shifts, so they look further ahead.
+    int prefetch_reach = 2;
+    if( const optional_vpart_position vp = here.veh_at( u.pos_bub( here ) ); vp && u.in_vehicle ) {
+        prefetch_reach += static_cast<int>( std::abs( vp->vehicle().velocity ) /
+                                            vehicles::vmiph_per_tile ) / SEEX;
+    }
+    MAPBUFFER.prefetch_ahead( here.get_abs_sub(), shift, std::min( prefetch_reach, HALF_MAPSIZE ) );
+
     // Shift monsters
     shift_monsters( { shift, 0 } );
     const point_rel_ms shift_ms = coords::project_to<coords::ms>( shift );
@@ -13400,8 +13435,11 @@ void game::quicksave()
 
     time_t now = std::time( nullptr ); //timestamp for start of saving procedure
 
-    //perform save
-    save();
+    //perform save, the map and overmap files are written in the background while play goes on
+    {
+        async_save::scope background_writes;
+        save();
+    }
     //Now reset counters for autosaving, so we don't immediately autosave after a quicksave or autosave.
     moves_since_last_save = 0;
     last_save_timestamp = now;
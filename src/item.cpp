@@ -251,6 +251,11 @@ static const int PRICE_FILTHY_MALUS = 100;  // cents
 
 static constexpr float MIN_LINK_EFFICIENCY = 0.001f;
 
+// Below this difference in kelvin to its surroundings an item keeps its temperature.
+static constexpr double settled_temperature_difference = 0.4;
+// Temperature and rot are processed at most this often, see item::process_temperature_rot.
+static constexpr time_duration temperature_check_interval = 10_minutes;
+
 class npc_class;
 
 using npc_class_id = string_id<npc_class>;
@@ -13003,6 +13008,7 @@ void item::set_item_temperature( units::temperature new_temperature )
 
     temperature = new_temperature;
     specific_energy = new_specific_energy ;
+    temperature_settled = false;
 
     // Energy that the item would have if it was completely solid at freezing temperature
     const float completely_frozen_specific_energy = specific_heat_solid * freezing_temperature;
@@ -13466,6 +13472,24 @@ int item::processing_speed() const
     return item::NO_PROCESSING;
 }
 
+int item::processing_delay() const
+{
+    // Anything but temperature and rot still needs the regular processing.
+    if( !temperature_settled || !is_comestible() || ethereal || wetness || has_link_data() ||
+        requires_tags_processing || countdown_point != calendar::turn_max ||
+        !type->emits.empty() || has_relic_recharge() || has_own_flag( flag_PROCESSING ) ) {
+        return 0;
+    }
+    // The surroundings may warm up or cool down meanwhile, which only the next
+    // temperature check notices.
+    return to_turns<int>( temperature_check_interval );
+}
+
+void item::unsettle_temperature()
+{
+    temperature_settled = false;
+}
+
 void item::apply_freezerburn()
 {
     if( !has_flag( flag_FREEZERBURN ) ) {
@@ -13488,8 +13512,8 @@ bool item::process_temperature_rot( float insulation, const tripoint_bub_ms &pos
 
     // process temperature and rot at most once every 100_turns (10 min)
     // note we're also gated by item::processing_speed
-    time_duration smallest_interval = 10_minutes;
-    if( now - last_temp_check < smallest_interval && units::to_joule_per_gram( specific_energy ) > 0 ) {
+    if( now - last_temp_check < temperature_check_interval &&
+        units::to_joule_per_gram( specific_energy ) > 0 ) {
         return false;
     }
 
@@ -13532,6 +13556,7 @@ bool item::process_temperature_rot( float insulation, const tripoint_bub_ms &pos
 
     if( now - time > 1_hours ) {
         // This code is for items that were left out of reality bubble for long time
+        temperature_settled = false;
 
         const weather_generator &wgen = get_weather().get_cur_weather_gen();
         const unsigned int seed = g->get_seed();
@@ -13612,9 +13637,11 @@ bool item::process_temperature_rot( float insulation, const tripoint_bub_ms &pos
 
     // Remaining <1 h from above
     // and items that are held near the player
-    if( now - time > smallest_interval ) {
+    if( now - time > temperature_check_interval ) {
         calc_temp( temp, insulation, now - time );
         last_temp_check = now;
+        const float difference = units::to_kelvin( temp ) - units::to_kelvin( temperature );
+        temperature_settled = std::abs( difference ) < settled_temperature_difference;
 
         if( decays_in_air &&
             process_decay_in_air( here, carrier, pos, max_air_exposure_hours, now - time ) ) {
@@ -13642,7 +13669,7 @@ void item::calc_temp( const units::temperature &temp, const float insulation,
     const float temperature_difference = env_temperature - old_temperature;
 
     // If no or only small temperature difference then no need to do math.
-    if( std::abs( temperature_difference ) < 0.4 ) {
+    if( std::abs( temperature_difference ) < settled_temperature_difference ) {
         return;
     }
     const float mass = to_gram( weight() ); // g
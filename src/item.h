@@ -1647,6 +1647,19 @@ class item : public visitable
          */
         int processing_speed() const;
         static constexpr int NO_PROCESSING = 10000;
+        /**
+         * How many turns processing this item can be skipped for without missing a change, 0 if
+         * it should be processed at its @ref processing_speed. Food that has settled at the
+         * temperature around it only rots, which @ref process_temperature_rot integrates over
+         * however long processing was skipped, so it only needs to be processed at each of its
+         * temperature checks, in case the surroundings changed.
+         */
+        int processing_delay() const;
+        /**
+         * Makes @ref processing_delay wait for the next temperature check again, for when the
+         * surroundings of the item may have changed, e.g. because it was moved.
+         */
+        void unsettle_temperature();
         /**
          * Process and apply artifact effects. This should be called exactly once each turn, it may
          * modify character stats (like speed, strength, ...), so call it after those have been reset.
@@ -3271,6 +3284,11 @@ class item : public visitable
          * This flag is reset to `true` if item tags are changed.
          */
         bool requires_tags_processing = true;
+        /**
+         * `true` if the last @ref process_temperature_rot left the item at the temperature around
+         * it, see @ref processing_delay.
+         */
+        bool temperature_settled = false; // NOLINT(cata-serialize)
         cata::heap<FlagsSetType> item_tags; // generic item specific flags
         cata::heap<FlagsSetType> inherited_tags_cache;
         cata::heap<FlagsSetType> prefix_tags_cache; // flags that will add prefixes to this item
@@ -15,6 +15,9 @@ level_cache::level_cache()
     std::fill_n( &lm[0][0], map_dimensions, four_zeros );
     std::fill_n( &sm[0][0], map_dimensions, 0.0f );
     std::fill_n( &light_source_buffer[0][0], map_dimensions, 0.0f );
+    // Doesn't match any transparency, so everything counts as changed at first
+    std::fill_n( &lightmap_transparency[0][0], map_dimensions, -1.0f );
+    lightmap_transparency_changed.fill( 0 );
     std::fill_n( &outside_cache[0][0], map_dimensions, false );
     std::fill_n( &floor_cache[0][0], map_dimensions, false );
     std::fill_n( &transparency_cache[0][0], map_dimensions, 0.0f );
@@ -57,6 +60,62 @@ void level_cache::set_veh_cached_parts( const tripoint_bub_ms &pt, vehicle &veh,
     veh_cached_parts[ pt ] = std::make_pair( &veh, part_num );
 }
 
+// Calls f with the index of each submap of the footprint cells that area touches.  Footprints
+// that reach past the edge of the map are kept in the cells along it.
+template<typename F>
+static void for_each_footprint_cell( const inclusive_rectangle<point_bub_ms> &area, F f )
+{
+    const int min_x = std::clamp( area.p_min.x() / SEEX, 0, MAPSIZE - 1 );
+    const int max_x = std::clamp( area.p_max.x() / SEEX, 0, MAPSIZE - 1 );
+    const int min_y = std::clamp( area.p_min.y() / SEEY, 0, MAPSIZE - 1 );
+    const int max_y = std::clamp( area.p_max.y() / SEEY, 0, MAPSIZE - 1 );
+    for( int x = min_x; x <= max_x; ++x ) {
+        for( int y = min_y; y <= max_y; ++y ) {
+            f( x * MAPSIZE + y );
+        }
+    }
+}
+
+void level_cache::set_veh_footprint( const vehicle &veh,
+                                     const inclusive_rectangle<point_bub_ms> &footprint )
+{
+    veh_cache_cleared = false;
+    clear_veh_footprint( &veh );
+    veh_footprints.emplace( &veh, footprint );
+    for_each_footprint_cell( footprint, [&]( int cell ) {
+        veh_footprint_cells[cell].push_back( &veh );
+    } );
+}
+
+void level_cache::clear_veh_footprint( const vehicle *veh )
+{
+    const auto it = veh_footprints.find( veh );
+    if( it == veh_footprints.end() ) {
+        return;
+    }
+    for_each_footprint_cell( it->second, [&]( int cell ) {
+        std::vector<const vehicle *> &cell_vehicles = veh_footprint_cells[cell];
+        cell_vehicles.erase( std::remove( cell_vehicles.begin(), cell_vehicles.end(), veh ),
+                             cell_vehicles.end() );
+    } );
+    veh_footprints.erase( it );
+}
+
+bool level_cache::other_veh_footprint_overlaps( const inclusive_rectangle<point_bub_ms> &area,
+        const vehicle *veh ) const
+{
+    if( veh_footprints.size() <= static_cast<size_t>( veh_footprints.count( veh ) ) ) {
+        return false;
+    }
+    bool overlaps = false;
+    for_each_footprint_cell( area, [&]( int cell ) {
+        for( const vehicle *other : veh_footprint_cells[cell] ) {
+            overlaps = overlaps || ( other != veh && veh_footprints.at( other ).overlaps( area ) );
+        }
+    } );
+    return overlaps;
+}
+
 void level_cache::clear_vehicle_cache()
 {
     if( veh_cache_cleared ) {
@@ -64,6 +123,10 @@ void level_cache::clear_vehicle_cache()
     }
     veh_exists_at.reset();
     veh_cached_parts.clear();
+    veh_footprints.clear();
+    for( std::vector<const vehicle *> &cell_vehicles : veh_footprint_cells ) {
+        cell_vehicles.clear();
+    }
     veh_cache_cleared = true;
 }
 
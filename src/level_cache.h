@@ -4,11 +4,14 @@
 
 #include <array>
 #include <bitset>
+#include <cstdint>
 #include <set>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "coordinates.h"
+#include "cuboid_rectangle.h"
 #include "map_scale_constants.h"
 #include "mdarray.h"
 #include "shadowcasting.h"
@@ -17,6 +20,16 @@
 class vehicle;
 enum class lit_level : int;
 
+// Light cast by the static sources (terrain and furniture) of one submap on their own.
+struct submap_static_light {
+    // position and luminance of each source
+    std::vector<std::pair<point_bub_ms, float>> sources;
+    // every tile the sources lit, with the light it got
+    std::vector<std::pair<point_bub_ms, four_quadrants>> lit;
+    // level_cache::lightmap_generation when the light was cast, -1 if it hasn't been
+    int64_t cast_generation = -1;
+};
+
 struct level_cache {
     public:
         // Zeros all relevant values
@@ -36,6 +49,16 @@ struct level_cache {
         // This is only valid for the duration of generate_lightmap
         cata::mdarray<float, point_bub_ms> light_source_buffer;
 
+        // generate_lightmap keeps the light of static sources between calls, and only casts it
+        // again once the transparency within its reach changes.
+        std::array<submap_static_light, MAPSIZE *MAPSIZE> static_lights;
+        // counts calls to generate_lightmap
+        int64_t lightmap_generation = 0;
+        // transparency_cache as of the last call to generate_lightmap...
+        cata::mdarray<float, point_bub_ms> lightmap_transparency;
+        // ...and the lightmap_generation at which each submap of it last changed
+        std::array<int64_t, MAPSIZE *MAPSIZE> lightmap_transparency_changed;
+
         // Cache of natural light level is useful if it needs to be in sync with the light cache.
         float natural_light_level_cache;
 
@@ -63,6 +86,10 @@ struct level_cache {
         // initial values derived from transparency_cache, uses same units
         // examples of adjustment: changed transparency on player's tile and special case for crouching
         cata::mdarray<float, point_bub_ms> vision_transparency_cache;
+        // tiles whose vision transparency was adjusted, with the value they were given
+        std::vector<std::pair<point_bub_ms, float>> vision_transparency_overrides;
+        // tiles whose vision transparency changed since the seen cache was last built
+        std::vector<point_bub_ms> vision_transparency_changes;
 
         // stores "visibility" of the tiles to the player
         // values range from 1 (fully visible to player) to 0 (not visible)
@@ -87,6 +114,13 @@ struct level_cache {
 
         void set_veh_exists_at( const tripoint_bub_ms &pt, bool exists_at );
         void set_veh_cached_parts( const tripoint_bub_ms &pt, vehicle &veh, int part_num );
+        // Sets the rectangle the parts of veh cover on this level.
+        void set_veh_footprint( const vehicle &veh,
+                                const inclusive_rectangle<point_bub_ms> &footprint );
+        void clear_veh_footprint( const vehicle *veh );
+        // Whether the footprint of a vehicle other than veh overlaps area.
+        bool other_veh_footprint_overlaps( const inclusive_rectangle<point_bub_ms> &area,
+                                           const vehicle *veh ) const;
 
         void clear_vehicle_cache();
         void clear_veh_from_veh_cached_parts( const tripoint_bub_ms &pt, vehicle *veh );
@@ -97,5 +131,9 @@ struct level_cache {
         bool veh_cache_cleared = true;
         std::bitset<MAPSIZE_X *MAPSIZE_Y> veh_exists_at;
         std::unordered_map<tripoint_bub_ms, std::pair<vehicle *, int>> veh_cached_parts;
+        // Footprint of each vehicle on this level, and the vehicles whose footprint touches each
+        // submap, so moving vehicles only look for each other where they might meet.
+        std::unordered_map<const vehicle *, inclusive_rectangle<point_bub_ms>> veh_footprints;
+        std::array<std::vector<const vehicle *>, MAPSIZE *MAPSIZE> veh_footprint_cells;
 };
 #endif // CATA_SRC_LEVEL_CACHE_H
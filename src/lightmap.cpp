@@ -34,6 +34,7 @@
 #include "monster.h"
 #include "mtype.h"
 #include "npc.h"
+#include "perf.h"
 #include "point.h"
 #include "string_formatter.h"
 #include "submap.h"
@@ -100,6 +101,7 @@ void map::add_light_from_items( const tripoint_bub_ms &p, const item_stack &item
 // TODO: Consider making this just clear the cache and dynamically fill it in as is_transparent() is called
 bool map::build_transparency_cache( const int zlev )
 {
+    CATA_PROFILE_ZONE( "map::build_transparency_cache" );
     level_cache &map_cache = get_cache( zlev );
     auto &transparent_cache_wo_fields = map_cache.transparent_cache_wo_fields;
     auto &transparency_cache = map_cache.transparency_cache;
@@ -138,6 +140,7 @@ bool map::build_transparency_cache( const int zlev )
             if( !rebuild_all && !map_cache.transparency_cache_dirty[smx * MAPSIZE + smy] ) {
                 continue;
             }
+            turn_counters::add( turn_counter::transparency_tiles, SEEX * SEEY );
 
             // calculates transparency of a single tile
             // x,y - coords in map local coords
@@ -206,25 +209,14 @@ bool map::build_transparency_cache( const int zlev )
 
 bool map::build_vision_transparency_cache( int zlev )
 {
+    CATA_PROFILE_ZONE( "map::build_vision_transparency_cache" );
     level_cache &map_cache = get_cache( zlev );
 
-    // We copy the transparency_cache so we need to recalc if it's dirty
-    if( map_cache.transparency_cache_dirty.none() /*&& map_cache.vision_transparency_cache_dirty.none()*/ ) {
-        return false;
-    }
-
-    const cata::mdarray<float, point_bub_ms> &transparency_cache = map_cache.transparency_cache;
-    cata::mdarray<float, point_bub_ms> &vision_transparency_cache = map_cache.vision_transparency_cache;
-
-    // TODO: Should only copy if transparency_cache was dirty
-    memcpy( &vision_transparency_cache, &transparency_cache, sizeof( transparency_cache ) );
-
     const Character &player_character = get_player_character();
     const tripoint_bub_ms p = player_character.pos_bub();
     const bool is_player_z = p.z() == zlev;
 
-    bool dirty = false;
-
+    std::vector<std::pair<point_bub_ms, float>> overrides;
     if( is_player_z ) {
         // This segment handles vision when the player is crouching or prone. It only checks adjacent tiles.
         // If you change this, also consider creature::sees and map::obstacle_coverage.
@@ -239,46 +231,103 @@ bool map::build_vision_transparency_cache( int zlev )
         const bool is_prone = player_character.is_prone();
         if( is_crouching || is_prone || low_profile ) {
             for( const tripoint_bub_ms &loc : points_in_radius( p, 1 ) ) {
-                if( loc != p && coverage( loc ) >= 30 ) {
+                if( loc != p && inbounds( loc ) && coverage( loc ) >= 30 ) {
                     // If we're crouching or prone behind an obstacle, we can't see past it.
-                    dirty |= vision_transparency_cache[loc.x()][loc.y()] != LIGHT_TRANSPARENCY_SOLID;
-                    vision_transparency_cache[loc.x()][loc.y()] = LIGHT_TRANSPARENCY_SOLID;
+                    overrides.emplace_back( loc.xy(), LIGHT_TRANSPARENCY_SOLID );
                 }
             }
         }
+        // The tile player is standing on should always be visible
+        // Shouldn't this be handled in the player's seen cache instead??
+        if( inbounds( p ) ) {
+            overrides.emplace_back( p.xy(), LIGHT_TRANSPARENCY_OPEN_AIR );
+        }
     }
 
-    // This segment handles blocking vision through TRANSLUCENT flagged terrain.
+    // We derive from the transparency_cache so we need to recalc if it's dirty
+    if( map_cache.transparency_cache_dirty.none() &&
+        overrides == map_cache.vision_transparency_overrides ) {
+        return false;
+    }
+
+    const cata::mdarray<float, point_bub_ms> &transparency_cache = map_cache.transparency_cache;
+    cata::mdarray<float, point_bub_ms> &vision_transparency_cache =
+        map_cache.vision_transparency_cache;
+    std::vector<point_bub_ms> &changes = map_cache.vision_transparency_changes;
+    const bool rebuild_all = map_cache.transparency_cache_dirty.all();
+
+    bool dirty = false;
+    const auto set_vision_transparency = [&]( const point_bub_ms & pt, float value ) {
+        float &current = vision_transparency_cache[pt.x()][pt.y()];
+        if( current != value ) {
+            current = value;
+            dirty = true;
+            if( !rebuild_all ) {
+                changes.push_back( pt );
+            }
+        }
+    };
+    const auto find_override = [&overrides]( const point_bub_ms & pt ) {
+        return std::find_if( overrides.begin(), overrides.end(),
+        [&pt]( const std::pair<point_bub_ms, float> &o ) {
+            return o.first == pt;
+        } );
+    };
+
+    // Only the submaps whose transparency changed need to be derived again.
+    // This segment also handles blocking vision through TRANSLUCENT flagged terrain.
     // Traverse the submaps in order (else map::ter() calls get_submap each time)
     for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
         for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
+            if( !map_cache.transparency_cache_dirty[smx * MAPSIZE + smy] ) {
+                continue;
+            }
             const submap *cur_submap = get_submap_at_grid( tripoint_rel_sm{smx, smy, zlev} );
             if( cur_submap == nullptr ) {
                 debugmsg( "Tried to build transparency cache at (%d,%d,%d) but the submap is not loaded", smx, smy,
                           zlev );
                 continue;
             }
-            if( !map_cache.transparency_cache_dirty[smx * MAPSIZE + smy] ) {
-                continue;
-            }
+            turn_counters::add( turn_counter::vision_transparency_tiles, SEEX * SEEY );
             for( int smi = 0; smi < SEEX; smi++ ) {
                 for( int smj = 0; smj < SEEY; smj++ ) {
+                    const point_bub_ms pt( smi + smx * SEEX, smj + smy * SEEY );
+                    float value = transparency_cache[pt.x()][pt.y()];
                     if( cur_submap->get_ter( point_sm_ms{smi, smj} ).obj().has_flag(
                             ter_furn_flag::TFLAG_TRANSLUCENT ) ) {
-                        const int i = smi + ( smx * SEEX );
-                        const int j = smj + ( smy * SEEY );
-                        dirty |= vision_transparency_cache[i][j] != LIGHT_TRANSPARENCY_SOLID;
-                        vision_transparency_cache[i][j] = LIGHT_TRANSPARENCY_SOLID;
+                        value = LIGHT_TRANSPARENCY_SOLID;
                     }
+                    const auto o = find_override( pt );
+                    set_vision_transparency( pt, o == overrides.end() ? value : o->second );
                 }
             }
         }
     }
 
-    // The tile player is standing on should always be visible
-    // Shouldn't this be handled in the player's seen cache instead??
-    if( is_player_z && inbounds( p ) ) {
-        vision_transparency_cache[p.x()][p.y()] = LIGHT_TRANSPARENCY_OPEN_AIR;
+    // Tiles that stopped or started being adjusted may lie in submaps that were not derived again
+    const auto update_adjusted = [&]( const point_bub_ms & pt ) {
+        const auto o = find_override( pt );
+        if( o != overrides.end() ) {
+            set_vision_transparency( pt, o->second );
+        } else if( ter( tripoint_bub_ms( pt, zlev ) )->has_flag(
+                       ter_furn_flag::TFLAG_TRANSLUCENT ) ) {
+            set_vision_transparency( pt, LIGHT_TRANSPARENCY_SOLID );
+        } else {
+            set_vision_transparency( pt, transparency_cache[pt.x()][pt.y()] );
+        }
+    };
+    for( const std::pair<point_bub_ms, float> &o : map_cache.vision_transparency_overrides ) {
+        update_adjusted( o.first );
+    }
+    for( const std::pair<point_bub_ms, float> &o : overrides ) {
+        update_adjusted( o.first );
+    }
+    map_cache.vision_transparency_overrides = std::move( overrides );
+
+    // Past a few submaps worth of changes, patching the seen cache costs more than rebuilding it
+    if( rebuild_all || changes.size() > static_cast<size_t>( 4 * SEEX * SEEY ) ) {
+        changes.clear();
+        map_cache.seen_cache_dirty |= dirty;
     }
 
     map_cache.transparency_cache_dirty.reset();
@@ -309,6 +358,7 @@ void map::apply_character_light( Character &p )
 // Once this is complete, additional operations add more dynamic lighting.
 void map::build_sunlight_cache( int pzlev )
 {
+    CATA_PROFILE_ZONE( "map::build_sunlight_cache" );
     const int zlev_min = -OVERMAP_DEPTH;
     // Start at the topmost populated zlevel to avoid unnecessary raycasting
     // Plus one zlevel to prevent clipping inside structures
@@ -440,8 +490,37 @@ void map::build_sunlight_cache( int pzlev )
     }
 }
 
+// How far from a source its light can get.  The cast stops once the intensity drops to
+// LIGHT_AMBIENT_LOW, and light_calc falls off at least as fast as 1 / distance.
+static int light_reach( float luminance )
+{
+    return std::min( static_cast<int>( luminance / LIGHT_AMBIENT_LOW ) + 1, MAX_VIEW_DISTANCE );
+}
+
+// Scratch space for casting the light of static sources apart from everything else
+struct static_light_scratch {
+    cata::mdarray<four_quadrants, point_bub_ms> lm;
+    // luminance of the static sources of the whole level...
+    cata::mdarray<float, point_bub_ms> sources;
+    // ...and of the submap being cast
+    cata::mdarray<float, point_bub_ms> submap_sources;
+};
+
+static static_light_scratch &get_static_light_scratch()
+{
+    static std::unique_ptr<static_light_scratch> scratch = [] {
+        std::unique_ptr<static_light_scratch> created = std::make_unique<static_light_scratch>();
+        // generate_lightmap returns these to all zeros after using them
+        created->lm.fill( four_quadrants() );
+        created->submap_sources.fill( 0.0f );
+        return created;
+    }();
+    return *scratch;
+}
+
 void map::generate_lightmap( const int zlev )
 {
+    CATA_PROFILE_ZONE( "map::generate_lightmap" );
     level_cache &map_cache = get_cache( zlev );
     auto &lm = map_cache.lm;
     auto &sm = map_cache.sm;
@@ -463,6 +542,95 @@ void map::generate_lightmap( const int zlev )
     auto &light_source_buffer = map_cache.light_source_buffer;
     light_source_buffer.fill( 0 );
 
+    static_light_scratch &scratch = get_static_light_scratch();
+    scratch.sources.fill( 0 );
+
+    // Note the submaps whose transparency changed since the last call, the light cast from
+    // static sources near them has to be cast again.
+    const int64_t generation = ++map_cache.lightmap_generation;
+    const cata::mdarray<float, point_bub_ms> &transparency_cache = map_cache.transparency_cache;
+    for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
+        for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
+            const point_bub_ms sm_offset = coords::project_to<coords::ms>( point_bub_sm( smx, smy ) );
+            bool changed = false;
+            for( int x = sm_offset.x(); x < sm_offset.x() + SEEX; ++x ) {
+                const float *current = &transparency_cache[x][sm_offset.y()];
+                float *previous = &map_cache.lightmap_transparency[x][sm_offset.y()];
+                if( !std::equal( current, current + SEEY, previous ) ) {
+                    std::copy( current, current + SEEY, previous );
+                    changed = true;
+                }
+            }
+            if( changed ) {
+                map_cache.lightmap_transparency_changed[smx * MAPSIZE + smy] = generation;
+            }
+        }
+    }
+
+    // Light only matters where something looks at it: the tiles the player sees, directly or
+    // through cameras, and the tiles of creatures, which check how lit they and their targets
+    // are.  Sources whose light can't reach any submap with such a tile aren't cast at all.
+    // relevant_submaps counts those submaps in the rectangle from the origin to each corner.
+    std::array<std::array<int, MAPSIZE + 1>, MAPSIZE + 1> relevant_submaps = {};
+    {
+        std::array<std::bitset<MAPSIZE>, MAPSIZE> relevant;
+        for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
+            for( int smy = 0; smy < my_MAPSIZE && !relevant[smx][smy]; ++smy ) {
+                for( int x = smx * SEEX; x < ( smx + 1 ) * SEEX && !relevant[smx][smy]; ++x ) {
+                    for( int y = smy * SEEY; y < ( smy + 1 ) * SEEY; ++y ) {
+                        if( map_cache.seen_cache[x][y] > LIGHT_TRANSPARENCY_SOLID ||
+                            map_cache.camera_cache[x][y] > LIGHT_TRANSPARENCY_SOLID ) {
+                            relevant[smx][smy] = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        const auto add_creature = [&]( const Creature & critter ) {
+            const tripoint_bub_ms pos = critter.pos_bub();
+            if( pos.z() == zlev && inbounds( pos ) ) {
+                relevant[pos.x() / SEEX][pos.y() / SEEY] = true;
+            }
+        };
+        add_creature( get_player_character() );
+        for( const npc &guy : g->all_npcs() ) {
+            add_creature( guy );
+        }
+        for( const monster &critter : g->all_monsters() ) {
+            add_creature( critter );
+        }
+        for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
+            for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
+                relevant_submaps[smx + 1][smy + 1] = relevant_submaps[smx][smy + 1] +
+                                                     relevant_submaps[smx + 1][smy] - relevant_submaps[smx][smy] +
+                                                     ( relevant[smx][smy] ? 1 : 0 );
+            }
+        }
+    }
+    // Inclusive bounds of the tiles some light can reach, clamped to the lightmap
+    const auto light_bounds = []( const point_bub_ms & p, float luminance ) {
+        const int reach = light_reach( luminance );
+        return std::make_pair(
+                   point_bub_ms( std::max( p.x() - reach, 0 ), std::max( p.y() - reach, 0 ) ),
+                   point_bub_ms( std::min( p.x() + reach, LIGHTMAP_CACHE_X - 1 ),
+                                 std::min( p.y() + reach, LIGHTMAP_CACHE_Y - 1 ) ) );
+    };
+    const auto reaches_relevant_submap = [&]( const point_bub_ms & from, const point_bub_ms & to ) {
+        const point_bub_sm sm_from = coords::project_to<coords::sm>( from );
+        const point_bub_sm sm_to = coords::project_to<coords::sm>( to ) + point::south_east;
+        return relevant_submaps[sm_to.x()][sm_to.y()] - relevant_submaps[sm_from.x()][sm_to.y()] -
+               relevant_submaps[sm_to.x()][sm_from.y()] + relevant_submaps[sm_from.x()][sm_from.y()] > 0;
+    };
+    const auto source_is_relevant = [&]( const point_bub_ms & p, float luminance ) {
+        const std::pair<point_bub_ms, point_bub_ms> bounds = light_bounds( p, luminance );
+        if( reaches_relevant_submap( bounds.first, bounds.second ) ) {
+            return true;
+        }
+        turn_counters::add( turn_counter::light_sources_culled, 1 );
+        return false;
+    };
+
     constexpr std::array<int, 4> dir_x = { {  0, -1, 1, 0 } };    //    [0]
     constexpr std::array<int, 4> dir_y = { { -1,  0, 0, 1 } };    // [1][X][2]
     constexpr std::array<int, 4> dir_d = { { 90, 0, 180, 270 } }; //    [3]
@@ -484,14 +652,17 @@ void map::generate_lightmap( const int zlev )
     }
 
     std::vector<std::pair<tripoint_bub_ms, float>> lm_override;
+    std::vector<std::pair<point_bub_ms, float>> static_sources;
     // Traverse the submaps in order
     for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
         for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
             const submap *cur_submap = get_submap_at_grid( tripoint_rel_sm{ smx, smy, zlev } );
             if( cur_submap == nullptr ) {
                 debugmsg( "Tried to generate lightmap at (%d,%d,%d) but the submap is not loaded", smx, smy, zlev );
+                map_cache.static_lights[smx * MAPSIZE + smy] = submap_static_light();
                 continue;
             }
+            static_sources.clear();
 
             for( int sx = 0; sx < SEEX; ++sx ) {
                 for( int sy = 0; sy < SEEY; ++sy ) {
@@ -524,12 +695,13 @@ void map::generate_lightmap( const int zlev )
                     }
 
                     const ter_id &terrain = cur_submap->get_ter( { sx, sy } );
-                    if( terrain->light_emitted > 0 ) {
-                        add_light_source( p, terrain->light_emitted );
-                    }
                     const furn_id &furniture = cur_submap->get_furn( {sx, sy } );
-                    if( furniture->light_emitted > 0 ) {
-                        add_light_source( p, furniture->light_emitted );
+                    const int static_luminance = std::max( terrain->light_emitted,
+                                                           furniture->light_emitted );
+                    if( static_luminance > 0 ) {
+                        add_light_source( p, static_luminance );
+                        scratch.sources[p.x()][p.y()] = static_luminance;
+                        static_sources.emplace_back( p.xy(), static_luminance );
                     }
 
                     for( const auto &fld : cur_submap->get_field( { sx, sy } ) ) {
@@ -545,6 +717,12 @@ void map::generate_lightmap( const int zlev )
                     }
                 }
             }
+
+            submap_static_light &static_light = map_cache.static_lights[smx * MAPSIZE + smy];
+            if( static_light.sources != static_sources ) {
+                static_light.sources = static_sources;
+                static_light.cast_generation = -1;
+            }
         }
     }
 
@@ -554,7 +732,7 @@ void map::generate_lightmap( const int zlev )
         }
         const tripoint_bub_ms mp = critter.pos_bub();
         if( inbounds( mp ) ) {
-            if( critter.has_effect( effect_onfire ) ) {
+            if( critter.has_effect( effect_onfire ) && source_is_relevant( mp.xy(), 8 ) ) {
                 apply_light_source( mp, 8 );
             }
             // TODO: [lightmap] Attach natural light brightness to creatures
@@ -562,7 +740,7 @@ void map::generate_lightmap( const int zlev )
             // TODO: [lightmap] Allow creatures to have facing and arc lights
             float critter_luminance = critter.calculate_by_enchantment( critter.type->luminance,
                                       enchant_vals::mod::LUMINATION, true );
-            if( critter_luminance > 0 ) {
+            if( critter_luminance > 0 && source_is_relevant( mp.xy(), critter_luminance ) ) {
                 apply_light_source( mp, critter_luminance );
             }
         }
@@ -654,8 +832,86 @@ void map::generate_lightmap( const int zlev )
     const tripoint_bub_ms cache_start( 0, 0, zlev );
     const tripoint_bub_ms cache_end( LIGHTMAP_CACHE_X, LIGHTMAP_CACHE_Y, zlev );
     for( const tripoint_bub_ms &p : points_in_rectangle( cache_start, cache_end ) ) {
-        if( light_source_buffer[p.x()][p.y()] > 0.0 ) {
-            apply_light_source( p, light_source_buffer[p.x()][p.y()] );
+        // Static sources are handled below, unless something brighter shares their tile
+        const float luminance = light_source_buffer[p.x()][p.y()];
+        if( luminance > scratch.sources[p.x()][p.y()] && source_is_relevant( p.xy(), luminance ) ) {
+            apply_light_source( p, luminance );
+        }
+    }
+
+    /* Terrain and furniture that emit light rarely change, and neither does the transparency
+      around them, so the light they cast is kept per submap between calls.  Each submap's
+      sources are cast on their own, only skipping directions covered by each other, and
+      then merged into the lightmap.  That gives up to a little more light along the edges
+      of the submap than casting everything together would, never less.
+    */
+    for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
+        for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
+            submap_static_light &static_light = map_cache.static_lights[smx * MAPSIZE + smy];
+            if( static_light.sources.empty() ) {
+                continue;
+            }
+            point_bub_ms from( LIGHTMAP_CACHE_X, LIGHTMAP_CACHE_Y );
+            point_bub_ms to( -1, -1 );
+            for( const std::pair<point_bub_ms, float> &source : static_light.sources ) {
+                const std::pair<point_bub_ms, point_bub_ms> bounds =
+                    light_bounds( source.first, source.second );
+                from = point_bub_ms( std::min( from.x(), bounds.first.x() ),
+                                     std::min( from.y(), bounds.first.y() ) );
+                to = point_bub_ms( std::max( to.x(), bounds.second.x() ),
+                                   std::max( to.y(), bounds.second.y() ) );
+            }
+            if( !reaches_relevant_submap( from, to ) ) {
+                turn_counters::add( turn_counter::light_sources_culled, static_light.sources.size() );
+                continue;
+            }
+
+            bool changed = static_light.cast_generation < 0;
+            const point_bub_sm sm_from = coords::project_to<coords::sm>( from );
+            const point_bub_sm sm_to = coords::project_to<coords::sm>( to );
+            for( int x = sm_from.x(); x <= sm_to.x() && !changed; ++x ) {
+                for( int y = sm_from.y(); y <= sm_to.y(); ++y ) {
+                    if( map_cache.lightmap_transparency_changed[x * MAPSIZE + y] >
+                        static_light.cast_generation ) {
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+            if( changed ) {
+                for( const std::pair<point_bub_ms, float> &source : static_light.sources ) {
+                    scratch.submap_sources[source.first.x()][source.first.y()] = source.second;
+                }
+                for( const std::pair<point_bub_ms, float> &source : static_light.sources ) {
+                    apply_light_source( tripoint_bub_ms( source.first, zlev ), source.second, scratch.lm,
+                                        scratch.submap_sources );
+                }
+                static_light.lit.clear();
+                for( int x = from.x(); x <= to.x(); ++x ) {
+                    for( int y = from.y(); y <= to.y(); ++y ) {
+                        four_quadrants &lit = scratch.lm[x][y];
+                        if( lit.max() > 0.0f ) {
+                            static_light.lit.emplace_back( point_bub_ms( x, y ), lit );
+                            lit = four_quadrants();
+                        }
+                    }
+                }
+                for( const std::pair<point_bub_ms, float> &source : static_light.sources ) {
+                    scratch.submap_sources[source.first.x()][source.first.y()] = 0.0f;
+                }
+                static_light.cast_generation = generation;
+                turn_counters::add( turn_counter::static_lights_cast, 1 );
+            } else {
+                turn_counters::add( turn_counter::static_lights_reused, 1 );
+            }
+            for( const std::pair<point_bub_ms, four_quadrants> &lit : static_light.lit ) {
+                lm[lit.first.x()][lit.first.y()] = elementwise_max( lm[lit.first.x()][lit.first.y()],
+                                                   lit.second );
+            }
+            for( const std::pair<point_bub_ms, float> &source : static_light.sources ) {
+                sm[source.first.x()][source.first.y()] = std::max( sm[source.first.x()][source.first.y()],
+                        source.second );
+            }
         }
     }
     for( const std::pair<tripoint_bub_ms, float> &elem : lm_override ) {
@@ -908,6 +1164,10 @@ void castLight( cata::mdarray<Out, point_bub_ms> &output_cache,
     }
     T last_intensity( 0.0 );
     tripoint delta;
+    // The distance and cumulative transparency rarely change along a row, so
+    // don't recalculate the intensity for every tile.
+    T intensity_value( 0.0 );
+    int intensity_dist = -1;
     for( int distance = row; distance <= radius; distance++ ) {
         delta.y = -distance;
         bool started_row = false;
@@ -935,7 +1195,11 @@ void castLight( cata::mdarray<Out, point_bub_ms> &output_cache,
             }
 
             const int dist = rl_dist( tripoint::zero, delta ) + offsetDistance;
-            last_intensity = calc( numerator, cumulative_transparency, dist );
+            if( dist != intensity_dist ) {
+                intensity_value = calc( numerator, cumulative_transparency, dist );
+                intensity_dist = dist;
+            }
+            last_intensity = intensity_value;
 
             T new_transparency = input_array[ current.x ][ current.y ];
 
@@ -948,6 +1212,46 @@ void castLight( cata::mdarray<Out, point_bub_ms> &output_cache,
 
             if( new_transparency == current_transparency ) {
                 newStart = leadingEdge;
+                if constexpr( xx == 0 && std::is_same_v<T, float> ) {
+                    // This row runs along a column of the caches, so the tiles that follow
+                    // with the same transparency can be lit in one go, unless trigdist
+                    // makes the distance change along the row.
+                    if( !trigdist ) {
+                        int limit = 0;
+                        while( delta.x + limit < 0 &&
+                               current.y + ( limit + 1 ) * yx >= 0 && current.y + ( limit + 1 ) * yx < MAPSIZE_Y &&
+                               !( end > ( delta.x + limit + 1 - 0.5f ) / ( delta.y + 0.5f ) ) ) {
+                            ++limit;
+                        }
+                        int run = 0;
+                        if( limit > 0 ) {
+                            // Only formed here, at the edge of the map the next tile is outside it.
+                            const float *input = &input_array[current.x][current.y + yx];
+                            const float t = current_transparency;
+                            run = yx > 0 ? shadowcasting_simd::equal_run( input, limit, t ) :
+                                  shadowcasting_simd::equal_run_reverse( input, limit, t );
+                        }
+                        const quadrant run_quadrant = check( current_transparency, last_intensity ) ?
+                                                      quadrant::default_ : quad;
+                        bool raised = false;
+                        if constexpr( std::is_same_v<Out, float> ) {
+                            if( update_output == update_light && run > 0 ) {
+                                float *output = &output_cache[current.x][current.y];
+                                shadowcasting_simd::raise_to( yx > 0 ? output + 1 : output - run, run,
+                                                              last_intensity );
+                                raised = true;
+                            }
+                        }
+                        for( int i = 1; !raised && i <= run; ++i ) {
+                            update_output( output_cache[current.x][current.y + i * yx], last_intensity,
+                                           run_quadrant );
+                        }
+                        if( run > 0 ) {
+                            delta.x += run;
+                            newStart = ( delta.x + 0.5f ) / ( delta.y - 0.5f );
+                        }
+                    }
+                }
                 continue;
             }
             // Only cast recursively if previous span was not opaque.
@@ -978,6 +1282,7 @@ void castLight( cata::mdarray<Out, point_bub_ms> &output_cache,
         }
         // Cumulative average of the transparency values encountered.
         cumulative_transparency = accumulate( cumulative_transparency, current_transparency, distance );
+        intensity_dist = -1;
     }
 }
 
@@ -1039,6 +1344,7 @@ castLightAll<fragment_cloud, fragment_cloud, shrapnel_calc, shrapnel_check,
 void map::build_seen_cache( const tripoint_bub_ms &origin, const int target_z, int extension_range,
                             bool cumulative, bool camera, int penalty )
 {
+    CATA_PROFILE_ZONE( "map::build_seen_cache" );
     level_cache &map_cache = get_cache( target_z );
     using mdarray = cata::mdarray<float, point_bub_ms>;
     mdarray &transparency_cache = map_cache.vision_transparency_cache;
@@ -1079,9 +1385,17 @@ void map::build_seen_cache( const tripoint_bub_ms &origin, const int target_z, i
     cast_zlight<float, sight_calc, sight_check, accumulate_transparency>(
         seen_caches, transparency_caches, floor_caches, origin, penalty, 1.0,
         directions_to_cast );
-    seen_cache_process_ledges( seen_caches, floor_caches, std::nullopt );
+    if( camera ) {
+        seen_cache_process_ledges( seen_caches, floor_caches, std::nullopt );
+    } else {
+        seen_cache_ledges.clear();
+        seen_cache_process_ledges( seen_caches, floor_caches, std::nullopt, &seen_cache_ledges );
+        turn_counters::add( turn_counter::seen_cache_rebuilds, 1 );
+        turn_counters::add( turn_counter::seen_cache_tiles, map_dimensions * OVERMAP_LAYERS );
+    }
 
     const optional_vpart_position vp = veh_at( origin );
+    seen_cache_patchable = !camera && !cumulative && penalty == 0 && !vp;
     if( !vp ) {
         return;
     }
@@ -1147,9 +1461,75 @@ void map::build_seen_cache( const tripoint_bub_ms &origin, const int target_z, i
     }
 }
 
+bool map::update_seen_cache( const tripoint_bub_ms &origin )
+{
+    if( !seen_cache_patchable ) {
+        return false;
+    }
+    zlight_segments changed;
+    for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; z++ ) {
+        const level_cache &cur_cache = get_cache( z );
+        for( const point_bub_ms &p : cur_cache.vision_transparency_changes ) {
+            // Tiles no ray reached can't have blocked any either.  Below the origin,
+            // reached tiles may have been hidden by ledges afterwards, so assume they were reached.
+            if( z >= origin.z() && cur_cache.seen_cache[p.x()][p.y()] == 0.0f &&
+                cur_cache.camera_cache[p.x()][p.y()] == 0.0f ) {
+                continue;
+            }
+            changed |= zlight_segments_containing( tripoint_bub_ms( p, z ) - origin );
+        }
+    }
+    if( changed.none() ) {
+        return true;
+    }
+    // Tiles shared with neighbouring segments get the best of all of them,
+    // so those have to be cast again too.
+    const zlight_segments recast = zlight_segments_overlapping( changed );
+    if( recast.all() ) {
+        return false;
+    }
+    CATA_PROFILE_ZONE( "map::update_seen_cache" );
+
+    array_of_grids_of<const float> transparency_caches;
+    array_of_grids_of<float> seen_caches;
+    array_of_grids_of<const bool> floor_caches;
+    vertical_direction directions_to_cast = vertical_direction::BOTH;
+    for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; z++ ) {
+        level_cache &cur_cache = get_cache( z );
+        transparency_caches[z + OVERMAP_DEPTH] = &cur_cache.vision_transparency_cache;
+        seen_caches[z + OVERMAP_DEPTH] = &cur_cache.seen_cache;
+        floor_caches[z + OVERMAP_DEPTH] = &cur_cache.floor_cache;
+        if( origin.z() == z && cur_cache.no_floor_gaps ) {
+            directions_to_cast = vertical_direction::UP;
+        }
+    }
+
+    // Bring back what the cast saw before ledges hid it, so that the tiles
+    // outside of the changed segments are exactly as the cast left them.
+    for( const std::pair<tripoint_bub_ms, float> &hidden : seen_cache_ledges ) {
+        const tripoint_bub_ms &p = hidden.first;
+        ( *seen_caches[p.z() + OVERMAP_DEPTH] )[p.x()][p.y()] = hidden.second;
+    }
+    // Casting only ever raises values, so the changed segments start over.
+    // The others can't have been affected, and casting them again over their
+    // own result changes nothing.
+    const int tiles = reset_zlight_segments( seen_caches, origin, 0, changed,
+                      LIGHT_TRANSPARENCY_SOLID );
+    cast_zlight<float, sight_calc, sight_check, accumulate_transparency>(
+        seen_caches, transparency_caches, floor_caches, origin, 0, 1.0,
+        directions_to_cast, recast );
+    seen_cache_ledges.clear();
+    seen_cache_process_ledges( seen_caches, floor_caches, std::nullopt, &seen_cache_ledges );
+
+    turn_counters::add( turn_counter::seen_cache_updates, 1 );
+    turn_counters::add( turn_counter::seen_cache_tiles, tiles );
+    return true;
+}
+
 void map::seen_cache_process_ledges( array_of_grids_of<float> &seen_caches,
                                      const array_of_grids_of<const bool> &floor_caches,
-                                     const std::optional<tripoint_bub_ms> &override_p ) const
+                                     const std::optional<tripoint_bub_ms> &override_p,
+                                     std::vector<std::pair<tripoint_bub_ms, float>> *hidden ) const
 {
     Character &player_character = get_player_character();
     // If override is not given, use player character for calculations
@@ -1173,6 +1553,10 @@ void map::seen_cache_process_ledges( array_of_grids_of<float> &seen_caches,
                             // In which case check if it should be obscured by a ledge
                             if( override_p ? ledge_coverage( origin, p ) > 100 : ledge_coverage( player_character,
                                     p ) > 100 ) {
+                                if( hidden != nullptr ) {
+                                    hidden->emplace_back( p,
+                                                          ( *seen_caches[cache_z] )[p.x()][p.y()] );
+                                }
                                 ( *seen_caches[cache_z] )[p.x()][p.y()] = 0.0f;
                             }
                             break;
@@ -1217,12 +1601,17 @@ static bool light_check( const float &transparency, const float &intensity )
 void map::apply_light_source( const tripoint_bub_ms &p, float luminance )
 {
     level_cache &cache = get_cache( p.z() );
-    cata::mdarray<four_quadrants, point_bub_ms> &lm = cache.lm;
+    apply_light_source( p, luminance, cache.lm, cache.light_source_buffer );
+}
+
+void map::apply_light_source( const tripoint_bub_ms &p, float luminance,
+                              cata::mdarray<four_quadrants, point_bub_ms> &lm,
+                              const cata::mdarray<float, point_bub_ms> &light_source_buffer )
+{
+    level_cache &cache = get_cache( p.z() );
     cata::mdarray<float, point_bub_ms> &sm = cache.sm;
     cata::mdarray<float, point_bub_ms> &transparency_cache =
         cache.transparency_cache;
-    cata::mdarray<float, point_bub_ms> &light_source_buffer =
-        cache.light_source_buffer;
 
     const point_bub_ms p2( p.xy() );
 
@@ -9,6 +9,7 @@
 // IWYU pragma: no_include <sys/signal.h>
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <clocale>
 #include <cstdio>
 #include <cstdlib>
@@ -54,6 +55,7 @@
 #include "ordered_static_globals.h"
 #include "output.h"
 #include "path_info.h"
+#include "perf.h"
 #include "rng.h"
 #include "system_locale.h"
 #include "translations.h"
@@ -334,6 +336,21 @@ cli_opts parse_commandline( int argc, const char **argv )
                     return 0;
                 }
             },
+            {
+                "--profile-slow-turns", "<milliseconds>",
+                "Records profiling zones and writes a Chrome trace of every turn slower than this to the user directory",
+                section_default,
+                1,
+                []( int, const char **params ) -> int {
+                    const int threshold = std::atoi( params[0] );
+                    if( threshold <= 0 ) {
+                        return -1;
+                    }
+                    cata_profiler::set_slow_turn_threshold( std::chrono::milliseconds( threshold ) );
+                    cata_profiler::set_enabled( true );
+                    return 1;
+                }
+            },
             {
                 "--world", "<name>",
                 "Load world",
@@ -80,6 +80,7 @@
 #include "overmap.h"
 #include "overmapbuffer.h"
 #include "pathfinding.h"
+#include "perf.h"
 #include "pocket_type.h"
 #include "projectile.h"
 #include "ranged.h"
@@ -476,6 +477,7 @@ void map::add_vehicle_to_cache( vehicle *veh )
     }
 
     // Get parts
+    std::map<int, inclusive_rectangle<point_bub_ms>> footprints;
     for( const vpart_reference &vpr : veh->get_all_parts_with_fakes() ) {
         if( vpr.part().removed ) {
             continue;
@@ -487,7 +489,24 @@ void map::add_vehicle_to_cache( vehicle *veh )
             ch.set_veh_exists_at( p, true );
             set_transparency_cache_dirty( p );
         }
+        const auto footprint = footprints.emplace( p.z(), inclusive_rectangle<point_bub_ms>( p.xy(),
+                               p.xy() ) );
+        inclusive_rectangle<point_bub_ms> &area = footprint.first->second;
+        area.p_min = point_bub_ms( std::min( area.p_min.x(), p.x() ),
+                               std::min( area.p_min.y(), p.y() ) );
+        area.p_max = point_bub_ms( std::max( area.p_max.x(), p.x() ),
+                               std::max( area.p_max.y(), p.y() ) );
     }
+    for( const std::pair<const int, inclusive_rectangle<point_bub_ms>> &footprint : footprints ) {
+        get_cache( footprint.first ).set_veh_footprint( *veh, footprint.second );
+    }
+}
+
+bool map::other_vehicle_within( const vehicle &veh, int z,
+                                const inclusive_rectangle<point_bub_ms> &area ) const
+{
+    const level_cache *ch = get_cache_lazy( z );
+    return ch != nullptr && ch->other_veh_footprint_overlaps( area, &veh );
 }
 
 void map::clear_vehicle_point_from_cache( vehicle *veh, const tripoint_bub_ms &pt )
@@ -523,6 +542,7 @@ void map::remove_vehicle_from_cache( vehicle *veh, int zmin, int zmax )
         if( ch != nullptr ) {
             ch->vehicle_list.erase( veh );
             ch->zone_vehicles.erase( veh );
+            ch->clear_veh_footprint( veh );
         }
         dirty_vehicle_list.erase( veh );
     }
@@ -595,6 +615,7 @@ std::unique_ptr<vehicle> map::detach_vehicle( vehicle *veh )
         z = veh->sm_pos.z() = abs_sub.z();
     }
 
+    vehicle::invalidate_power_grids();
     // Unboard all passengers before detaching
     for( const vpart_reference &part : veh->get_avail_parts( VPFLAG_BOARDABLE ) ) {
         Character *passenger = part.get_passenger();
@@ -750,7 +771,22 @@ bool map::vehproceed( VehicleList &vehicle_list )
 
     cur_veh->v = cur_veh->v->act_on_map( *this );
     if( cur_veh->v == nullptr ) {
-        vehicle_list = get_vehicles();
+        // A collision may have destroyed or split vehicles. The level caches know the ones
+        // left, without visiting every submap like get_vehicles() does.
+        vehicle_list.clear();
+        const int minz = zlevels ? -OVERMAP_DEPTH : abs_sub.z();
+        const int maxz = zlevels ? OVERMAP_HEIGHT : abs_sub.z();
+        for( int zlev = minz; zlev <= maxz; ++zlev ) {
+            const level_cache *cache = get_cache_lazy( zlev );
+            if( !cache ) {
+                continue;
+            }
+            for( vehicle *veh : cache->vehicle_list ) {
+                wrapped_vehicle w;
+                w.v = veh;
+                vehicle_list.push_back( w );
+            }
+        }
     }
 
     return true;
@@ -1486,6 +1522,10 @@ bool map::displace_vehicle( vehicle &veh, const tripoint_rel_ms &dp, const bool
         return true;
     }
     std::set<int> smzs;
+    // Cables now lead to other tiles of the vehicle, or to other vehicles.
+    if( veh.has_power_transfer() ) {
+        vehicle::invalidate_power_grids();
+    }
 
     // first, let's find our position in current vehicles vector
     size_t our_i = 0;
@@ -1813,7 +1853,6 @@ bool map::furn_set( const tripoint_bub_ms &p, const furn_id &new_furniture, cons
         old_f.has_flag( ter_furn_flag::TFLAG_TRANSLUCENT ) != new_f.has_flag(
             ter_furn_flag::TFLAG_TRANSLUCENT ) ) {
         set_transparency_cache_dirty( p );
-        set_seen_cache_dirty( p );
     }
 
     if( old_f.has_flag( ter_furn_flag::TFLAG_INDOORS ) != new_f.has_flag(
@@ -2259,7 +2298,6 @@ bool map::ter_set( const tripoint_bub_ms &p, const ter_id &new_terrain, bool avo
         old_t.has_flag( ter_furn_flag::TFLAG_TRANSLUCENT ) != new_t.has_flag(
             ter_furn_flag::TFLAG_TRANSLUCENT ) ) {
         set_transparency_cache_dirty( p );
-        set_seen_cache_dirty( p );
     }
 
     if( old_t.has_flag( ter_furn_flag::TFLAG_INDOORS ) != new_t.has_flag(
@@ -3456,33 +3494,30 @@ void map::decay_fields_and_scent( const time_duration &amount )
                 continue;
             }
 
-            for( int sx = 0; sx < SEEX; ++sx ) {
+            cur_submap->field_tiles().for_each( [&]( const point_sm_ms & tile ) {
                 if( to_proc < 1 ) {
                     // This submap had some fields, but all got proc'd already
-                    break;
+                    return;
                 }
+                const point p( tile.x() + smx * SEEX, tile.y() + smy * SEEY );
 
-                for( int sy = 0; sy < SEEY; ++sy ) {
-                    const point p( sx + smx * SEEX, sy + smy * SEEY );
-
-                    const field &fields = cur_submap->get_field( { sx, sy} );
-                    if( !outside_cache[p.x][p.y] ) {
-                        to_proc -= fields.field_count();
-                        continue;
-                    }
+                const field &fields = cur_submap->get_field( tile );
+                if( !outside_cache[p.x][p.y] ) {
+                    to_proc -= fields.field_count();
+                    return;
+                }
 
-                    for( const auto &fp : fields ) {
-                        to_proc--;
-                        field_entry cur = fp.second;
-                        const field_type_id type = cur.get_field_type();
-                        const int decay_amount_factor =  type.obj().decay_amount_factor;
-                        if( decay_amount_factor != 0 ) {
-                            const time_duration decay_amount = amount / decay_amount_factor;
-                            cur.set_field_age( cur.get_field_age() + decay_amount );
-                        }
+                for( const auto &fp : fields ) {
+                    to_proc--;
+                    field_entry cur = fp.second;
+                    const field_type_id type = cur.get_field_type();
+                    const int decay_amount_factor =  type.obj().decay_amount_factor;
+                    if( decay_amount_factor != 0 ) {
+                        const time_duration decay_amount = amount / decay_amount_factor;
+                        cur.set_field_age( cur.get_field_age() + decay_amount );
                     }
                 }
-            }
+            } );
 
             if( to_proc > 0 ) {
                 cur_submap->field_count = cur_submap->field_count - to_proc;
@@ -5670,7 +5705,7 @@ std::vector<item_reference> map::item_network_connections( vehicle *power_grid )
         tripoint_abs_sm const abs_pos = iter;
         const tripoint_rel_sm local_pos = abs_pos - abs_sub.xy();
         submap *const current_submap = get_submap_at_grid( local_pos );
-        std::vector<item_reference> active_items = current_submap->active_items.get_for_processing();
+        std::vector<item_reference> active_items = current_submap->active_items.get();
         for( item_reference &active_item_ref : active_items ) {
             if( !active_item_ref.item_ref ) {
                 continue;
@@ -6534,6 +6569,7 @@ bool map::add_field( const tripoint_bub_ms &p, const field_type_id &type_id, int
             get_cache( p.z() ).field_cache.set(
                 static_cast<size_t>( p.x() / SEEX ) + ( ( p.y() / SEEX ) * MAPSIZE ) );
         }
+        current_submap->field_tiles().insert( l );
     }
 
     if( hit_player ) {
@@ -6595,7 +6631,6 @@ void map::on_field_modified( const tripoint_bub_ms &p, const field_type &fd_type
     // Dirty the transparency cache now that field processing doesn't always do it
     if( fd_type.dirty_transparency_cache || !fd_type.is_transparent() ) {
         set_transparency_cache_dirty( p, true );
-        set_seen_cache_dirty( p );
     }
 
     if( fd_type.is_dangerous() ) {
@@ -6729,6 +6764,7 @@ void map::update_submaps_with_active_items()
 
 void map::update_visibility_cache( const int zlev )
 {
+    CATA_PROFILE_ZONE( "map::update_visibility_cache" );
     Character &player_character = get_player_character();
     const tripoint_bub_ms pos = player_character.pos_bub( *this );
 
@@ -8640,43 +8676,42 @@ void map::actualize( const tripoint_rel_sm &grid )
     process_items_in_vehicles( *tmpsub );
     process_items_in_submap( *tmpsub, grid );
     explosion_handler::process_explosions();
-    for( int x = 0; x < SEEX; x++ ) {
-        for( int y = 0; y < SEEY; y++ ) {
-            const tripoint_bub_ms pnt =  rebase_bub( coords::project_to<coords::ms>( grid ) + point( x, y ) );
-            const point_sm_ms p( x, y );
-            const furn_t &furn = *this->furn( pnt );
-            const ter_t &terr = *this->ter( pnt );
-            if( !furn.emissions.empty() ) {
-                field_furn_locs.push_back( pnt );
-            }
-            if( !terr.emissions.empty() ) {
-                field_ter_locs.push_back( pnt );
-            }
+    // Only tiles with something to catch up on, a handful even in towns. Each tile only
+    // changes itself, so the set can be taken up front.
+    tmpsub->tiles_to_actualize().for_each( [&]( const point_sm_ms & p ) {
+        const tripoint_bub_ms pnt = rebase_bub( coords::project_to<coords::ms>( grid ) + p.raw() );
+        const furn_t &furn = *this->furn( pnt );
+        const ter_t &terr = *this->ter( pnt );
+        if( !furn.emissions.empty() ) {
+            field_furn_locs.push_back( pnt );
+        }
+        if( !terr.emissions.empty() ) {
+            field_ter_locs.push_back( pnt );
+        }
 
-            const trap_id trap_here = tmpsub->get_trap( p );
-            if( trap_here != tr_null ) {
-                traplocs[trap_here.to_i()].push_back( pnt );
-            }
-            const ter_t &ter = tmpsub->get_ter( p ).obj();
-            if( ter.trap != tr_null ) {
-                traplocs[ter.trap.to_i()].push_back( pnt );
-            }
+        const trap_id trap_here = tmpsub->get_trap( p );
+        if( trap_here != tr_null ) {
+            traplocs[trap_here.to_i()].push_back( pnt );
+        }
+        const ter_t &ter = tmpsub->get_ter( p ).obj();
+        if( ter.trap != tr_null ) {
+            traplocs[ter.trap.to_i()].push_back( pnt );
+        }
 
-            if( do_funnels ) {
-                fill_funnels( pnt, tmpsub->last_touched );
-            }
+        if( do_funnels ) {
+            fill_funnels( pnt, tmpsub->last_touched );
+        }
 
-            grow_plant( pnt );
+        grow_plant( pnt );
 
-            restock_fruits( pnt, time_since_last_actualize );
+        restock_fruits( pnt, time_since_last_actualize );
 
-            produce_sap( pnt, time_since_last_actualize );
+        produce_sap( pnt, time_since_last_actualize );
 
-            rad_scorch( pnt, time_since_last_actualize );
+        rad_scorch( pnt, time_since_last_actualize );
 
-            decay_cosmetic_fields( pnt, time_since_last_actualize );
-        }
-    }
+        decay_cosmetic_fields( pnt, time_since_last_actualize );
+    } );
 
     // the last time we touched the submap, is right now.
     tmpsub->last_touched = calendar::turn;
@@ -9251,6 +9286,7 @@ int map::determine_wall_corner( const tripoint_bub_ms &p ) const
 
 void map::build_outside_cache( const int zlev )
 {
+    CATA_PROFILE_ZONE( "map::build_outside_cache" );
     auto *ch_lazy = get_cache_lazy( zlev );
     if( !ch_lazy || !ch_lazy->outside_cache_dirty ) {
         return;
@@ -9311,6 +9347,7 @@ void map::build_obstacle_cache(
     const tripoint_bub_ms &start, const tripoint_bub_ms &end,
     cata::mdarray<fragment_cloud, point_bub_ms> &obstacle_cache )
 {
+    CATA_PROFILE_ZONE( "map::build_obstacle_cache" );
     const point_sm_ms min_submap{ std::max( 0, start.x() / SEEX ), std::max( 0, start.y() / SEEY ) };
     const point_sm_ms max_submap{
         std::min( my_MAPSIZE - 1, end.x() / SEEX ), std::min( my_MAPSIZE - 1, end.y() / SEEY ) };
@@ -9408,6 +9445,7 @@ std::bitset<OVERMAP_LAYERS> map::get_inter_level_visibility( const int origin_zl
 
 bool map::build_floor_cache( const int zlev )
 {
+    CATA_PROFILE_ZONE( "map::build_floor_cache" );
     auto *ch_lazy = get_cache_lazy( zlev );
     if( !ch_lazy || !ch_lazy->floor_cache_dirty ) {
         return false;
@@ -9465,6 +9503,7 @@ bool map::build_floor_cache( const int zlev )
 
 void map::build_floor_caches()
 {
+    CATA_PROFILE_ZONE( "map::build_floor_caches" );
     const int minz = zlevels ? -OVERMAP_DEPTH : abs_sub.z();
     const int maxz = zlevels ? OVERMAP_HEIGHT : abs_sub.z();
     for( int z = minz; z <= maxz; z++ ) {
@@ -9540,6 +9579,7 @@ void map::do_vehicle_caching( int z )
 
 void map::build_map_cache( const int zlev, bool skip_lightmap )
 {
+    CATA_PROFILE_ZONE( "map::build_map_cache" );
     const int minz = zlevels ? -OVERMAP_DEPTH : zlev;
     const int maxz = zlevels ? OVERMAP_HEIGHT : zlev;
     bool seen_cache_dirty = false;
@@ -9556,11 +9596,16 @@ void map::build_map_cache( const int zlev, bool skip_lightmap )
     for( int z = minz; z <= maxz; z++ ) {
         do_vehicle_caching( z );
     }
+    bool vision_transparency_changed = false;
     for( int z = minz; z <= maxz; z++ ) {
-        seen_cache_dirty |= build_vision_transparency_cache( z );
+        vision_transparency_changed |= build_vision_transparency_cache( z );
+    }
+    for( int z = minz; z <= maxz; z++ ) {
+        // Too many changes to patch the seen cache
+        seen_cache_dirty |= get_cache( z ).seen_cache_dirty;
     }
 
-    if( seen_cache_dirty ) {
+    if( seen_cache_dirty || vision_transparency_changed ) {
         skew_vision_cache.clear();
         skew_vision_wo_fields_cache.clear();
     }
@@ -9576,6 +9621,15 @@ void map::build_map_cache( const int zlev, bool skip_lightmap )
     static tripoint_abs_ms player_prev_pos;
     static int player_prev_range( 0 );
     seen_cache_dirty |= player_prev_pos != p || sr != player_prev_range || camera_cache_dirty;
+    bool seen_cache_patched = false;
+    if( !seen_cache_dirty && vision_transparency_changed ) {
+        // Only a few tiles changed, so try to recast only the part of the view they affect
+        seen_cache_patched = mcache.empty() && inbounds( p ) && update_seen_cache( get_bub( p ) );
+        seen_cache_dirty = !seen_cache_patched;
+    }
+    for( int z = minz; z <= maxz; z++ ) {
+        get_cache( z ).vision_transparency_changes.clear();
+    }
     if( seen_cache_dirty ) {
         if( inbounds( p ) ) {
             build_seen_cache( get_bub( p ), zlev, sr );
@@ -9583,6 +9637,8 @@ void map::build_map_cache( const int zlev, bool skip_lightmap )
         player_prev_pos = p;
         player_prev_range = sr;
         camera_cache_dirty = true;
+    }
+    if( seen_cache_dirty || seen_cache_patched ) {
 #if defined(TILES)
         if( !test_mode ) {
             // Mark cata_tiles draw caches as dirty
@@ -10458,6 +10514,9 @@ void map::update_pathfinding_cache( const tripoint_bub_ms &p ) const
         if( terrain.has_flag( ter_furn_flag::TFLAG_CLIMBABLE ) ) {
             cur_value |= PathfindingFlag::Climbable;
         }
+        if( terrain.open || furniture.open ) {
+            cur_value |= PathfindingFlag::Door;
+        }
     }
 
     if( veh != nullptr ) {
@@ -10501,13 +10560,36 @@ void map::update_pathfinding_cache( const tripoint_bub_ms &p ) const
         cur_value |= ( PathfindingFlag::RestrictLarge | PathfindingFlag::RestrictHuge );
     }
 
+    if( cache.special[p.x()][p.y()] == cur_value ) {
+        return;
+    }
     cache.special[p.x()][p.y()] = cur_value;
+
+    // The portals of a submap also depend on the edge tiles of its neighbours
+    const point_bub_sm cluster( p.x() / SEEX, p.y() / SEEY );
+    cache.clusters[cluster].dirty = true;
+    const int x_in_cluster = p.x() % SEEX;
+    const int y_in_cluster = p.y() % SEEY;
+    if( x_in_cluster == 0 && cluster.x() > 0 ) {
+        cache.clusters[cluster + point::west].dirty = true;
+    } else if( x_in_cluster == SEEX - 1 && cluster.x() < MAPSIZE - 1 ) {
+        cache.clusters[cluster + point::east].dirty = true;
+    }
+    if( y_in_cluster == 0 && cluster.y() > 0 ) {
+        cache.clusters[cluster + point::north].dirty = true;
+    } else if( y_in_cluster == SEEY - 1 && cluster.y() < MAPSIZE - 1 ) {
+        cache.clusters[cluster + point::south].dirty = true;
+    }
 }
 
 void map::update_pathfinding_cache( int zlev ) const
 {
     pathfinding_cache &cache = get_pathfinding_cache( zlev );
 
+    if( cache.dirty || !cache.dirty_points.empty() ) {
+        // Any change can reroute everything, so shared routes have to be searched again
+        cache.flow_fields.clear();
+    }
     if( cache.dirty ) {
         const int size = getmapsize();
         for( int x = 0; x < size * SEEX; ++x ) {
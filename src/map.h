@@ -96,6 +96,7 @@ using VehicleList = std::vector<wrapped_vehicle>;
 class map;
 
 enum class ter_furn_flag : int;
+struct flow_field;
 struct pathfinding_cache;
 struct pathfinding_settings;
 struct pathfinding_target;
@@ -555,7 +556,10 @@ class map
                          const oter_id &om_ter );
         void create_hot_air( const tripoint_bub_ms &p, int intensity );
         bool gas_can_spread_to( field_entry &cur, const maptile &dst );
-        void gas_spread_to( field_entry &cur, maptile &dst, const tripoint_bub_ms &p );
+        /** Moves one intensity of @p cur to @p p once all fields are processed. */
+        void gas_spread_to( field_entry &cur, const tripoint_bub_ms &p );
+        /** Adds the gas spread by @ref gas_spread_to while processing fields. */
+        void apply_gas_spreads();
         int burn_body_part( Character &you, field_entry &cur, const bodypart_id &bp, int scale );
     public:
 
@@ -754,6 +758,22 @@ class map
         int extra_cost( const tripoint_bub_ms &cur, const tripoint_bub_ms &p,
                         const pathfinding_settings &settings,
                         PathfindingFlags p_special ) const;
+        // Route read from a flow_field shared with other requests for the same target this
+        // turn, or nullopt if the request has to be searched for on its own.
+        std::optional<std::vector<tripoint_bub_ms>> flow_field_route( const tripoint_bub_ms &f,
+                const pathfinding_target &target, const pathfinding_settings &settings,
+                const std::function<bool( const tripoint_bub_ms & )> &avoid ) const;
+        // Fills in the costs of |field| with a Dijkstra search outwards from its target.
+        void build_flow_field( flow_field &field, const pathfinding_cache &pf_cache ) const;
+        // Long route planned over the portals between submaps and then searched for one
+        // submap at a time, or nullopt if the route is short or can't be planned that way.
+        std::optional<std::vector<tripoint_bub_ms>> portal_route( const tripoint_bub_ms &f,
+                const pathfinding_target &target, const pathfinding_settings &settings,
+                const std::function<bool( const tripoint_bub_ms & )> &avoid ) const;
+        // The A* search behind route(), without any of its shortcuts.
+        std::vector<tripoint_bub_ms> search_route( const tripoint_bub_ms &f,
+                const pathfinding_target &target, const pathfinding_settings &settings,
+                const std::function<bool( const tripoint_bub_ms & )> &avoid ) const;
     public:
 
         // Vehicles: Common to 2D and 3D
@@ -767,6 +787,10 @@ class map
         void reset_vehicles_sm_pos();
         // clears and build vehicle level caches
         void rebuild_vehicle_level_caches();
+        // Whether the cached parts of a vehicle other than veh might lie within area on level z.
+        // Can give false positives, never false negatives.
+        bool other_vehicle_within( const vehicle &veh, int z,
+                                   const inclusive_rectangle<point_bub_ms> &area ) const;
         void clear_vehicle_list( int zlev );
         void update_vehicle_list( const submap *to, int zlev );
         //Returns true if vehicle zones are dirty and need to be recached
@@ -1899,6 +1923,8 @@ class map
         // Builds a transparency cache and returns true if the cache was invalidated.
         // Used to determine if seen cache should be rebuilt.
         bool build_transparency_cache( int zlev );
+        // Returns true if the vision transparency of any tile changed; the changed
+        // tiles are listed in the level cache unless too many changed to bother.
         bool build_vision_transparency_cache( int zlev );
         // fills lm with sunlight. pzlev is current player's zlevel
         void build_sunlight_cache( int pzlev );
@@ -1911,9 +1937,12 @@ class map
         bool build_floor_cache( int zlev );
         // We want this visible in `game`, because we want it built earlier in the turn than the rest
         void build_floor_caches();
+        // If @p hidden is given, the tiles hidden by ledges are added to it with their previous value.
         void seen_cache_process_ledges( array_of_grids_of<float> &seen_caches,
                                         const array_of_grids_of<const bool> &floor_caches,
-                                        const std::optional<tripoint_bub_ms> &override_p ) const;
+                                        const std::optional<tripoint_bub_ms> &override_p,
+                                        std::vector<std::pair<tripoint_bub_ms, float>> *hidden =
+                                            nullptr ) const;
 
     protected:
         void generate_lightmap( int zlev );
@@ -1921,6 +1950,12 @@ class map
                                int extension_range = MAX_VIEW_DISTANCE,
                                bool cumulative = false,
                                bool camera = false, int penalty = 0 );
+        /**
+         * Recasts only the parts of the seen cache built from @p origin that can be affected
+         * by the tiles listed in the vision_transparency_changes of the level caches.
+         * Returns false without changing anything if the whole cache has to be rebuilt instead.
+         */
+        bool update_seen_cache( const tripoint_bub_ms &origin );
         void apply_character_light( Character &p );
 
         int my_MAPSIZE;
@@ -2049,6 +2084,10 @@ class map
         int determine_wall_corner( const tripoint_bub_ms &p ) const;
         // apply a circular light pattern immediately, however it's best to use...
         void apply_light_source( const tripoint_bub_ms &p, float luminance );
+        // casts into @p lm, skipping directions covered by a neighbouring source in @p buffer
+        void apply_light_source( const tripoint_bub_ms &p, float luminance,
+                                 cata::mdarray<four_quadrants, point_bub_ms> &lm,
+                                 const cata::mdarray<float, point_bub_ms> &buffer );
         // ...this, which will apply the light after at the end of generate_lightmap, and prevent redundant
         // light rays from causing massive slowdowns, if there's a huge amount of light.
         void add_light_source( const tripoint_bub_ms &p, float luminance );
@@ -2127,6 +2166,16 @@ class map
          * Vector of tripoints containing active field-emitting terrain
          */
         std::vector<tripoint_bub_ms> field_ter_locs;
+        /**
+         * Gas spread by the fields processed this turn, added by @ref apply_gas_spreads once
+         * all of them are processed.
+         */
+        struct gas_spread {
+            tripoint_bub_ms p;
+            field_type_id type;
+            time_duration age;
+        };
+        std::vector<gas_spread> pending_gas_spreads;
         /**
          * Holds caches for visibility, light, transparency and vehicles
          */
@@ -2146,6 +2195,12 @@ class map
         mutable lru_cache_t skew_vision_cache;
         mutable lru_cache_t skew_vision_wo_fields_cache;
 
+        // Tiles hidden by ledges in the last build of the seen cache, with the value they had before
+        std::vector<std::pair<tripoint_bub_ms, float>> seen_cache_ledges;
+        // Whether the last build of the seen cache can be patched by update_seen_cache,
+        // i.e. it was cast from a single point without mirrors or cameras
+        bool seen_cache_patchable = false;
+
         // Note: no bounds check
         level_cache &get_cache( int zlev ) const {
             std::unique_ptr<level_cache> &cache = caches[zlev + OVERMAP_DEPTH];
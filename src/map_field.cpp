@@ -181,6 +181,27 @@ void map::process_fields()
             }
         }
     }
+    apply_gas_spreads();
+}
+
+void map::apply_gas_spreads()
+{
+    for( const gas_spread &spread : pending_gas_spreads ) {
+        field_entry *f = get_field( spread.p, spread.type );
+        if( f != nullptr ) {
+            f->set_field_intensity( f->get_field_intensity() + 1 );
+            f->set_field_age( f->get_field_age() + spread.age );
+            // Or, just create a new field.
+        } else if( add_field( spread.p, spread.type, 1, 0_turns ) ) {
+            f = get_field( spread.p, spread.type );
+            if( f != nullptr ) {
+                f->set_field_age( spread.age );
+            } else {
+                debugmsg( "While spreading the gas, field was added but doesn't exist." );
+            }
+        }
+    }
+    pending_gas_spreads.clear();
 }
 
 bool ter_furn_has_flag( const ter_t &ter, const furn_t &furn, const ter_furn_flag flag )
@@ -247,30 +268,20 @@ bool map::gas_can_spread_to( field_entry &cur, const maptile &dst )
     return false;
 }
 
-void map::gas_spread_to( field_entry &cur, maptile &dst, const tripoint_bub_ms &p )
+void map::gas_spread_to( field_entry &cur, const tripoint_bub_ms &p )
 {
-    const field_type_id current_type = cur.get_field_type();
+    if( !inbounds( p ) ) {
+        return;
+    }
     const time_duration current_age = cur.get_field_age();
     const int current_intensity = cur.get_field_intensity();
-    field_entry *f = dst.find_field( current_type );
-    // Nearby gas grows thicker, and ages are shared.
+    // Nearby gas grows thicker, and ages are shared. The gas arrives once all fields have
+    // been processed, so it does not spread again in the same turn. The source thins out
+    // right away though, and a tile can receive gas from several sources in one turn.
     const time_duration age_fraction = current_age / current_intensity;
-    if( f != nullptr ) {
-        f->set_field_intensity( f->get_field_intensity() + 1 );
-        cur.set_field_intensity( current_intensity - 1 );
-        f->set_field_age( f->get_field_age() + age_fraction );
-        cur.set_field_age( current_age - age_fraction );
-        // Or, just create a new field.
-    } else if( add_field( p, current_type, 1, 0_turns ) ) {
-        f = dst.find_field( current_type );
-        if( f != nullptr ) {
-            f->set_field_age( age_fraction );
-        } else {
-            debugmsg( "While spreading the gas, field was added but doesn't exist." );
-        }
-        cur.set_field_intensity( current_intensity - 1 );
-        cur.set_field_age( current_age - age_fraction );
-    }
+    pending_gas_spreads.push_back( { p, cur.get_field_type(), age_fraction } );
+    cur.set_field_intensity( current_intensity - 1 );
+    cur.set_field_age( current_age - age_fraction );
 }
 
 void map::spread_gas( field_entry &cur, const tripoint_bub_ms &p, int percent_spread,
@@ -313,7 +324,7 @@ void map::spread_gas( field_entry &cur, const tripoint_bub_ms &p, int percent_sp
         const tripoint_bub_ms down = p + tripoint_rel_ms::below;
         maptile down_tile = maptile_at_internal( down );
         if( gas_can_spread_to( cur, down_tile ) && valid_move( p, down, true, true ) ) {
-            gas_spread_to( cur, down_tile, down );
+            gas_spread_to( cur, down );
             return;
         }
     }
@@ -338,7 +349,7 @@ void map::spread_gas( field_entry &cur, const tripoint_bub_ms &p, int percent_sp
         // Construct the destination from offset and p
         if( sheltered || windpower < 5 ) {
             std::pair<tripoint_bub_ms, maptile> &n = neighs[ random_entry( spread ) ];
-            gas_spread_to( cur, n.second, n.first );
+            gas_spread_to( cur, n.first );
         } else {
             std::vector<size_t> neighbour_vec;
             auto maptiles = get_wind_blockers( winddirection, p );
@@ -357,14 +368,14 @@ void map::spread_gas( field_entry &cur, const tripoint_bub_ms &p, int percent_sp
             }
             if( !neighbour_vec.empty() ) {
                 std::pair<tripoint_bub_ms, maptile> &n = neighs[ random_entry( neighbour_vec ) ];
-                gas_spread_to( cur, n.second, n.first );
+                gas_spread_to( cur, n.first );
             }
         }
     } else if( p.z() < OVERMAP_HEIGHT ) {
         const tripoint_bub_ms up = p + tripoint_rel_ms::above;
         maptile up_tile = maptile_at_internal( up );
         if( gas_can_spread_to( cur, up_tile ) && valid_move( p, up, true, true ) ) {
-            gas_spread_to( cur, up_tile, up );
+            gas_spread_to( cur, up );
         }
     }
 }
@@ -443,60 +454,65 @@ void map::process_fields_in_submap( submap *const current_submap,
         &( *fd_null )
     };
 
-    // Loop through all tiles in this submap indicated by current_submap
-    for( locx = 0; locx < SEEX; locx++ ) {
-        for( locy = 0; locy < SEEY; locy++ ) {
-            // Get a reference to the field variable from the submap;
-            // contains all the pointers to the real field effects.
-            field &curfield = current_submap->get_field( { static_cast<int>( locx ), static_cast<int>( locy ) } );
-
-            // when displayed_field_type == fd_null it means that `curfield` has no fields inside
-            // avoids instantiating (relatively) expensive map iterator
-            if( !curfield.displayed_field_type() ) {
-                continue;
-            }
-
-            // This is a translation from local coordinates to submap coordinates.
-            const tripoint_bub_ms p{sm_offset + rebase_rel( map_tile.pos() ), submap.z()};
-
-            for( auto it = curfield.begin(); it != curfield.end(); ) {
-                // Iterating through all field effects in the submap's field.
-                field_entry &cur = it->second;
-                const int prev_intensity = cur.is_field_alive() ? cur.get_field_intensity() : 0;
+    // Loop through the tiles of this submap that may have fields
+    tile_set &field_tiles = current_submap->field_tiles();
+    field_tiles.for_each( [&]( const point_sm_ms & tile ) {
+        locx = tile.x();
+        locy = tile.y();
+        // Get a reference to the field variable from the submap;
+        // contains all the pointers to the real field effects.
+        field &curfield = current_submap->get_field( tile );
+
+        // when displayed_field_type == fd_null it means that `curfield` has no fields inside
+        // avoids instantiating (relatively) expensive map iterator
+        if( !curfield.displayed_field_type() ) {
+            field_tiles.erase( tile );
+            return;
+        }
 
-                pd.cur_fd_type_id = cur.get_field_type();
-                pd.cur_fd_type = &( *pd.cur_fd_type_id );
+        // This is a translation from local coordinates to submap coordinates.
+        const tripoint_bub_ms p{sm_offset + rebase_rel( map_tile.pos() ), submap.z()};
 
-                // The field might have been killed by processing a neighbor field
-                if( prev_intensity == 0 ) {
-                    on_field_modified( p, *pd.cur_fd_type );
-                    --current_submap->field_count;
-                    curfield.remove_field( it++ );
-                    continue;
-                }
+        for( auto it = curfield.begin(); it != curfield.end(); ) {
+            // Iterating through all field effects in the submap's field.
+            field_entry &cur = it->second;
+            const int prev_intensity = cur.is_field_alive() ? cur.get_field_intensity() : 0;
 
-                // Don't process "newborn" fields. This gives the player time to run if they need to.
-                if( cur.get_field_age() == 0_turns ) {
-                    cur.do_decay();
-                    if( !cur.is_field_alive() || cur.get_field_intensity() != prev_intensity ) {
-                        on_field_modified( p, *pd.cur_fd_type );
-                    }
-                    ++it;
-                    continue;
-                }
+            pd.cur_fd_type_id = cur.get_field_type();
+            pd.cur_fd_type = &( *pd.cur_fd_type_id );
 
-                for( const FieldProcessorPtr &proc : pd.cur_fd_type->get_processors() ) {
-                    proc( p, cur, pd );
-                }
+            // The field might have been killed by processing a neighbor field
+            if( prev_intensity == 0 ) {
+                on_field_modified( p, *pd.cur_fd_type );
+                --current_submap->field_count;
+                curfield.remove_field( it++ );
+                continue;
+            }
 
+            // Don't process "newborn" fields. This gives the player time to run if they need to.
+            if( cur.get_field_age() == 0_turns ) {
                 cur.do_decay();
                 if( !cur.is_field_alive() || cur.get_field_intensity() != prev_intensity ) {
                     on_field_modified( p, *pd.cur_fd_type );
                 }
                 ++it;
+                continue;
             }
+
+            for( const FieldProcessorPtr &proc : pd.cur_fd_type->get_processors() ) {
+                proc( p, cur, pd );
+            }
+
+            cur.do_decay();
+            if( !cur.is_field_alive() || cur.get_field_intensity() != prev_intensity ) {
+                on_field_modified( p, *pd.cur_fd_type );
+            }
+            ++it;
         }
-    }
+        if( !curfield.displayed_field_type() ) {
+            field_tiles.erase( tile );
+        }
+    } );
     sblk.commit_modifications();
 }
 
@@ -1,13 +1,21 @@
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <deque>
 #include <exception>
 #include <filesystem>
 #include <functional>
 #include <limits>
 #include <memory>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "cached_options.h"
 #include "cata_assert.h"
@@ -21,6 +29,7 @@
 #include "game_constants.h"
 #include "json_loader.h"
 #include "map_memory.h"
+#include "mmap_file.h"
 #include "path_info.h"
 #include "string_formatter.h"
 #include "translations.h"
@@ -62,6 +71,87 @@ struct reg_coord_pair {
     }
 };
 
+namespace
+{
+// Every id a tile was memorized with. Memory holds the same few thousand ids over and
+// over, so tiles keep an index into this table. Index 0 is the empty id. Ids are never
+// removed, and the deque keeps references to them valid.
+class memorized_tile_ids
+{
+    public:
+        memorized_tile_ids() : ids{ std::string() }, indices{ { std::string(), 0 } } {}
+
+        uint32_t intern( std::string_view id ) {
+            const auto [it, inserted] = indices.emplace( std::string( id ),
+                                        static_cast<uint32_t>( ids.size() ) );
+            if( inserted ) {
+                ids.push_back( it->first );
+            }
+            return it->second;
+        }
+
+        const std::string &get( uint32_t index ) const {
+            return ids[index];
+        }
+
+    private:
+        std::deque<std::string> ids;
+        std::unordered_map<std::string, uint32_t> indices;
+};
+
+memorized_tile_ids &tile_ids()
+{
+    static memorized_tile_ids ids;
+    return ids;
+}
+
+constexpr std::string_view region_magic = "CDMM";
+// Bump when the layout changes. Readers refuse files newer than they know.
+constexpr uint32_t region_format_version = 1;
+// Length, symbol, terrain, decoration and the four subtiles and rotations.
+constexpr size_t run_size = sizeof( uint16_t ) + 3 * sizeof( uint32_t ) + 4 * sizeof( int8_t );
+
+template<typename T>
+void put( std::string &out, T value )
+{
+    static_assert( std::is_trivially_copyable_v<T> );
+    char bytes[sizeof( T )];
+    std::memcpy( bytes, &value, sizeof( T ) );
+    out.append( bytes, sizeof( T ) );
+}
+
+// Bounds checked reading of a region file.
+class cursor
+{
+    public:
+        cursor( std::string_view data, size_t pos ) : data( data ), pos( pos ) {
+            if( pos > data.size() ) {
+                throw std::runtime_error( "memory map region is truncated" );
+            }
+        }
+
+        template<typename T>
+        T get() {
+            T value;
+            std::memcpy( &value, bytes( sizeof( T ) ).data(), sizeof( T ) );
+            return value;
+        }
+
+        std::string_view bytes( size_t count ) {
+            if( count > data.size() - pos ) {
+                throw std::runtime_error( "memory map region is truncated" );
+            }
+            std::string_view result = data.substr( pos, count );
+            pos += count;
+            return result;
+        }
+
+    private:
+        std::string_view data;
+        size_t pos;
+};
+} // namespace
+
 mm_submap::mm_submap( bool make_valid ) : valid( make_valid ) {}
 
 bool mm_submap::is_empty() const
@@ -74,6 +164,16 @@ bool mm_submap::is_valid() const
     return valid;
 }
 
+bool mm_submap::is_dirty() const
+{
+    return dirty;
+}
+
+void mm_submap::mark_clean()
+{
+    dirty = false;
+}
+
 const memorized_tile &mm_submap::get_tile( const point_sm_ms &p ) const
 {
     if( tiles.empty() ) {
@@ -89,42 +189,205 @@ void mm_submap::set_tile( const point_sm_ms &p, const memorized_tile &value )
         tiles.reserve( SEEX * SEEY );
         tiles.resize( SEEX * SEEY, default_tile );
     }
-    tiles[p.y() * SEEX + p.x()] = value;
+    memorized_tile &tile = tiles[p.y() * SEEX + p.x()];
+    if( tile != value ) {
+        tile = value;
+        dirty = true;
+    }
 }
 
 mm_region::mm_region() : submaps( nullptr ) {}
 
-bool mm_region::is_empty() const
+const shared_ptr_fast<mm_submap> &mm_region::get_submap( const point &p )
+{
+    shared_ptr_fast<mm_submap> &sm = submaps[p];
+    if( !sm && file ) {
+        try {
+            sm = file->load( p );
+        } catch( const std::exception &err ) {
+            debugmsg( "Failed to load memorized submap %s of region: %s", p.to_string(),
+                      err.what() );
+        }
+    }
+    if( !sm ) {
+        sm = make_shared_fast<mm_submap>();
+    }
+    return sm;
+}
+
+bool mm_region::is_dirty() const
 {
     for( size_t y = 0; y < MM_REG_SIZE; y++ ) {
         // NOLINTNEXTLINE(modernize-loop-convert)
         for( size_t x  = 0; x < MM_REG_SIZE; x++ ) {
-            if( !submaps[x][y]->is_empty() ) {
-                return false;
+            if( submaps[x][y] && submaps[x][y]->is_dirty() ) {
+                return true;
             }
         }
     }
-    return true;
+    return false;
+}
+
+bool mm_region_file::is_binary( std::string_view data )
+{
+    return data.substr( 0, region_magic.size() ) == region_magic;
+}
+
+std::string mm_region_file::write( mm_region &region )
+{
+    // The file refers to ids by their position in its own table.
+    std::vector<uint32_t> file_ids;
+    std::unordered_map<uint32_t, uint32_t> file_indices;
+    const auto file_index = [&]( uint32_t id ) {
+        const auto [it, inserted] = file_indices.emplace( id,
+                                    static_cast<uint32_t>( file_ids.size() ) );
+        if( inserted ) {
+            file_ids.push_back( id );
+        }
+        return it->second;
+    };
+
+    std::array<std::string, MM_REG_SIZE * MM_REG_SIZE> bodies;
+    for( size_t y = 0; y < MM_REG_SIZE; y++ ) {
+        for( size_t x = 0; x < MM_REG_SIZE; x++ ) {
+            const mm_submap &sm = *region.get_submap( point( x, y ) );
+            if( sm.is_empty() ) {
+                continue;
+            }
+            // Runs of equal tiles, row by row.
+            std::vector<std::pair<const memorized_tile *, uint16_t>> runs;
+            for( const memorized_tile &tile : sm.tiles ) {
+                if( !runs.empty() && *runs.back().first == tile ) {
+                    runs.back().second += 1;
+                } else {
+                    runs.emplace_back( &tile, 1 );
+                }
+            }
+            std::string &out = bodies[y * MM_REG_SIZE + x];
+            out.reserve( sizeof( uint16_t ) + runs.size() * run_size );
+            put<uint16_t>( out, runs.size() );
+            for( const std::pair<const memorized_tile *, uint16_t> &run : runs ) {
+                const memorized_tile &tile = *run.first;
+                put<uint16_t>( out, run.second );
+                put<uint32_t>( out, tile.symbol );
+                put<uint32_t>( out, file_index( tile.ter_id ) );
+                put<uint32_t>( out, file_index( tile.dec_id ) );
+                put<int8_t>( out, tile.ter_subtile );
+                put<int8_t>( out, tile.ter_rotation );
+                put<int8_t>( out, tile.dec_subtile );
+                put<int8_t>( out, tile.dec_rotation );
+            }
+        }
+    }
+
+    std::string file( region_magic );
+    put<uint32_t>( file, region_format_version );
+    put<uint32_t>( file, file_ids.size() );
+    for( const uint32_t id : file_ids ) {
+        const std::string &str = tile_ids().get( id );
+        if( str.size() > std::numeric_limits<uint16_t>::max() ) {
+            throw std::runtime_error( "memorized tile id is too long" );
+        }
+        put<uint16_t>( file, str.size() );
+        file += str;
+    }
+    const size_t offsets_start = file.size();
+    file.append( bodies.size() * sizeof( uint32_t ), '\0' );
+    for( size_t i = 0; i < bodies.size(); ++i ) {
+        if( bodies[i].empty() ) {
+            continue;
+        }
+        const uint32_t offset = file.size();
+        std::memcpy( &file[offsets_start + i * sizeof( uint32_t )], &offset, sizeof( offset ) );
+        file += bodies[i];
+    }
+    if( file.size() > std::numeric_limits<uint32_t>::max() ) {
+        throw std::runtime_error( "memory map region is too large" );
+    }
+    return file;
+}
+
+mm_region_file::mm_region_file( std::shared_ptr<const void> owner, std::string_view data ) :
+    owner( std::move( owner ) ), data( data )
+{
+    cursor in( data, 0 );
+    if( in.bytes( region_magic.size() ) != region_magic ) {
+        throw std::runtime_error( "not a binary memory map region" );
+    }
+    const uint32_t version = in.get<uint32_t>();
+    if( version > region_format_version ) {
+        throw std::runtime_error( string_format( "memory map region format %d is newer than this "
+                                  "game supports", version ) );
+    }
+    const uint32_t count = in.get<uint32_t>();
+    ids.reserve( count );
+    for( uint32_t i = 0; i < count; ++i ) {
+        ids.push_back( tile_ids().intern( in.bytes( in.get<uint16_t>() ) ) );
+    }
+    for( uint32_t &offset : offsets ) {
+        offset = in.get<uint32_t>();
+        if( offset >= data.size() ) {
+            throw std::runtime_error( "memory map region offset points outside of the file" );
+        }
+    }
+}
+
+shared_ptr_fast<mm_submap> mm_region_file::load( const point &p ) const
+{
+    shared_ptr_fast<mm_submap> sm = make_shared_fast<mm_submap>();
+    const uint32_t offset = offsets[p.y * MM_REG_SIZE + p.x];
+    if( offset == 0 ) {
+        return sm;
+    }
+    const auto id = [this]( uint32_t index ) {
+        if( index >= ids.size() ) {
+            throw std::runtime_error( "memorized tile refers to a missing id" );
+        }
+        return ids[index];
+    };
+    cursor in( data, offset );
+    std::vector<memorized_tile> &tiles = sm->tiles;
+    tiles.reserve( SEEX * SEEY );
+    const uint16_t count = in.get<uint16_t>();
+    for( uint16_t i = 0; i < count; ++i ) {
+        const uint16_t length = in.get<uint16_t>();
+        memorized_tile tile;
+        tile.symbol = in.get<uint32_t>();
+        tile.ter_id = id( in.get<uint32_t>() );
+        tile.dec_id = id( in.get<uint32_t>() );
+        tile.ter_subtile = in.get<int8_t>();
+        tile.ter_rotation = in.get<int8_t>();
+        tile.dec_subtile = in.get<int8_t>();
+        tile.dec_rotation = in.get<int8_t>();
+        if( length > SEEX * SEEY - tiles.size() ) {
+            throw std::runtime_error( "memorized submap runs cover too many tiles" );
+        }
+        tiles.insert( tiles.end(), length, tile );
+    }
+    if( tiles.size() != SEEX * SEEY ) {
+        throw std::runtime_error( "memorized submap runs cover too few tiles" );
+    }
+    return sm;
 }
 
 const std::string &memorized_tile::get_ter_id() const
 {
-    return ter_id.str();
+    return tile_ids().get( ter_id );
 }
 
 const std::string &memorized_tile::get_dec_id() const
 {
-    return dec_id;
+    return tile_ids().get( dec_id );
 }
 
 void memorized_tile::set_ter_id( std::string_view id )
 {
-    ter_id = ter_str_id( id );
+    ter_id = tile_ids().intern( id );
 }
 
 void memorized_tile::set_dec_id( std::string_view id )
 {
-    dec_id = id;
+    dec_id = tile_ids().intern( id );
 }
 
 int memorized_tile::get_ter_rotation() const
@@ -311,114 +574,95 @@ bool map_memory::prepare_region( const tripoint_abs_ms &p1, const tripoint_abs_m
             }
         }
     }
+    page_out( cache_pos + point_rel_sm( cache_size / 2 ) );
     return true;
 }
 
 shared_ptr_fast<mm_submap> map_memory::fetch_submap( const tripoint_abs_sm &sm_pos )
 {
-    shared_ptr_fast<mm_submap> sm = find_submap( sm_pos );
-    if( sm ) {
-        return sm;
-    }
-    sm = load_submap( sm_pos );
-    if( sm ) {
-        return sm;
-    }
-    return allocate_submap( sm_pos );
-}
-
-shared_ptr_fast<mm_submap> map_memory::allocate_submap( const tripoint_abs_sm &sm_pos )
-{
-    // Since all save/load operations are done on regions of submaps,
-    // we need to allocate the whole region at once.
-    shared_ptr_fast<mm_submap> ret;
-    tripoint reg = reg_coord_pair( sm_pos ).reg;
-
-    dbg( D_INFO ) << "Allocated mm_region " << reg << " [" << mmr_to_sm_copy( reg ) << "]";
-
-    for( size_t y = 0; y < MM_REG_SIZE; y++ ) {
-        for( size_t x = 0; x < MM_REG_SIZE; x++ ) {
-            const tripoint_abs_sm pos( mmr_to_sm_copy( reg ) + tripoint( x, y, 0 ) );
-            shared_ptr_fast<mm_submap> sm = make_shared_fast<mm_submap>();
-            if( pos == sm_pos ) {
-                ret = sm;
-            }
-            submaps.insert( std::make_pair( pos, sm ) );
-        }
-    }
-
-    return ret;
-}
-
-shared_ptr_fast<mm_submap> map_memory::find_submap( const tripoint_abs_sm &sm_pos )
-{
-    auto sm = submaps.find( sm_pos );
-    if( sm == submaps.end() ) {
-        return nullptr;
-    } else {
-        return sm->second;
+    const reg_coord_pair p( sm_pos );
+    auto it = regions.find( p.reg );
+    if( it == regions.end() ) {
+        it = regions.emplace( p.reg, load_region( p.reg ) ).first;
     }
+    return it->second.get_submap( p.sm_loc.raw() );
 }
 
-shared_ptr_fast<mm_submap> map_memory::load_submap( const tripoint_abs_sm &sm_pos )
+mm_region map_memory::load_region( const tripoint &reg ) const
 {
+    mm_region mmr;
     if( test_mode ) {
-        return nullptr;
+        return mmr;
     }
 
-    const reg_coord_pair p( sm_pos );
     const cata_path mm_dir = find_mm_dir();
-    std::filesystem::path mm_filename = std::filesystem::u8path( find_region_filename( p.reg ) );
-
-    mm_region mmr;
-    const auto loader = [&mmr]( const JsonValue & jsin ) {
-        mmr.deserialize( jsin );
-    };
+    const std::filesystem::path mm_filename = std::filesystem::u8path( find_region_filename(
+                reg ) );
 
     try {
-
+        // Binary regions are read in place, json regions of older saves as usual.
+        std::shared_ptr<const void> owner;
+        std::string_view contents;
         if( world_generator->active_world->has_compression_enabled() ) {
             std::shared_ptr<zzip_stack> z = zzip_stack::load( mm_dir.get_unrelative_path(),
                                             ( PATH_INFO::world_base_save_path() / "mmr.dict" ).get_unrelative_path() );
-            if( !z ) {
-                return nullptr;
-            }
-            if( !read_from_zzip_optional( z, mm_filename, [&]( std::string_view sv ) {
-            JsonValue jsin = json_loader::from_string( std::string( sv ) );
-                loader( jsin );
-            } ) ) {
-                return nullptr;
+            if( !z || !z->has_file( mm_filename ) ) {
+                return mmr;
             }
+            std::shared_ptr<std::vector<std::byte>> data = std::make_shared<std::vector<std::byte>>
+                    ( z->get_file( mm_filename ) );
+            contents = std::string_view( reinterpret_cast<const char *>( data->data() ),
+                                         data->size() );
+            owner = std::move( data );
         } else {
-
-            if( !read_from_file_optional_json( mm_dir / mm_filename, loader ) ) {
+            std::shared_ptr<const mmap_file> mapped = mmap_file::map_file( ( mm_dir /
+                    mm_filename ).get_unrelative_path() );
+            if( !mapped ) {
                 // Region not found
-                return nullptr;
+                return mmr;
             }
+            contents = std::string_view( static_cast<const char *>( mapped->base() ),
+                                         mapped->len() );
+            owner = std::move( mapped );
+        }
+        if( mm_region_file::is_binary( contents ) ) {
+            mmr.file = std::make_shared<const mm_region_file>( std::move( owner ), contents );
+        } else {
+            mmr.deserialize( json_loader::from_string( std::string( contents ) ) );
         }
-
     } catch( const std::exception &err ) {
         debugmsg( "Failed to load memory map region (%d,%d,%d): %s",
-                  p.reg.x, p.reg.y, p.reg.z, err.what() );
-        return nullptr;
+                  reg.x, reg.y, reg.z, err.what() );
+        return mm_region();
     }
 
-    dbg( D_INFO ) << "Loaded mm_region " << p.reg << " [" << mmr_to_sm_copy( p.reg ) << "]";
+    dbg( D_INFO ) << "Loaded mm_region " << reg << " [" << mmr_to_sm_copy( reg ) << "]";
 
-    shared_ptr_fast<mm_submap> ret;
+    return mmr;
+}
 
-    for( size_t y = 0; y < MM_REG_SIZE; y++ ) {
-        for( size_t x = 0; x < MM_REG_SIZE; x++ ) {
-            const tripoint_abs_sm pos( mmr_to_sm_copy( p.reg ) + tripoint( x, y, 0 ) );
-            shared_ptr_fast<mm_submap> &sm = mmr.submaps[x][y];
-            if( pos == sm_pos ) {
-                ret = sm;
-            }
-            submaps.emplace( pos, sm );
+void map_memory::page_out( const tripoint_abs_sm &center )
+{
+    constexpr point MM_HSIZE_P = point( MM_SIZE / 2, MM_SIZE / 2 );
+    const rectangle<point_abs_sm> rect_keep( center.xy() - MM_HSIZE_P, center.xy() + MM_HSIZE_P );
+    // A wide view can reach past the kept area. Its cached submaps must stay the ones
+    // of their regions, or tiles memorized there would never be saved.
+    const half_open_rectangle<point_abs_sm> rect_cached( cache_pos.xy(),
+            cache_pos.xy() + cache_size );
+    for( auto it = regions.begin(); it != regions.end(); ) {
+        const tripoint_abs_sm regp_sm( mmr_to_sm_copy( it->first ) );
+        const half_open_rectangle<point_abs_sm> rect_reg(
+            regp_sm.xy(),
+            regp_sm.xy() + point( MM_REG_SIZE, MM_REG_SIZE ) );
+        const bool in_view = cached.count( regp_sm.z() ) != 0 && rect_reg.overlaps( rect_cached );
+        // Clean regions can be read back from their file when they are needed again.
+        if( rect_reg.overlaps( rect_keep ) || in_view || it->second.is_dirty() ) {
+            ++it;
+        } else {
+            dbg( D_INFO ) << "Dropping mm_region " << it->first << " [" << regp_sm << "]";
+            it = regions.erase( it );
         }
     }
-
-    return ret;
 }
 
 static mm_submap null_mz_submap;
@@ -472,22 +716,8 @@ bool map_memory::save( const tripoint_abs_ms &pos )
 
     clear_cache();
 
-    dbg( D_INFO ) << "N submaps before save: " << submaps.size();
-
-    // Since mm_submaps are always allocated in regions,
-    // we are certain that each region will be filled.
-    std::map<tripoint, mm_region> regions;
-    for( auto &it : submaps ) {
-        const reg_coord_pair p( it.first );
-        regions[p.reg].submaps[p.sm_loc.x()][p.sm_loc.y()] = it.second;
-    }
-    submaps.clear();
-
-    constexpr point MM_HSIZE_P = point( MM_SIZE / 2, MM_SIZE / 2 );
-    rectangle<point_abs_sm> rect_keep( sm_center.xy() - MM_HSIZE_P, sm_center.xy() + MM_HSIZE_P );
-
-    dbg( D_INFO ) << "[SAVE] Saving memory map around " << sm_center << ". Keeping submaps within " <<
-                  rect_keep.p_min << "->" << rect_keep.p_max;
+    dbg( D_INFO ) << "N regions before save: " << regions.size();
+    dbg( D_INFO ) << "[SAVE] Saving memory map around " << sm_center;
 
     bool result = true;
 
@@ -496,61 +726,74 @@ bool map_memory::save( const tripoint_abs_ms &pos )
         z = zzip_stack::load( dirname.get_unrelative_path(),
                               ( PATH_INFO::world_base_save_path() / "mmr.dict" ).get_unrelative_path() );
     }
-    for( auto &it : regions ) {
+    std::vector<std::pair<std::filesystem::path, std::string>> compressed_regions;
+    std::vector<mm_region *> saved_regions;
+    for( std::pair<const tripoint, mm_region> &it : regions ) {
         const tripoint &regp = it.first;
         mm_region &reg = it.second;
-        if( !reg.is_empty() ) {
-            const std::filesystem::path mm_filename = std::filesystem::u8path( find_region_filename( regp ) );
-            const std::string descr = string_format(
-                                          _( "memory map region for (%d,%d,%d)" ),
-                                          regp.x, regp.y, regp.z
-                                      );
-            std::string mm_str = serialize_wrapper( [&]( JsonOut & jsout ) {
-                reg.serialize( jsout );
-            } );
-
-            if( world_generator->active_world->has_compression_enabled() ) {
-                if( z ) {
-                    result = z->add_file( mm_filename, mm_str ) && result;
-                } else {
-                    result = false;
-                }
-
-            } else {
-                const cata_path path = dirname / mm_filename;
-                const auto writer = [&]( std::ostream & fout ) -> void {
-                    fout << mm_str;
-                };
-
-                const bool res = write_to_file( path, writer, descr.c_str() );
-                result = result && res;
-            }
+        // Regions that did not change since they were loaded are already saved.
+        if( !reg.is_dirty() ) {
+            continue;
         }
-        const tripoint_abs_sm regp_sm( mmr_to_sm_copy( regp ) );
-        const half_open_rectangle<point_abs_sm> rect_reg(
-            regp_sm.xy(),
-            regp_sm.xy() + point( MM_REG_SIZE, MM_REG_SIZE ) );
+        const std::filesystem::path mm_filename = std::filesystem::u8path( find_region_filename(
+                    regp ) );
+        const std::string descr = string_format(
+                                      _( "memory map region for (%d,%d,%d)" ),
+                                      regp.x, regp.y, regp.z
+                                  );
+        std::string mm_str;
+        try {
+            mm_str = mm_region_file::write( reg );
+        } catch( const std::exception &err ) {
+            debugmsg( "Failed to save %s: %s", descr, err.what() );
+            result = false;
+            continue;
+        }
+        // Everything is decoded now, and the file is about to be replaced.
+        reg.file.reset();
 
-        if( rect_reg.overlaps( rect_keep ) ) {
-            dbg( D_INFO ) << "Keeping mm_region " << regp << " [" << regp_sm << "]";
-            // Put submaps back
-            for( size_t y = 0; y < MM_REG_SIZE; y++ ) {
-                for( size_t x = 0; x < MM_REG_SIZE; x++ ) {
-                    const tripoint_abs_sm p = regp_sm + tripoint( x, y, 0 );
-                    shared_ptr_fast<mm_submap> &sm = reg.submaps[x][y];
-                    submaps.insert( std::make_pair( p, sm ) );
-                }
-            }
+        if( world_generator->active_world->has_compression_enabled() ) {
+            // Compressed together below.
+            compressed_regions.emplace_back( mm_filename, std::move( mm_str ) );
+            saved_regions.push_back( &reg );
         } else {
-            dbg( D_INFO ) << "Dropping mm_region " << regp << " [" << regp_sm << "]";
+            const cata_path path = dirname / mm_filename;
+            const auto writer = [&]( std::ostream & fout ) -> void {
+                fout << mm_str;
+            };
+
+            const bool res = write_to_file( path, writer, descr.c_str() );
+            if( res ) {
+                saved_regions.push_back( &reg );
+            }
+            result = result && res;
+        }
+    }
+    if( !compressed_regions.empty() ) {
+        std::vector<std::pair<std::filesystem::path, std::string_view>> files;
+        files.reserve( compressed_regions.size() );
+        for( const std::pair<std::filesystem::path, std::string> &region : compressed_regions ) {
+            files.emplace_back( region.first, region.second );
+        }
+        if( !z || !z->add_files( files ) ) {
+            saved_regions.clear();
+            result = false;
         }
     }
     if( z ) {
         z->compact( 3.0 );
     }
+    for( mm_region *reg : saved_regions ) {
+        for( size_t y = 0; y < MM_REG_SIZE; y++ ) {
+            for( size_t x = 0; x < MM_REG_SIZE; x++ ) {
+                reg->submaps[x][y]->mark_clean();
+            }
+        }
+    }
+    page_out( sm_center );
 
     dbg( D_INFO ) << "[SAVE] Done.";
-    dbg( D_INFO ) << "N submaps after save: " << submaps.size();
+    dbg( D_INFO ) << "N regions after save: " << regions.size();
 
     return result;
 }
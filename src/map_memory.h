@@ -2,8 +2,10 @@
 #ifndef CATA_SRC_MAP_MEMORY_H
 #define CATA_SRC_MAP_MEMORY_H
 
+#include <array>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -16,9 +18,13 @@
 #include "type_id.h"
 
 class JsonArray;
-class JsonOut;
 class JsonValue;
+class mm_region_file;
 
+/**
+ * What the avatar remembers of a tile. Tile ids are kept as indices into a table of all
+ * memorized ids, so a tile takes 16 bytes instead of two strings.
+ */
 class memorized_tile
 {
     public:
@@ -45,8 +51,9 @@ class memorized_tile
         }
     private:
         friend struct mm_submap; // serialization needs access to private members
-        ter_str_id ter_id;       // terrain tile id
-        std::string dec_id;      // decoration tile id (furniture, vparts ...)
+        friend class mm_region_file;
+        uint32_t ter_id = 0;     // terrain tile id
+        uint32_t dec_id = 0;     // decoration tile id (furniture, vparts ...)
         int8_t ter_rotation = 0;
         int8_t dec_rotation = 0;
         int8_t ter_subtile = 0;
@@ -66,35 +73,85 @@ struct mm_submap {
         // @returns true if mm_submap is valid, i.e. not returned from an uninitialized region.
         bool is_valid() const;
 
+        // @returns true if a tile changed since the submap was last saved.
+        bool is_dirty() const;
+        void mark_clean();
+
         const memorized_tile &get_tile( const point_sm_ms &p ) const;
         void set_tile( const point_sm_ms &p, const memorized_tile &value );
 
-        void serialize( JsonOut &jsout ) const;
+        // Reads the json format of older saves. Submaps are saved by mm_region_file.
         void deserialize( int version, const JsonArray &ja );
 
     private:
+        friend class mm_region_file;
         // NOLINTNEXTLINE(cata-serialize)
         std::vector<memorized_tile> tiles; // holds either 0 or SEEX*SEEY elements
         // NOLINTNEXTLINE(cata-serialize)
         bool valid = true;
+        // NOLINTNEXTLINE(cata-serialize)
+        bool dirty = false;
 };
 
 /**
  * Represents a square of mm_submaps.
  * For faster save/load, submaps are collected into regions
  * and each region is saved in its own file.
+ * Submaps of a saved region are decoded from its file when they are first needed, so
+ * looking at a corner of a region does not load all of it.
  */
 struct mm_region {
+    // Null until loaded or allocated, see get_submap.
     cata::mdarray<shared_ptr_fast<mm_submap>, point, MM_REG_SIZE, MM_REG_SIZE> submaps;
+    // The saved region, mapped or decompressed, if there is one.
+    std::shared_ptr<const mm_region_file> file;
 
     mm_region();
 
-    bool is_empty() const;
+    /** Decodes the submap from the file or allocates an empty one. */
+    const shared_ptr_fast<mm_submap> &get_submap( const point &p );
+
+    // @returns true if any loaded submap changed since the region was saved.
+    bool is_dirty() const;
 
-    void serialize( JsonOut &jsout ) const;
+    // Reads the json format of older saves, loading all submaps.
     void deserialize( const JsonValue &ja );
 };
 
+/**
+ * The binary format of a saved mm_region.
+ *
+ * The file starts with the tile ids used in the region, followed by the offset of each
+ * submap and the submaps themselves as runs of equal tiles. It is read in place, from a
+ * mapped file or a decompressed zzip entry, and each submap is only decoded when it is
+ * needed.
+ */
+class mm_region_file
+{
+    public:
+        static bool is_binary( std::string_view data );
+
+        /** Loads all submaps of the region and encodes it. */
+        static std::string write( mm_region &region );
+
+        /**
+         * Reads the id table and the submap offsets. @p owner keeps @p data alive.
+         * Throws if @p data is not a region of a format this game understands.
+         */
+        mm_region_file( std::shared_ptr<const void> owner, std::string_view data );
+
+        /** Decodes the submap at @p p within the region. Throws if it is corrupt. */
+        shared_ptr_fast<mm_submap> load( const point &p ) const;
+
+    private:
+        std::shared_ptr<const void> owner;
+        std::string_view data;
+        // Indices of the ids of the file in the table of memorized tile ids.
+        std::vector<uint32_t> ids;
+        // Start of each submap by y * MM_REG_SIZE + x, 0 for submaps with nothing memorized.
+        std::array<uint32_t, MM_REG_SIZE * MM_REG_SIZE> offsets{};
+};
+
 /**
  * Manages map tiles memorized by the avatar.
  */
@@ -167,7 +224,9 @@ class map_memory
         void clear_tile_decoration( const tripoint_abs_ms &pos, std::string_view prefix = "" );
 
     private:
-        std::map<tripoint_abs_sm, shared_ptr_fast<mm_submap>> submaps;
+        // Loaded regions by region coordinates. Clean regions far from the view are dropped
+        // again, they can be read back from their files.
+        std::map<tripoint, mm_region> regions;
 
         mutable std::map<int, std::vector<shared_ptr_fast<mm_submap>>> cached;
         tripoint_abs_sm cache_pos;
@@ -175,12 +234,10 @@ class map_memory
 
         /** Find, load or allocate a submap. @returns the submap. */
         shared_ptr_fast<mm_submap> fetch_submap( const tripoint_abs_sm &sm_pos );
-        /** Find submap amongst the loaded submaps. @returns nullptr if failed. */
-        shared_ptr_fast<mm_submap> find_submap( const tripoint_abs_sm &sm_pos );
-        /** Load submap from disk. @returns nullptr if failed. */
-        shared_ptr_fast<mm_submap> load_submap( const tripoint_abs_sm &sm_pos );
-        /** Allocate empty submap. @returns the submap. */
-        shared_ptr_fast<mm_submap> allocate_submap( const tripoint_abs_sm &sm_pos );
+        /** Load region from disk. @returns an empty region if there is none. */
+        mm_region load_region( const tripoint &reg ) const;
+        /** Drops clean regions that overlap neither the given area nor the cached view. */
+        void page_out( const tripoint_abs_sm &center );
 
         /** Get submap from within the cache */
         //@{
@@ -1,19 +1,34 @@
 #include "mapbuffer.h"
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <exception>
 #include <filesystem>
+#include <fstream>
 #include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#if defined(_WIN32) && !defined(_MSC_VER)
+#   include "mingw.thread.h"
+#endif
+
+#include "async_save.h"
 #include "cata_path.h"
 #include "cata_utility.h"
 #include "debug.h"
@@ -23,14 +38,18 @@
 #include "json.h"
 #include "json_loader.h"
 #include "map.h"
+#include "mmap_file.h"
+#include "options.h"
 #include "output.h"
 #include "overmapbuffer.h"
 #include "path_info.h"
+#include "perf.h"
 #include "point.h"
 #include "popup.h"
 #include "std_hash_fs_path.h"
 #include "string_formatter.h"
 #include "submap.h"
+#include "submap_binary.h"
 #include "translations.h"
 #include "type_id.h"
 #include "ui_manager.h"
@@ -51,14 +70,264 @@ static std::string quad_file_name( const tripoint_abs_omt &om_addr )
     return string_format( "%d.%d.%d.map", om_addr.x(), om_addr.y(), om_addr.z() );
 }
 
-static cata_path find_dirname( const tripoint_abs_omt &om_addr )
+// Quads unloaded by mapbuffer::evict_to_budget wait here for the next save.
+static const std::string evicted_maps_folder = "maps.evicted";
+
+static cata_path find_dirname( const tripoint_abs_omt &om_addr,
+                               const std::string &folder = "maps" )
 {
     const tripoint_abs_seg segment_addr = project_to<coords::seg>( om_addr );
-    return PATH_INFO::world_base_save_path() / "maps" / string_format( "%d.%d.%d",
+    return PATH_INFO::world_base_save_path() / folder / string_format( "%d.%d.%d",
             segment_addr.x(),
             segment_addr.y(), segment_addr.z() );
 }
 
+// What the background save jobs of a segment write to: its zzip, or the folder of its
+// quad files that is named the same without the extension.
+static std::string save_target( const cata_path &dirname )
+{
+    return ( dirname + ".zzip" ).get_unrelative_path().generic_u8string();
+}
+
+static cata_path maps_dictionary_path()
+{
+    return PATH_INFO::world_base_save_path() / "maps.dict";
+}
+
+namespace
+{
+// Where the quad file of an overmap terrain is stored. This is resolved on the main
+// thread, the world settings are not safe to look at from the prefetch worker.
+struct quad_location {
+    tripoint_abs_omt om_addr;
+    // The quad file, or the zzip holding it for compressed worlds.
+    std::filesystem::path path;
+    // Only set for compressed worlds.
+    std::filesystem::path dictionary;
+    std::filesystem::path file_name;
+};
+
+enum class staged_state : int {
+    queued,
+    reading,
+    ready,
+    // There is no file, the quad is uniform or has never been generated.
+    missing,
+    // Reading failed, the main thread reads it again so the error gets reported.
+    failed
+};
+
+struct staged_quad {
+    staged_state state = staged_state::queued;
+    uint64_t ticket = 0;
+    std::string contents;
+};
+} // namespace
+
+static staged_quad read_staged_quad( const quad_location &loc )
+{
+    staged_quad result;
+    result.state = staged_state::failed;
+    try {
+        std::error_code ec;
+        if( !std::filesystem::exists( loc.path, ec ) ) {
+            result.state = ec ? staged_state::failed : staged_state::missing;
+            return result;
+        }
+        if( loc.dictionary.empty() ) {
+            std::ifstream fin( loc.path, std::ios::binary );
+            if( !fin ) {
+                return result;
+            }
+            result.contents.assign( std::istreambuf_iterator<char>( fin ), std::istreambuf_iterator<char>() );
+            // Gzipped legacy saves are left to the regular loading code.
+            if( fin.bad() || ( result.contents.size() >= 2 && result.contents[0] == '\x1f' &&
+                               result.contents[1] == '\x8b' ) ) {
+                return result;
+            }
+        } else {
+            // Safe next to the main thread: every zzip gets zstd contexts of its own.
+            const std::shared_ptr<zzip> z = zzip::load( loc.path, loc.dictionary );
+            if( !z ) {
+                return result;
+            }
+            if( !z->has_file( loc.file_name ) ) {
+                result.state = staged_state::missing;
+                return result;
+            }
+            const std::vector<std::byte> contents = z->get_file( loc.file_name );
+            result.contents.assign( reinterpret_cast<const char *>( contents.data() ), contents.size() );
+        }
+        result.state = staged_state::ready;
+    } catch( const std::exception & ) {
+        result.state = staged_state::failed;
+    }
+    return result;
+}
+
+/**
+ * Reads quad files on a worker thread ahead of time. Only the disk access and the
+ * decompression happen there: deserializing submaps and running mapgen touch global
+ * game state and stay on the main thread.
+ */
+struct submap_prefetcher {
+        // Far more than the edge of the reality bubble, the oldest reads are dropped beyond this.
+        static constexpr size_t max_staged = 1024;
+
+        submap_prefetcher() : worker( [this]() {
+            run();
+        } ) {}
+        ~submap_prefetcher() {
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                stopping = true;
+            }
+            wake.notify_all();
+            worker.join();
+        }
+
+        /** Returns whether a new read was queued. */
+        bool request( quad_location &&loc ) {
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                if( staged.count( loc.om_addr ) != 0 ) {
+                    return false;
+                }
+                staged_quad &entry = staged[loc.om_addr];
+                entry.ticket = ++last_ticket;
+                staged_order.emplace_back( loc.om_addr, entry.ticket );
+                queue.emplace_back( std::move( loc ), entry.ticket );
+                drop_oldest();
+            }
+            wake.notify_one();
+            return true;
+        }
+
+        /**
+         * Hands over the staged quad, waiting for it when it is being read right now.
+         * Returns nothing when the quad has not been read yet.
+         */
+        std::optional<staged_quad> take( const tripoint_abs_omt &om_addr ) {
+            std::unique_lock<std::mutex> lock( mutex );
+            auto iter = staged.find( om_addr );
+            if( iter == staged.end() ) {
+                return std::nullopt;
+            }
+            if( iter->second.state == staged_state::reading ) {
+                done.wait( lock, [&]() {
+                    iter = staged.find( om_addr );
+                    return iter == staged.end() || iter->second.state != staged_state::reading;
+                } );
+                if( iter == staged.end() ) {
+                    return std::nullopt;
+                }
+            }
+            staged_quad result = std::move( iter->second );
+            // The worker skips queued entries that are gone.
+            staged.erase( iter );
+            if( result.state != staged_state::ready && result.state != staged_state::missing ) {
+                return std::nullopt;
+            }
+            return result;
+        }
+
+        /** Blocks until every quad requested so far has been read. */
+        void finish() {
+            std::unique_lock<std::mutex> lock( mutex );
+            done.wait( lock, [this]() {
+                return queue.empty() && !busy;
+            } );
+        }
+
+        void cancel() {
+            std::unique_lock<std::mutex> lock( mutex );
+            queue.clear();
+            staged.clear();
+            staged_order.clear();
+            done.wait( lock, [this]() {
+                return !busy;
+            } );
+        }
+
+    private:
+        void drop_oldest() {
+            while( staged.size() > max_staged && !staged_order.empty() ) {
+                const auto [om_addr, ticket] = staged_order.front();
+                staged_order.pop_front();
+                const auto iter = staged.find( om_addr );
+                if( iter != staged.end() && iter->second.ticket == ticket &&
+                    iter->second.state != staged_state::reading ) {
+                    staged.erase( iter );
+                }
+            }
+        }
+
+        void run() {
+            std::unique_lock<std::mutex> lock( mutex );
+            while( true ) {
+                wake.wait( lock, [this]() {
+                    return stopping || !queue.empty();
+                } );
+                if( stopping ) {
+                    return;
+                }
+                auto [loc, ticket] = std::move( queue.front() );
+                queue.pop_front();
+                auto iter = staged.find( loc.om_addr );
+                if( iter == staged.end() || iter->second.ticket != ticket ||
+                    iter->second.state != staged_state::queued ) {
+                    done.notify_all();
+                    continue;
+                }
+                iter->second.state = staged_state::reading;
+                busy = true;
+                lock.unlock();
+                staged_quad result = read_staged_quad( loc );
+                lock.lock();
+                busy = false;
+                // Cancelling leaves reading entries alone, but check anyway.
+                iter = staged.find( loc.om_addr );
+                if( iter != staged.end() && iter->second.ticket == ticket ) {
+                    result.ticket = ticket;
+                    iter->second = std::move( result );
+                }
+                done.notify_all();
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        std::deque<std::pair<quad_location, uint64_t>> queue;
+        std::map<tripoint_abs_omt, staged_quad> staged;
+        std::deque<std::pair<tripoint_abs_omt, uint64_t>> staged_order;
+        uint64_t last_ticket = 0;
+        bool busy = false;
+        bool stopping = false;
+        // Last, so everything above exists before the thread starts.
+        std::thread worker;
+};
+
+/**
+ * The quad files written by a save or an eviction, by segment. Each segment gets a
+ * single background job, so its archive is opened, appended to and compacted once.
+ */
+struct quad_writes {
+    struct quad {
+        cata_path filename;
+        // Json text, or the binary format once the writer has finished it.
+        std::string contents;
+        std::optional<submap_binary_writer> binary;
+        // Reverted to uniform, the file is removed again right after writing it.
+        bool remove = false;
+    };
+    struct segment {
+        cata_path dirname;
+        std::vector<quad> quads;
+    };
+    std::map<std::string, segment> segments;
+};
+
 mapbuffer MAPBUFFER;
 
 mapbuffer::mapbuffer() = default;
@@ -66,7 +335,104 @@ mapbuffer::~mapbuffer() = default;
 
 void mapbuffer::clear()
 {
+    cancel_prefetch();
+    async_save::wait();
     submaps.clear();
+    quad_last_used.clear();
+    if( !evicted_quads.empty() ) {
+        // Never saved, so they go away with the rest of the unsaved game.
+        std::error_code ec;
+        std::filesystem::remove_all( ( PATH_INFO::world_base_save_path() /
+                                       evicted_maps_folder ).get_unrelative_path(), ec );
+        evicted_quads.clear();
+    }
+}
+
+cata_path mapbuffer::quad_dirname( const tripoint_abs_omt &om_addr ) const
+{
+    if( evicted_quads.count( om_addr ) != 0 ) {
+        return find_dirname( om_addr, evicted_maps_folder );
+    }
+    return find_dirname( om_addr );
+}
+
+void mapbuffer::touch( const tripoint_abs_sm &p )
+{
+    quad_last_used[project_to<coords::omt>( p )] = ++use_tick;
+}
+
+void mapbuffer::prefetch( const tripoint_abs_omt &om_addr )
+{
+    if( submaps.count( project_to<coords::sm>( om_addr ) ) != 0 ) {
+        return;
+    }
+    const cata_path dirname = quad_dirname( om_addr );
+    // The files may be half written, and the regular loading waits for them anyway.
+    if( async_save::in_progress( save_target( dirname ) ) ) {
+        return;
+    }
+    if( !prefetcher ) {
+        prefetcher = std::make_unique<submap_prefetcher>();
+    }
+    quad_location loc;
+    loc.om_addr = om_addr;
+    const std::string file_name = quad_file_name( om_addr );
+    if( world_generator->active_world->has_compression_enabled() ) {
+        cata_path zzip_name = dirname;
+        zzip_name += ".zzip";
+        loc.path = zzip_name.get_unrelative_path();
+        loc.dictionary = maps_dictionary_path().get_unrelative_path();
+        loc.file_name = std::filesystem::u8path( file_name );
+    } else {
+        loc.path = ( dirname / file_name ).get_unrelative_path();
+    }
+    if( prefetcher->request( std::move( loc ) ) ) {
+        turn_counters::add( turn_counter::submap_prefetch_requests, 1 );
+    }
+}
+
+void mapbuffer::prefetch_ahead( const tripoint_abs_sm &bubble_origin,
+                                const point_rel_sm &heading, int reach )
+{
+    const int dir_x = heading.x() > 0 ? 1 : heading.x() < 0 ? -1 : 0;
+    const int dir_y = heading.y() > 0 ? 1 : heading.y() < 0 ? -1 : 0;
+    if( ( dir_x == 0 && dir_y == 0 ) || reach <= 0 ) {
+        return;
+    }
+    std::set<point_abs_omt> ahead;
+    for( int step = 1; step <= reach; ++step ) {
+        // The strip of submaps `step` beyond the edge, widened a bit each step in case
+        // the heading turns.
+        for( int along = -step; along < MAPSIZE + step; ++along ) {
+            if( dir_x != 0 ) {
+                const int x = dir_x > 0 ? bubble_origin.x() + MAPSIZE - 1 + step : bubble_origin.x() - step;
+                ahead.insert( project_to<coords::omt>( point_abs_sm( x, bubble_origin.y() + along ) ) );
+            }
+            if( dir_y != 0 ) {
+                const int y = dir_y > 0 ? bubble_origin.y() + MAPSIZE - 1 + step : bubble_origin.y() - step;
+                ahead.insert( project_to<coords::omt>( point_abs_sm( bubble_origin.x() + along, y ) ) );
+            }
+        }
+    }
+    for( const point_abs_omt &omt : ahead ) {
+        for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; ++z ) {
+            prefetch( tripoint_abs_omt( omt, z ) );
+        }
+    }
+}
+
+void mapbuffer::finish_prefetch()
+{
+    if( prefetcher ) {
+        prefetcher->finish();
+    }
+}
+
+void mapbuffer::cancel_prefetch()
+{
+    if( prefetcher ) {
+        prefetcher->cancel();
+    }
 }
 
 void mapbuffer::clear_outside_reality_bubble()
@@ -77,6 +443,7 @@ void mapbuffer::clear_outside_reality_bubble()
         if( here.inbounds( it->first ) ) {
             ++it;
         } else {
+            quad_last_used.erase( project_to<coords::omt>( it->first ) );
             it = submaps.erase( it );
         }
     }
@@ -88,7 +455,12 @@ bool mapbuffer::add_submap( const tripoint_abs_sm &p, std::unique_ptr<submap> &s
         return false;
     }
 
+    // Freshly generated or loaded submaps are final enough to drop single valued layers.
+    if( sm ) {
+        sm->compact_layers();
+    }
     submaps[p] = std::move( sm );
+    touch( p );
 
     return true;
 }
@@ -105,6 +477,17 @@ bool mapbuffer::add_submap( const tripoint_abs_sm &p, submap *sm )
     return result;
 }
 
+size_t mapbuffer::memory_usage() const
+{
+    size_t total = 0;
+    for( const auto &elem : submaps ) {
+        if( elem.second ) {
+            total += elem.second->memory_usage();
+        }
+    }
+    return total;
+}
+
 void mapbuffer::remove_submap( const tripoint_abs_sm &addr )
 {
     auto m_target = submaps.find( addr );
@@ -113,6 +496,7 @@ void mapbuffer::remove_submap( const tripoint_abs_sm &addr )
         return;
     }
     submaps.erase( m_target );
+    quad_last_used.erase( project_to<coords::omt>( addr ) );
 }
 
 submap *mapbuffer::lookup_submap( const tripoint_abs_sm &p )
@@ -130,6 +514,7 @@ submap *mapbuffer::lookup_submap( const tripoint_abs_sm &p )
         return nullptr;
     }
 
+    touch( p );
     return iter->second.get();
 }
 
@@ -155,7 +540,8 @@ bool mapbuffer::submap_exists_approx( const tripoint_abs_sm &p )
     if( iter == submaps.end() ) {
         try {
             const tripoint_abs_omt om_addr = project_to<coords::omt>( p );
-            const cata_path dirname = find_dirname( om_addr );
+            const cata_path dirname = quad_dirname( om_addr );
+            async_save::wait_for( save_target( dirname ) );
             std::string file_name = quad_file_name( om_addr );
 
             if( world_generator->active_world->has_compression_enabled() ) {
@@ -165,7 +551,7 @@ bool mapbuffer::submap_exists_approx( const tripoint_abs_sm &p )
                     return false;
                 }
                 std::shared_ptr<zzip> z = zzip::load( zzip_name.get_unrelative_path(),
-                                                      ( PATH_INFO::world_base_save_path() / "maps.dict" ).get_unrelative_path() );
+                                                      maps_dictionary_path().get_unrelative_path() );
                 return z->has_file( std::filesystem::u8path( file_name ) );
             } else {
                 return file_exist( dirname / file_name );
@@ -181,6 +567,10 @@ bool mapbuffer::submap_exists_approx( const tripoint_abs_sm &p )
 
 void mapbuffer::save( bool delete_after_save )
 {
+    // Staged reads would be stale after this, and the worker must not read files being written.
+    cancel_prefetch();
+    // Another background save may still be writing the same archives.
+    async_save::wait();
     assure_dir_exist( PATH_INFO::world_base_save_path() / "maps" );
 
     int num_saved_submaps = 0;
@@ -193,6 +583,7 @@ void mapbuffer::save( bool delete_after_save )
     // A set of already-saved submaps, in global overmap coordinates.
     std::set<tripoint_abs_omt> saved_submaps;
     std::list<tripoint_abs_sm> submaps_to_delete;
+    quad_writes writes;
     static constexpr std::chrono::milliseconds update_interval( 500 );
     std::chrono::steady_clock::time_point last_update = std::chrono::steady_clock::now();
 
@@ -227,17 +618,156 @@ void mapbuffer::save( bool delete_after_save )
         // delete_on_save deletes everything, otherwise delete submaps
         // outside the current map.
         save_quad( dirname, quad_path, om_addr, submaps_to_delete,
-                   delete_after_save || !inside_reality_bubble );
+                   delete_after_save || !inside_reality_bubble, writes );
         num_saved_submaps += 4;
     }
     for( auto &elem : submaps_to_delete ) {
         remove_submap( elem );
     }
+    submit_writes( writes );
+    save_evicted( saved_submaps );
+}
+
+void mapbuffer::save_evicted( const std::set<tripoint_abs_omt> &saved_quads )
+{
+    // Grouped by segment, so each archive is opened once.
+    std::map<tripoint_abs_seg, std::vector<tripoint_abs_omt>> by_segment;
+    for( const tripoint_abs_omt &om_addr : evicted_quads ) {
+        // Loaded again since, and saved from memory just now.
+        if( saved_quads.count( om_addr ) == 0 ) {
+            by_segment[project_to<coords::seg>( om_addr )].push_back( om_addr );
+        }
+    }
+    // The scratch store itself is removed by the next eviction, once these jobs are done.
+    evicted_quads.clear();
+
+    const bool compressed = world_generator->active_world->has_compression_enabled();
+    const std::filesystem::path dictionary_path = maps_dictionary_path().get_unrelative_path();
+    for( const auto &[segment, quads] : by_segment ) {
+        const cata_path from = find_dirname( quads.front(), evicted_maps_folder );
+        const cata_path to = find_dirname( quads.front() );
+        std::vector<std::filesystem::path> file_names;
+        file_names.reserve( quads.size() );
+        for( const tripoint_abs_omt &om_addr : quads ) {
+            file_names.push_back( std::filesystem::u8path( quad_file_name( om_addr ) ) );
+        }
+        const std::filesystem::path from_zzip = ( from + ".zzip" ).get_unrelative_path();
+        const std::filesystem::path to_zzip = ( to + ".zzip" ).get_unrelative_path();
+        // Quads that were uniform when evicted have no file. They are generated again, so a
+        // file from before they were reverted to uniform has to go.
+        async_save::submit( save_target( to ), [ =, file_names = std::move( file_names )]() {
+            if( compressed ) {
+                std::shared_ptr<zzip> source;
+                if( std::filesystem::exists( from_zzip ) ) {
+                    source = zzip::load( from_zzip, dictionary_path );
+                }
+                const std::shared_ptr<zzip> target = zzip::load( to_zzip, dictionary_path );
+                if( !target ) {
+                    throw std::runtime_error( "Failed opening compressed save file " +
+                                              to_zzip.generic_u8string() );
+                }
+                std::vector<std::filesystem::path> present;
+                std::unordered_set<std::filesystem::path, std_fs_path_hash> uniform;
+                for( const std::filesystem::path &file_name : file_names ) {
+                    if( source && source->has_file( file_name ) ) {
+                        present.push_back( file_name );
+                    } else if( target->has_file( file_name ) ) {
+                        uniform.insert( file_name );
+                    }
+                }
+                // Same dictionary on both sides, the compressed entries are copied as they are.
+                if( !present.empty() && !target->copy_files( present, source ) ) {
+                    throw std::runtime_error( "Failed copying evicted map data into " +
+                                              to_zzip.generic_u8string() );
+                }
+                if( !uniform.empty() ) {
+                    target->delete_files( uniform );
+                }
+                target->compact( 2.0 );
+                async_save::written( to_zzip );
+            } else {
+                for( const std::filesystem::path &file_name : file_names ) {
+                    const std::filesystem::path source = from.get_unrelative_path() / file_name;
+                    const std::filesystem::path target = to.get_unrelative_path() / file_name;
+                    if( std::filesystem::exists( source ) ) {
+                        assure_dir_exist( to );
+                        std::filesystem::copy_file( source, target,
+                                                    std::filesystem::copy_options::overwrite_existing );
+                        async_save::written( target );
+                    } else {
+                        std::error_code ec;
+                        std::filesystem::remove( target, ec );
+                    }
+                }
+            }
+        } );
+    }
+}
+
+size_t mapbuffer::evict_to_budget( size_t budget )
+{
+    map &here = get_map();
+    size_t resident = 0;
+    std::unordered_map<tripoint_abs_omt, size_t> quad_bytes;
+    for( const auto &elem : submaps ) {
+        const size_t bytes = elem.second ? elem.second->memory_usage() : 0;
+        resident += bytes;
+        const tripoint_abs_omt om_addr = project_to<coords::omt>( elem.first );
+        if( !here.inbounds( om_addr ) ) {
+            quad_bytes[om_addr] += bytes;
+        }
+    }
+    if( resident <= budget ) {
+        return 0;
+    }
+
+    std::vector<std::pair<uint64_t, tripoint_abs_omt>> least_recently_used;
+    least_recently_used.reserve( quad_bytes.size() );
+    for( const auto &[om_addr, bytes] : quad_bytes ) {
+        const auto last_used = quad_last_used.find( om_addr );
+        least_recently_used.emplace_back( last_used == quad_last_used.end() ? 0 : last_used->second,
+                                          om_addr );
+    }
+    std::sort( least_recently_used.begin(), least_recently_used.end() );
+
+    // Staged reads would be stale after this, and the worker must not read files being written.
+    cancel_prefetch();
+    // Waits for the previous save, so nothing reads the scratch store any more.
+    async_save::scope background;
+    const cata_path evicted_root = PATH_INFO::world_base_save_path() / evicted_maps_folder;
+    if( evicted_quads.empty() ) {
+        // Saved already, or left behind by a game that was not saved.
+        std::error_code ec;
+        std::filesystem::remove_all( evicted_root.get_unrelative_path(), ec );
+    }
+    assure_dir_exist( evicted_root );
+
+    size_t evicted = 0;
+    std::list<tripoint_abs_sm> submaps_to_delete;
+    quad_writes writes;
+    for( const auto &[last_used, om_addr] : least_recently_used ) {
+        if( resident <= budget ) {
+            break;
+        }
+        // Submaps are not tracked for changes, so every quad is written back.
+        const cata_path dirname = find_dirname( om_addr, evicted_maps_folder );
+        save_quad( dirname, dirname / quad_file_name( om_addr ), om_addr, submaps_to_delete, true,
+                   writes );
+        evicted_quads.insert( om_addr );
+        resident -= quad_bytes[om_addr];
+        ++evicted;
+    }
+    for( const tripoint_abs_sm &elem : submaps_to_delete ) {
+        remove_submap( elem );
+    }
+    submit_writes( writes );
+    turn_counters::add( turn_counter::quads_evicted, evicted );
+    return evicted;
 }
 
 void mapbuffer::save_quad(
     const cata_path &dirname, const cata_path &filename, const tripoint_abs_omt &om_addr,
-    std::list<tripoint_abs_sm> &submaps_to_delete, bool delete_after_save )
+    std::list<tripoint_abs_sm> &submaps_to_delete, bool delete_after_save, quad_writes &writes )
 {
     std::vector<point_rel_sm> offsets;
     std::vector<tripoint_abs_sm> submap_addrs;
@@ -301,6 +831,12 @@ void mapbuffer::save_quad(
         }
     }
 
+    // Binary is the default, json stays around for debugging and editing saves by hand.
+    quad_writes::quad quad;
+    quad.filename = filename;
+    if( !get_option<bool>( "SAVE_SUBMAPS_AS_JSON" ) ) {
+        quad.binary.emplace();
+    }
     std::stringstream stringout;
     JsonOut jsout( stringout );
     jsout.start_array();
@@ -315,6 +851,19 @@ void mapbuffer::save_quad(
             continue;
         }
 
+        if( delete_after_save ) {
+            submaps_to_delete.push_back( submap_addr );
+        } else {
+            // Kept around, changes made while it was in the reality bubble may have
+            // left layers single valued again.
+            sm->compact_layers();
+        }
+
+        if( quad.binary ) {
+            quad.binary->add( submap_addr, *sm );
+            continue;
+        }
+
         jsout.start_object();
 
         jsout.member( "version", savegame_version );
@@ -329,34 +878,80 @@ void mapbuffer::save_quad(
         sm->store( jsout );
 
         jsout.end_object();
-
-        if( delete_after_save ) {
-            submaps_to_delete.push_back( submap_addr );
-        }
     }
 
     jsout.end_array();
 
-    std::string s = std::move( stringout ).str();
+    quad.contents = std::move( stringout ).str();
+    quad.remove = all_uniform && reverted_to_uniform;
+    quad_writes::segment &segment = writes.segments[dirname.generic_u8string()];
+    segment.dirname = dirname;
+    segment.quads.emplace_back( std::move( quad ) );
+}
 
-    if( z ) {
-        z->add_file( filename.get_relative_path().filename(), s );
-        z->compact( 2.0 );
-    } else {
-        // Don't create the directory if it would be empty
-        assure_dir_exist( dirname );
-        write_to_file( filename, [&]( std::ostream & fout ) {
-            fout << s;
+void mapbuffer::submit_writes( quad_writes &writes )
+{
+    const bool compressed = world_generator->active_world->has_compression_enabled();
+    const std::filesystem::path dictionary_path = maps_dictionary_path().get_unrelative_path();
+    for( auto &[name, segment] : writes.segments ) {
+        const cata_path dirname = segment.dirname;
+        const std::filesystem::path zzip_path = ( dirname + ".zzip" ).get_unrelative_path();
+        async_save::submit( save_target( dirname ), [ =, quads = std::move( segment.quads )]() mutable {
+            for( quad_writes::quad &quad : quads )
+            {
+                if( quad.binary ) {
+                    quad.contents = quad.binary->finish();
+                    quad.binary.reset();
+                }
+            }
+            if( !compressed )
+            {
+                // Don't create the directory if it would be empty
+                assure_dir_exist( dirname );
+                for( const quad_writes::quad &quad : quads ) {
+                    write_to_file( quad.filename, [&]( std::ostream & fout ) {
+                        fout << quad.contents;
+                    } );
+                    if( quad.remove ) {
+                        std::filesystem::remove( quad.filename.get_unrelative_path() );
+                    } else {
+                        async_save::written( quad.filename.get_unrelative_path() );
+                    }
+                }
+                return;
+            }
+            std::shared_ptr<zzip> z = zzip::load( zzip_path, dictionary_path );
+            if( !z )
+            {
+                throw std::runtime_error( "Failed opening compressed save file " +
+                                          zzip_path.generic_u8string() );
+            }
+            std::vector<std::pair<std::filesystem::path, std::string_view>> files;
+            std::unordered_set<std::filesystem::path, std_fs_path_hash> removed;
+            files.reserve( quads.size() );
+            for( const quad_writes::quad &quad : quads )
+            {
+                const std::filesystem::path file_name = quad.filename.get_relative_path().filename();
+                files.emplace_back( file_name, quad.contents );
+                if( quad.remove ) {
+                    removed.insert( file_name );
+                }
+            }
+            if( !z->add_files( files ) )
+            {
+                throw std::runtime_error( "Failed writing map data to " + zzip_path.generic_u8string() );
+            }
+            if( !removed.empty() )
+            {
+                z->delete_files( removed );
+            }
+            // Quads are rewritten on every save, drop the old versions once they take up
+            // as much space as the current ones.
+            z->compact_if_dead( 0.5 );
+            async_save::written( zzip_path );
         } );
     }
-
-    if( all_uniform && reverted_to_uniform ) {
-        if( z ) {
-            z->delete_files( { filename.get_relative_path().filename() } );
-        } else {
-            std::filesystem::remove( filename.get_unrelative_path() );
-        }
-    }
+    writes.segments.clear();
 }
 
 // We're reading in way too many entities here to mess around with creating sub-objects and
@@ -365,12 +960,37 @@ submap *mapbuffer::unserialize_submaps( const tripoint_abs_sm &p )
 {
     // Map the tripoint to the submap quad that stores it.
     const tripoint_abs_omt om_addr = project_to<coords::omt>( p );
-    const cata_path dirname = find_dirname( om_addr );
+    const cata_path dirname = quad_dirname( om_addr );
     std::string file_name = quad_file_name( om_addr );
     std::filesystem::path file_name_path = std::filesystem::u8path( file_name );
     cata_path quad_path = dirname / file_name;
 
-    bool read = [&] {
+    const std::chrono::steady_clock::time_point load_start = std::chrono::steady_clock::now();
+    // The quad may have been unloaded by a save that is still being written out.
+    async_save::wait_for( save_target( dirname ) );
+    std::optional<staged_quad> staged;
+    if( prefetcher ) {
+        staged = prefetcher->take( om_addr );
+    }
+    turn_counters::add( staged ? turn_counter::submap_prefetch_hits :
+                        turn_counter::submap_prefetch_misses, 1 );
+
+    const auto read_staged = [&]() {
+        if( staged->state == staged_state::missing ) {
+            return false;
+        }
+        try {
+            std::shared_ptr<std::string> contents = std::make_shared<std::string>( std::move(
+                        staged->contents ) );
+            deserialize( contents, *contents );
+        } catch( std::exception &err ) {
+            debugmsg( _( "Failed to read from \"%1$s\": %2$s" ), quad_path.generic_u8string(), err.what() );
+            return false;
+        }
+        return true;
+    };
+
+    bool read = staged ? read_staged() : [&] {
         if( world_generator->active_world->has_compression_enabled() )
         {
             cata_path zzip_name = dirname;
@@ -383,11 +1003,11 @@ submap *mapbuffer::unserialize_submaps( const tripoint_abs_sm &p )
             if( !z->has_file( file_name_path ) ) {
                 return false;
             }
-            std::vector<std::byte> contents = z->get_file( file_name_path );
-            std::string_view string_contents{ reinterpret_cast<char *>( contents.data() ), contents.size() };
-            JsonValue jsin = json_loader::from_string( std::string( string_contents ) );
+            std::shared_ptr<std::vector<std::byte>> contents = std::make_shared<std::vector<std::byte>>
+                    ( z->get_file( file_name_path ) );
             try {
-                deserialize( jsin );
+                deserialize( contents, std::string_view( reinterpret_cast<const char *>( contents->data() ),
+                             contents->size() ) );
             } catch( std::exception &err ) {
                 debugmsg( _( "Failed to read from \"%1$s\": %2$s" ), zzip_name.generic_u8string() + ":" + file_name,
                           err.what() );
@@ -396,12 +1016,28 @@ submap *mapbuffer::unserialize_submaps( const tripoint_abs_sm &p )
             return true;
         } else
         {
+            // Binary quads are read in place, json and gzipped legacy quads as usual.
+            std::shared_ptr<const mmap_file> mapped = mmap_file::map_file( quad_path.get_unrelative_path() );
+            const std::string_view contents = mapped ? std::string_view( static_cast<const char *>
+                                              ( mapped->base() ), mapped->len() ) : std::string_view();
+            if( submap_binary_reader::is_binary( contents ) ) {
+                try {
+                    deserialize( mapped, contents );
+                } catch( std::exception &err ) {
+                    debugmsg( _( "Failed to read from \"%1$s\": %2$s" ), quad_path.generic_u8string(), err.what() );
+                    return false;
+                }
+                return true;
+            }
             return read_from_file_optional_json( quad_path, [this]( const JsonValue & jsin ) {
                 deserialize( jsin );
             } );
 
         }
     }();
+    turn_counters::add( turn_counter::submap_load_stall_us,
+                        std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - load_start ).count() );
 
     if( !read ) {
         return nullptr;
@@ -419,6 +1055,21 @@ submap *mapbuffer::unserialize_submaps( const tripoint_abs_sm &p )
     return submaps[ p ].get();
 }
 
+void mapbuffer::deserialize( std::shared_ptr<const void> owner, std::string_view contents )
+{
+    if( !submap_binary_reader::is_binary( contents ) ) {
+        deserialize( json_loader::from_string( std::string( contents ) ) );
+        return;
+    }
+    const submap_binary_reader reader( std::move( owner ), contents );
+    for( size_t i = 0; i < reader.size(); ++i ) {
+        std::unique_ptr<submap> sm = reader.load( i );
+        if( !add_submap( reader.position( i ), sm ) ) {
+            debugmsg( "submap %s was already loaded", reader.position( i ).to_string() );
+        }
+    }
+}
+
 void mapbuffer::deserialize( const JsonArray &ja )
 {
     for( JsonObject submap_json : ja ) {
@@ -2,15 +2,22 @@
 #ifndef CATA_SRC_MAPBUFFER_H
 #define CATA_SRC_MAPBUFFER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
+#include <string_view>
+#include <unordered_map>
 
 #include "coordinates.h"
 
 class JsonArray;
 class cata_path;
 class submap;
+struct quad_writes;
+struct submap_prefetcher;
 
 /**
  * Store, buffer, save and load the entire world map.
@@ -22,6 +29,8 @@ class mapbuffer
         ~mapbuffer();
 
         /** Store all submaps in this instance into savefiles.
+         * Quads unloaded by @ref evict_to_budget since the last save are moved
+         * into the savefiles as well.
          * @param delete_after_save If true, the saved submaps are removed
          * from the mapbuffer (and deleted).
          **/
@@ -66,6 +75,51 @@ class mapbuffer
         // Cheaper version of the above for when you don't mind some false results
         bool submap_exists_approx( const tripoint_abs_sm &p );
 
+        /** Memory used by the buffered submaps, see @ref submap::memory_usage. */
+        size_t memory_usage() const;
+        /** Number of buffered submaps. */
+        size_t submap_count() const {
+            return submaps.size();
+        }
+        /** Number of quads unloaded by @ref evict_to_budget that have not been saved yet. */
+        size_t evicted_quad_count() const {
+            return evicted_quads.size();
+        }
+
+        /**
+         * Unloads the least recently used quads outside the reality bubble until the
+         * buffered submaps use at most @p budget bytes, see @ref memory_usage.
+         *
+         * The quads are written in the background to a scratch store next to the map
+         * files, and @ref lookup_submap loads them from there again. They only become
+         * part of the world with the next @ref save, so quitting without saving still
+         * drops all changes made since the last save.
+         *
+         * Like @ref save, this must not run while a tinymap holds buffered submaps.
+         * @return The number of quads unloaded.
+         */
+        size_t evict_to_budget( size_t budget );
+
+        /**
+         * Start reading the quad file of the given overmap terrain on a worker thread,
+         * so that a later @ref lookup_submap only has to deserialize it. Does nothing
+         * if the quad is already loaded or being read.
+         */
+        void prefetch( const tripoint_abs_omt &om_addr );
+        /**
+         * Prefetch the quads the reality bubble starting at @p bubble_origin will enter
+         * next when it keeps moving towards @p heading, up to @p reach submaps ahead.
+         */
+        void prefetch_ahead( const tripoint_abs_sm &bubble_origin, const point_rel_sm &heading,
+                             int reach );
+        /**
+         * Blocks until every quad requested with @ref prefetch has been read. Quads that
+         * are still queued when they are looked up are read by the main thread instead.
+         */
+        void finish_prefetch();
+        /** Drop all prefetched quads, waiting for a read in progress to finish. */
+        void cancel_prefetch();
+
     private:
         using submap_map_t = std::map<tripoint_abs_sm, std::unique_ptr<submap>>;
 
@@ -84,11 +138,30 @@ class mapbuffer
         submap *unserialize_submaps( const tripoint_abs_sm &p );
         bool submap_file_exists( const tripoint_abs_sm &p );
         void deserialize( const JsonArray &ja );
+        /**
+         * Adds the submaps of a quad file in the binary or the json format.
+         * @param owner keeps @p contents alive while they are read.
+         */
+        void deserialize( std::shared_ptr<const void> owner, std::string_view contents );
         void save_quad(
             const cata_path &dirname, const cata_path &filename,
             const tripoint_abs_omt &om_addr, std::list<tripoint_abs_sm> &submaps_to_delete,
-            bool delete_after_save );
+            bool delete_after_save, quad_writes &writes );
+        /** Hands the quad files collected by @ref save_quad to the background save. */
+        static void submit_writes( quad_writes &writes );
+        /** Directory of the quad file, in the scratch store if the quad has been evicted. */
+        cata_path quad_dirname( const tripoint_abs_omt &om_addr ) const;
+        /** Marks the quad holding @p p as used now, for @ref evict_to_budget. */
+        void touch( const tripoint_abs_sm &p );
+        /** Moves the evicted quads that are not loaded again from the scratch store into the world. */
+        void save_evicted( const std::set<tripoint_abs_omt> &saved_quads );
         submap_map_t submaps; // NOLINT(cata-serialize)
+        std::unique_ptr<submap_prefetcher> prefetcher; // NOLINT(cata-serialize)
+        // Quads written to the scratch store since the last save.
+        std::set<tripoint_abs_omt> evicted_quads; // NOLINT(cata-serialize)
+        // When each loaded quad was last looked up, in ticks of use_tick.
+        std::unordered_map<tripoint_abs_omt, uint64_t> quad_last_used; // NOLINT(cata-serialize)
+        uint64_t use_tick = 0; // NOLINT(cata-serialize)
 };
 
 extern mapbuffer MAPBUFFER;
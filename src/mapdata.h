@@ -750,6 +750,18 @@ class ter_furn_migrations
 
         /** Checks migrations */
         static void check();
+
+        /**
+         * Terrain a saved terrain id loads as, and the furniture the migration adds
+         * (f_null if none). Invalid ids load as dirt.
+         */
+        static std::pair<ter_id, furn_id> migrate_terrain( const ter_str_id &ter );
+
+        /**
+         * Furniture a saved furniture id loads as, and the terrain the migration puts
+         * under it (t_null if the terrain stays). Invalid ids load as f_null.
+         */
+        static std::pair<ter_id, furn_id> migrate_furniture( const furn_str_id &furn );
 };
 
 class trap_migrations
@@ -5,6 +5,7 @@
 #include <sstream>
 #include <string>
 
+#include "async_save.h"
 #include "filesystem.h"
 #include "ofstream_wrapper.h"
 
@@ -158,6 +159,8 @@ void ofstream_wrapper::close()
         std::filesystem::remove( temp_path, ec );
         throw std::runtime_error( "writing to file failed" );
     }
+    // In the background, the rename may reach the disk before the data does.
+    async_save::sync( temp_path );
     std::error_code ec2;
     std::filesystem::rename( temp_path, path, ec2 );
     if( ec2 ) {
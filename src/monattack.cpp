@@ -3186,7 +3186,7 @@ bool mattack::upgrade( monster *z )
     const map &here = get_map();
 
     std::vector<monster *> targets;
-    for( monster &zed : g->all_monsters() ) {
+    get_creature_tracker().for_each_in_radius( z->pos_abs(), 10, [&]( monster & zed ) {
         // Check this first because it is a relatively cheap check
         if( zed.can_upgrade() ) {
             // Then do the more expensive ones
@@ -3195,7 +3195,7 @@ bool mattack::upgrade( monster *z )
                 targets.push_back( &zed );
             }
         }
-    }
+    } );
     if( targets.empty() ) {
         // Nobody to upgrade, get MAD!
         z->anger = 100;
@@ -3982,12 +3982,11 @@ bool mattack::mon_leech_evolution( monster *z )
 {
     const bool is_queen = z->has_flag( mon_flag_QUEEN );
     std::list<monster *> queens;
-    for( monster &candidate : g->all_monsters() ) {
-        if( candidate.in_species( species_LEECH_PLANT ) && candidate.has_flag( mon_flag_QUEEN ) &&
-            rl_dist( z->pos_bub(), candidate.pos_bub() ) < 35 ) {
+    get_creature_tracker().for_each_in_radius( z->pos_abs(), 34, [&]( monster & candidate ) {
+        if( candidate.in_species( species_LEECH_PLANT ) && candidate.has_flag( mon_flag_QUEEN ) ) {
             queens.push_back( &candidate );
         }
-    }
+    } );
     if( !is_queen ) {
         if( queens.empty() ) {
             z->poly( mon_leech_blossom );
@@ -41,6 +41,7 @@
 #include "npc.h"
 #include "options.h"
 #include "pathfinding.h"
+#include "perf.h"
 #include "pimpl.h"
 #include "point.h"
 #include "rng.h"
@@ -430,12 +431,16 @@ void monster::anger_mating_season( const monster_plan &mon_plan )
 
 void monster::anger_cub_threatened( monster_plan &mon_plan )
 {
-    if( mon_plan.angers_cub_threatened < 0 ) {
-        // return early, not angered by cubs being threatened
+    if( mon_plan.angers_cub_threatened <= 0 ||
+        ( type->baby_type.baby_monster.is_null() && type->baby_type.baby_monster_group.is_null() ) ) {
+        // return early, not angered by cubs being threatened or can't have any.
+        // Otherwise every member of a horde that sees its target would scan every monster.
         return;
     }
 
-    for( monster &tmp : g->all_monsters() ) {
+    // A baby rates the target only if it sees it, which never reaches past MAX_VIEW_DISTANCE.
+    get_creature_tracker().for_each_in_radius( mon_plan.target->pos_abs(), MAX_VIEW_DISTANCE,
+    [&]( monster & tmp ) {
         bool is_baby = false;
         if( !type->baby_type.baby_monster.is_null() ) {
             is_baby = type->baby_type.baby_monster == tmp.type->id;
@@ -455,7 +460,7 @@ void monster::anger_cub_threatened( monster_plan &mon_plan )
                 aggro_character = true;
             }
         }
-    }
+    } );
 }
 
 bool monster::mating_angry() const
@@ -476,6 +481,7 @@ bool monster::mating_angry() const
 
 void monster::plan()
 {
+    CATA_PROFILE_ZONE( "monster::plan" );
     monster_plan mon_plan( *this );
 
     map &here = get_map();
@@ -507,7 +513,9 @@ void monster::plan()
         }
         anger_cub_threatened( mon_plan );
     } else if( friendly != 0 && !mon_plan.docile ) {
-        for( monster &tmp : g->all_monsters() ) {
+        // rate_target requires sight, which never reaches past MAX_VIEW_DISTANCE.
+        get_creature_tracker().for_each_in_radius( pos_abs(), MAX_VIEW_DISTANCE,
+        [&]( monster & tmp ) {
             if( tmp.friendly == 0 && tmp.attitude_to( *this ) == Attitude::HOSTILE &&
                 seen_levels.test( tmp.posz() + OVERMAP_DEPTH ) ) {
                 float rating = rate_target( tmp, mon_plan.dist, mon_plan.smart_planning );
@@ -516,7 +524,7 @@ void monster::plan()
                     mon_plan.dist = rating;
                 }
             }
-        }
+        } );
     }
 
     if( mon_plan.docile ) {
@@ -826,6 +834,7 @@ bool monster::die_if_drowning( const tripoint_bub_ms &at_pos, const int chance )
 // 4) Sound-based tracking
 void monster::move()
 {
+    CATA_PROFILE_ZONE( "monster::move" );
     map &here = get_map();
 
     add_msg_debug( debugmode::DF_MONMOVE, "Monster %s starting monmove::move, remaining moves %d",
@@ -1657,6 +1657,13 @@ void options_manager::add_options_general()
 
     add_empty_line();
 
+    add( "MAPBUFFER_MEMORY_BUDGET", "general", to_translation( "Map memory budget" ),
+         to_translation( "Megabytes of map data kept in memory.  When there is more, the areas outside the reality bubble that were visited least recently are unloaded until they are visited again.  0 = unlimited." ),
+         0, 16384, 512
+       );
+
+    add_empty_line();
+
     add_option_group( "general", Group( "auto_note_opts", to_translation( "Auto notes options" ),
                                         to_translation( "Options regarding auto notes." ) ),
     [&]( const std::string & page_id ) {
@@ -2909,6 +2916,12 @@ void options_manager::add_options_debug()
          false
 #endif
        );
+
+    add_empty_line();
+
+    add( "SAVE_SUBMAPS_AS_JSON", "debug", to_translation( "Save map data as JSON" ),
+         to_translation( "If enabled, map data is saved as JSON text instead of the faster binary format.  Both formats can be loaded.  Useful for inspecting or editing saves by hand." ),
+         false );
 }
 
 void options_manager::add_options_android()
@@ -19,6 +19,7 @@
 
 #include "all_enum_values.h"
 #include "assign.h"
+#include "async_save.h"
 #include "auto_note.h"
 #include "avatar.h"
 #include "cached_options.h"
@@ -7790,39 +7791,53 @@ void overmap::open( overmap_special_batch &enabled_specials )
 // Note: this may throw io errors from std::ofstream
 void overmap::save() const
 {
-    write_to_file( overmapbuffer::player_filename( loc ), [&]( std::ostream & stream ) {
-        serialize_view( stream );
+    // Serialize here, the strings are what gets written even if the game goes on meanwhile.
+    std::ostringstream view;
+    serialize_view( view );
+    const cata_path view_path = overmapbuffer::player_filename( loc );
+    async_save::submit( view_path.generic_u8string(), [view_path, contents = view.str()]() {
+        write_to_file( view_path, [&]( std::ostream & stream ) {
+            stream << contents;
+        } );
+        async_save::written( view_path.get_unrelative_path() );
     } );
 
+    std::ostringstream terrain;
+    serialize( terrain );
     if( world_generator->active_world->has_compression_enabled() ) {
         const std::string terfilename = overmapbuffer::terrain_filename( loc );
         const std::filesystem::path terfilename_path = std::filesystem::u8path( terfilename );
         const cata_path overmaps_folder = PATH_INFO::world_base_save_path() / "overmaps";
         assure_dir_exist( overmaps_folder );
         const cata_path zzip_path = overmaps_folder / terfilename_path + ".zzip";
-        std::shared_ptr<zzip> z = zzip::load( zzip_path.get_unrelative_path(),
-                                              ( PATH_INFO::world_base_save_path() / "overmaps.dict" ).get_unrelative_path()
-                                            );
-        if( !z ) {
-            throw std::runtime_error(
-                string_format(
-                    "Failed to open %s",
-                    zzip_path.get_unrelative_path().generic_u8string().c_str()
-                )
-            );
-        }
-
-        std::stringstream s;
-        serialize( s );
-
-        if( !z->add_file( terfilename_path, s.str() ) ) {
-            throw std::runtime_error( string_format( "Failed to save omap %d.%d to %s", loc.x(),
-                                      loc.y(), zzip_path.get_unrelative_path().generic_u8string().c_str() ) );
-        }
+        const std::filesystem::path dictionary_path = ( PATH_INFO::world_base_save_path() /
+                "overmaps.dict" ).get_unrelative_path();
+        async_save::submit( zzip_path.generic_u8string(), [zzip_path, dictionary_path, terfilename_path,
+                                     pos = loc, contents = terrain.str()]() {
+            std::shared_ptr<zzip> z = zzip::load( zzip_path.get_unrelative_path(), dictionary_path );
+            if( !z ) {
+                throw std::runtime_error(
+                    string_format(
+                        "Failed to open %s",
+                        zzip_path.get_unrelative_path().generic_u8string().c_str()
+                    )
+                );
+            }
+
+            if( !z->add_file( terfilename_path, contents ) ) {
+                throw std::runtime_error( string_format( "Failed to save omap %d.%d to %s", pos.x(),
+                                          pos.y(), zzip_path.get_unrelative_path().generic_u8string().c_str() ) );
+            }
+            async_save::written( zzip_path.get_unrelative_path() );
+        } );
     } else {
-        write_to_file( PATH_INFO::world_base_save_path() / overmapbuffer::terrain_filename( loc ), [&](
-        std::ostream & stream ) {
-            serialize( stream );
+        const cata_path terrain_path = PATH_INFO::world_base_save_path() /
+                                       overmapbuffer::terrain_filename( loc );
+        async_save::submit( terrain_path.generic_u8string(), [terrain_path, contents = terrain.str()]() {
+            write_to_file( terrain_path, [&]( std::ostream & stream ) {
+                stream << contents;
+            } );
+            async_save::written( terrain_path.get_unrelative_path() );
         } );
     }
 }
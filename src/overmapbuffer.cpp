@@ -10,6 +10,7 @@
 #include <string>
 #include <tuple>
 
+#include "async_save.h"
 #include "basecamp.h"
 #include "calendar.h"
 #include "cata_assert.h"
@@ -230,6 +231,8 @@ void overmapbuffer::fix_npcs( overmap &new_overmap )
 
 void overmapbuffer::save()
 {
+    // A background save may still be writing the same files.
+    async_save::wait();
     for( auto &omp : overmaps ) {
         // Note: this may throw io errors from std::ofstream
         omp.second->save();
@@ -238,12 +241,14 @@ void overmapbuffer::save()
 
 void overmapbuffer::reset()
 {
+    async_save::wait();
     overmaps.clear();
     last_requested_overmap = nullptr;
 }
 
 void overmapbuffer::clear()
 {
+    async_save::wait();
     overmaps.clear();
     known_non_existing.clear();
     placed_unique_specials.clear();
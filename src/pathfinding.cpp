@@ -8,9 +8,11 @@
 #include <memory>
 #include <optional>
 #include <queue>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "calendar.h"
 #include "cata_utility.h"
 #include "coordinates.h"
 #include "creature.h"
@@ -21,6 +23,7 @@
 #include "map_scale_constants.h"
 #include "mapdata.h"
 #include "maptile_fwd.h"
+#include "perf.h"
 #include "point.h"
 #include "submap.h"
 #include "trap.h"
@@ -380,6 +383,385 @@ int map::extra_cost( const tripoint_bub_ms &cur, const tripoint_bub_ms &p,
     return pass_cost + avoid_cost;
 }
 
+// Fields kept per z-level; a horde rarely chases more than a handful of targets at once
+static constexpr size_t max_flow_fields = 8;
+
+void map::build_flow_field( flow_field &field, const pathfinding_cache &pf_cache ) const
+{
+    CATA_PROFILE_ZONE( "map::build_flow_field" );
+    field.cost = std::make_unique<cata::mdarray<int, point_bub_ms>>( -1 );
+    field.next = std::make_unique<cata::mdarray<point_bub_ms, point_bub_ms>>();
+    cata::mdarray<int, point_bub_ms> &cost = *field.cost;
+    cata::mdarray<point_bub_ms, point_bub_ms> &next = *field.next;
+    const int z = field.target.z();
+
+    std::priority_queue< std::pair<int, point_bub_ms>, std::vector< std::pair<int, point_bub_ms> >, pair_greater_cmp_first >
+    open;
+    for( const tripoint_bub_ms &p : points_in_radius( field.target, field.r ) ) {
+        cost[p.xy()] = 0;
+        next[p.xy()] = p.xy();
+        open.emplace( 0, p.xy() );
+    }
+
+    constexpr std::array<int, 8> x_offset{ { -1,  1,  0,  0,  1, -1, -1, 1 } };
+    constexpr std::array<int, 8> y_offset{ {  0,  0, -1,  1, -1,  1, -1, 1 } };
+    while( !open.empty() ) {
+        const auto [cur_cost, cur] = open.top();
+        open.pop();
+        if( cur_cost > cost[cur] ) {
+            // Already reached more cheaply
+            continue;
+        }
+        const tripoint_bub_ms to( cur, z );
+        const PathfindingFlags cur_special = pf_cache.special[cur];
+        for( size_t i = 0; i < 8; i++ ) {
+            const tripoint_bub_ms from( cur.x() + x_offset[i], cur.y() + y_offset[i], z );
+            if( !inbounds( from ) ) {
+                continue;
+            }
+            // The search runs backwards, so this is the cost of stepping from |from| onto |cur|
+            const int step = extra_cost( from, to, field.settings, cur_special );
+            if( step < 0 ) {
+                continue;
+            }
+            // Same diagonal penalty as in map::route
+            const int new_cost = cur_cost + step + ( ( x_offset[i] != 0 && y_offset[i] != 0 ) ? 1 : 0 );
+            int &from_cost = cost[from.xy()];
+            if( from_cost >= 0 && from_cost <= new_cost ) {
+                continue;
+            }
+            from_cost = new_cost;
+            next[from.xy()] = cur;
+            open.emplace( new_cost, from.xy() );
+        }
+    }
+}
+
+std::optional<std::vector<tripoint_bub_ms>> map::flow_field_route( const tripoint_bub_ms &f,
+        const pathfinding_target &target, const pathfinding_settings &settings,
+        const std::function<bool( const tripoint_bub_ms & )> &avoid ) const
+{
+    // Routes between z-levels, and ones that may climb down ledges to avoid traps, need
+    // the full search.
+    if( f.z() != target.center.z() || settings.avoid_traps ) {
+        return std::nullopt;
+    }
+    // Brings the cache up to date first, which drops fields made stale by map changes
+    const pathfinding_cache &pf_cache = get_pathfinding_cache_ref( f.z() );
+    std::vector<flow_field> &fields = get_pathfinding_cache( f.z() ).flow_fields;
+    fields.erase( std::remove_if( fields.begin(), fields.end(), []( const flow_field & field ) {
+        return field.turn != calendar::turn;
+    } ), fields.end() );
+
+    auto field_it = std::find_if( fields.begin(), fields.end(), [&]( const flow_field & field ) {
+        return field.matches( target, settings );
+    } );
+    if( field_it == fields.end() ) {
+        if( fields.size() >= max_flow_fields ) {
+            fields.erase( fields.begin() );
+        }
+        flow_field &field = fields.emplace_back();
+        field.target = target.center;
+        field.r = target.r;
+        field.settings = settings;
+        field.turn = calendar::turn;
+        field.first_origin = f;
+        return std::nullopt;
+    }
+    flow_field &field = *field_it;
+    if( !field.cost ) {
+        if( field.first_origin == f ) {
+            // Asked again by the same creature, nothing to share yet
+            return std::nullopt;
+        }
+        build_flow_field( field, pf_cache );
+    }
+
+    std::vector<tripoint_bub_ms> ret;
+    const cata::mdarray<int, point_bub_ms> &cost = *field.cost;
+    const int total_cost = cost[f.xy()];
+    if( total_cost < 0 || total_cost > settings.max_length ) {
+        return ret;
+    }
+    ret.reserve( rl_dist( f, target.center ) * 2 );
+    // Every step costs at least 1, so this always ends at the target
+    for( tripoint_bub_ms cur = f; cost[cur.xy()] > 0; ) {
+        cur = tripoint_bub_ms( ( *field.next )[cur.xy()], cur.z() );
+        if( !target.contains( cur ) && avoid( cur ) ) {
+            // The shared route isn't good for this creature. The cheapest route that avoids
+            // the tile needs its own search.
+            return std::nullopt;
+        }
+        ret.push_back( cur );
+    }
+    return ret;
+}
+
+// Routes shorter than this are searched directly, longer ones are planned over portals first
+static constexpr int portal_route_min_dist = 2 * SEEX;
+
+// Whether a tile can be part of a route between submaps, for someone who can open doors and
+// climb. Planning doesn't know who is moving; the routes searched within each submap do.
+static bool is_portal_passable( PathfindingFlags special )
+{
+    return !( special & PathfindingFlag::Obstacle ) ||
+           special & ( PathfindingFlag::Door | PathfindingFlag::Climbable );
+}
+
+static int portal_step_cost( PathfindingFlags special )
+{
+    return special & ( PathfindingFlag::Obstacle | PathfindingFlag::Slow ) ? 4 : 2;
+}
+
+static point_bub_sm cluster_of( const point_bub_ms &p )
+{
+    return point_bub_sm( p.x() / SEEX, p.y() / SEEY );
+}
+
+static point_bub_ms cluster_origin( const point_bub_sm &cluster )
+{
+    return point_bub_ms( cluster.x() * SEEX, cluster.y() * SEEY );
+}
+
+static int cluster_index( const point_bub_ms &p )
+{
+    return ( p.x() % SEEX ) * SEEY + p.y() % SEEY;
+}
+
+// Costs of walking from |from| to every tile of its submap without leaving it, indexed by
+// cluster_index, or -1 for tiles that can't be reached that way.
+static std::array<int, SEEX *SEEY> cluster_costs( const pathfinding_cache &cache,
+        const point_bub_ms &from )
+{
+    std::array<int, SEEX *SEEY> costs;
+    costs.fill( -1 );
+    const point_bub_ms origin = cluster_origin( cluster_of( from ) );
+    const point_bub_ms last = origin + point( SEEX - 1, SEEY - 1 );
+    std::priority_queue< std::pair<int, point_bub_ms>, std::vector< std::pair<int, point_bub_ms> >, pair_greater_cmp_first >
+    open;
+    costs[cluster_index( from )] = 0;
+    open.emplace( 0, from );
+    while( !open.empty() ) {
+        const auto [cur_cost, cur] = open.top();
+        open.pop();
+        if( cur_cost > costs[cluster_index( cur )] ) {
+            continue;
+        }
+        for( const tripoint &d : eight_horizontal_neighbors ) {
+            const point_bub_ms p = cur + d.xy();
+            if( p.x() < origin.x() || p.y() < origin.y() || p.x() > last.x() || p.y() > last.y() ) {
+                continue;
+            }
+            const PathfindingFlags p_special = cache.special[p];
+            if( !is_portal_passable( p_special ) ) {
+                continue;
+            }
+            const int new_cost = cur_cost + portal_step_cost( p_special ) + ( d.x != 0 && d.y != 0 ? 1 : 0 );
+            int &p_cost = costs[cluster_index( p )];
+            if( p_cost < 0 || new_cost < p_cost ) {
+                p_cost = new_cost;
+                open.emplace( new_cost, p );
+            }
+        }
+    }
+    return costs;
+}
+
+static void update_pathfinding_cluster( pathfinding_cache &cache, const point_bub_sm &cluster,
+                                        int mapsize )
+{
+    turn_counters::add( turn_counter::pathfinding_clusters_rebuilt, 1 );
+    pathfinding_cluster &cl = cache.clusters[cluster];
+    cl.dirty = false;
+    cl.portals.clear();
+    const point_bub_ms origin = cluster_origin( cluster );
+
+    // First tile of each edge, the direction along it, and the direction out of the submap.
+    // Neighbours walk their shared edge in the same direction, so both sides agree on where
+    // the portals are.
+    struct cluster_edge {
+        point start;
+        point along;
+        point out;
+    };
+    static constexpr std::array<cluster_edge, 4> edges = { {
+            { point::zero, point::east, point::north },
+            { point( 0, SEEY - 1 ), point::east, point::south },
+            { point::zero, point::south, point::west },
+            { point( SEEX - 1, 0 ), point::south, point::east },
+        }
+    };
+    for( const cluster_edge &edge : edges ) {
+        const point_bub_sm neighbour = cluster + edge.out;
+        if( neighbour.x() < 0 || neighbour.y() < 0 || neighbour.x() >= mapsize ||
+            neighbour.y() >= mapsize ) {
+            continue;
+        }
+        int run_start = -1;
+        for( int i = 0; i <= SEEX; ++i ) {
+            const point_bub_ms inside = origin + edge.start + edge.along * i;
+            const bool open = i < SEEX && is_portal_passable( cache.special[inside] ) &&
+                              is_portal_passable( cache.special[inside + edge.out] );
+            if( open && run_start < 0 ) {
+                run_start = i;
+            } else if( !open && run_start >= 0 ) {
+                const point_bub_ms portal = origin + edge.start + edge.along * ( ( run_start + i - 1 ) / 2 );
+                if( std::find( cl.portals.begin(), cl.portals.end(), portal ) == cl.portals.end() ) {
+                    cl.portals.push_back( portal );
+                }
+                run_start = -1;
+            }
+        }
+    }
+
+    const size_t num_portals = cl.portals.size();
+    cl.portal_costs.assign( num_portals * num_portals, -1 );
+    for( size_t i = 0; i < num_portals; ++i ) {
+        const std::array<int, SEEX *SEEY> costs = cluster_costs( cache, cl.portals[i] );
+        for( size_t j = 0; j < num_portals; ++j ) {
+            cl.portal_costs[i * num_portals + j] = costs[cluster_index( cl.portals[j] )];
+        }
+    }
+}
+
+std::optional<std::vector<tripoint_bub_ms>> map::portal_route( const tripoint_bub_ms &f,
+        const pathfinding_target &target, const pathfinding_settings &settings,
+        const std::function<bool( const tripoint_bub_ms & )> &avoid ) const
+{
+    const tripoint_bub_ms &t = target.center;
+    // Changing z-levels needs the full search
+    if( f.z() != t.z() || rl_dist( f, t ) < portal_route_min_dist ) {
+        return std::nullopt;
+    }
+    CATA_PROFILE_ZONE( "map::portal_route" );
+    get_pathfinding_cache_ref( f.z() );
+    pathfinding_cache &cache = get_pathfinding_cache( f.z() );
+    const int mapsize = getmapsize();
+    for( int x = 0; x < mapsize; ++x ) {
+        for( int y = 0; y < mapsize; ++y ) {
+            if( cache.clusters[x][y].dirty ) {
+                update_pathfinding_cluster( cache, point_bub_sm( x, y ), mapsize );
+            }
+        }
+    }
+
+    // A* over the portals, entering from every portal reachable from f in its own submap
+    const point_bub_sm goal_cluster = cluster_of( t.xy() );
+    const std::array<int, SEEX *SEEY> goal_costs = cluster_costs( cache, t.xy() );
+    std::unordered_map<point_bub_ms, int> gscore;
+    std::unordered_map<point_bub_ms, point_bub_ms> parent;
+    std::priority_queue< std::pair<int, point_bub_ms>, std::vector< std::pair<int, point_bub_ms> >, pair_greater_cmp_first >
+    open;
+    const auto add_portal = [&]( const point_bub_ms & p, const point_bub_ms & from, int g ) {
+        const auto iter = gscore.find( p );
+        if( iter != gscore.end() && iter->second <= g ) {
+            return;
+        }
+        gscore[p] = g;
+        parent[p] = from;
+        open.emplace( g + 2 * rl_dist( p, t.xy() ), p );
+    };
+    const point_bub_sm start_cluster = cluster_of( f.xy() );
+    const pathfinding_cluster &start = cache.clusters[start_cluster];
+    const std::array<int, SEEX *SEEY> start_costs = cluster_costs( cache, f.xy() );
+    for( const point_bub_ms &p : start.portals ) {
+        const int cost = start_costs[cluster_index( p )];
+        if( cost >= 0 ) {
+            add_portal( p, p, cost );
+        }
+    }
+
+    int best_cost = -1;
+    point_bub_ms best_exit;
+    while( !open.empty() ) {
+        const auto [score, cur] = open.top();
+        open.pop();
+        if( best_cost >= 0 && score >= best_cost ) {
+            break;
+        }
+        const int cur_g = gscore[cur];
+        if( score > cur_g + 2 * rl_dist( cur, t.xy() ) ) {
+            // Already reached more cheaply
+            continue;
+        }
+        const point_bub_sm cur_cluster = cluster_of( cur );
+        if( cur_cluster == goal_cluster ) {
+            const int to_goal = goal_costs[cluster_index( cur )];
+            if( to_goal >= 0 && ( best_cost < 0 || cur_g + to_goal < best_cost ) ) {
+                best_cost = cur_g + to_goal;
+                best_exit = cur;
+            }
+        }
+        const pathfinding_cluster &cl = cache.clusters[cur_cluster];
+        const size_t num_portals = cl.portals.size();
+        const size_t cur_index = std::find( cl.portals.begin(), cl.portals.end(),
+                                            cur ) - cl.portals.begin();
+        for( size_t j = 0; j < num_portals; ++j ) {
+            const int cost = cl.portal_costs[cur_index * num_portals + j];
+            if( j != cur_index && cost >= 0 ) {
+                add_portal( cl.portals[j], cur, cur_g + cost );
+            }
+        }
+        for( const point &d : four_adjacent_offsets ) {
+            const point_bub_ms next = cur + d;
+            if( !inbounds( tripoint_bub_ms( next, f.z() ) ) || cluster_of( next ) == cur_cluster ) {
+                continue;
+            }
+            const std::vector<point_bub_ms> &next_portals = cache.clusters[cluster_of( next )].portals;
+            if( std::find( next_portals.begin(), next_portals.end(), next ) != next_portals.end() ) {
+                add_portal( next, cur, cur_g + portal_step_cost( cache.special[next] ) );
+            }
+        }
+    }
+    if( best_cost < 0 ) {
+        return std::nullopt;
+    }
+
+    // Search the route one submap at a time, heading for the portal it is left through
+    std::vector<point_bub_ms> waypoints;
+    for( point_bub_ms cur = best_exit; ; cur = parent[cur] ) {
+        if( waypoints.empty() || cluster_of( waypoints.back() ) != cluster_of( cur ) ) {
+            waypoints.push_back( cur );
+        }
+        if( parent[cur] == cur ) {
+            break;
+        }
+    }
+    std::reverse( waypoints.begin(), waypoints.end() );
+    // The portal where the goal's submap is entered; from there the goal itself is searched for
+    waypoints.pop_back();
+
+    std::vector<tripoint_bub_ms> ret;
+    tripoint_bub_ms cur = f;
+    for( const point_bub_ms &waypoint : waypoints ) {
+        const tripoint_bub_ms next( waypoint, f.z() );
+        if( next == cur ) {
+            continue;
+        }
+        const std::vector<tripoint_bub_ms> part = search_route( cur, pathfinding_target::point( next ),
+                settings, avoid );
+        if( part.empty() ) {
+            // Somebody who can't open doors, for example
+            return std::nullopt;
+        }
+        ret.insert( ret.end(), part.begin(), part.end() );
+        cur = next;
+    }
+    if( !target.contains( cur ) ) {
+        const std::vector<tripoint_bub_ms> part = search_route( cur, target, settings, avoid );
+        if( part.empty() ) {
+            return std::nullopt;
+        }
+        ret.insert( ret.end(), part.begin(), part.end() );
+    }
+    // Every step costs at least 2
+    if( static_cast<int>( ret.size() ) * 2 > settings.max_length ) {
+        return std::vector<tripoint_bub_ms>();
+    }
+    turn_counters::add( turn_counter::portal_routes, 1 );
+    return ret;
+}
+
 std::vector<tripoint_bub_ms> map::route( const Creature &who,
         const pathfinding_target &target ) const
 {
@@ -435,6 +817,26 @@ std::vector<tripoint_bub_ms> map::route( const tripoint_bub_ms &f,
         return ret;
     }
 
+    CATA_PROFILE_ZONE( "map::route" );
+    if( std::optional<std::vector<tripoint_bub_ms>> shared = flow_field_route( f, target, settings,
+            avoid ) ) {
+        return *shared;
+    }
+    if( std::optional<std::vector<tripoint_bub_ms>> planned = portal_route( f, target, settings,
+            avoid ) ) {
+        return *planned;
+    }
+
+    return search_route( f, target, settings, avoid );
+}
+
+std::vector<tripoint_bub_ms> map::search_route( const tripoint_bub_ms &f,
+        const pathfinding_target &target,
+        const pathfinding_settings &settings,
+        const std::function<bool( const tripoint_bub_ms & )> &avoid ) const
+{
+    std::vector<tripoint_bub_ms> ret;
+    const tripoint_bub_ms &t = target.center;
     const int max_length = settings.max_length;
 
     const int pad = 16;  // Should be much bigger - low value makes pathfinders dumb!
@@ -669,3 +1071,18 @@ bool pathfinding_target::contains( const tripoint_bub_ms &p ) const
     }
     return square_dist( center, p ) <= r;
 }
+
+bool pathfinding_settings::has_same_costs( const pathfinding_settings &other ) const
+{
+    return bash_strength == other.bash_strength && climb_cost == other.climb_cost &&
+           allow_open_doors == other.allow_open_doors &&
+           allow_unlock_doors == other.allow_unlock_doors && avoid_traps == other.avoid_traps &&
+           allow_climb_stairs == other.allow_climb_stairs &&
+           avoid_rough_terrain == other.avoid_rough_terrain && avoid_sharp == other.avoid_sharp &&
+           avoid_dangerous_fields == other.avoid_dangerous_fields && size == other.size;
+}
+
+bool flow_field::matches( const pathfinding_target &t, const pathfinding_settings &s ) const
+{
+    return target == t.center && r == t.r && settings.has_same_costs( s );
+}
@@ -3,9 +3,12 @@
 #define CATA_SRC_PATHFINDING_H
 
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <unordered_set>
+#include <vector>
 
+#include "calendar.h"
 #include "coordinates.h"
 #include "mdarray.h"
 #include "point.h"
@@ -86,6 +89,13 @@ class PathfindingFlags
             return is_any_set();
         }
 
+        constexpr bool operator==( PathfindingFlags flags ) const {
+            return flags_ == flags.flags_;
+        }
+        constexpr bool operator!=( PathfindingFlags flags ) const {
+            return flags_ != flags.flags_;
+        }
+
         constexpr PathfindingFlags &operator|=( PathfindingFlags flags ) {
             set_union( flags );
             return *this;
@@ -125,15 +135,6 @@ constexpr PathfindingFlags operator |( const PathfindingFlag &a, const Pathfindi
     return PathfindingFlags( a ) | PathfindingFlags( b );
 }
 
-struct pathfinding_cache {
-    pathfinding_cache();
-
-    bool dirty = false;
-    std::unordered_set<point_bub_ms> dirty_points;
-
-    cata::mdarray<PathfindingFlags, point_bub_ms> special;
-};
-
 struct pathfinding_settings {
     int bash_strength = 0;
     int max_dist = 0;
@@ -164,6 +165,10 @@ struct pathfinding_settings {
           avoid_rough_terrain( art ), avoid_sharp( as ), size( sz )  {}
 
     pathfinding_settings &operator=( const pathfinding_settings & ) = default;
+
+    // True if every step costs the same under both settings, so that they only differ in
+    // how far they are willing to search.
+    bool has_same_costs( const pathfinding_settings &other ) const;
 };
 
 struct pathfinding_target {
@@ -187,4 +192,49 @@ struct pathfinding_target {
     }
 };
 
+// Cost of reaching a pathfinding target from every tile of a z-level, found with a single
+// search outwards from the target. Creatures heading for the same target with equivalent
+// settings during a turn read their route from it instead of running their own search.
+struct flow_field {
+    tripoint_bub_ms target;
+    int r = 0;
+    pathfinding_settings settings;
+    time_point turn;
+    // Origin of the first route request for this target. The field is only built once a
+    // request from another origin shows that it would actually be shared.
+    tripoint_bub_ms first_origin;
+    // Remaining cost to reach the target, or -1 if it can't be reached
+    std::unique_ptr<cata::mdarray<int, point_bub_ms>> cost;
+    // Next step towards the target
+    std::unique_ptr<cata::mdarray<point_bub_ms, point_bub_ms>> next;
+
+    bool matches( const pathfinding_target &t, const pathfinding_settings &s ) const;
+};
+
+// A submap of a pathfinding_cache level, as a node of the graph used to plan long routes.
+// Portals are the tiles in the middle of each open stretch of the submap's edges, through
+// which it can be entered from or left to its neighbours.
+struct pathfinding_cluster {
+    bool dirty = true;
+    std::vector<point_bub_ms> portals;
+    // Cost of walking from portal i to portal j without leaving the submap, stored at
+    // i * portals.size() + j, or -1 if there is no such route.
+    std::vector<int> portal_costs;
+};
+
+struct pathfinding_cache {
+    pathfinding_cache();
+
+    bool dirty = false;
+    std::unordered_set<point_bub_ms> dirty_points;
+
+    cata::mdarray<PathfindingFlags, point_bub_ms> special;
+
+    // Dropped whenever special is updated, and from map::route once their turn has passed
+    std::vector<flow_field> flow_fields;
+
+    // Rebuilt lazily from special, only for the submaps whose flags changed
+    cata::mdarray<pathfinding_cluster, point_bub_sm> clusters;
+};
+
 #endif // CATA_SRC_PATHFINDING_H
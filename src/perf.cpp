@@ -1,13 +1,311 @@
 #include "perf.h"
 
-cata_timer::timers_map &cata_timer::top_level_timer_map()
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "calendar.h"
+#include "cata_utility.h"
+#include "debug.h"
+#include "json.h"
+#include "path_info.h"
+#include "string_formatter.h"
+
+namespace
+{
+struct zone_event {
+    const cata_profiler::zone_info *zone;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// Power of two so that wrapping around is a mask
+constexpr size_t zone_event_capacity = 1 << 16;
+
+struct thread_events {
+    std::array<zone_event, zone_event_capacity> events;
+    // Total number of events ever recorded; the newest is at ( head - 1 ) % capacity
+    std::atomic<uint64_t> head{ 0 };
+    int thread_index = 0;
+};
+
+std::mutex &thread_events_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Buffers of every thread that ever recorded, kept alive so that events of
+// finished threads can still be exported.
+std::vector<std::unique_ptr<thread_events>> &all_thread_events()
+{
+    static std::vector<std::unique_ptr<thread_events>> buffers;
+    return buffers;
+}
+
+thread_events &local_thread_events()
+{
+    thread_local thread_events *local = nullptr;
+    if( local == nullptr ) {
+        std::lock_guard<std::mutex> lock( thread_events_mutex() );
+        std::vector<std::unique_ptr<thread_events>> &buffers = all_thread_events();
+        buffers.push_back( std::make_unique<thread_events>() );
+        local = buffers.back().get();
+        local->thread_index = static_cast<int>( buffers.size() ) - 1;
+    }
+    return *local;
+}
+
+// Reference points used to convert ticks to wall-clock time
+struct tick_calibration {
+    uint64_t ticks = 0;
+    std::chrono::steady_clock::time_point time;
+};
+
+tick_calibration &calibration_start()
+{
+    static tick_calibration start{ cata_profiler::now_ticks(), std::chrono::steady_clock::now() };
+    return start;
+}
+
+std::chrono::milliseconds slow_turn_threshold{ 0 };
+uint64_t last_turn_end = 0;
+} // namespace
+
+namespace cata_profiler
+{
+namespace detail
+{
+std::atomic<bool> enabled{ false };
+
+void record( const zone_info *zone, uint64_t begin, uint64_t end )
+{
+    thread_events &local = local_thread_events();
+    const uint64_t index = local.head.load( std::memory_order_relaxed );
+    local.events[index & ( zone_event_capacity - 1 )] = { zone, begin, end };
+    local.head.store( index + 1, std::memory_order_release );
+}
+} // namespace detail
+
+void set_enabled( bool enabled )
+{
+    // Make sure the calibration point predates every recorded event
+    calibration_start();
+    detail::enabled.store( enabled, std::memory_order_relaxed );
+}
+
+void clear()
+{
+    std::lock_guard<std::mutex> lock( thread_events_mutex() );
+    for( const std::unique_ptr<thread_events> &buffer : all_thread_events() ) {
+        buffer->head.store( 0, std::memory_order_relaxed );
+    }
+}
+
+double ticks_to_us( uint64_t ticks )
+{
+#if defined(CATA_PROFILER_USE_TSC)
+    const tick_calibration &start = calibration_start();
+    const uint64_t elapsed_ticks = now_ticks() - start.ticks;
+    const double elapsed_us = std::chrono::duration<double, std::micro>(
+                                  std::chrono::steady_clock::now() - start.time ).count();
+    if( elapsed_ticks == 0 || elapsed_us <= 0.0 ) {
+        return 0.0;
+    }
+    return ticks * ( elapsed_us / elapsed_ticks );
+#else
+    return ticks / 1000.0;
+#endif
+}
+
+void write_chrome_trace( std::ostream &out, uint64_t since )
+{
+    const uint64_t origin = calibration_start().ticks;
+    // Compute the conversion factor once rather than per event
+    const double us_per_tick = ticks_to_us( 1u << 20 ) / ( 1u << 20 );
+
+    std::lock_guard<std::mutex> lock( thread_events_mutex() );
+    JsonOut jsout( out );
+    jsout.start_object();
+    jsout.member( "displayTimeUnit", "ms" );
+    jsout.member( "traceEvents" );
+    jsout.start_array();
+    for( const std::unique_ptr<thread_events> &buffer : all_thread_events() ) {
+        const uint64_t head = buffer->head.load( std::memory_order_acquire );
+        const uint64_t first = head > zone_event_capacity ? head - zone_event_capacity : 0;
+        for( uint64_t i = first; i < head; ++i ) {
+            const zone_event &event = buffer->events[i & ( zone_event_capacity - 1 )];
+            if( event.begin < since || event.begin < origin ) {
+                continue;
+            }
+            jsout.start_object();
+            jsout.member( "name", event.zone->name );
+            jsout.member( "cat", "cata" );
+            jsout.member( "ph", "X" );
+            jsout.member( "ts", ( event.begin - origin ) * us_per_tick );
+            jsout.member( "dur", ( event.end - event.begin ) * us_per_tick );
+            jsout.member( "pid", 0 );
+            jsout.member( "tid", buffer->thread_index );
+            jsout.member( "args" );
+            jsout.start_object();
+            jsout.member( "file", event.zone->file );
+            jsout.member( "line", event.zone->line );
+            jsout.end_object();
+            jsout.end_object();
+        }
+    }
+    jsout.end_array();
+    jsout.end_object();
+}
+
+void set_slow_turn_threshold( std::chrono::milliseconds threshold )
+{
+    slow_turn_threshold = threshold;
+}
+
+void end_turn( uint64_t update_begin )
+{
+    const uint64_t now = now_ticks();
+    const uint64_t previous_turn_end = last_turn_end;
+    last_turn_end = now;
+    if( !is_enabled() || slow_turn_threshold.count() <= 0 ) {
+        return;
+    }
+    const double update_us = ticks_to_us( now - update_begin );
+    if( update_us < std::chrono::duration<double, std::micro>( slow_turn_threshold ).count() ) {
+        return;
+    }
+    const std::string path = string_format( "%sslow_turn_%d.json", PATH_INFO::user_dir(),
+                                            to_turns<int>( calendar::turn - calendar::turn_zero ) );
+    DebugLog( D_WARNING, D_MAIN ) << "Turn took " << update_us / 1000.0 << "ms, writing profile to "
+                                  << path;
+    write_to_file( path, [&]( std::ostream & fout ) {
+        write_chrome_trace( fout, previous_turn_end );
+    }, "slow turn profile" );
+}
+} // namespace cata_profiler
+
+namespace
+{
+bool turn_phase_stats_enabled = false;
+
+std::array<turn_phase_stats::phase_totals, static_cast<size_t>( turn_phase::num_turn_phases )> &
+turn_phase_totals()
+{
+    static std::array<turn_phase_stats::phase_totals,
+           static_cast<size_t>( turn_phase::num_turn_phases )> totals;
+    return totals;
+}
+
+constexpr std::array<cata_profiler::zone_info, static_cast<size_t>( turn_phase::num_turn_phases )>
+turn_phase_zones = {{
+        { "vehmove", __FILE__, __LINE__ },
+        { "process_fields", __FILE__, __LINE__ },
+        { "process_items", __FILE__, __LINE__ },
+        { "process_sounds", __FILE__, __LINE__ },
+        { "build_map_cache", __FILE__, __LINE__ },
+        { "monmove", __FILE__, __LINE__ },
+    }
+};
+} // namespace
+
+namespace turn_phase_stats
+{
+void set_enabled( bool enabled )
+{
+    turn_phase_stats_enabled = enabled;
+}
+
+bool is_enabled()
+{
+    return turn_phase_stats_enabled;
+}
+
+void reset()
+{
+    turn_phase_totals().fill( phase_totals() );
+}
+
+void record( turn_phase phase, uint64_t duration_ns )
+{
+    phase_totals &totals = turn_phase_totals()[static_cast<size_t>( phase )];
+    totals.total_ns += duration_ns;
+    totals.max_ns = std::max( totals.max_ns, duration_ns );
+    ++totals.count;
+}
+
+const phase_totals &get( turn_phase phase )
+{
+    return turn_phase_totals()[static_cast<size_t>( phase )];
+}
+
+std::string_view name( turn_phase phase )
+{
+    return zone( phase ).name;
+}
+
+const cata_profiler::zone_info &zone( turn_phase phase )
+{
+    if( phase == turn_phase::num_turn_phases ) {
+        cata_fatal( "Invalid turn_phase" );
+    }
+    return turn_phase_zones[static_cast<size_t>( phase )];
+}
+} // namespace turn_phase_stats
+
+namespace
+{
+std::array<uint64_t, static_cast<size_t>( turn_counter::num_turn_counters )> turn_counter_totals;
+
+constexpr std::array<std::string_view, static_cast<size_t>( turn_counter::num_turn_counters )>
+turn_counter_names = {{
+        "transparency_tiles",
+        "vision_transparency_tiles",
+        "seen_cache_rebuilds",
+        "seen_cache_updates",
+        "seen_cache_tiles",
+        "static_lights_cast",
+        "static_lights_reused",
+        "light_sources_culled",
+        "submap_prefetch_requests",
+        "submap_prefetch_hits",
+        "submap_prefetch_misses",
+        "submap_load_stall_us",
+        "quads_evicted",
+        "area_query_monsters",
+        "vehicle_collision_lookups",
+        "portal_routes",
+        "pathfinding_clusters_rebuilt",
+    }
+};
+} // namespace
+
+namespace turn_counters
+{
+void add( turn_counter counter, uint64_t amount )
+{
+    turn_counter_totals[static_cast<size_t>( counter )] += amount;
+}
+
+uint64_t get( turn_counter counter )
+{
+    return turn_counter_totals[static_cast<size_t>( counter )];
+}
+
+void reset()
 {
-    static cata_timer::timers_map map;
-    return map;
+    turn_counter_totals.fill( 0 );
 }
 
-std::vector<cata_timer::timers_map::iterator> &cata_timer::timer_stack()
+std::string_view name( turn_counter counter )
 {
-    static std::vector<cata_timer::timers_map::iterator> stack;
-    return stack;
+    if( counter == turn_counter::num_turn_counters ) {
+        cata_fatal( "Invalid turn_counter" );
+    }
+    return turn_counter_names[static_cast<size_t>( counter )];
 }
+} // namespace turn_counters
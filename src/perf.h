@@ -4,80 +4,244 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <chrono>
-#include <functional>
-#include <iostream>
-#include <map>
-#include <string>
+#include <iosfwd>
 #include <string_view>
-#include <utility>
-#include <vector>
-
-#include "debug.h"
-
-struct cata_timer {
-        struct timer_stats {
-            std::string name;
-            std::chrono::high_resolution_clock::time_point current_start;
-            uint64_t duration = 0;
-            uint64_t count = 0;
-            std::map<std::string, timer_stats, std::less<>> child_timers;
-
-            explicit timer_stats( std::string_view name ) : name{ name } {}
-
-            void print_stats_recursively( std::string_view prefix = "" ) const {
-                DebugLog( DebugLevel::D_WARNING,
-                          D_MAIN ) << prefix << name << ": " << std::to_string( duration ) << "us (avg: " << std::to_string(
-                                       duration / count ) << "us) (count: " << count << ")";
-                std::string child_prefix;
-                child_prefix.reserve( prefix.length() + 2 );
-                child_prefix += prefix;
-                child_prefix += "  ";
-                for( const auto& [name, timer] : child_timers ) {
-                    timer.print_stats_recursively( child_prefix );
-                }
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CATA_PROFILER_USE_TSC
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define CATA_PROFILER_USE_TSC
+#endif
+
+/**
+ * Low overhead hierarchical zone profiler.
+ *
+ * A zone is a scope marked with @ref CATA_PROFILE_ZONE.  Its identity is the
+ * address of a constexpr @ref cata_profiler::zone_info describing the call
+ * site, so no registration or lookup happens at runtime.  While profiling is
+ * enabled each zone appends one event to a fixed size ring buffer owned by the
+ * recording thread; when disabled a zone costs a single relaxed load.  The
+ * retained events can be exported as Chrome trace-event JSON, which can be
+ * opened in chrome://tracing, Perfetto or speedscope to get flame graphs.
+ */
+namespace cata_profiler
+{
+/** Static description of a profiled call site. */
+struct zone_info {
+    const char *name;
+    const char *file;
+    int line;
+};
+
+namespace detail
+{
+extern std::atomic<bool> enabled;
+void record( const zone_info *zone, uint64_t begin, uint64_t end );
+} // namespace detail
+
+inline bool is_enabled()
+{
+    return detail::enabled.load( std::memory_order_relaxed );
+}
+
+/** Starts or stops recording zones.  Already recorded events are kept. */
+void set_enabled( bool enabled );
+
+/** Discards all recorded events on all threads. */
+void clear();
+
+/** Monotonic tick counter used to time zones: the TSC where available, nanoseconds otherwise. */
+inline uint64_t now_ticks()
+{
+#if defined(CATA_PROFILER_USE_TSC)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch() ).count();
+#endif
+}
+
+/** Converts a difference of @ref now_ticks values to microseconds. */
+double ticks_to_us( uint64_t ticks );
+
+/**
+ * Writes all retained events that started at or after @p since (in ticks) as
+ * Chrome trace-event JSON.  Other threads should not be recording while this runs.
+ */
+void write_chrome_trace( std::ostream &out, uint64_t since = 0 );
+
+/**
+ * Sets the duration above which the world update of a turn is considered slow
+ * and its events are written out by @ref end_turn.  Zero disables the capture.
+ */
+void set_slow_turn_threshold( std::chrono::milliseconds threshold );
+
+/**
+ * Called once at the end of every turn with the tick at which the world update
+ * (everything after the player's input) started.  If the update was slow, every
+ * event since the previous turn ended is written to slow_turn_<turn>.json in
+ * the user directory.
+ */
+void end_turn( uint64_t update_begin );
+
+/** Records the lifetime of this object as an event of its zone when profiling is enabled. */
+class scoped_zone
+{
+    public:
+        explicit scoped_zone( const zone_info &zone ) : zone( &zone ), active( is_enabled() ) {
+            if( active ) {
+                begin = now_ticks();
             }
-        };
-
-        using timers_map = std::map<std::string, timer_stats, std::less<>>;
-
-        // NOLINTNEXTLINE(cata-large-inline-function)
-        explicit cata_timer( std::string_view name ) {
-            timers_map &timer_map = ( [&]() -> timers_map& {
-                if( timer_stack().empty() ) {
-                    return top_level_timer_map();
-                } else {
-                    return timer_stack().back()->second.child_timers;
-                }
-            } )();
-            timer = timer_map.find( name );
-            if( timer == timer_map.end() ) {
-                timer = timer_map.emplace( name, timer_stats{ name } ).first;
+        }
+
+        ~scoped_zone() {
+            if( active ) {
+                detail::record( zone, begin, now_ticks() );
             }
-            timer_stack().push_back( timer );
-            timer->second.current_start = std::chrono::high_resolution_clock::now();
         }
 
-        ~cata_timer() {
-            std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
-            timer->second.duration += std::chrono::duration_cast<std::chrono::microseconds>( (
-                                          end - current_start ) ).count();
-            ++timer->second.count;
-            timer_stack().pop_back();
+        scoped_zone( const scoped_zone & ) = delete;
+        scoped_zone &operator=( const scoped_zone & ) = delete;
+    private:
+        const zone_info *zone;
+        bool active;
+        uint64_t begin = 0;
+};
+} // namespace cata_profiler
+
+#define CATA_PROFILE_CONCAT_IMPL( a, b ) a##b
+#define CATA_PROFILE_CONCAT( a, b ) CATA_PROFILE_CONCAT_IMPL( a, b )
+
+/** Profiles the rest of the enclosing scope as a zone called @p zone_name (a string literal). */
+#define CATA_PROFILE_ZONE( zone_name ) \
+    static constexpr cata_profiler::zone_info CATA_PROFILE_CONCAT( cata_profile_zone_info_, __LINE__ ){ \
+        zone_name, __FILE__, __LINE__ }; \
+    cata_profiler::scoped_zone CATA_PROFILE_CONCAT( cata_profile_zone_, __LINE__ )( \
+            CATA_PROFILE_CONCAT( cata_profile_zone_info_, __LINE__ ) )
+
+/** The phases of do_turn() whose cost is tracked by @ref turn_phase_stats. */
+enum class turn_phase : int {
+    vehmove,
+    process_fields,
+    process_items,
+    process_sounds,
+    build_map_cache,
+    monmove,
+    num_turn_phases
+};
+
+/**
+ * Accumulated wall-clock time spent in each @ref turn_phase.
+ *
+ * Collection is disabled by default, in which case a @ref scoped_turn_phase
+ * costs a single branch.  The headless turn benchmark enables it to report
+ * where the time of a turn goes.
+ */
+namespace turn_phase_stats
+{
+struct phase_totals {
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t count = 0;
+};
+
+void set_enabled( bool enabled );
+bool is_enabled();
+/** Discard everything recorded so far. */
+void reset();
+void record( turn_phase phase, uint64_t duration_ns );
+const phase_totals &get( turn_phase phase );
+std::string_view name( turn_phase phase );
+/** The profiler zone each phase is reported as. */
+const cata_profiler::zone_info &zone( turn_phase phase );
+} // namespace turn_phase_stats
+
+/**
+ * Records the lifetime of this object against @ref phase when collection is
+ * enabled, and as a profiler zone of the same name.
+ */
+class scoped_turn_phase
+{
+    public:
+        explicit scoped_turn_phase( turn_phase phase ) : phase( phase ),
+            active( turn_phase_stats::is_enabled() ), zone( turn_phase_stats::zone( phase ) ) {
+            if( active ) {
+                start = std::chrono::steady_clock::now();
+            }
         }
 
-        static void print_stats() {
-            for( const auto& [name, timer] : top_level_timer_map() ) {
-                timer.print_stats_recursively();
+        ~scoped_turn_phase() {
+            if( active ) {
+                const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                turn_phase_stats::record( phase, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              end - start ).count() );
             }
         }
+
+        scoped_turn_phase( const scoped_turn_phase & ) = delete;
+        scoped_turn_phase &operator=( const scoped_turn_phase & ) = delete;
     private:
-        timers_map::iterator timer;
-        std::chrono::high_resolution_clock::time_point current_start =
-            std::chrono::high_resolution_clock::now();
+        turn_phase phase;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+        cata_profiler::scoped_zone zone;
+};
 
-        static timers_map &top_level_timer_map();
-        static std::vector<timers_map::iterator> &timer_stack();
+/** Amounts of work done by the turn, tracked by @ref turn_counters. */
+enum class turn_counter : int {
+    // Tiles whose transparency was recalculated
+    transparency_tiles,
+    // Tiles whose vision transparency was recalculated
+    vision_transparency_tiles,
+    // Complete rebuilds of the avatar's seen cache
+    seen_cache_rebuilds,
+    // Incremental updates of the avatar's seen cache after transparency changes
+    seen_cache_updates,
+    // Tiles of the seen cache that were recast by either of the above
+    seen_cache_tiles,
+    // Submaps whose static light sources were cast again for the lightmap
+    static_lights_cast,
+    // Submaps whose static light sources reused the light cast on an earlier turn
+    static_lights_reused,
+    // Light sources skipped because their light can't reach anything that looks at it
+    light_sources_culled,
+    // Quad files queued for reading ahead of the reality bubble
+    submap_prefetch_requests,
+    // Quad loads that found their file already read by the prefetcher
+    submap_prefetch_hits,
+    // Quad loads that had to go to the disk on the main thread
+    submap_prefetch_misses,
+    // Microseconds the main thread spent waiting for, reading and parsing quad files
+    submap_load_stall_us,
+    // Quads unloaded from the mapbuffer to keep it within its memory budget
+    quads_evicted,
+    // Monsters looked at by area queries of the creature tracker
+    area_query_monsters,
+    // Tiles moving vehicles looked up for other vehicles because another one was close enough
+    vehicle_collision_lookups,
+    // Routes planned over the portals between submaps
+    portal_routes,
+    // Submaps whose portals for route planning were worked out again
+    pathfinding_clusters_rebuilt,
+    num_turn_counters
 };
 
+/**
+ * Running totals of @ref turn_counter, so benchmarks can report how much work
+ * a turn did besides how long it took.  Counting is always on; it is a plain
+ * integer add.
+ */
+namespace turn_counters
+{
+void add( turn_counter counter, uint64_t amount );
+uint64_t get( turn_counter counter );
+/** Zero every counter. */
+void reset();
+std::string_view name( turn_counter counter );
+} // namespace turn_counters
+
 #endif // CATA_SRC_PERF_H
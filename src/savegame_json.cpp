@@ -3531,6 +3531,8 @@ void vehicle::deserialize( const JsonObject &data )
 void vehicle::deserialize_parts( const JsonArray &data )
 {
     parts.clear();
+    parts_by_flag.clear();
+    parts_by_flag_size = 0;
     parts.reserve( data.size() );
     for( const JsonValue jv : data ) {
         try {
@@ -3993,51 +3995,6 @@ void player_morale::load( const JsonObject &jsin )
     jsin.read( "morale", points );
 }
 
-void mm_submap::serialize( JsonOut &jsout ) const
-{
-    jsout.start_array();
-
-    // Uses RLE for compression.
-
-    memorized_tile last;
-    int num_same = 1;
-
-    const auto write_seq = [&]() {
-        jsout.start_array();
-        jsout.write( num_same );
-        jsout.write( static_cast<int>( last.symbol ) );
-        jsout.write( last.ter_id );
-        jsout.write( static_cast<int>( last.ter_subtile ) );
-        jsout.write( static_cast<int>( last.ter_rotation ) );
-        if( !last.get_dec_id().empty() ) {
-            jsout.write( last.dec_id );
-            jsout.write( static_cast<int>( last.dec_subtile ) );
-            jsout.write( static_cast<int>( last.dec_rotation ) );
-        }
-        jsout.end_array();
-    };
-
-    for( size_t y = 0; y < SEEY; y++ ) {
-        for( size_t x = 0; x < SEEX; x++ ) {
-            const memorized_tile &elem = get_tile( point_sm_ms( x, y ) );
-            if( x == 0 && y == 0 ) {
-                last = elem;
-                continue;
-            }
-            if( last == elem ) {
-                num_same += 1;
-                continue;
-            }
-            write_seq();
-            num_same = 1;
-            last = elem;
-        }
-    }
-    write_seq();
-
-    jsout.end_array();
-}
-
 void mm_submap::deserialize( int version, const JsonArray &ja )
 {
     size_t submap_array_idx = 0;
@@ -4068,7 +4025,7 @@ void mm_submap::deserialize( int version, const JsonArray &ja )
                         tile.set_dec_id( std::move( id ) );
                         tile.set_dec_subtile( ja_tile.get_int( 1 ) );
                         const int legacy_rotation = ja_tile.get_int( 2 );
-                        if( string_starts_with( tile.dec_id, "vp_" ) ) {
+                        if( string_starts_with( tile.get_dec_id(), "vp_" ) ) {
                             // legacy vehicle rotation needs to be converted from 0-360 degrees
                             // to 0-3 tileset rotation
                             const units::angle legacy_angle = units::from_degrees( legacy_rotation );
@@ -4104,28 +4061,8 @@ void mm_submap::deserialize( int version, const JsonArray &ja )
             }
         }
     }
-}
-
-void mm_region::serialize( JsonOut &jsout ) const
-{
-    jsout.start_object();
-    jsout.member( "version", 1 );
-    jsout.write( "data" );
-    jsout.write_member_separator();
-    jsout.start_array();
-    for( size_t y = 0; y < MM_REG_SIZE; y++ ) {
-        // NOLINTNEXTLINE(modernize-loop-convert)
-        for( size_t x = 0; x < MM_REG_SIZE; x++ ) {
-            const shared_ptr_fast<mm_submap> &sm = submaps[x][y];
-            if( sm->is_empty() ) {
-                jsout.write_null();
-            } else {
-                sm->serialize( jsout );
-            }
-        }
-    }
-    jsout.end_array();
-    jsout.end_object();
+    // Not saved in the current format yet, so the next save converts it.
+    dirty = true;
 }
 
 void mm_region::deserialize( const JsonValue &ja )
@@ -4755,6 +4692,36 @@ void ter_furn_migrations::check()
     }
 }
 
+std::pair<ter_id, furn_id> ter_furn_migrations::migrate_terrain( const ter_str_id &ter )
+{
+    ter_str_id terstr = ter;
+    furn_id furn = furn_str_id::NULL_ID().id();
+    if( auto it = ter_migrations.find( terstr ); it != ter_migrations.end() ) {
+        terstr = it->second.first;
+        furn = it->second.second.id();
+    }
+    if( !terstr.is_valid() ) {
+        debugmsg( "invalid ter_str_id '%s'", terstr.c_str() );
+        return { ter_t_dirt, furn };
+    }
+    return { terstr.id(), furn };
+}
+
+std::pair<ter_id, furn_id> ter_furn_migrations::migrate_furniture( const furn_str_id &furn )
+{
+    furn_str_id furnstr = furn;
+    ter_id ter = ter_str_id::NULL_ID().id();
+    if( auto it = furn_migrations.find( furnstr ); it != furn_migrations.end() ) {
+        furnstr = it->second.second;
+        ter = it->second.first.id();
+    }
+    if( !furnstr.is_valid() ) {
+        debugmsg( "invalid furn_str_id '%s'", furnstr.c_str() );
+        return { ter, furn_str_id::NULL_ID().id() };
+    }
+    return { ter, furnstr.id() };
+}
+
 static std::unordered_map<trap_str_id, trap_str_id> tr_migrations;
 
 void trap_migrations::load( const JsonObject &jo )
@@ -4824,7 +4791,7 @@ void submap::store( JsonOut &jsout ) const
     for( int j = 0; j < SEEY; j++ ) {
         // NOLINTNEXTLINE(modernize-loop-convert)
         for( int i = 0; i < SEEX; i++ ) {
-            const std::string this_id = m->ter[i][j].obj().id.str();
+            const std::string this_id = m->ter.get( point_sm_ms( i, j ) ).obj().id.str();
             if( !last_id.empty() ) {
                 if( this_id == last_id ) {
                     num_same++;
@@ -4897,6 +4864,11 @@ void submap::store( JsonOut &jsout ) const
     }
     jsout.end_array();
 
+    store_objects( jsout );
+}
+
+void submap::store_objects( JsonOut &jsout ) const
+{
     jsout.member( "items" );
     jsout.start_array();
     for( int j = 0; j < SEEY; j++ ) {
@@ -5044,26 +5016,26 @@ void submap::load( const JsonValue &jv, const std::string &member_name, int vers
                     const ter_str_id tid( terrain_json.next_string() );
 
                     if( tid == ter_t_rubble ) {
-                        m->ter[i][j] = ter_t_dirt;
-                        m->frn[i][j] = furn_id( "f_rubble" );
+                        m->ter.set( point_sm_ms( i, j ), ter_t_dirt );
+                        m->frn.set( point_sm_ms( i, j ), furn_id( "f_rubble" ) );
                         m->itm[i][j].insert( rock );
                         m->itm[i][j].insert( rock );
                     } else if( tid == ter_t_wreckage ) {
-                        m->ter[i][j] = ter_t_dirt;
-                        m->frn[i][j] = furn_id( "f_wreckage" );
+                        m->ter.set( point_sm_ms( i, j ), ter_t_dirt );
+                        m->frn.set( point_sm_ms( i, j ), furn_id( "f_wreckage" ) );
                         m->itm[i][j].insert( chunk );
                         m->itm[i][j].insert( chunk );
                     } else if( tid == ter_t_ash ) {
-                        m->ter[i][j] = ter_t_dirt;
-                        m->frn[i][j] = furn_id( "f_ash" );
+                        m->ter.set( point_sm_ms( i, j ), ter_t_dirt );
+                        m->frn.set( point_sm_ms( i, j ), furn_id( "f_ash" ) );
                     } else if( tid == ter_t_pwr_sb_support_l ) {
-                        m->ter[i][j] = ter_t_support_l;
+                        m->ter.set( point_sm_ms( i, j ), ter_t_support_l );
                     } else if( tid == ter_t_pwr_sb_switchgear_l ) {
-                        m->ter[i][j] = ter_t_switchgear_l;
+                        m->ter.set( point_sm_ms( i, j ), ter_t_switchgear_l );
                     } else if( tid == ter_t_pwr_sb_switchgear_s ) {
-                        m->ter[i][j] = ter_t_switchgear_s;
+                        m->ter.set( point_sm_ms( i, j ), ter_t_switchgear_s );
                     } else {
-                        m->ter[i][j] = tid.id();
+                        m->ter.set( point_sm_ms( i, j ), tid.id() );
                     }
                 }
             }
@@ -5077,19 +5049,8 @@ void submap::load( const JsonValue &jv, const std::string &member_name, int vers
                 for( int i = 0; i < SEEX; i++ ) {
                     if( !remaining ) {
                         JsonValue terrain_entry = terrain_json.next_value();
-                        auto migrate_terstr = [&]( ter_str_id terstr ) {
-                            if( auto it = ter_migrations.find( terstr ); it != ter_migrations.end() ) {
-                                terstr = it->second.first;
-                                iid_furn = it->second.second.id();
-                            } else {
-                                iid_furn = furn_str_id::NULL_ID().id();
-                            }
-                            if( terstr.is_valid() ) {
-                                iid_ter = terstr.id();
-                            } else {
-                                debugmsg( "invalid ter_str_id '%s'", terstr.c_str() );
-                                iid_ter = ter_t_dirt;
-                            }
+                        auto migrate_terstr = [&]( const ter_str_id & terstr ) {
+                            std::tie( iid_ter, iid_furn ) = ter_furn_migrations::migrate_terrain( terstr );
                         };
                         if( terrain_entry.test_string() ) {
                             migrate_terstr( ter_str_id( terrain_entry.get_string() ) );
@@ -5106,9 +5067,9 @@ void submap::load( const JsonValue &jv, const std::string &member_name, int vers
                     } else {
                         --remaining;
                     }
-                    m->ter[i][j] = iid_ter;
+                    m->ter.set( point_sm_ms( i, j ), iid_ter );
                     if( iid_furn ) {
-                        m->frn[i][j] = iid_furn;
+                        m->frn.set( point_sm_ms( i, j ), iid_furn );
                     }
                 }
             }
@@ -5130,26 +5091,16 @@ void submap::load( const JsonValue &jv, const std::string &member_name, int vers
             }
         }
     } else if( member_name == "furniture" ) {
-        int_id<ter_t> iid_ter;
-        int_id<furn_t> iid_furn;
         JsonArray furniture_json = jv;
         for( JsonArray furniture_entry : furniture_json ) {
             int i = furniture_entry.next_int();
             int j = furniture_entry.next_int();
-            furn_str_id furnstr( furniture_entry.next_string() );
-            if( auto it = furn_migrations.find( furnstr ); it != furn_migrations.end() ) {
-                furnstr = it->second.second;
-                if( it->second.first != ter_str_id::NULL_ID() ) {
-                    m->ter[i][j] = it->second.first.id();
-                }
-            }
-            if( furnstr.is_valid() ) {
-                iid_furn = furnstr.id();
-            } else {
-                debugmsg( "invalid furn_str_id '%s'", furnstr.c_str() );
-                iid_furn = furn_str_id::NULL_ID().id();
+            const auto [iid_ter, iid_furn] = ter_furn_migrations::migrate_furniture(
+                                                 furn_str_id( furniture_entry.next_string() ) );
+            if( iid_ter ) {
+                m->ter.set( point_sm_ms( i, j ), iid_ter );
             }
-            m->frn[i][j] = iid_furn;
+            m->frn.set( point_sm_ms( i, j ), iid_furn );
             if( furniture_entry.size() > 3 ) {
                 furniture_entry.throw_error( "Too many values for furniture entry." );
             }
@@ -5180,12 +5131,12 @@ void submap::load( const JsonValue &jv, const std::string &member_name, int vers
             const point_sm_ms p( i, j );
             // TODO: jsin should support returning an id like jsin.get_id<trap>()
             const trap_str_id trid( trap_entry.next_string() );
-            m->trp[p.x()][p.y()] = trid.id();
+            m->trp.set( p, trid.id() );
             if( trap_entry.has_more() ) {
                 std::optional<std::string> trap_item_type = std::nullopt;
                 trap_entry.read_next( trap_item_type );
                 if( trap_item_type.has_value() ) {
-                    const_cast<trap &>( m->trp[p.x()][p.y()].obj() ).set_trap_data( itype_id(
+                    const_cast<trap &>( m->trp.get( p ).obj() ).set_trap_data( itype_id(
                                 trap_item_type.value() ) );
                 }
             }
@@ -5214,6 +5165,7 @@ void submap::load( const JsonValue &jv, const std::string &member_name, int vers
                     } else if( ft != field_type_str_id::NULL_ID() &&
                                m->fld[i][j].add_field( ft.id(), intensity, time_duration::from_turns( age ) ) ) {
                         field_count++;
+                        m->fld_tiles.insert( point_sm_ms( i, j ) );
                     }
                 } else { // Handle removed int enum method
                     field_json.next_value(); // Skip intensity
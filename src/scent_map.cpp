@@ -178,18 +178,6 @@ void scent_map::update( const tripoint_bub_ms &center, map &m )
         return;
     }
 
-    // note: the next four intermediate matrices need to be at least
-    // [2*SCENT_RADIUS+3][2*SCENT_RADIUS+1] in size to hold enough data
-    // The code I'm modifying used [MAPSIZE_X]. I'm staying with that to avoid new bugs.
-
-    // These two matrices are transposed so that x addresses are contiguous in memory
-    scent_array<int> sum_3_scent_y;
-    scent_array<int> squares_used_y;
-
-    // these are for caching flag lookups
-    scent_array<bool> blocks_scent; // currently only ter_furn_flag::TFLAG_NO_SCENT blocks scent
-    scent_array<bool> reduces_scent;
-
     // for loop constants
     const int scentmap_minx = center.x() - SCENT_RADIUS;
     const int scentmap_maxx = center.x() + SCENT_RADIUS;
@@ -203,66 +191,56 @@ void scent_map::update( const tripoint_bub_ms &center, map &m )
     // The new scent flag searching function. Should be wayyy faster than the old one.
     m.scent_blockers( blocks_scent, reduces_scent, point_bub_ms( scentmap_minx - 1, scentmap_miny - 1 ),
                       point_bub_ms( scentmap_maxx + 1, scentmap_maxy + 1 ) );
+
+    // The loops below have no branches and run over y, which is contiguous in memory, so
+    // the compiler can vectorize them. Flags become weights: blocked squares take no part,
+    // and only 20% of scent can diffuse on REDUCE_SCENT squares.
+    // note: the sums need one more square on each side in the x direction than the final
+    // scent matrix, and the weights one more in the y direction too. This is fine since
+    // SCENT_RADIUS is less than MAPSIZE_X, but if that changes, this may need tweaking.
+    for( int x = scentmap_minx - 1; x <= scentmap_maxx + 1; ++x ) {
+        for( int y = scentmap_miny - 1; y <= scentmap_maxy + 1; ++y ) {
+            const int weight = blocks_scent[x][y] ? 0 : reduces_scent[x][y] ? 2 : 10;
+            scent_weight[x][y] = weight;
+            weighted_scent[x][y] = weight * grscent[x][y];
+        }
+    }
+
     // Sum neighbors in the y direction.  This way, each square gets called 3 times instead of 9
-    // times. This cost us an extra loop here, but it also eliminated a loop at the end, so there
-    // is a net performance improvement over the old code. Could probably still be better.
-    // note: this method needs an array that is one square larger on each side in the x direction
-    // than the final scent matrix. I think this is fine since SCENT_RADIUS is less than
-    // MAPSIZE_X, but if that changes, this may need tweaking.
+    // times.
     for( int x = scentmap_minx - 1; x <= scentmap_maxx + 1; ++x ) {
         for( int y = scentmap_miny; y <= scentmap_maxy; ++y ) {
             // remember the sum of the scent val for the 3 neighboring squares that can defuse into
-            sum_3_scent_y[y][x] = 0;
-            squares_used_y[y][x] = 0;
-            for( int i = y - 1; i <= y + 1; ++i ) {
-                if( !blocks_scent[x][i] ) {
-                    if( reduces_scent[x][i] ) {
-                        // only 20% of scent can diffuse on REDUCE_SCENT squares
-                        sum_3_scent_y[y][x] += 2 * grscent[x][i];
-                        squares_used_y[y][x] += 2;
-                    } else {
-                        sum_3_scent_y[y][x] += 10 * grscent[x][i];
-                        squares_used_y[y][x] += 10;
-                    }
-                }
-            }
+            sum_3_scent_y[x][y] = weighted_scent[x][y - 1] + weighted_scent[x][y] +
+                                  weighted_scent[x][y + 1];
+            sum_3_weight_y[x][y] = scent_weight[x][y - 1] + scent_weight[x][y] +
+                                   scent_weight[x][y + 1];
         }
     }
 
-    // Rest of the scent map
+    // Rest of the scent map. Each square reads only its own scent and the sums, so the
+    // sums act as the back buffer and the result can be written in place.
     for( int x = scentmap_minx; x <= scentmap_maxx; ++x ) {
         for( int y = scentmap_miny; y <= scentmap_maxy; ++y ) {
-            int &scent_here = grscent[x][y];
-            if( !blocks_scent[x][y] ) {
-                // to how many neighboring squares do we diffuse out? (include our own square
-                // since we also include our own square when diffusing in)
-                const int squares_used = squares_used_y[y][x - 1]
-                                         + squares_used_y[y][x]
-                                         + squares_used_y[y][x + 1];
-
-                int this_diffusivity;
-                if( !reduces_scent[x][y] ) {
-                    this_diffusivity = diffusivity;
-                } else {
-                    this_diffusivity = diffusivity / 5; //less air movement for REDUCE_SCENT square
-                }
-                // take the old scent and subtract what diffuses out
-                int temp_scent = scent_here * ( 10 * 1000 - squares_used * this_diffusivity );
-                // neighboring REDUCE_SCENT squares absorb some scent
-                temp_scent -= scent_here * this_diffusivity * ( 90 - squares_used ) / 5;
-                // we've already summed neighboring scent values in the y direction in the previous
-                // loop. Now we do it for the x direction, multiply by diffusion, and this is what
-                // diffuses into our current square.
-                scent_here =
-                    ( temp_scent
-                      + this_diffusivity * ( sum_3_scent_y[y][x - 1]
-                                             + sum_3_scent_y[y][x]
-                                             + sum_3_scent_y[y][x + 1] )
-                    ) / ( 1000 * 10 );
-            } else {
-                // this cell blocks scent via NO_SCENT (in json)
-                scent_here = 0;
-            }
+            const int scent_here = grscent[x][y];
+            // to how many neighboring squares do we diffuse out? (include our own square
+            // since we also include our own square when diffusing in)
+            const int squares_used = sum_3_weight_y[x - 1][y] + sum_3_weight_y[x][y] +
+                                     sum_3_weight_y[x + 1][y];
+            //less air movement for REDUCE_SCENT square
+            const int this_diffusivity = reduces_scent[x][y] ? diffusivity / 5 : diffusivity;
+            // take the old scent and subtract what diffuses out
+            int temp_scent = scent_here * ( 10 * 1000 - squares_used * this_diffusivity );
+            // neighboring REDUCE_SCENT squares absorb some scent
+            temp_scent -= scent_here * this_diffusivity * ( 90 - squares_used ) / 5;
+            // we've already summed neighboring scent values in the y direction in the previous
+            // loop. Now we do it for the x direction, multiply by diffusion, and this is what
+            // diffuses into our current square.
+            const int sum_3_scent = sum_3_scent_y[x - 1][y] + sum_3_scent_y[x][y] +
+                                    sum_3_scent_y[x + 1][y];
+            const int diffused = ( temp_scent + this_diffusivity * sum_3_scent ) / ( 1000 * 10 );
+            // this cell blocks scent via NO_SCENT (in json)
+            grscent[x][y] = blocks_scent[x][y] ? 0 : diffused;
         }
     }
 }
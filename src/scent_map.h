@@ -56,6 +56,17 @@ class scent_map
 
         const game &gm; // NOLINT(cata-serialize)
 
+        // Buffers of @ref update, kept between turns instead of taking 200 KiB of stack.
+        // Like grscent they are indexed [x][y], so the loops over y run over contiguous memory.
+        scent_array<bool> blocks_scent; // NOLINT(cata-serialize)
+        scent_array<bool> reduces_scent; // NOLINT(cata-serialize)
+        // How much of the scent of a square diffuses, 0 for blocked squares.
+        scent_array<int> scent_weight; // NOLINT(cata-serialize)
+        scent_array<int> weighted_scent; // NOLINT(cata-serialize)
+        // Sums of the above over each square and its neighbors in the y direction.
+        scent_array<int> sum_3_weight_y; // NOLINT(cata-serialize)
+        scent_array<int> sum_3_scent_y; // NOLINT(cata-serialize)
+
     public:
         explicit scent_map( const game &g ) : gm( g ) { }
 
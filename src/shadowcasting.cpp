@@ -1,9 +1,20 @@
 #include "shadowcasting.h"
 
+#include <array>
 #include <cstdint>
 #include <cstdlib>
 #include <iterator>
 
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define CATA_SHADOWCASTING_SSE2
+#include <emmintrin.h>
+// AVX2 is only used through function level target attributes, which MSVC lacks
+#if defined(__GNUC__) || defined(__clang__)
+#define CATA_SHADOWCASTING_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 #include "coordinates.h"
 #include "cuboid_rectangle.h"
 #include "fragment_cloud.h" // IWYU pragma: keep
@@ -158,6 +169,36 @@ static void split_span( cata::list<span<T>> &spans,
     current_transparency = new_transparency;
 }
 
+/**
+ * Counts the tiles after @p current along a row of cast_horizontal_zlight_segment that
+ * have @p transparency and that the sweep would visit before leaving @p this_span or
+ * the map.  The row has to run along a column of the caches, i.e. in y.
+ */
+template<int y_step>
+static int same_transparency_run( const tripoint_bub_ms &current, const tripoint_rel_ms &delta,
+                                  const int distance, const span<float> &this_span,
+                                  const cata::mdarray<float, point_bub_ms> &input, const float transparency )
+{
+    int limit = 0;
+    for( int next = delta.x() + 1; next <= distance; ++next ) {
+        const int y = current.y() + ( next - delta.x() ) * y_step;
+        if( y < 0 || y >= MAPSIZE_Y ||
+            this_span.end_minor < slope( next * 2 - 1, delta.y() * 2 + 1 ) ) {
+            break;
+        }
+        ++limit;
+    }
+    if( limit == 0 ) {
+        return 0;
+    }
+    const float *first = &input[current.x()][current.y() + y_step];
+    if constexpr( y_step > 0 ) {
+        return shadowcasting_simd::equal_run( first, limit, transparency );
+    } else {
+        return shadowcasting_simd::equal_run_reverse( first, limit, transparency );
+    }
+}
+
 template<int xx_transform, int xy_transform, int yx_transform, int yy_transform, int z_transform, typename T,
          T( *calc )( const T &, const T &, const int & ),
          bool( *is_transparent )( const T &, const T & ),
@@ -182,6 +223,20 @@ void cast_horizontal_zlight_segment(
     tripoint_rel_ms delta;
     tripoint_bub_ms current;
 
+    // Along a row the cumulative value and distance rarely change, so don't
+    // recalculate the intensity for every tile.
+    T intensity_value( 0.0 );
+    T intensity_cumulative_value( 0.0 );
+    int intensity_dist = -1;
+    const auto intensity = [&]( const T & cumulative_value, int dist ) {
+        if( dist != intensity_dist || !( cumulative_value == intensity_cumulative_value ) ) {
+            intensity_value = calc( numerator, cumulative_value, dist );
+            intensity_cumulative_value = cumulative_value;
+            intensity_dist = dist;
+        }
+        return intensity_value;
+    };
+
     // We start out with one span covering the entire horizontal and vertical space
     // we are interested in.  Then as changes in transparency are encountered, we truncate
     // that initial span and insert new spans before/after it in the list, removing any that
@@ -300,7 +355,7 @@ void cast_horizontal_zlight_segment(
                     }
 
                     const int dist = rl_dist( tripoint_rel_ms::zero, delta ) + offset_distance;
-                    last_intensity = calc( numerator, this_span->cumulative_value, dist );
+                    last_intensity = intensity( this_span->cumulative_value, dist );
 
                     if( !floor_block ) {
                         ( *output_caches[z_index] )[current.x()][current.y()] =
@@ -316,6 +371,25 @@ void cast_horizontal_zlight_segment(
                     if( new_transparency == current_transparency ) {
                         // All in order, no need to split the span.
                         new_start_minor = leading_edge_minor;
+                        if constexpr( xx_transform == 0 && std::is_same_v<T, float> ) {
+                            // This row runs along a column of the caches, so the tiles that
+                            // follow with the same transparency can be lit in one go.  Off the
+                            // origin's z-level floors get in the way, and with trigdist the
+                            // distance changes along the row.
+                            if( current.z() == offset.z() && !trigdist ) {
+                                const int run = same_transparency_run<yx_transform>( current,
+                                                delta, distance, *this_span,
+                                                *input_arrays[z_index], current_transparency );
+                                if( run > 0 ) {
+                                    float *output = &( *output_caches[z_index] )[current.x()][current.y()];
+                                    shadowcasting_simd::raise_to( yx_transform > 0 ? output + 1 : output - run,
+                                                                  run, last_intensity );
+                                    delta.x() += run;
+                                    current.y() += run * yx_transform;
+                                    new_start_minor = slope( delta.x() * 2 + 1, delta.y() * 2 - 1 );
+                                }
+                            }
+                        }
                         continue;
                     }
 
@@ -377,6 +451,20 @@ void cast_vertical_zlight_segment(
     tripoint_rel_ms delta;
     tripoint_bub_ms current;
 
+    // Along a row the cumulative value and distance rarely change, so don't
+    // recalculate the intensity for every tile.
+    T intensity_value( 0.0 );
+    T intensity_cumulative_value( 0.0 );
+    int intensity_dist = -1;
+    const auto intensity = [&]( const T & cumulative_value, int dist ) {
+        if( dist != intensity_dist || !( cumulative_value == intensity_cumulative_value ) ) {
+            intensity_value = calc( numerator, cumulative_value, dist );
+            intensity_cumulative_value = cumulative_value;
+            intensity_dist = dist;
+        }
+        return intensity_value;
+    };
+
     // We start out with one span covering the entire horizontal and vertical space
     // we are interested in.  Then as changes in transparency are encountered, we truncate
     // that initial span and insert new spans before/after it in the list, removing any that
@@ -472,7 +560,7 @@ void cast_vertical_zlight_segment(
                     }
 
                     const int dist = rl_dist( tripoint_rel_ms::zero, delta ) + offset_distance;
-                    last_intensity = calc( numerator, this_span->cumulative_value, dist );
+                    last_intensity = intensity( this_span->cumulative_value, dist );
 
                     if( !floor_block ) {
                         ( *output_caches[z_index] )[current.x()][current.y()] =
@@ -527,6 +615,139 @@ void cast_vertical_zlight_segment(
     }
 }
 
+namespace
+{
+// The transforms of the segments cast by cast_zlight, in the order it casts them.
+// Vertical segments only use x_transform (as xx) and y_transform (as yy).
+struct zlight_segment {
+    bool vertical;
+    int xx;
+    int xy;
+    int yx;
+    int yy;
+    int z;
+};
+
+constexpr std::array<zlight_segment, zlight_segment_count> zlight_segment_transforms = {{
+        // Down lateral
+        { false, 0, 1, 1, 0, -1 }, { false, 1, 0, 0, 1, -1 },
+        { false, 0, -1, 1, 0, -1 }, { false, -1, 0, 0, 1, -1 },
+        { false, 0, 1, -1, 0, -1 }, { false, 1, 0, 0, -1, -1 },
+        { false, 0, -1, -1, 0, -1 }, { false, -1, 0, 0, -1, -1 },
+        // Straight down
+        { true, 1, 0, 0, 1, -1 }, { true, 1, 0, 0, -1, -1 },
+        { true, -1, 0, 0, 1, -1 }, { true, -1, 0, 0, -1, -1 },
+        // Up lateral
+        { false, 0, 1, 1, 0, 1 }, { false, 1, 0, 0, 1, 1 },
+        { false, 0, -1, 1, 0, 1 }, { false, -1, 0, 0, 1, 1 },
+        { false, 0, 1, -1, 0, 1 }, { false, 1, 0, 0, -1, 1 },
+        { false, 0, -1, -1, 0, 1 }, { false, -1, 0, 0, -1, 1 },
+        // Straight up
+        { true, 1, 0, 0, 1, 1 }, { true, 1, 0, 0, -1, 1 },
+        { true, -1, 0, 0, 1, 1 }, { true, -1, 0, 0, -1, 1 },
+    }
+};
+
+// Maps an offset from the origin to the coordinates swept by the segment:
+// the distance being swept, then the minor and major offsets within it.
+tripoint segment_local( const zlight_segment &seg, const tripoint_rel_ms &delta )
+{
+    if( seg.vertical ) {
+        return tripoint( delta.z() * seg.z, delta.x() * seg.xx, delta.y() * seg.yy );
+    }
+    // The transforms are orthogonal, so the inverse is the transpose
+    return tripoint( delta.x() * seg.xy + delta.y() * seg.yy,
+                     delta.x() * seg.xx + delta.y() * seg.yx,
+                     delta.z() * seg.z );
+}
+
+bool segment_contains( const zlight_segment &seg, const tripoint_rel_ms &delta )
+{
+    const tripoint local = segment_local( seg, delta );
+    return local.x >= 1 && local.y >= 0 && local.y <= local.x && local.z >= 0 && local.z <= local.x;
+}
+
+std::array<zlight_segments, zlight_segment_count> build_segment_overlaps()
+{
+    // The segments are cones with their apex at the origin, so any two that
+    // intersect at all already do so right next to it.
+    constexpr int range = 2;
+    std::array<zlight_segments, zlight_segment_count> overlaps;
+    for( int x = -range; x <= range; ++x ) {
+        for( int y = -range; y <= range; ++y ) {
+            for( int z = -range; z <= range; ++z ) {
+                const zlight_segments containing =
+                    zlight_segments_containing( tripoint_rel_ms( x, y, z ) );
+                for( int i = 0; i < zlight_segment_count; ++i ) {
+                    if( containing[i] ) {
+                        overlaps[i] |= containing;
+                    }
+                }
+            }
+        }
+    }
+    return overlaps;
+}
+} // namespace
+
+zlight_segments zlight_segments_containing( const tripoint_rel_ms &delta )
+{
+    zlight_segments result;
+    for( int i = 0; i < zlight_segment_count; ++i ) {
+        result[i] = segment_contains( zlight_segment_transforms[i], delta );
+    }
+    return result;
+}
+
+zlight_segments zlight_segments_overlapping( const zlight_segments &segments )
+{
+    static const std::array<zlight_segments, zlight_segment_count> overlaps =
+        build_segment_overlaps();
+    zlight_segments result = segments;
+    for( int i = 0; i < zlight_segment_count; ++i ) {
+        if( segments[i] ) {
+            result |= overlaps[i];
+        }
+    }
+    return result;
+}
+
+int reset_zlight_segments( const array_of_grids_of<float> &output_caches,
+                           const tripoint_bub_ms &origin, const int offset_distance,
+                           const zlight_segments &segments, const float value )
+{
+    const int radius = MAX_VIEW_DISTANCE - offset_distance;
+    int count = 0;
+    for( int i = 0; i < zlight_segment_count; ++i ) {
+        if( !segments[i] ) {
+            continue;
+        }
+        const zlight_segment &seg = zlight_segment_transforms[i];
+        for( int distance = 1; distance <= radius; ++distance ) {
+            for( int major = 0; major <= distance; ++major ) {
+                const int z = origin.z() + ( seg.vertical ? distance : major ) * seg.z;
+                if( z < -OVERMAP_DEPTH || z > OVERMAP_HEIGHT ) {
+                    // Every further tile is out of bounds too, at least until the next distance
+                    break;
+                }
+                cata::mdarray<float, point_bub_ms> &output = *output_caches[z + OVERMAP_DEPTH];
+                for( int minor = 0; minor <= distance; ++minor ) {
+                    const point_bub_ms p = seg.vertical ?
+                                           origin.xy() + point( minor * seg.xx, major * seg.yy ) :
+                                           origin.xy() + point( minor * seg.xx + distance * seg.xy,
+                                                   minor * seg.yx + distance * seg.yy );
+                    if( p.x() < 0 || p.x() >= MAPSIZE_X || p.y() < 0 || p.y() >= MAPSIZE_Y ) {
+                        continue;
+                    }
+                    output[p.x()][p.y()] = value;
+                    ++count;
+                }
+            }
+        }
+    }
+    return count;
+}
+
 template<typename T, T( *calc )( const T &, const T &, const int & ),
          bool( *is_transparent )( const T &, const T & ),
          T( *accumulate )( const T &, const T &, const int & )>
@@ -535,68 +756,92 @@ void cast_zlight(
     const array_of_grids_of<const T> &input_arrays,
     const array_of_grids_of<const bool> &floor_caches,
     const tripoint_bub_ms &origin, const int offset_distance, const T numerator,
-    vertical_direction dir )
+    vertical_direction dir, const zlight_segments &segments )
 {
     if( dir == vertical_direction::DOWN || dir == vertical_direction::BOTH ) {
         // Down lateral
         // @..
         //  ..
         //   .
-        cast_horizontal_zlight_segment < 0, 1, 1, 0, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[0] ) {
+            cast_horizontal_zlight_segment < 0, 1, 1, 0, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // @
         // ..
         // ...
-        cast_horizontal_zlight_segment < 1, 0, 0, 1, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[1] ) {
+            cast_horizontal_zlight_segment < 1, 0, 0, 1, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         //   .
         //  ..
         // @..
-        cast_horizontal_zlight_segment < 0, -1, 1, 0, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[2] ) {
+            cast_horizontal_zlight_segment < 0, -1, 1, 0, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ...
         // ..
         // @
-        cast_horizontal_zlight_segment < -1, 0, 0, 1, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[3] ) {
+            cast_horizontal_zlight_segment < -1, 0, 0, 1, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ..@
         // ..
         // .
-        cast_horizontal_zlight_segment < 0, 1, -1, 0, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[4] ) {
+            cast_horizontal_zlight_segment < 0, 1, -1, 0, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         //   @
         //  ..
         // ...
-        cast_horizontal_zlight_segment < 1, 0, 0, -1, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[5] ) {
+            cast_horizontal_zlight_segment < 1, 0, 0, -1, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // .
         // ..
         // ..@
-        cast_horizontal_zlight_segment < 0, -1, -1, 0, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[6] ) {
+            cast_horizontal_zlight_segment < 0, -1, -1, 0, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ...
         //  ..
         //   @
-        cast_horizontal_zlight_segment < -1, 0, 0, -1, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[7] ) {
+            cast_horizontal_zlight_segment < -1, 0, 0, -1, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
 
         // Straight down
         // @.
         // ..
-        cast_vertical_zlight_segment < 1, 1, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[8] ) {
+            cast_vertical_zlight_segment < 1, 1, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ..
         // @.
-        cast_vertical_zlight_segment < 1, -1, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[9] ) {
+            cast_vertical_zlight_segment < 1, -1, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // .@
         // ..
-        cast_vertical_zlight_segment < -1, 1, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[10] ) {
+            cast_vertical_zlight_segment < -1, 1, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ..
         // .@
-        cast_vertical_zlight_segment < -1, -1, -1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[11] ) {
+            cast_vertical_zlight_segment < -1, -1, -1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
     }
 
     if( dir == vertical_direction::UP || dir == vertical_direction::BOTH ) {
@@ -604,61 +849,85 @@ void cast_zlight(
         // @..
         //  ..
         //   .
-        cast_horizontal_zlight_segment < 0, 1, 1, 0, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[12] ) {
+            cast_horizontal_zlight_segment < 0, 1, 1, 0, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // @
         // ..
         // ...
-        cast_horizontal_zlight_segment < 1, 0, 0, 1, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[13] ) {
+            cast_horizontal_zlight_segment < 1, 0, 0, 1, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ..@
         // ..
         // .
-        cast_horizontal_zlight_segment < 0, -1, 1, 0, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[14] ) {
+            cast_horizontal_zlight_segment < 0, -1, 1, 0, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         //   @
         //  ..
         // ...
-        cast_horizontal_zlight_segment < -1, 0, 0, 1, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[15] ) {
+            cast_horizontal_zlight_segment < -1, 0, 0, 1, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         //   .
         //  ..
         // @..
-        cast_horizontal_zlight_segment < 0, 1, -1, 0, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[16] ) {
+            cast_horizontal_zlight_segment < 0, 1, -1, 0, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ...
         // ..
         // @
-        cast_horizontal_zlight_segment < 1, 0, 0, -1, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[17] ) {
+            cast_horizontal_zlight_segment < 1, 0, 0, -1, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // .
         // ..
         // ..@
-        cast_horizontal_zlight_segment < 0, -1, -1, 0, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[18] ) {
+            cast_horizontal_zlight_segment < 0, -1, -1, 0, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ...
         //  ..
         //   @
-        cast_horizontal_zlight_segment < -1, 0, 0, -1, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[19] ) {
+            cast_horizontal_zlight_segment < -1, 0, 0, -1, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
 
         // Straight up
         // @.
         // ..
-        cast_vertical_zlight_segment < 1, 1, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[20] ) {
+            cast_vertical_zlight_segment < 1, 1, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ..
         // @.
-        cast_vertical_zlight_segment < 1, -1, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[21] ) {
+            cast_vertical_zlight_segment < 1, -1, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // .@
         // ..
-        cast_vertical_zlight_segment < -1, 1, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[22] ) {
+            cast_vertical_zlight_segment < -1, 1, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
         // ..
         // .@
-        cast_vertical_zlight_segment < -1, -1, 1, T, calc, is_transparent, accumulate > (
-            output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        if( segments[23] ) {
+            cast_vertical_zlight_segment < -1, -1, 1, T, calc, is_transparent, accumulate > (
+                output_caches, input_arrays, floor_caches, origin, offset_distance, numerator );
+        }
     }
 }
 
@@ -669,11 +938,250 @@ template void cast_zlight<float, sight_calc, sight_check, accumulate_transparenc
     const array_of_grids_of<const float> &input_arrays,
     const array_of_grids_of<const bool> &floor_caches,
     const tripoint_bub_ms &origin, int offset_distance, float numerator,
-    vertical_direction dir );
+    vertical_direction dir, const zlight_segments &segments );
 
 template void cast_zlight<fragment_cloud, shrapnel_calc, shrapnel_check, accumulate_fragment_cloud>(
     const array_of_grids_of<fragment_cloud> &output_caches,
     const array_of_grids_of<const fragment_cloud> &input_arrays,
     const array_of_grids_of<const bool> &floor_caches,
     const tripoint_bub_ms &origin, int offset_distance, fragment_cloud numerator,
-    vertical_direction dir );
+    vertical_direction dir, const zlight_segments &segments );
+
+namespace
+{
+using equal_run_fn = int( * )( const float *, int, float );
+using raise_to_fn = void( * )( float *, int, float );
+
+struct simd_kernels {
+    equal_run_fn equal_run;
+    equal_run_fn equal_run_reverse;
+    raise_to_fn raise_to;
+};
+
+int equal_run_scalar( const float *values, int count, float value )
+{
+    int i = 0;
+    while( i < count && values[i] == value ) {
+        ++i;
+    }
+    return i;
+}
+
+int equal_run_reverse_scalar( const float *values, int count, float value )
+{
+    int i = 0;
+    while( i < count && *( values - i ) == value ) {
+        ++i;
+    }
+    return i;
+}
+
+void raise_to_scalar( float *out, int count, float value )
+{
+    for( int i = 0; i < count; ++i ) {
+        out[i] = std::max( out[i], value );
+    }
+}
+
+#if defined(CATA_SHADOWCASTING_SSE2)
+// Number of set bits of @p mask counted from bit @p from downwards, up to the first unset one
+int set_bits_down_from( unsigned int mask, int from )
+{
+    int bits = 0;
+    while( from - bits >= 0 && ( mask & ( 1u << ( from - bits ) ) ) ) {
+        ++bits;
+    }
+    return bits;
+}
+
+int equal_run_sse2( const float *values, int count, float value )
+{
+    const __m128 target = _mm_set1_ps( value );
+    int i = 0;
+    for( ; i + 4 <= count; i += 4 ) {
+        const int mask = _mm_movemask_ps( _mm_cmpeq_ps( _mm_loadu_ps( values + i ), target ) );
+        if( mask != 0xF ) {
+            return i + equal_run_scalar( values + i, 4, value );
+        }
+    }
+    return i + equal_run_scalar( values + i, count - i, value );
+}
+
+int equal_run_reverse_sse2( const float *values, int count, float value )
+{
+    const __m128 target = _mm_set1_ps( value );
+    int i = 0;
+    for( ; i + 4 <= count; i += 4 ) {
+        // The highest lane holds the value nearest to the start of the run
+        const int mask = _mm_movemask_ps( _mm_cmpeq_ps( _mm_loadu_ps( values - i - 3 ), target ) );
+        if( mask != 0xF ) {
+            return i + set_bits_down_from( mask, 3 );
+        }
+    }
+    return i + equal_run_reverse_scalar( values - i, count - i, value );
+}
+
+void raise_to_sse2( float *out, int count, float value )
+{
+    const __m128 target = _mm_set1_ps( value );
+    int i = 0;
+    for( ; i + 4 <= count; i += 4 ) {
+        // Operand order matters: this keeps out[i] unless value is greater, like std::max
+        _mm_storeu_ps( out + i, _mm_max_ps( target, _mm_loadu_ps( out + i ) ) );
+    }
+    raise_to_scalar( out + i, count - i, value );
+}
+#endif
+
+#if defined(CATA_SHADOWCASTING_AVX2)
+__attribute__( ( target( "avx2" ) ) )
+int equal_run_avx2( const float *values, int count, float value )
+{
+    const __m256 target = _mm256_set1_ps( value );
+    int i = 0;
+    for( ; i + 8 <= count; i += 8 ) {
+        const int mask = _mm256_movemask_ps( _mm256_cmp_ps( _mm256_loadu_ps( values + i ), target,
+                                             _CMP_EQ_OQ ) );
+        if( mask != 0xFF ) {
+            return i + equal_run_scalar( values + i, 8, value );
+        }
+    }
+    return i + equal_run_sse2( values + i, count - i, value );
+}
+
+__attribute__( ( target( "avx2" ) ) )
+int equal_run_reverse_avx2( const float *values, int count, float value )
+{
+    const __m256 target = _mm256_set1_ps( value );
+    int i = 0;
+    for( ; i + 8 <= count; i += 8 ) {
+        const int mask = _mm256_movemask_ps( _mm256_cmp_ps( _mm256_loadu_ps( values - i - 7 ), target,
+                                             _CMP_EQ_OQ ) );
+        if( mask != 0xFF ) {
+            return i + set_bits_down_from( mask, 7 );
+        }
+    }
+    return i + equal_run_reverse_sse2( values - i, count - i, value );
+}
+
+__attribute__( ( target( "avx2" ) ) )
+void raise_to_avx2( float *out, int count, float value )
+{
+    const __m256 target = _mm256_set1_ps( value );
+    int i = 0;
+    for( ; i + 8 <= count; i += 8 ) {
+        _mm256_storeu_ps( out + i, _mm256_max_ps( target, _mm256_loadu_ps( out + i ) ) );
+    }
+    raise_to_sse2( out + i, count - i, value );
+}
+#endif
+
+constexpr std::array<simd_kernels, static_cast<size_t>
+          ( shadowcasting_simd::instruction_set::num_instruction_sets )> all_simd_kernels = {{
+        { equal_run_scalar, equal_run_reverse_scalar, raise_to_scalar },
+#if defined(CATA_SHADOWCASTING_SSE2)
+        { equal_run_sse2, equal_run_reverse_sse2, raise_to_sse2 },
+#else
+        { nullptr, nullptr, nullptr },
+#endif
+#if defined(CATA_SHADOWCASTING_AVX2)
+        { equal_run_avx2, equal_run_reverse_avx2, raise_to_avx2 },
+#else
+        { nullptr, nullptr, nullptr },
+#endif
+    }
+};
+
+bool cpu_supports( shadowcasting_simd::instruction_set set )
+{
+    switch( set ) {
+        case shadowcasting_simd::instruction_set::scalar:
+            return true;
+        case shadowcasting_simd::instruction_set::sse2:
+#if defined(CATA_SHADOWCASTING_SSE2)
+            return true;
+#else
+            return false;
+#endif
+        case shadowcasting_simd::instruction_set::avx2:
+#if defined(CATA_SHADOWCASTING_AVX2)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports( "avx2" );
+#else
+            return false;
+#endif
+        case shadowcasting_simd::instruction_set::num_instruction_sets:
+            break;
+    }
+    return false;
+}
+
+shadowcasting_simd::instruction_set best_instruction_set()
+{
+    for( int i = static_cast<int>( shadowcasting_simd::instruction_set::num_instruction_sets ) - 1;
+         i > 0; --i ) {
+        if( cpu_supports( static_cast<shadowcasting_simd::instruction_set>( i ) ) ) {
+            return static_cast<shadowcasting_simd::instruction_set>( i );
+        }
+    }
+    return shadowcasting_simd::instruction_set::scalar;
+}
+
+shadowcasting_simd::instruction_set &active_instruction_set()
+{
+    static shadowcasting_simd::instruction_set set = best_instruction_set();
+    return set;
+}
+
+const simd_kernels &active_kernels()
+{
+    return all_simd_kernels[static_cast<size_t>( active_instruction_set() )];
+}
+} // namespace
+
+namespace shadowcasting_simd
+{
+instruction_set active()
+{
+    return active_instruction_set();
+}
+
+bool set_active( instruction_set set )
+{
+    if( set == instruction_set::num_instruction_sets || !cpu_supports( set ) ) {
+        return false;
+    }
+    active_instruction_set() = set;
+    return true;
+}
+
+std::string_view name( instruction_set set )
+{
+    switch( set ) {
+        case instruction_set::scalar:
+            return "scalar";
+        case instruction_set::sse2:
+            return "sse2";
+        case instruction_set::avx2:
+            return "avx2";
+        case instruction_set::num_instruction_sets:
+            break;
+    }
+    return "invalid";
+}
+
+int equal_run( const float *values, int count, float value )
+{
+    return active_kernels().equal_run( values, count, value );
+}
+
+int equal_run_reverse( const float *values, int count, float value )
+{
+    return active_kernels().equal_run_reverse( values, count, value );
+}
+
+void raise_to( float *out, int count, float value )
+{
+    active_kernels().raise_to( out, count, value );
+}
+} // namespace shadowcasting_simd
@@ -4,9 +4,11 @@
 
 #include <algorithm>
 #include <array>
+#include <bitset>
 #include <cmath>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
 #include "coords_fwd.h"
@@ -115,6 +117,34 @@ inline float accumulate_transparency( const float &cumulative_transparency,
     return ( ( distance - 1 ) * cumulative_transparency + current_transparency ) / distance;
 }
 
+/**
+ * Kernels for the stretches of a shadowcasting sweep that lie along a row of a
+ * cache in memory, where several tiles can be handled at once.  The
+ * implementation is picked on first use from the widest instruction set the
+ * CPU supports; all of them give exactly the same results as the scalar one.
+ */
+namespace shadowcasting_simd
+{
+enum class instruction_set : int {
+    scalar,
+    sse2,
+    avx2,
+    num_instruction_sets
+};
+
+instruction_set active();
+/** Switches to @p set, returning false if this build or CPU can't use it. */
+bool set_active( instruction_set set );
+std::string_view name( instruction_set set );
+
+/** Number of values from @p values onwards equal to @p value, at most @p count. */
+int equal_run( const float *values, int count, float value );
+/** Same as equal_run, but walking backwards from @p values. */
+int equal_run_reverse( const float *values, int count, float value );
+/** Raises each of the @p count values from @p out onwards to at least @p value. */
+void raise_to( float *out, int count, float value );
+} // namespace shadowcasting_simd
+
 template<typename T, typename Out, T( *calc )( const T &, const T &, const int & ),
          bool( *check )( const T &, const T & ),
          void( *update_output )( Out &, const T &, quadrant ),
@@ -132,6 +162,25 @@ using array_of_grids_of =
     std::array<cata::mdarray<T, point_bub_ms>*, OVERMAP_LAYERS>
     >;
 
+// cast_zlight sweeps the space around the origin in 24 segments: eight octants
+// and four quadrants of the vertical cone looking down, then the same looking up.
+// Neighbouring segments share the tiles on their common boundary.
+constexpr int zlight_segment_count = 24;
+using zlight_segments = std::bitset<zlight_segment_count>;
+
+/** The segments whose sweep includes the tile at @p delta from the origin. */
+zlight_segments zlight_segments_containing( const tripoint_rel_ms &delta );
+/** @p segments together with every segment sharing tiles with one of them. */
+zlight_segments zlight_segments_overlapping( const zlight_segments &segments );
+/**
+ * Sets every in-bounds tile that the @p segments of a cast from @p origin could
+ * reach to @p value, so that they can be cast again from scratch.
+ * @return the number of tiles that were set.
+ */
+int reset_zlight_segments( const array_of_grids_of<float> &output_caches,
+                           const tripoint_bub_ms &origin, int offset_distance,
+                           const zlight_segments &segments, float value );
+
 // TODO: Generalize the floor check, allow semi-transparent floors
 template< typename T, T( *calc )( const T &, const T &, const int & ),
           bool( *check )( const T &, const T & ),
@@ -141,6 +190,7 @@ void cast_zlight(
     const array_of_grids_of<const T> &input_arrays,
     const array_of_grids_of<const bool> &floor_caches,
     const tripoint_bub_ms &origin, int offset_distance, T numerator,
-    vertical_direction dir = vertical_direction::BOTH );
+    vertical_direction dir = vertical_direction::BOTH,
+    const zlight_segments &segments = zlight_segments().set() );
 
 #endif // CATA_SRC_SHADOWCASTING_H
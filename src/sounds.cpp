@@ -1,16 +1,21 @@
 #include "sounds.h"
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <cmath>
 #include <cstdlib>
+#include <limits>
+#include <map>
 #include <memory>
+#include <optional>
 #include <type_traits>
 #include <unordered_map>
 
 #include "activity_type.h"
 #include "cached_options.h" // IWYU pragma: keep
 #include "calendar.h"
+#include "cata_utility.h"
 #include "character.h"
 #include "coordinates.h"
 #include "creature_tracker.h"
@@ -250,10 +255,10 @@ static std::unordered_map<tripoint_bub_ms, sound_event> sound_markers;
 // My research indicates that attenuation through soil-like materials is as
 // high as 100x the attenuation through air, plus vertical distances are
 // roughly five times as large as horizontal ones.
-static int sound_distance( const tripoint_bub_ms &source, const tripoint_bub_ms &sink )
+static int vertical_sound_attenuation( const int source_z, const int sink_z )
 {
-    const int lower_z = std::min( source.z(), sink.z() );
-    const int upper_z = std::max( source.z(), sink.z() );
+    const int lower_z = std::min( source_z, sink_z );
+    const int upper_z = std::max( source_z, sink_z );
     const int vertical_displacement = upper_z - lower_z;
     int vertical_attenuation = vertical_displacement;
     if( lower_z < 0 && vertical_displacement > 0 ) {
@@ -264,10 +269,91 @@ static int sound_distance( const tripoint_bub_ms &source, const tripoint_bub_ms
         vertical_attenuation += ( underground_displacement - 1 ) * 20;
     }
     // Regardless of underground effects, scale the vertical distance by 5x.
-    vertical_attenuation *= 5;
-    return rl_dist( source.xy(), sink.xy() ) + vertical_attenuation;
+    return vertical_attenuation * 5;
 }
 
+// The vertical part only depends on the two z-levels, so it is tabulated once.
+static int cached_vertical_attenuation( const int source_z, const int sink_z )
+{
+    static const std::array<std::array<int, OVERMAP_LAYERS>, OVERMAP_LAYERS> table = [] {
+        std::array<std::array<int, OVERMAP_LAYERS>, OVERMAP_LAYERS> result{};
+        for( int from = -OVERMAP_DEPTH; from <= OVERMAP_HEIGHT; ++from )
+        {
+            for( int to = -OVERMAP_DEPTH; to <= OVERMAP_HEIGHT; ++to ) {
+                result[from + OVERMAP_DEPTH][to + OVERMAP_DEPTH] = vertical_sound_attenuation( from, to );
+            }
+        }
+        return result;
+    }();
+    if( source_z < -OVERMAP_DEPTH || source_z > OVERMAP_HEIGHT || sink_z < -OVERMAP_DEPTH ||
+        sink_z > OVERMAP_HEIGHT ) {
+        return vertical_sound_attenuation( source_z, sink_z );
+    }
+    return table[source_z + OVERMAP_DEPTH][sink_z + OVERMAP_DEPTH];
+}
+
+static int sound_distance( const tripoint_bub_ms &source, const tripoint_bub_ms &sink )
+{
+    return rl_dist( source.xy(), sink.xy() ) + cached_vertical_attenuation( source.z(), sink.z() );
+}
+
+namespace
+{
+// The sound-triggered traps on one submap of one z-level.
+struct sound_listener_bucket {
+    tripoint_bub_ms min;
+    tripoint_bub_ms max;
+    std::vector<tripoint_bub_ms> traps;
+
+    // No listener in this bucket is closer to @p source than this.
+    int min_distance( const tripoint_bub_ms &source ) const {
+        const int dx = std::max( { 0, min.x() - source.x(), source.x() - max.x() } );
+        const int dy = std::max( { 0, min.y() - source.y(), source.y() - max.y() } );
+        // rl_dist never undercuts the Chebyshev distance.
+        return std::max( dx, dy ) + cached_vertical_attenuation( source.z(), min.z() );
+    }
+};
+
+// Sound-triggered traps of one turn, bucketed per submap in a fixed order. Monsters
+// are found through the submap index of the creature tracker instead.
+class sound_listeners
+{
+    public:
+        void add_trap( const tripoint_bub_ms &p ) {
+            bucket_for( p ).traps.push_back( p );
+        }
+        /** Calls @p fn for every bucket which something at @p reach from @p source might be in. */
+        template<typename Fn>
+        void for_each_in_reach( const tripoint_bub_ms &source, const int reach, Fn &&fn ) const {
+            // Buckets are sorted by x first, so only the columns in reach are walked.
+            const int min_x = divide_round_down( source.x() - reach, SEEX );
+            const int max_x = divide_round_down( source.x() + reach, SEEX );
+            const tripoint first( min_x, std::numeric_limits<int>::min(),
+                                  std::numeric_limits<int>::min() );
+            for( auto iter = buckets.lower_bound( first );
+                 iter != buckets.end() && iter->first.x <= max_x; ++iter ) {
+                if( iter->second.min_distance( source ) < reach ) {
+                    fn( iter->second );
+                }
+            }
+        }
+    private:
+        sound_listener_bucket &bucket_for( const tripoint_bub_ms &p ) {
+            const tripoint key( divide_round_down( p.x(), SEEX ), divide_round_down( p.y(), SEEY ), p.z() );
+            const auto iter = buckets.find( key );
+            if( iter != buckets.end() ) {
+                return iter->second;
+            }
+            sound_listener_bucket &bucket = buckets[key];
+            bucket.min = tripoint_bub_ms( key.x * SEEX, key.y * SEEY, key.z );
+            bucket.max = bucket.min + tripoint( SEEX - 1, SEEY - 1, 0 );
+            return bucket;
+        }
+
+        std::map<tripoint, sound_listener_bucket> buckets;
+};
+} // namespace
+
 static std::string season_str( const season_type &season )
 {
     switch( season ) {
@@ -463,6 +549,18 @@ void sounds::process_sounds()
 
     std::vector<centroid> sound_clusters = cluster_sounds( recent_sounds );
     const int weather_vol = get_weather().weather_id->sound_attn;
+
+    // Sound-triggered traps are listed once, monsters are looked up per sound.
+    sound_listeners traps;
+    if( !sound_clusters.empty() ) {
+        for( const trap *trapType : trap::get_sound_triggered_traps() ) {
+            for( const tripoint_bub_ms &tp : here.trap_locations( trapType->id ) ) {
+                traps.add_trap( tp );
+            }
+        }
+    }
+    creature_tracker &creatures = get_creature_tracker();
+
     for( const centroid &this_centroid : sound_clusters ) {
         // Since monsters don't go deaf ATM we can just use the weather modified volume
         // If they later get physical effects from loud noises we'll have to change this
@@ -479,28 +577,37 @@ void sounds::process_sounds()
             const tripoint_abs_sm target( abs_sm, source.z() );
             overmap_buffer.signal_hordes( target, sig_power );
         }
-        // Alert all monsters (that can hear) to the sound.
-        for( monster &critter : g->all_monsters() ) {
+        const int reach = vol * 2;
+        if( reach <= 0 ) {
+            continue;
+        }
+        // Alert all monsters (that can hear) to the sound. A listener is at least as far as
+        // its horizontal distance plus 5 per level, so only a box around the source is asked.
+        const tripoint_abs_ms abs_source = here.get_abs( source );
+        const tripoint box( reach - 1, reach - 1, ( reach - 1 ) / 5 );
+        creatures.for_each_in_rect( abs_source - box, abs_source + box, [&]( monster & critter ) {
             // TODO: Generalize this to Creature::hear_sound
             const int dist = sound_distance( source, critter.pos_bub() );
-            if( vol * 2 > dist ) {
+            if( reach > dist ) {
                 // Exclude monsters that certainly won't hear the sound
                 critter.hear_sound( source, vol, dist, this_centroid.provocative );
             }
-        }
-        // Trigger sound-triggered traps and ensure they are still valid
-        for( const trap *trapType : trap::get_sound_triggered_traps() ) {
-            for( const tripoint_bub_ms &tp : here.trap_locations( trapType->id ) ) {
+        } );
+        // Trigger sound-triggered traps. Buckets that are certainly out of earshot are
+        // skipped as a whole.
+        traps.for_each_in_reach( source, reach, [&]( const sound_listener_bucket & bucket ) {
+            for( const tripoint_bub_ms &tp : bucket.traps ) {
                 const int dist = sound_distance( source, tp );
+                // Ensure the trap is still valid, an earlier sound may have set it off
                 const trap &tr = here.tr_at( tp );
                 // Exclude traps that certainly won't hear the sound
-                if( vol * 2 > dist ) {
+                if( reach > dist ) {
                     if( tr.triggered_by_sound( vol, dist ) ) {
                         tr.trigger( tp );
                     }
                 }
             }
-        }
+        } );
     }
     recent_sounds.clear();
 }
@@ -18,15 +18,29 @@ static furn_id f_null;
 
 static const furn_str_id furn_f_console( "f_console" );
 
+static const ter_str_id ter_t_tree_maple_tapped( "t_tree_maple_tapped" );
+
 void maptile_soa::swap_soa_tile( const point_sm_ms &p1, const point_sm_ms &p2 )
 {
-    std::swap( ter[p1.x()][p1.y()], ter[p2.x()][p2.y()] );
-    std::swap( frn[p1.x()][p1.y()], frn[p2.x()][p2.y()] );
-    std::swap( lum[p1.x()][p1.y()], lum[p2.x()][p2.y()] );
+    ter.swap_tiles( p1, p2 );
+    frn.swap_tiles( p1, p2 );
+    lum.swap_tiles( p1, p2 );
     std::swap( itm[p1.x()][p1.y()], itm[p2.x()][p2.y()] );
     std::swap( fld[p1.x()][p1.y()], fld[p2.x()][p2.y()] );
-    std::swap( trp[p1.x()][p1.y()], trp[p2.x()][p2.y()] );
-    std::swap( rad[p1.x()][p1.y()], rad[p2.x()][p2.y()] );
+    fld_tiles.swap_tiles( p1, p2 );
+    trp.swap_tiles( p1, p2 );
+    rad.swap_tiles( p1, p2 );
+}
+
+size_t maptile_soa::compact()
+{
+    return ter.compact() + frn.compact() + lum.compact() + trp.compact() + rad.compact();
+}
+
+size_t maptile_soa::memory_usage() const
+{
+    return sizeof( maptile_soa ) + ter.dense_bytes() + frn.dense_bytes() + lum.dense_bytes() +
+           trp.dense_bytes() + rad.dense_bytes();
 }
 
 submap::submap( submap && ) noexcept( map_is_noexcept ) = default;
@@ -34,11 +48,112 @@ submap::~submap() = default;
 
 submap &submap::operator=( submap && ) noexcept = default;
 
+size_t submap::compact_layers()
+{
+    return is_uniform() ? 0 : m->compact();
+}
+
+size_t submap::tile_memory_usage() const
+{
+    return sizeof( submap ) + ( is_uniform() ? 0 : m->memory_usage() );
+}
+
+size_t submap::memory_usage() const
+{
+    size_t total = tile_memory_usage() + cosmetics.capacity() * sizeof( cosmetic_t ) +
+                   spawns.capacity() * sizeof( spawn_point ) +
+                   partial_constructions.size() * sizeof( partial_con ) +
+                   ephemeral_data.size() * sizeof( tile_data ) +
+                   computers.size() * sizeof( computer );
+    if( camp ) {
+        total += sizeof( basecamp );
+    }
+    for( const std::unique_ptr<vehicle> &veh : vehicles ) {
+        total += sizeof( vehicle ) + veh->part_count() * sizeof( vehicle_part );
+    }
+    if( is_uniform() ) {
+        return total;
+    }
+    total += static_cast<size_t>( std::max( field_count, 0 ) ) * sizeof( field_entry );
+    for( int x = 0; x < SEEX; ++x ) {
+        for( int y = 0; y < SEEY; ++y ) {
+            for( const item &it : m->itm[x][y] ) {
+                total += ( 1 + it.num_item_stacks() ) * sizeof( item );
+            }
+        }
+    }
+    return total;
+}
+
+// Adds the tiles of the layer whose value matches, testing a single valued layer only once.
+template<typename T, typename Predicate>
+static void insert_matching_tiles( tile_set &tiles, const tile_layer<T> &layer,
+                                   Predicate matches )
+{
+    const bool uniform = layer.is_uniform();
+    if( uniform && !matches( layer.get( point_sm_ms::zero ) ) ) {
+        return;
+    }
+    for( int x = 0; x < SEEX; ++x ) {
+        for( int y = 0; y < SEEY; ++y ) {
+            const point_sm_ms p( x, y );
+            if( uniform || matches( layer.get( p ) ) ) {
+                tiles.insert( p );
+            }
+        }
+    }
+}
+
+static bool actualize_terrain( const ter_id &id )
+{
+    const ter_t &ter = id.obj();
+    return !ter.emissions.empty() || ter.trap != tr_null ||
+           ter.has_flag( ter_furn_flag::TFLAG_HARVESTED ) || id == ter_t_tree_maple_tapped;
+}
+
+tile_set submap::tiles_to_actualize() const
+{
+    tile_set tiles;
+    if( is_uniform() ) {
+        if( actualize_terrain( uniform_ter ) ) {
+            for( int x = 0; x < SEEX; ++x ) {
+                for( int y = 0; y < SEEY; ++y ) {
+                    tiles.insert( point_sm_ms( x, y ) );
+                }
+            }
+        }
+        return tiles;
+    }
+    insert_matching_tiles( tiles, m->ter, actualize_terrain );
+    insert_matching_tiles( tiles, m->frn, []( const furn_id & id ) {
+        const furn_t &furn = id.obj();
+        return !furn.emissions.empty() || furn.has_flag( ter_furn_flag::TFLAG_PLANT );
+    } );
+    insert_matching_tiles( tiles, m->trp, []( const trap_id & id ) {
+        return id != tr_null;
+    } );
+    insert_matching_tiles( tiles, m->rad, []( int rad ) {
+        return rad != 0;
+    } );
+    m->fld_tiles.for_each( [&]( const point_sm_ms & p ) {
+        for( const std::pair<const field_type_id, field_entry> &fd : m->fld[p] ) {
+            if( fd.first->accelerated_decay && fd.first->half_life > 0_turns ) {
+                tiles.insert( p );
+                return;
+            }
+        }
+    } );
+    return tiles;
+}
+
 void submap::clear_fields( const point_sm_ms &p )
 {
     field &f = get_field( p );
     field_count -= f.field_count();
     f.clear();
+    if( !is_uniform() ) {
+        m->fld_tiles.erase( p );
+    }
 }
 
 static const std::string COSMETICS_GRAFFITI( "GRAFFITI" );
@@ -105,7 +220,7 @@ void submap::delete_graffiti( const point_sm_ms &p )
 }
 bool submap::has_signage( const point_sm_ms &p ) const
 {
-    if( !is_uniform() && m->frn[p.x()][p.y()].obj().has_flag( ter_furn_flag::TFLAG_SIGN ) ) {
+    if( !is_uniform() && m->frn.get( p ).obj().has_flag( ter_furn_flag::TFLAG_SIGN ) ) {
         return find_cosmetic( cosmetics, p, COSMETICS_SIGNAGE ).result;
     }
 
@@ -113,7 +228,7 @@ bool submap::has_signage( const point_sm_ms &p ) const
 }
 std::string submap::get_signage( const point_sm_ms &p ) const
 {
-    if( !is_uniform() && m->frn[p.x()][p.y()].obj().has_flag( ter_furn_flag::TFLAG_SIGN ) ) {
+    if( !is_uniform() && m->frn.get( p ).obj().has_flag( ter_furn_flag::TFLAG_SIGN ) ) {
         const cosmetic_find_result fresult = find_cosmetic( cosmetics, p, COSMETICS_SIGNAGE );
         if( fresult.result ) {
             return cosmetics[ fresult.ndx ].str;
@@ -329,12 +444,12 @@ void submap::revert_submap( submap &sr )
     }
 
     ensure_nonuniform();
+    m->frn = sr.m->frn;
+    m->ter = sr.m->ter;
+    m->trp = sr.m->trp;
     for( int x = 0; x < SEEX; x++ ) {
         for( int y = 0; y < SEEY; y++ ) {
             point_sm_ms pt( x, y );
-            m->frn[x][y] = sr.get_furn( pt );
-            m->ter[x][y] = sr.get_ter( pt );
-            m->trp[x][y] = sr.get_trap( pt );
             m->itm[x][y] = sr.get_items( pt );
             for( item &itm : m->itm[x][y] ) {
                 if( itm.is_emissive() ) {
@@ -362,8 +477,8 @@ void submap::update_lum_rem( const point_sm_ms &p, const item &i )
     ensure_nonuniform();
     if( !i.is_emissive() ) {
         return;
-    } else if( m->lum[p.x()][p.y()] && m->lum[p.x()][p.y()] < 255 ) {
-        m->lum[p.x()][p.y()]--;
+    } else if( const uint8_t lum = m->lum.get( p ); lum && lum < 255 ) {
+        m->lum.set( p, static_cast<uint8_t>( lum - 1 ) );
         return;
     }
 
@@ -377,7 +492,7 @@ void submap::update_lum_rem( const point_sm_ms &p, const item &i )
     }
 
     if( count <= 256 ) {
-        m->lum[p.x()][p.y()] = static_cast<uint8_t>( count - 1 );
+        m->lum.set( p, static_cast<uint8_t>( count - 1 ) );
     }
 }
 
@@ -387,18 +502,20 @@ void submap::merge_submaps( submap *copy_from, bool copy_from_is_overlay )
 
     for( int x = 0; x < SEEX; x++ ) {
         for( int y = 0; y < SEEY; y++ ) {
-            if( copy_from->m->ter[x][y] != t_null && ( copy_from_is_overlay ||
-                    this->m->ter[x][y] == t_null ) ) {
-                this->m->ter[x][y] = copy_from->m->ter[x][y];
+            const point_sm_ms p( x, y );
+            const ter_id ter = copy_from->m->ter.get( p );
+            if( ter != t_null && ( copy_from_is_overlay || this->m->ter.get( p ) == t_null ) ) {
+                this->m->ter.set( p, ter );
                 this->set_map_damage( { x, y }, copy_from->get_map_damage( { x, y } ) );
             }
 
-            if( copy_from->m->frn[x][y] != f_null && ( copy_from_is_overlay ||
-                    this->m->frn[x][y] == f_null ) ) {
-                this->m->frn[x][y] = copy_from->m->frn[x][y];
+            const furn_id furn = copy_from->m->frn.get( p );
+            if( furn != f_null && ( copy_from_is_overlay || this->m->frn.get( p ) == f_null ) ) {
+                this->m->frn.set( p, furn );
             }
 
-            this->m->lum[x][y] += copy_from->m->lum[x][y];
+            this->m->lum.set( p, static_cast<uint8_t>( this->m->lum.get( p ) +
+                              copy_from->m->lum.get( p ) ) );
 
             for( const item &itm : copy_from->m->itm[x][y] ) {
                 this->m->itm[x][y].emplace( itm );
@@ -420,14 +537,18 @@ void submap::merge_submaps( submap *copy_from, bool copy_from_is_overlay )
                  it != this->m->fld[x][y].end(); it++ ) {
                 this->field_count++;
             }
+            if( this->m->fld[x][y].field_count() > 0 ) {
+                this->m->fld_tiles.insert( p );
+            }
 
-            if( copy_from->m->trp[x][y] != tr_null && ( copy_from_is_overlay ||
-                    this->m->trp[x][y] == tr_null ) ) {
-                this->m->trp[x][y] = copy_from->m->trp[x][y];
+            const trap_id trap = copy_from->m->trp.get( p );
+            if( trap != tr_null && ( copy_from_is_overlay || this->m->trp.get( p ) == tr_null ) ) {
+                this->m->trp.set( p, trap );
             }
 
-            if( copy_from->m->rad[x][y] > 0 && ( copy_from_is_overlay || this->m->rad[x][y] == 0 ) ) {
-                this->m->rad[x][y] = copy_from->m->rad[x][y];
+            const int rad = copy_from->m->rad.get( p );
+            if( rad > 0 && ( copy_from_is_overlay || this->m->rad.get( p ) == 0 ) ) {
+                this->m->rad.set( p, rad );
             }
         }
     }
@@ -478,7 +599,7 @@ void submap::merge_submaps( submap *copy_from, bool copy_from_is_overlay )
     }
 
     for( const std::pair<const point_sm_ms, computer>  &comp : copy_from->computers ) {
-        if( this->m->frn[comp.first.x()][comp.first.y()] == furn_f_console &&
+        if( this->m->frn.get( comp.first ) == furn_f_console &&
             !this->get_computer( comp.first ) ) {
             this->set_computer( comp.first, comp.second );
         }
@@ -29,6 +29,7 @@
 #include "mapgen_primitives.h"
 #include "mdarray.h"
 #include "point.h"
+#include "tile_layer.h"
 #include "trap.h"
 #include "type_id.h"
 #include "units.h"
@@ -60,15 +61,20 @@ struct spawn_point {
 // Suppression due to bug in clang-tidy 12
 // NOLINTNEXTLINE(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
 struct maptile_soa {
-    cata::mdarray<ter_id, point_sm_ms>             ter; // Terrain on each square
-    cata::mdarray<furn_id, point_sm_ms>            frn; // Furniture on each square
-    cata::mdarray<std::uint8_t, point_sm_ms>       lum; // Num items emitting light on each square
+    tile_layer<ter_id>                             ter; // Terrain on each square
+    tile_layer<furn_id>                            frn; // Furniture on each square
+    tile_layer<std::uint8_t>                       lum; // Num items emitting light on each square
     cata::mdarray<cata::colony<item>, point_sm_ms> itm; // Items on each square
     cata::mdarray<field, point_sm_ms>              fld; // Field on each square
-    cata::mdarray<trap_id, point_sm_ms>            trp; // Trap on each square
-    cata::mdarray<int, point_sm_ms>                rad; // Irradiation of each square
+    tile_set                                       fld_tiles; // Squares that may have a field
+    tile_layer<trap_id>                            trp; // Trap on each square
+    tile_layer<int>                                rad; // Irradiation of each square
 
     void swap_soa_tile( const point_sm_ms &p1, const point_sm_ms &p2 );
+    /** @ref tile_layer::compact for every layer. @return The number of bytes freed. */
+    size_t compact();
+    /** Heap memory used by the tile layers, including this struct. */
+    size_t memory_usage() const;
 };
 
 class submap
@@ -83,11 +89,11 @@ class submap
         void ensure_nonuniform() {
             if( is_uniform() ) {
                 m = std::make_unique<maptile_soa>();
-                std::uninitialized_fill_n( &m->ter[0][0], elements, uniform_ter );
-                std::uninitialized_fill_n( &m->frn[0][0], elements, furn_str_id::NULL_ID() );
-                std::uninitialized_fill_n( &m->lum[0][0], elements, 0 );
-                std::uninitialized_fill_n( &m->trp[0][0], elements, tr_null );
-                std::uninitialized_fill_n( &m->rad[0][0], elements, 0 );
+                m->ter.fill( uniform_ter );
+                m->frn.fill( furn_str_id::NULL_ID() );
+                m->lum.fill( 0 );
+                m->trp.fill( tr_null );
+                m->rad.fill( 0 );
             }
         }
 
@@ -99,34 +105,34 @@ class submap
             if( is_uniform() ) {
                 return tr_null;
             }
-            return m->trp[p.x()][p.y()];
+            return m->trp.get( p );
         }
 
         void set_trap( const point_sm_ms &p, trap_id trap ) {
             ensure_nonuniform();
-            m->trp[p.x()][p.y()] = trap;
+            m->trp.set( p, trap );
         }
 
         void set_all_traps( const trap_id &trap ) {
             ensure_nonuniform();
-            std::uninitialized_fill_n( &m->trp[0][0], elements, trap );
+            m->trp.fill( trap );
         }
 
         furn_id get_furn( const point_sm_ms &p ) const {
             if( is_uniform() ) {
                 return furn_str_id::NULL_ID();
             }
-            return m->frn[p.x()][p.y()];
+            return m->frn.get( p );
         }
 
         void set_furn( const point_sm_ms &p, furn_id furn ) {
             ensure_nonuniform();
-            m->frn[p.x()][p.y()] = furn;
+            m->frn.set( p, furn );
         }
 
         void set_all_furn( const furn_id &furn ) {
             ensure_nonuniform();
-            std::uninitialized_fill_n( &m->frn[0][0], elements, furn );
+            m->frn.fill( furn );
         }
         int get_map_damage( const point_sm_ms &p ) const {
             auto it = ephemeral_data.find( p );
@@ -144,12 +150,12 @@ class submap
             if( is_uniform() ) {
                 return uniform_ter;
             }
-            return m->ter[p.x()][p.y()];
+            return m->ter.get( p );
         }
 
         void set_ter( const point_sm_ms &p, ter_id terr ) {
             ensure_nonuniform();
-            m->ter[p.x()][p.y()] = terr;
+            m->ter.set( p, terr );
         }
 
         void set_all_ter( const ter_id &terr, bool uniform_ok = false ) {
@@ -159,7 +165,7 @@ class submap
             if( is_uniform() ) {
                 uniform_ter = terr;
             } else {
-                std::uninitialized_fill_n( &m->ter[0][0], elements, terr );
+                m->ter.fill( terr );
             }
         }
 
@@ -167,30 +173,31 @@ class submap
             if( is_uniform() ) {
                 return 0;
             }
-            return m->rad[p.x()][p.y()];
+            return m->rad.get( p );
         }
 
         void set_radiation( const point_sm_ms &p, const int radiation ) {
             ensure_nonuniform();
-            m->rad[p.x()][p.y()] = radiation;
+            m->rad.set( p, radiation );
         }
 
         uint8_t get_lum( const point_sm_ms &p ) const {
             if( is_uniform() ) {
                 return 0;
             }
-            return m->lum[p.x()][p.y()];
+            return m->lum.get( p );
         }
 
         void set_lum( const point_sm_ms &p, uint8_t luminance ) {
             ensure_nonuniform();
-            m->lum[p.x()][p.y()] = luminance;
+            m->lum.set( p, luminance );
         }
 
         void update_lum_add( const point_sm_ms &p, const item &i ) {
             ensure_nonuniform();
-            if( i.is_emissive() && m->lum[p.x()][p.y()] < 255 ) {
-                m->lum[p.x()][p.y()]++;
+            const uint8_t lum = m->lum.get( p );
+            if( i.is_emissive() && lum < 255 ) {
+                m->lum.set( p, static_cast<uint8_t>( lum + 1 ) );
             }
         }
 
@@ -232,6 +239,25 @@ class submap
 
         void clear_fields( const point_sm_ms &p );
 
+        /**
+         * The tiles that may have fields, a superset of the tiles that do. Tiles are added
+         * by @ref map::add_field and when loading, and dropped again by field processing
+         * once their field is empty. Uniform submaps have no fields, changing their tiles
+         * makes them non-uniform.
+         */
+        tile_set &field_tiles() {
+            ensure_nonuniform();
+            return m->fld_tiles;
+        }
+
+        const tile_set &field_tiles() const {
+            if( is_uniform() ) {
+                tile_set static notiles;
+                return notiles;
+            }
+            return m->fld_tiles;
+        }
+
         struct cosmetic_t {
             point_sm_ms pos;
             std::string type;
@@ -287,6 +313,11 @@ class submap
 
         void store( JsonOut &jsout ) const;
         void load( const JsonValue &jv, const std::string &member_name, int version );
+        /**
+         * Writes the members of @ref store that are not per-tile layers: items, traps,
+         * fields, vehicles and so on. The binary quad format keeps only those as json.
+         */
+        void store_objects( JsonOut &jsout ) const;
 
         // If is_uniform is true, this submap is a solid block of terrain
         // Uniform submaps aren't saved/loaded, because regenerating them is faster
@@ -294,6 +325,20 @@ class submap
             return !static_cast<bool>( m );
         }
 
+        /**
+         * Drops the per-tile arrays of terrain, furniture, trap, light and radiation
+         * layers whose tiles all agree. @return The number of bytes freed.
+         */
+        size_t compact_layers();
+        /** Memory used by this submap and its tiles, not counting items, fields and vehicles. */
+        size_t tile_memory_usage() const;
+        /**
+         * Memory used by this submap and everything it owns: tiles, items, fields, vehicles,
+         * computers and so on. An estimate from their counts, contents of items are counted
+         * one level deep and vehicles by their parts.
+         */
+        size_t memory_usage() const;
+
         // Merge the contents of the two submaps onto the target submap. If there is a
         // conflict the overlay wins out. Note that it's technically possible for both
         // submaps to actually be overlays, but the one that's not called out is treated
@@ -311,6 +356,13 @@ class submap
         time_point last_touched = calendar::turn_zero;
         bool reverted = false; // NOLINT(cata-serialize)
         std::vector<spawn_point> spawns;
+        /**
+         * The tiles @ref map::actualize has to catch up on: those with plants, funnels or
+         * other traps, harvested or tapped terrain, radiation, decaying cosmetic fields
+         * and emitting terrain or furniture. Single valued layers are tested once.
+         */
+        tile_set tiles_to_actualize() const;
+
         /**
          * Vehicles on this submap (their (0,0) point is on this submap).
          * This vehicle objects are deleted by this submap when it gets
@@ -325,13 +377,14 @@ class submap
         };
 
     private:
+        friend class submap_binary_writer;
+        friend class submap_binary_reader;
+
         std::map<point_sm_ms, tile_data> ephemeral_data;
         std::map<point_sm_ms, computer> computers;
         std::unique_ptr<maptile_soa> m;
         ter_id uniform_ter = t_null;
         int temperature_mod = 0; // delta in F
-
-        static constexpr size_t elements = SEEX * SEEY;
 };
 
 /**
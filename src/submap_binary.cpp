@@ -0,0 +1,345 @@
+#include "submap_binary.h"
+
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "calendar.h"
+#include "flexbuffer_cache.h"
+#include "flexbuffer_json.h"
+#include "json.h"
+#include "map_scale_constants.h"
+#include "mapdata.h"
+#include "string_formatter.h"
+#include "submap.h"
+
+// NOLINTNEXTLINE(cata-static-declarations)
+extern const int savegame_version;
+
+namespace
+{
+constexpr std::string_view binary_magic = "CDSB";
+// Bump when the layout changes. Readers refuse files newer than they know.
+constexpr uint32_t binary_format_version = 1;
+constexpr size_t block_alignment = 8;
+constexpr size_t index_entry_size = 3 * sizeof( int32_t ) + 2 * sizeof( uint32_t );
+
+template<typename T>
+void put( std::string &out, T value )
+{
+    static_assert( std::is_trivially_copyable_v<T> );
+    char bytes[sizeof( T )];
+    std::memcpy( bytes, &value, sizeof( T ) );
+    out.append( bytes, sizeof( T ) );
+}
+
+void pad( std::string &out )
+{
+    out.append( ( block_alignment - out.size() % block_alignment ) % block_alignment, '\0' );
+}
+
+void put_dictionary( std::string &out, const std::vector<std::string> &dictionary )
+{
+    put<uint32_t>( out, dictionary.size() );
+    for( const std::string &id : dictionary ) {
+        put<uint16_t>( out, id.size() );
+        out += id;
+    }
+}
+
+// Runs of equal values over the tiles of a submap, row by row.
+template<typename T>
+class run_encoder
+{
+    public:
+        void add( T value ) {
+            if( !runs.empty() && runs.back().first == value ) {
+                runs.back().second += 1;
+            } else {
+                runs.emplace_back( value, 1 );
+            }
+        }
+
+        void write( std::string &out ) const {
+            put<uint16_t>( out, runs.size() );
+            for( const std::pair<T, uint16_t> &run : runs ) {
+                put<T>( out, run.first );
+                put<uint16_t>( out, run.second );
+            }
+        }
+
+    private:
+        std::vector<std::pair<T, uint16_t>> runs;
+};
+
+// Bounds checked reading of the file. Offsets are relative to the start of the file, which
+// is what blocks are aligned to.
+class cursor
+{
+    public:
+        cursor( std::string_view data, size_t pos, size_t end ) : data( data ), pos( pos ), end( end ) {
+            if( end > data.size() || pos > end ) {
+                throw std::runtime_error( "binary submap data is truncated" );
+            }
+        }
+
+        template<typename T>
+        T get() {
+            T value;
+            std::memcpy( &value, bytes( sizeof( T ) ).data(), sizeof( T ) );
+            return value;
+        }
+
+        std::string_view bytes( size_t count ) {
+            if( count > end - pos ) {
+                throw std::runtime_error( "binary submap data is truncated" );
+            }
+            std::string_view result = data.substr( pos, count );
+            pos += count;
+            return result;
+        }
+
+        void align() {
+            bytes( ( block_alignment - pos % block_alignment ) % block_alignment );
+        }
+
+        // Calls visit( tile, value ) for every tile covered by a column of runs.
+        template<typename T, typename Visit>
+        void runs( Visit visit ) {
+            const uint16_t count = get<uint16_t>();
+            size_t tile = 0;
+            for( uint16_t i = 0; i < count; ++i ) {
+                const T value = get<T>();
+                const uint16_t length = get<uint16_t>();
+                if( length > SEEX * SEEY - tile ) {
+                    throw std::runtime_error( "binary submap runs cover too many tiles" );
+                }
+                for( uint16_t j = 0; j < length; ++j, ++tile ) {
+                    visit( point_sm_ms( tile % SEEX, tile / SEEX ), value );
+                }
+            }
+            if( tile != SEEX * SEEY ) {
+                throw std::runtime_error( "binary submap runs cover too few tiles" );
+            }
+        }
+
+    private:
+        std::string_view data;
+        size_t pos;
+        size_t end;
+};
+
+// A slice of the file, kept alive by whatever owns the file contents.
+struct flexbuffer_view_storage : flexbuffer_storage {
+    std::shared_ptr<const void> owner;
+    std::string_view view;
+
+    flexbuffer_view_storage( std::shared_ptr<const void> owner, std::string_view view )
+        : owner( std::move( owner ) ), view( view ) {}
+
+    const uint8_t *data() const override {
+        return reinterpret_cast<const uint8_t *>( view.data() );
+    }
+
+    size_t size() const override {
+        return view.size();
+    }
+};
+} // namespace
+
+uint16_t submap_binary_writer::intern( std::vector<std::string> &dictionary,
+                                       std::unordered_map<std::string, uint16_t> &indices, const std::string &id )
+{
+    const auto [it, inserted] = indices.emplace( id, static_cast<uint16_t>( dictionary.size() ) );
+    if( inserted ) {
+        if( dictionary.size() > std::numeric_limits<uint16_t>::max() ) {
+            throw std::runtime_error( "too many distinct ids for a binary quad file" );
+        }
+        dictionary.push_back( id );
+    }
+    return it->second;
+}
+
+void submap_binary_writer::add( const tripoint_abs_sm &pos, const submap &sm )
+{
+    pending_submap &out = submaps.emplace_back();
+    out.pos = pos;
+    put<int32_t>( out.columns, savegame_version );
+    put<int32_t>( out.columns, to_turn<int>( sm.last_touched ) );
+    put<int32_t>( out.columns, sm.temperature_mod );
+
+    run_encoder<uint16_t> ter_runs;
+    run_encoder<uint16_t> furn_runs;
+    run_encoder<int32_t> rad_runs;
+    for( int j = 0; j < SEEY; j++ ) {
+        for( int i = 0; i < SEEX; i++ ) {
+            const point_sm_ms p( i, j );
+            ter_runs.add( intern( terrain, terrain_indices, sm.get_ter( p ).id().str() ) );
+            furn_runs.add( intern( furniture, furniture_indices, sm.get_furn( p ).id().str() ) );
+            rad_runs.add( sm.get_radiation( p ) );
+        }
+    }
+    ter_runs.write( out.columns );
+    furn_runs.write( out.columns );
+    rad_runs.write( out.columns );
+
+    if( !sm.is_uniform() ) {
+        std::ostringstream buffer;
+        JsonOut jsout( buffer );
+        jsout.start_object();
+        sm.store_objects( jsout );
+        jsout.end_object();
+        out.objects = std::move( buffer ).str();
+    }
+}
+
+std::string submap_binary_writer::finish() const
+{
+    std::string file( binary_magic );
+    put<uint32_t>( file, binary_format_version );
+    put<uint32_t>( file, submaps.size() );
+    put_dictionary( file, terrain );
+    put_dictionary( file, furniture );
+
+    const size_t index_start = file.size();
+    file.append( submaps.size() * index_entry_size, '\0' );
+    std::string entry;
+    for( size_t i = 0; i < submaps.size(); ++i ) {
+        const pending_submap &sm = submaps[i];
+        pad( file );
+        const size_t offset = file.size();
+        file += sm.columns;
+        const std::vector<uint8_t> objects = sm.objects.empty() ? std::vector<uint8_t>() :
+                                             flexbuffer_cache::parse_buffer_to_binary( sm.objects );
+        put<uint32_t>( file, objects.size() );
+        pad( file );
+        file.append( reinterpret_cast<const char *>( objects.data() ), objects.size() );
+
+        entry.clear();
+        put<int32_t>( entry, sm.pos.x() );
+        put<int32_t>( entry, sm.pos.y() );
+        put<int32_t>( entry, sm.pos.z() );
+        put<uint32_t>( entry, offset );
+        put<uint32_t>( entry, file.size() - offset );
+        file.replace( index_start + i * index_entry_size, index_entry_size, entry );
+    }
+    if( file.size() > std::numeric_limits<uint32_t>::max() ) {
+        throw std::runtime_error( "binary quad file is too large" );
+    }
+    return file;
+}
+
+bool submap_binary_reader::is_binary( std::string_view data )
+{
+    return data.substr( 0, binary_magic.size() ) == binary_magic;
+}
+
+submap_binary_reader::submap_binary_reader( std::shared_ptr<const void> owner,
+        std::string_view data ) : owner( std::move( owner ) ), data( data )
+{
+    cursor in( data, 0, data.size() );
+    if( in.bytes( binary_magic.size() ) != binary_magic ) {
+        throw std::runtime_error( "not a binary quad file" );
+    }
+    const uint32_t version = in.get<uint32_t>();
+    if( version > binary_format_version ) {
+        throw std::runtime_error( string_format( "binary quad format %d is newer than this game supports",
+                                  version ) );
+    }
+    const uint32_t count = in.get<uint32_t>();
+
+    const auto read_dictionary = [&in]( auto migrate, std::vector<std::pair<ter_id, furn_id>> &out ) {
+        const uint32_t entries = in.get<uint32_t>();
+        for( uint32_t i = 0; i < entries; ++i ) {
+            out.push_back( migrate( std::string( in.bytes( in.get<uint16_t>() ) ) ) );
+        }
+    };
+    read_dictionary( []( const std::string & id ) {
+        return ter_furn_migrations::migrate_terrain( ter_str_id( id ) );
+    }, terrain );
+    read_dictionary( []( const std::string & id ) {
+        return ter_furn_migrations::migrate_furniture( furn_str_id( id ) );
+    }, furniture );
+
+    index.reserve( count );
+    for( uint32_t i = 0; i < count; ++i ) {
+        index_entry &entry = index.emplace_back();
+        const int x = in.get<int32_t>();
+        const int y = in.get<int32_t>();
+        const int z = in.get<int32_t>();
+        entry.pos = tripoint_abs_sm( x, y, z );
+        entry.offset = in.get<uint32_t>();
+        entry.size = in.get<uint32_t>();
+        if( entry.offset > data.size() || entry.size > data.size() - entry.offset ) {
+            throw std::runtime_error( "binary quad index points outside of the file" );
+        }
+    }
+}
+
+std::optional<size_t> submap_binary_reader::find( const tripoint_abs_sm &pos ) const
+{
+    for( size_t i = 0; i < index.size(); ++i ) {
+        if( index[i].pos == pos ) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+std::unique_ptr<submap> submap_binary_reader::load( size_t i ) const
+{
+    const index_entry &entry = index[i];
+    cursor in( data, entry.offset, entry.offset + entry.size );
+    std::unique_ptr<submap> sm = std::make_unique<submap>();
+    const int version = in.get<int32_t>();
+    sm->last_touched = time_point( in.get<int32_t>() );
+    sm->temperature_mod = in.get<int32_t>();
+    sm->ensure_nonuniform();
+    maptile_soa &tiles = *sm->m;
+
+    const auto dictionary_entry = []( const std::vector<std::pair<ter_id, furn_id>> &dictionary,
+    uint16_t index ) -> const std::pair<ter_id, furn_id> & {
+        if( index >= dictionary.size() )
+        {
+            throw std::runtime_error( "binary submap refers to a missing dictionary entry" );
+        }
+        return dictionary[index];
+    };
+    in.runs<uint16_t>( [&]( const point_sm_ms & p, uint16_t index ) {
+        const auto &[ter, furn] = dictionary_entry( terrain, index );
+        tiles.ter.set( p, ter );
+        if( furn ) {
+            tiles.frn.set( p, furn );
+        }
+    } );
+    in.runs<uint16_t>( [&]( const point_sm_ms & p, uint16_t index ) {
+        const auto &[ter, furn] = dictionary_entry( furniture, index );
+        if( ter ) {
+            tiles.ter.set( p, ter );
+        }
+        // Like the json format, no furniture keeps what a terrain migration put there.
+        if( furn ) {
+            tiles.frn.set( p, furn );
+        }
+    } );
+    in.runs<int32_t>( [&]( const point_sm_ms & p, int32_t radiation ) {
+        tiles.rad.set( p, radiation );
+    } );
+
+    const uint32_t objects_size = in.get<uint32_t>();
+    in.align();
+    const std::string_view objects = in.bytes( objects_size );
+    if( !objects.empty() ) {
+        std::shared_ptr<flexbuffer_storage> storage =
+            std::make_shared<flexbuffer_view_storage>( owner, objects );
+        const flexbuffers::Reference root = flexbuffer_root_from_storage( storage );
+        JsonObject jo = JsonValue( flexbuffer_cache::wrap_binary( std::move( storage ) ), root, nullptr,
+                                   0 );
+        for( JsonMember member : jo ) {
+            sm->load( member, member.name(), version );
+        }
+    }
+    return sm;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#ifndef CATA_SRC_SUBMAP_BINARY_H
+#define CATA_SRC_SUBMAP_BINARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "coordinates.h"
+#include "type_id.h"
+
+class submap;
+
+/**
+ * Binary encoding of the submaps of a quad file, the default save format of map data.
+ * Json quad files (see @ref submap::store) are still read, and can be written instead
+ * with the SAVE_SUBMAPS_AS_JSON debug option for inspection and editing.
+ *
+ * Terrain, furniture and radiation are stored as run length encoded columns. Terrain
+ * and furniture runs refer to per-file dictionaries of string ids, so the ids are only
+ * looked up once per file. Everything else (items, traps, fields, vehicles...) is kept
+ * as a flexbuffer of the members @ref submap::store_objects writes, and it is read
+ * through the regular json loading code without parsing any text.
+ *
+ * All numbers are little endian. Blocks start at 8 byte aligned offsets, so the file
+ * can be read in place from a memory mapping.
+ *
+ * +-----------------------+--------------------------------------------------+
+ * |        header         | "CDSB", format version, submap count             |
+ * +-----------------------+--------------------------------------------------+
+ * |  terrain dictionary   | count, then length prefixed ter_str_ids          |
+ * +-----------------------+--------------------------------------------------+
+ * | furniture dictionary  | count, then length prefixed furn_str_ids         |
+ * +-----------------------+--------------------------------------------------+
+ * |         index         | coordinates, offset and size of each submap      |
+ * +-----------------------+--------------------------------------------------+
+ * |     submap block      | savegame version, turn last touched, temperature |
+ * |                       | terrain runs: dictionary index, count            |
+ * |                       | furniture runs: dictionary index, count          |
+ * |                       | radiation runs: intensity, count                 |
+ * |                       | size and data of the objects flexbuffer          |
+ * +-----------------------+--------------------------------------------------+
+ * |               <repeated submap blocks>                                   |
+ * +-----------------------+--------------------------------------------------+
+ *
+ * Runs cover all tiles of a submap, row by row. Uniform submaps have an empty objects
+ * flexbuffer.
+ */
+class submap_binary_writer
+{
+    public:
+        /**
+         * Encodes the tile layers of @p sm right away and serializes its other members
+         * to json. @p sm may change or go away after this returns.
+         */
+        void add( const tripoint_abs_sm &pos, const submap &sm );
+
+        /**
+         * Builds the file. This converts the json of the objects into flexbuffers, which
+         * is the expensive part, and touches no game data, so it may run on another thread.
+         */
+        std::string finish() const;
+
+    private:
+        struct pending_submap {
+            tripoint_abs_sm pos;
+            // Everything up to the objects flexbuffer.
+            std::string columns;
+            std::string objects;
+        };
+
+        static uint16_t intern( std::vector<std::string> &dictionary,
+                                std::unordered_map<std::string, uint16_t> &indices, const std::string &id );
+
+        std::vector<pending_submap> submaps;
+        std::vector<std::string> terrain;
+        std::unordered_map<std::string, uint16_t> terrain_indices;
+        std::vector<std::string> furniture;
+        std::unordered_map<std::string, uint16_t> furniture_indices;
+};
+
+/**
+ * Reads a binary quad file in place. Only the header, the dictionaries and the index
+ * are looked at up front, submaps are decoded on request.
+ * Throws std::runtime_error if the data is truncated or malformed.
+ */
+class submap_binary_reader
+{
+    public:
+        /** Whether @p data starts like a binary quad file rather than json text. */
+        static bool is_binary( std::string_view data );
+
+        /**
+         * @param owner keeps the memory of @p data alive, it is shared with the json
+         * values made from it.
+         */
+        submap_binary_reader( std::shared_ptr<const void> owner, std::string_view data );
+
+        size_t size() const {
+            return index.size();
+        }
+
+        const tripoint_abs_sm &position( size_t i ) const {
+            return index[i].pos;
+        }
+
+        std::optional<size_t> find( const tripoint_abs_sm &pos ) const;
+
+        /** Decodes the i-th submap, including id migrations. */
+        std::unique_ptr<submap> load( size_t i ) const;
+
+    private:
+        struct index_entry {
+            tripoint_abs_sm pos;
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        std::shared_ptr<const void> owner;
+        std::string_view data;
+        // Dictionary entries after migrations: terrain and the furniture it adds.
+        std::vector<std::pair<ter_id, furn_id>> terrain;
+        // Dictionary entries after migrations: terrain it replaces and furniture.
+        std::vector<std::pair<ter_id, furn_id>> furniture;
+        std::vector<index_entry> index;
+};
+
+#endif // CATA_SRC_SUBMAP_BINARY_H
@@ -0,0 +1,177 @@
+#pragma once
+#ifndef CATA_SRC_TILE_LAYER_H
+#define CATA_SRC_TILE_LAYER_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "coordinates.h"
+#include "map_scale_constants.h"
+#include "mdarray.h"
+
+/**
+ * One value per tile of a submap, kept as a single value while all tiles share it.
+ *
+ * Most submaps have no traps, no radiation, no light emitting items and, away from
+ * towns, hardly any furniture, so those layers are a single value almost everywhere.
+ * Reads never allocate. The dense array is only allocated when a tile is set to a
+ * value different from the shared one, and @ref compact drops it again once all tiles
+ * agree.
+ */
+template<typename T>
+class tile_layer
+{
+    public:
+        using array_type = cata::mdarray<T, point_sm_ms>;
+
+        explicit tile_layer( const T &value = T() ) : uniform_value( value ) {}
+
+        tile_layer( const tile_layer &other ) : uniform_value( other.uniform_value ),
+            dense( other.dense ? std::make_unique<array_type>( *other.dense ) : nullptr ) {}
+
+        tile_layer &operator=( const tile_layer &other ) {
+            if( this != &other ) {
+                uniform_value = other.uniform_value;
+                dense = other.dense ? std::make_unique<array_type>( *other.dense ) : nullptr;
+            }
+            return *this;
+        }
+
+        tile_layer( tile_layer && ) noexcept = default;
+        tile_layer &operator=( tile_layer && ) noexcept = default;
+
+        T get( const point_sm_ms &p ) const {
+            return dense ? ( *dense )[p] : uniform_value;
+        }
+
+        void set( const point_sm_ms &p, const T &value ) {
+            if( !dense ) {
+                if( value == uniform_value ) {
+                    return;
+                }
+                dense = std::make_unique<array_type>( uniform_value );
+            }
+            ( *dense )[p] = value;
+        }
+
+        /** Sets all tiles, dropping the dense array. */
+        void fill( const T &value ) {
+            dense.reset();
+            uniform_value = value;
+        }
+
+        bool is_uniform() const {
+            return !dense;
+        }
+
+        void swap_tiles( const point_sm_ms &p1, const point_sm_ms &p2 ) {
+            if( dense ) {
+                std::swap( ( *dense )[p1], ( *dense )[p2] );
+            }
+        }
+
+        /**
+         * Drops the dense array if all tiles have the same value.
+         * @return The number of bytes freed.
+         */
+        size_t compact() {
+            if( !dense ) {
+                return 0;
+            }
+            const T first = ( *dense )[0][0];
+            for( size_t x = 0; x < array_type::size_x; ++x ) {
+                const typename array_type::column_type &column = ( *dense )[x];
+                if( std::any_of( column.begin(), column.end(), [&first]( const T & value ) {
+                return !( value == first );
+                } ) ) {
+                    return 0;
+                }
+            }
+            fill( first );
+            return sizeof( array_type );
+        }
+
+        /** Heap memory used by this layer. */
+        size_t dense_bytes() const {
+            return dense ? sizeof( array_type ) : 0;
+        }
+
+    private:
+        T uniform_value;
+        std::unique_ptr<array_type> dense;
+};
+
+/**
+ * A set of tiles of a submap, one bit per tile.
+ *
+ * Used to visit only the few tiles that have something to process instead of all of
+ * them. @ref for_each visits the tiles in the same order as looping over x, then y.
+ */
+class tile_set
+{
+    public:
+        void insert( const point_sm_ms &p ) {
+            words[index( p ) / word_bits] |= bit( p );
+        }
+
+        void erase( const point_sm_ms &p ) {
+            words[index( p ) / word_bits] &= ~bit( p );
+        }
+
+        bool contains( const point_sm_ms &p ) const {
+            return ( words[index( p ) / word_bits] & bit( p ) ) != 0;
+        }
+
+        bool empty() const {
+            return std::all_of( words.begin(), words.end(), []( uint64_t word ) {
+                return word == 0;
+            } );
+        }
+
+        void clear() {
+            words.fill( 0 );
+        }
+
+        void swap_tiles( const point_sm_ms &p1, const point_sm_ms &p2 ) {
+            const bool had_p1 = contains( p1 );
+            const bool had_p2 = contains( p2 );
+            had_p2 ? insert( p1 ) : erase( p1 );
+            had_p1 ? insert( p2 ) : erase( p2 );
+        }
+
+        /**
+         * Calls visit( tile ) for every tile in the set. The set may be changed while
+         * visiting: tiles inserted after the current one are visited, erased ones are not.
+         */
+        template<typename Visit>
+        void for_each( Visit visit ) const {
+            for( size_t w = 0; w < words.size(); ++w ) {
+                for( size_t b = 0; b < word_bits && ( words[w] >> b ) != 0; ++b ) {
+                    if( ( words[w] >> b ) & 1 ) {
+                        const size_t i = w * word_bits + b;
+                        visit( point_sm_ms( static_cast<int>( i / SEEY ),
+                                            static_cast<int>( i % SEEY ) ) );
+                    }
+                }
+            }
+        }
+
+    private:
+        static constexpr size_t word_bits = 64;
+
+        static size_t index( const point_sm_ms &p ) {
+            return static_cast<size_t>( p.x() ) * SEEY + p.y();
+        }
+
+        static uint64_t bit( const point_sm_ms &p ) {
+            return uint64_t( 1 ) << ( index( p ) % word_bits );
+        }
+
+        std::array<uint64_t, ( SEEX * SEEY + word_bits - 1 ) / word_bits> words = {};
+};
+
+#endif // CATA_SRC_TILE_LAYER_H
@@ -245,7 +245,10 @@ vehicle::vehicle( const vproto_id &proto_id )
     }
 }
 
-vehicle::~vehicle() = default;
+vehicle::~vehicle()
+{
+    invalidate_power_grids();
+}
 
 turret_cpu::~turret_cpu() = default;
 
@@ -2220,6 +2223,9 @@ bool vehicle::do_remove_part_actual( map *here )
             }
             it = parts.erase( it );
             changed = true;
+            // Indices after the erased part have moved.
+            parts_by_flag.clear();
+            parts_by_flag_size = 0;
         }
     }
     return changed;
@@ -2903,9 +2909,14 @@ int vehicle::part_with_feature( const point_rel_ms &pt, vpart_bitflags f, bool u
 int vehicle::part_with_feature( const point_rel_ms &pt, const std::string &flag, bool unbroken,
                                 bool include_fake ) const
 {
-    for( const int p : parts_at_relative( pt, /* use_cache = */ false, include_fake ) ) {
-        const vehicle_part &vp_here = this->part( p );
-        if( vp_here.info().has_flag( flag ) && !( unbroken && vp_here.is_broken() ) ) {
+    // Same parts as parts_at_relative( pt, false, include_fake ), in the same order.
+    for( const int p : parts_with_flag( flag ) ) {
+        const vehicle_part &vp_here = parts[p];
+        if( vp_here.mount != pt || vp_here.removed ||
+            !( include_fake ? vp_here.is_real_or_active_fake() : !vp_here.is_fake ) ) {
+            continue;
+        }
+        if( !( unbroken && vp_here.is_broken() ) ) {
             return p;
         }
     }
@@ -2943,11 +2954,27 @@ int vehicle::avail_linkable_part( const point_rel_ms &pt, bool to_ports ) const
     return -1;
 }
 
+const std::vector<int> &vehicle::parts_with_flag( const std::string &flag ) const
+{
+    if( parts_by_flag_size > parts.size() ) {
+        parts_by_flag.clear();
+        parts_by_flag_size = 0;
+    }
+    for( ; parts_by_flag_size < parts.size(); ++parts_by_flag_size ) {
+        for( const std::string &part_flag : parts[parts_by_flag_size].info().get_flags() ) {
+            parts_by_flag[part_flag].push_back( static_cast<int>( parts_by_flag_size ) );
+        }
+    }
+    static const std::vector<int> no_parts;
+    const auto iter = parts_by_flag.find( flag );
+    return iter == parts_by_flag.end() ? no_parts : iter->second;
+}
+
 bool vehicle::has_part( const std::string &flag, bool enabled ) const
 {
-    for( const vpart_reference &vpr : get_all_parts() ) {
-        if( !vpr.part().removed && ( !enabled || vpr.part().enabled ) && !vpr.part().is_broken() &&
-            vpr.part().info().has_flag( flag ) ) {
+    for( const int p : parts_with_flag( flag ) ) {
+        const vehicle_part &vp = parts[p];
+        if( !vp.is_fake && !vp.removed && ( !enabled || vp.enabled ) && !vp.is_broken() ) {
             return true;
         }
     }
@@ -2957,20 +2984,9 @@ bool vehicle::has_part( const std::string &flag, bool enabled ) const
 tiny_bitset vehicle::has_parts( const std::vector<std::string> &flags, bool enabled ) const
 {
     tiny_bitset ret = tiny_bitset( flags.size() );
-    for( const vpart_reference &vpr : get_all_parts() ) {
-        vehicle_part &part = vpr.part();
-        if( !part.removed && ( !enabled || part.enabled ) && !part.is_broken() ) {
-            // Check whether the part has any of the flags we are looking for
-            for( size_t i = 0; i < flags.size(); i++ ) {
-                const std::string &flag = flags[i];
-                if( part.info().has_flag( flag ) ) {
-                    ret.set( i );
-                }
-            }
-            // Exit early if we have found parts matching each flag.
-            if( ret.all() ) {
-                return ret;
-            }
+    for( size_t i = 0; i < flags.size(); i++ ) {
+        if( has_part( flags[i], enabled ) ) {
+            ret.set( i );
         }
     }
     return ret;
@@ -2986,12 +3002,12 @@ bool vehicle::has_part( const tripoint_abs_ms &pos, const std::string &flag, boo
 {
     const tripoint_rel_ms relative_pos = pos - pos_abs();
 
-    for( const vpart_reference &vpr : get_all_parts() ) {
-        if( vpr.part().precalc[0] != relative_pos ) {
+    for( const int p : parts_with_flag( flag ) ) {
+        const vehicle_part &vp = parts[p];
+        if( vp.precalc[0] != relative_pos || vp.is_fake ) {
             continue;
         }
-        if( !vpr.part().removed && ( !enabled || vpr.part().enabled ) && !vpr.part().is_broken() &&
-            vpr.part().info().has_flag( flag ) ) {
+        if( !vp.removed && ( !enabled || vp.enabled ) && !vp.is_broken() ) {
             return true;
         }
     }
@@ -3014,15 +3030,20 @@ std::vector<vehicle_part *> vehicle::get_parts_at( const tripoint_abs_ms &pos,
     // TODO: provide access to fake parts via argument ?
     const tripoint_rel_ms relative_pos = pos - pos_abs();
     std::vector<vehicle_part *> res;
-    for( const vpart_reference &vpr : get_all_parts() ) {
-        if( vpr.part().precalc[0] != relative_pos ) {
-            continue;
+    const auto add_if_matching = [&]( vehicle_part & vp ) {
+        if( vp.precalc[0] == relative_pos && !vp.is_fake && !vp.removed &&
+            ( !( condition & part_status_flag::enabled ) || vp.enabled ) &&
+            ( !( condition & part_status_flag::working ) || !vp.is_broken() ) ) {
+            res.push_back( &vp );
         }
-        if( !vpr.part().removed &&
-            ( flag.empty() || vpr.part().info().has_flag( flag ) ) &&
-            ( !( condition & part_status_flag::enabled ) || vpr.part().enabled ) &&
-            ( !( condition & part_status_flag::working ) || !vpr.part().is_broken() ) ) {
-            res.push_back( &vpr.part() );
+    };
+    if( flag.empty() ) {
+        for( const vpart_reference &vpr : get_all_parts() ) {
+            add_if_matching( vpr.part() );
+        }
+    } else {
+        for( const int p : parts_with_flag( flag ) ) {
+            add_if_matching( parts[p] );
         }
     }
     return res;
@@ -3251,11 +3272,7 @@ int vehicle::get_next_shifted_index( int original_index, Character &you ) const
 std::vector<std::vector<int>> vehicle::find_lines_of_parts(
                                int part, const std::string &flag, bool only_healthy ) const
 {
-    const auto possible_parts = only_healthy ? get_avail_parts( flag ) :  get_any_parts( flag );
     std::vector<std::vector<int>> ret_parts;
-    if( empty( possible_parts ) ) {
-        return ret_parts;
-    }
 
     std::vector<int> x_parts;
     std::vector<int> y_parts;
@@ -3267,19 +3284,20 @@ std::vector<std::vector<int>> vehicle::find_lines_of_parts(
     const vpart_id &part_id = vp.info().id;
     const point_rel_ms target = vp.mount;
     // create vectors of parts on the same X or Y axis
-    for( const vpart_reference &vpr : possible_parts ) {
-        const vehicle_part &vp_other = vpr.part();
+    for( const int p : parts_with_flag( flag ) ) {
+        const vehicle_part &vp_other = parts[p];
         const vpart_info &vpi_other = vp_other.info();
-        if( ( vp_other.is_broken() && only_healthy ) ||
+        if( vp_other.removed || vp_other.is_fake ||
+            ( only_healthy && ( vp_other.is_broken() || !vp_other.is_available() ) ) ||
             !vpi_other.has_flag( "MULTISQUARE" ) ||
             vpi_other.id != part_id )  {
             continue;
         }
         if( vp_other.mount.x() == target.x() ) {
-            x_parts.push_back( vpr.part_index() );
+            x_parts.push_back( p );
         }
         if( vp_other.mount.y() == target.y() ) {
-            y_parts.push_back( vpr.part_index() );
+            y_parts.push_back( p );
         }
     }
 
@@ -3484,6 +3502,10 @@ tripoint_abs_ms vehicle::mount_to_tripoint_abs( const point_rel_ms &mount,
 void vehicle::precalc_mounts( int idir, const units::angle &dir,
                               const point_rel_ms &pivot )
 {
+    // Turning moves the parts cables are looked up by.
+    if( has_power_transfer() ) {
+        invalidate_power_grids();
+    }
     if( idir < 0 || idir > 1 ) {
         idir = 0;
     }
@@ -3703,7 +3725,7 @@ int64_t vehicle::fuel_left( map &here, const itype_id &ftype,
 {
     int64_t fl = 0;
     if( ftype == fuel_type_battery ) {
-        for( const std::pair<const vehicle *const, float> &pair : search_connected_vehicles( here ) ) {
+        for( const std::pair<vehicle *const, float> &pair : connected_grid( here ).vehicles ) {
             const vehicle &veh = *pair.first;
             const float loss = pair.second;
             for( const int part_idx : veh.batteries ) {
@@ -3770,7 +3792,7 @@ int vehicle::fuel_capacity( map &here, const itype_id &ftype ) const
 {
     if( ftype == fuel_type_battery ) { // batteries get special treatment due to power cables
         int64_t capacity = 0;
-        for( const std::pair<const vehicle *const, float> &pair : search_connected_vehicles( here ) ) {
+        for( const std::pair<vehicle *const, float> &pair : connected_grid( here ).vehicles ) {
             const vehicle &veh = *pair.first;
             for( const int part_idx : veh.batteries ) {
                 const vehicle_part &vp = veh.parts[part_idx];
@@ -5236,7 +5258,7 @@ std::pair<int, int> vehicle::connected_battery_power_level( const map &here ) co
     int total_epower_remaining = 0;
     int total_epower_capacity = 0;
 
-    for( const std::pair<const vehicle *const, float> &pair : search_connected_vehicles( here ) ) {
+    for( const std::pair<vehicle *const, float> &pair : connected_grid( here ).vehicles ) {
         int epower_remaining;
         int epower_capacity;
         std::tie( epower_remaining, epower_capacity ) = pair.first->battery_power_level( );
@@ -5644,14 +5666,62 @@ std::map<Vehicle *, float> vehicle::search_connected_vehicles( const map &here,
     return distances;
 }
 
+// Starts above the generation of a default constructed grid, so that one is never current.
+unsigned vehicle::power_grid_generation = 1;
+
+void vehicle::invalidate_power_grids()
+{
+    ++power_grid_generation;
+}
+
+bool vehicle::has_power_transfer() const
+{
+    return std::any_of( loose_parts.begin(), loose_parts.end(), [this]( int part_idx ) {
+        return part( part_idx ).info().has_flag( VPFLAG_POWER_TRANSFER );
+    } );
+}
+
+const vehicle::power_grid &vehicle::connected_grid( const map &here ) const
+{
+    power_grid &grid = grid_cache;
+    if( grid.owner == this && grid.here == &here && grid.abs_sub == here.get_abs_sub() &&
+        grid.generation == power_grid_generation ) {
+        return grid;
+    }
+    grid = power_grid();
+    grid.owner = this;
+    grid.here = &here;
+    grid.abs_sub = here.get_abs_sub();
+    grid.generation = power_grid_generation;
+    // Callers charging and discharging the grid need the vehicles to be mutable.
+    grid.vehicles = search_connected_vehicles( here, const_cast<vehicle *>( this ) );
+    double loss = 0.0;
+    for( const std::pair<vehicle *const, float> &pair : grid.vehicles ) {
+        vehicle *veh = pair.first;
+        for( const int part_idx : veh->batteries ) {
+            const vpart_reference vpr( *veh, part_idx );
+            if( vpr.part().is_fake ) {
+                continue;
+            }
+            const int capacity = vpr.part().ammo_capacity( ammo_battery );
+            grid.batteries.emplace( vpr, pair.second );
+            grid.battery_capacity += capacity;
+            loss += pair.second * capacity;
+        }
+    }
+    grid.battery_loss = grid.battery_capacity > 0 ? loss / grid.battery_capacity : 0.0;
+    return grid;
+}
+
 std::map<vehicle *, float> vehicle::search_connected_vehicles( const map &here )
 {
-    return search_connected_vehicles( here, this );
+    return connected_grid( here ).vehicles;
 }
 
 std::map<const vehicle *, float> vehicle::search_connected_vehicles( const map &here ) const
 {
-    return search_connected_vehicles( here, this );
+    const std::map<vehicle *, float> &vehicles = connected_grid( here ).vehicles;
+    return std::map<const vehicle *, float>( vehicles.begin(), vehicles.end() );
 }
 
 void vehicle::get_connected_vehicles( const map &here, std::unordered_set<vehicle *> &dest )
@@ -5675,35 +5745,7 @@ void vehicle::get_connected_vehicles( const map &here, std::unordered_set<vehicl
 
 std::map<vpart_reference, float> vehicle::search_connected_batteries( map &here )
 {
-    std::map<vpart_reference, float> result;
-
-    for( const std::pair<vehicle *const, float> &pair : search_connected_vehicles( here ) ) {
-        vehicle *veh = pair.first;
-        const float efficiency = pair.second;
-        for( const int part_idx : veh->batteries ) {
-            const vpart_reference vpr( *veh, part_idx );
-            if( vpr.part().is_fake ) {
-                continue;
-            }
-            result.emplace( vpr, efficiency );
-        }
-    }
-
-    return result;
-}
-
-// helper method to calculate power loss weighted by capacity
-static double weighted_power_loss( const std::map<vpart_reference, float> &batteries )
-{
-    double res = 0.0; // sum of power losses
-    int64_t total_capacity = 0; // sum of capacity of all batteries
-    for( const std::pair<const vpart_reference, float> &pair : batteries ) {
-        vehicle_part &vp = pair.first.part();
-        const int capacity = vp.ammo_capacity( ammo_battery );
-        total_capacity += capacity;
-        res += pair.second * capacity;
-    }
-    return res / total_capacity;
+    return connected_grid( here ).batteries;
 }
 
 // helper method to take a map of batteries, amount of charge, total capacity of batteries
@@ -5740,7 +5782,7 @@ static void distribute_charge_evenly( const std::map<vpart_reference, float> &ba
 
 bool vehicle::is_battery_available( map &here ) const
 {
-    for( const std::pair<const vehicle *const, float> &pair : search_connected_vehicles( here ) ) {
+    for( const std::pair<vehicle *const, float> &pair : connected_grid( here ).vehicles ) {
         const vehicle &veh = *pair.first;
         for( const int part_idx : veh.batteries ) {
             const vehicle_part &vp = veh.parts[part_idx];
@@ -5755,7 +5797,7 @@ bool vehicle::is_battery_available( map &here ) const
 int64_t vehicle::battery_left( map &here, bool apply_loss ) const
 {
     int64_t ret = 0;
-    for( const std::pair<const vehicle *const, float> &pair : search_connected_vehicles( here ) ) {
+    for( const std::pair<vehicle *const, float> &pair : connected_grid( here ).vehicles ) {
         const vehicle &veh = *pair.first;
         const float efficiency = 1.0f - ( apply_loss ? pair.second : 0.0f );
         for( const int part_idx : veh.batteries ) {
@@ -5775,17 +5817,16 @@ int vehicle::charge_battery( map &here, int amount, bool apply_loss )
     if( amount == 0 ) {
         return 0;
     }
-    const std::map<vpart_reference, float> batteries = search_connected_batteries( here );
+    const power_grid &grid = connected_grid( here );
+    const std::map<vpart_reference, float> &batteries = grid.batteries;
     if( batteries.empty() ) {
         return amount;
     }
-    const double loss = apply_loss ? weighted_power_loss( batteries ) : 0.0;
+    const double loss = apply_loss ? grid.battery_loss : 0.0;
     int64_t total_charge = 0; // sum of current charge of all batteries
-    int64_t total_capacity = 0; // sum of capacity of all batteries
+    const int64_t total_capacity = grid.battery_capacity;
     for( const std::pair<const vpart_reference, float> &pair : batteries ) {
-        vehicle_part &vp = pair.first.part();
-        total_charge += vp.ammo_remaining( );
-        total_capacity += vp.ammo_capacity( ammo_battery );
+        total_charge += pair.first.part().ammo_remaining( );
     }
     const int64_t chargeable = total_capacity - total_charge;
     int64_t lost_amount = roll_remainder( amount * loss );
@@ -5818,17 +5859,16 @@ int vehicle::discharge_battery( map &here, int amount, bool apply_loss )
     if( amount == 0 ) {
         return 0;
     }
-    const std::map<vpart_reference, float> batteries = search_connected_batteries( here );
+    const power_grid &grid = connected_grid( here );
+    const std::map<vpart_reference, float> &batteries = grid.batteries;
     if( batteries.empty() ) {
         return amount;
     }
-    const double loss = apply_loss ? weighted_power_loss( batteries ) : 0.0;
+    const double loss = apply_loss ? grid.battery_loss : 0.0;
     int64_t total_charge = 0; // sum of current charge of all batteries
-    int64_t total_capacity = 0; // sum of capacity of all batteries
+    const int64_t total_capacity = grid.battery_capacity;
     for( const std::pair<const vpart_reference, float> &pair : batteries ) {
-        vehicle_part &vp = pair.first.part();
-        total_charge += vp.ammo_remaining( );
-        total_capacity += vp.ammo_capacity( ammo_battery );
+        total_charge += pair.first.part().ammo_remaining( );
     }
 
     int64_t discharged = amount;
@@ -6432,6 +6472,7 @@ void vehicle::refresh( const bool remove_fakes )
     if( no_refresh ) {
         return;
     }
+    invalidate_power_grids();
 
     alternators.clear();
     engines.clear();
@@ -875,6 +875,25 @@ class vehicle
         /// Templated to support const and non-const vehicle*
         template<typename Vehicle>
         static std::map<Vehicle *, float> search_connected_vehicles( const map &here, Vehicle *start );
+
+        /// The power grid this vehicle is part of, as found by search_connected_vehicles
+        struct power_grid {
+            // What the grid was searched for, it is searched again when any of these differ
+            const vehicle *owner = nullptr;
+            const map *here = nullptr;
+            tripoint_abs_sm abs_sub;
+            unsigned generation = 0;
+
+            std::map<vehicle *, float> vehicles;
+            // Non-fake batteries of the vehicles, with their line loss
+            std::map<vpart_reference, float> batteries;
+            int64_t battery_capacity = 0;
+            // Line loss of the batteries weighted by their capacity
+            double battery_loss = 0.0;
+        };
+        /// Cached until a vehicle is refreshed, moved or destroyed, see invalidate_power_grids
+        const power_grid &connected_grid( const map &here ) const;
+        static unsigned power_grid_generation;
     public:
         std::vector<std::string> chat_topics; // What it has to say.
         void set_value( const std::string &key, diag_value value );
@@ -896,6 +915,15 @@ class vehicle
          * @param where Location of the other vehicle's origin tile.
          */
         static vehicle *find_vehicle( const map &here, const tripoint_abs_ms &where );
+        /**
+         * Drops the cached power grids of all vehicles. Needed whenever a POWER_TRANSFER
+         * part could connect to a different vehicle than before: parts being installed or
+         * removed, vehicles moving, and vehicles being created or destroyed.
+         */
+        static void invalidate_power_grids();
+        /// Whether a POWER_TRANSFER part, such as a cable, may link this vehicle to others.
+        /// Vehicles without one can move without changing any power grid.
+        bool has_power_transfer() const;
         // find_vehicle, but it compares the provided position to the position of
         // every vehicle part instead of just the vehicle's position
         static vehicle *find_vehicle_using_parts( const map &here,  const tripoint_abs_ms &where );
@@ -1836,8 +1864,10 @@ class vehicle
 
         // Handle given part collision with vehicle, monster/NPC/player or terrain obstacle
         // Returns collision, which has type, impulse, part, & target.
+        // may_hit_vehicle is false when no other vehicle is close enough to be at p.
         veh_collision part_collision( map &here, int part, const tripoint_abs_ms &p,
-                                      bool just_detect, bool bash_floor );
+                                      bool just_detect, bool bash_floor,
+                                      bool may_hit_vehicle = true );
 
         // Process the trap beneath
         void handle_trap( map *here, const tripoint_bub_ms &p, vehicle_part &vp_wheel );
@@ -2048,6 +2078,9 @@ class vehicle
         // get all vehicle parts' projected points
         std::set<tripoint_abs_ms> get_projected_part_points() const;
 
+        // Whether another vehicle might be where the parts that collide were projected to
+        bool other_vehicle_near_projection( map &here ) const;
+
         /**
         * Consumes specified charges (or fewer) from the vehicle part
         * @param what specific type of charge required, e.g. 'battery'
@@ -2216,6 +2249,16 @@ class vehicle
         mutable units::angle occupied_cache_direction = 0_degrees; // NOLINT(cata-serialize)
         // Cached points occupied by the vehicle
         mutable std::set<tripoint_abs_ms> occupied_points; // NOLINT(cata-serialize)
+        // Vehicles and batteries connected by power cables
+        mutable power_grid grid_cache; // NOLINT(cata-serialize)
+        // Indices of the parts whose type has the flag, for the first parts_by_flag_size parts.
+        // Parts are only appended outside of do_remove_part_actual, so new parts are indexed
+        // when the index is next used instead of rebuilding it.
+        // NOLINTNEXTLINE(cata-serialize)
+        mutable std::unordered_map<std::string, std::vector<int>> parts_by_flag;
+        mutable size_t parts_by_flag_size = 0; // NOLINT(cata-serialize)
+        /// Parts whose type has the flag, in index order, including removed and fake parts
+        const std::vector<int> &parts_with_flag( const std::string &flag ) const;
 
         // Master list of parts installed in the vehicle.
         std::vector<vehicle_part> parts; // NOLINT(cata-serialize)
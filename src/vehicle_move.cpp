@@ -4,6 +4,7 @@
 #include <array>
 #include <cmath>
 #include <cstdlib>
+#include <map>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -16,6 +17,7 @@
 #include "character.h"
 #include "creature.h"
 #include "creature_tracker.h"
+#include "cuboid_rectangle.h"
 #include "damage.h"
 #include "debug.h"
 #include "effect_source.h"
@@ -33,6 +35,7 @@
 #include "messages.h"
 #include "monster.h"
 #include "options.h"
+#include "perf.h"
 #include "rng.h"
 #include "sounds.h"
 #include "translations.h"
@@ -743,6 +746,7 @@ bool vehicle::collision( map &here, std::vector<veh_collision> &colls,
     const int sign_before = sgn( velocity_before );
     bool empty = true;
     part_project_points( dp );
+    const bool may_hit_vehicle = other_vehicle_near_projection( here );
     for( int p = 0; p < part_count(); p++ ) {
         const vehicle_part &vp = parts.at( p );
         if( vp.removed || !vp.is_real_or_active_fake() ) {
@@ -757,12 +761,13 @@ bool vehicle::collision( map &here, std::vector<veh_collision> &colls,
         // Coordinates of where part will go due to movement (dx/dy/dz)
         //  and turning (precalc[1])
         const tripoint_abs_ms dsp = vp.next_pos;
-        veh_collision coll = part_collision( here, p, dsp, just_detect, bash_floor );
+        veh_collision coll = part_collision( here, p, dsp, just_detect, bash_floor,
+                                             may_hit_vehicle );
         if( coll.type == veh_coll_nothing && info.has_flag( VPFLAG_ROTOR ) ) {
             size_t radius = static_cast<size_t>( std::round( info.rotor_info->rotor_diameter / 2.0f ) );
             for( const tripoint_bub_ms &rotor_point : here.points_in_radius( here.get_bub( dsp ), radius ) ) {
                 veh_collision rotor_coll = part_collision( here, p, here.get_abs( rotor_point ), just_detect,
-                                           false );
+                                           false, may_hit_vehicle );
                 if( rotor_coll.type != veh_coll_nothing ) {
                     coll = rotor_coll;
                     if( just_detect ) {
@@ -821,6 +826,40 @@ bool vehicle::collision( map &here, std::vector<veh_collision> &colls,
     return !colls.empty();
 }
 
+bool vehicle::other_vehicle_near_projection( map &here ) const
+{
+    // The area each level the projected parts reach, grown by the reach of the rotors
+    std::map<int, inclusive_rectangle<point_bub_ms>> areas;
+    for( const vehicle_part &vp : parts ) {
+        if( vp.removed || !vp.is_real_or_active_fake() ) {
+            continue;
+        }
+        const vpart_info &info = vp.info();
+        const bool rotor = info.has_flag( VPFLAG_ROTOR );
+        if( !vp.is_fake && info.location != part_location_structure && !rotor ) {
+            continue;
+        }
+        const int reach = rotor ?
+                          static_cast<int>( std::round( info.rotor_info->rotor_diameter / 2.0f ) ) :
+                          0;
+        const tripoint_bub_ms p = here.get_bub( vp.next_pos );
+        const point_bub_ms p_min = p.xy() - point( reach, reach );
+        const point_bub_ms p_max = p.xy() + point( reach, reach );
+        const auto area = areas.emplace( p.z(), inclusive_rectangle<point_bub_ms>( p_min, p_max ) );
+        inclusive_rectangle<point_bub_ms> &r = area.first->second;
+        r.p_min = point_bub_ms( std::min( r.p_min.x(), p_min.x() ),
+                               std::min( r.p_min.y(), p_min.y() ) );
+        r.p_max = point_bub_ms( std::max( r.p_max.x(), p_max.x() ),
+                               std::max( r.p_max.y(), p_max.y() ) );
+    }
+    for( const std::pair<const int, inclusive_rectangle<point_bub_ms>> &area : areas ) {
+        if( here.other_vehicle_within( *this, area.first, area.second ) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // A helper to make sure mass and density is always calculated the same way
 static void terrain_collision_data( map &here, const tripoint_bub_ms &p, bool bash_floor,
                                     float &mass, float &density, float &elastic )
@@ -834,7 +873,7 @@ static void terrain_collision_data( map &here, const tripoint_bub_ms &p, bool ba
 }
 
 veh_collision vehicle::part_collision( map &here, int part, const tripoint_abs_ms &p,
-                                       bool just_detect, bool bash_floor )
+                                       bool just_detect, bool bash_floor, bool may_hit_vehicle )
 {
     tripoint_bub_ms pos = here.get_bub( p );
     // Vertical collisions need to be handled differently
@@ -843,15 +882,20 @@ veh_collision vehicle::part_collision( map &here, int part, const tripoint_abs_m
     Creature *critter = get_creature_tracker().creature_at( p, true );
     Character *ph = dynamic_cast<Character *>( critter );
 
-    Character *driver = get_driver( here );
-
     // If in a vehicle assume it's this one
     if( ph != nullptr && ph->in_vehicle ) {
         critter = nullptr;
         ph = nullptr;
     }
 
-    const optional_vpart_position ovp = here.veh_at( p );
+    // Without another vehicle close by, the only one that can be at p is this one, which only
+    // matters for critters riding it.
+    const bool look_for_vehicle = may_hit_vehicle && !bash_floor;
+    if( look_for_vehicle ) {
+        turn_counters::add( turn_counter::vehicle_collision_lookups, 1 );
+    }
+    const optional_vpart_position ovp = look_for_vehicle || critter != nullptr ?
+                                        here.veh_at( p ) : optional_vpart_position( std::nullopt );
     // Disable vehicle/critter collisions when bashing floor
     // TODO: More elegant code
     const bool is_veh_collision = !bash_floor && ovp && &ovp->vehicle() != this;
@@ -975,6 +1019,8 @@ veh_collision vehicle::part_collision( map &here, int part, const tripoint_abs_m
         return ret;
     }
     stop_autodriving();
+    // Finding the driver walks the boarded parts, so only do it when someone gets hit
+    Character *driver = ret.type == veh_coll_body ? get_driver( here ) : nullptr;
     // Calculate mass AFTER checking for collision
     //  because it involves iterating over all cargo
     // Rotors only use rotor mass in calculation.
@@ -2065,6 +2065,26 @@ bool WORLD::has_compression_enabled() const
            std::filesystem::exists( ( world_folder_path / "overmaps.dict" ).get_unrelative_path() );
 }
 
+void WORLD::update_compression_dictionaries() const
+{
+    const cata_path dictionary_folder = PATH_INFO::compression_folder_path();
+    for( const std::string &kind : std::array<std::string, 3> { "maps", "mmr", "overmaps" } ) {
+        const cata_path shipped = dictionary_folder / ( kind + ".dict" );
+        const cata_path current = folder_path() / ( kind + ".dict" );
+        const unsigned shipped_id = zzip::dictionary_id( shipped.get_unrelative_path() );
+        const unsigned current_id = zzip::dictionary_id( current.get_unrelative_path() );
+        // Raw content dictionaries have no id for the entries to refer to, so they stay.
+        if( shipped_id == 0 || current_id == 0 || shipped_id == current_id ) {
+            continue;
+        }
+        const cata_path retired = folder_path() / string_format( "%s.%u.dict", kind, current_id );
+        if( !rename_file( current, retired ) || !copy_file( shipped, current ) ) {
+            debugmsg( "Could not update the %s compression dictionary of world %s", kind,
+                      world_name );
+        }
+    }
+}
+
 bool WORLD::set_compression_enabled( bool enabled ) const
 {
     // Return immediately if we're already in the desired state.
@@ -2336,6 +2356,11 @@ bool WORLD::set_compression_enabled( bool enabled ) const
         remove_file( maps_dict );
         remove_file( overmaps_dict );
         remove_file( mmr_dict );
+        // Versions retired by update_compression_dictionaries.
+        for( const cata_path &retired : get_files_from_path( ".dict", world_folder_path, false,
+                true ) ) {
+            remove_file( retired );
+        }
         done = 0;
         for( const cata_path &zzip_to_clean : zzips_to_clean ) {
             popup.message( _( "Cleaning up [%d/%d]" ), done++, zzips_to_clean.size() );
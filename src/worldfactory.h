@@ -86,6 +86,12 @@ struct WORLD {
 
         bool has_compression_enabled() const;
         bool set_compression_enabled( bool enabled ) const;
+        /**
+         * Replaces the world's compression dictionaries with the ones shipped with the game
+         * if those are newer versions. The old ones are kept under their id so entries
+         * written with them can still be read, see zzip::load.
+         */
+        void update_compression_dictionaries() const;
 
 };
 
@@ -2,20 +2,28 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstring>
 #include <exception>
+#include <fstream>
 #include <functional>
 #include <iosfwd>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <system_error>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#if defined(_WIN32) && !defined(_MSC_VER)
+#   include "mingw.thread.h"
+#endif
+
 #include <flatbuffers/flexbuffers.h>
 
 #include <zstd/zstd.h>
@@ -85,56 +93,76 @@ struct zzip_vector_storage : flexbuffer_storage {
     }
 };
 
-// To save time, and because we aren't multithreading, we can cache zstd
-// compress and decompress contexts, indexed by dictionary path.
-struct cached_zstd_context {
-    std::vector<char> dictionary_;
-    ZSTD_CCtx *cctx = nullptr;
-    ZSTD_DCtx *dctx = nullptr;
-
-    cached_zstd_context(
-        std::vector<char> &&dictionary,
-        ZSTD_CCtx *cctx,
-        ZSTD_DCtx *dctx )
-        : dictionary_{std::move( dictionary )},
-          cctx{ cctx },
-          dctx{ dctx } {
+// Setting up zstd contexts with a dictionary is expensive, so they are pooled by
+// dictionary path. zzips are used from several threads at once (background saves,
+// map prefetching, parallel compression), so each zzip takes a pair of its own.
+struct zstd_context_pool {
+    std::shared_ptr<const std::vector<char>> dictionary_;
+    unsigned dictionary_id_ = 0;
+    std::vector<std::pair<ZSTD_CCtx *, ZSTD_DCtx *>> idle_;
+
+    zstd_context_pool() = default;
+    zstd_context_pool( zstd_context_pool const & ) = delete;
+    zstd_context_pool &operator=( zstd_context_pool const & ) = delete;
+
+    ~zstd_context_pool() {
+        for( const std::pair<ZSTD_CCtx *, ZSTD_DCtx *> &contexts : idle_ ) {
+            ZSTD_freeCCtx( contexts.first );
+            ZSTD_freeDCtx( contexts.second );
+        }
     }
+};
 
-    cached_zstd_context( cached_zstd_context const & ) = delete;
-    cached_zstd_context( cached_zstd_context &&rhs ) noexcept : dictionary_( std::move(
-                    rhs.dictionary_ ) ), cctx( rhs.cctx ), dctx( rhs.dctx ) {
-        rhs.cctx = nullptr;
-        rhs.dctx = nullptr;
+std::mutex context_pools_mutex;
+std::unordered_map<std::string, zstd_context_pool> context_pools;
+
+// Pools are keyed by the id of the dictionary as well as its path, so a dictionary that
+// was replaced by a newer version does not get contexts made for the old one.
+std::string context_pool_key( const std::filesystem::path &dictionary_path )
+{
+    return dictionary_path.string() + ':' + std::to_string( zzip::dictionary_id( dictionary_path ) );
+}
+
+struct ddict_deleter {
+    void operator()( ZSTD_DDict *ddict ) const {
+        ZSTD_freeDDict( ddict );
     }
+};
+
+// Older versions of dictionaries by zstd dictionary id. Every frame records the id of the
+// dictionary it was compressed with, so after a dictionary is replaced the entries written
+// with the old one are decompressed with it. Digested dictionaries are immutable and can
+// be shared by all threads; they are never freed.
+std::mutex retired_dictionaries_mutex;
+std::unordered_map<unsigned, std::unique_ptr<ZSTD_DDict, ddict_deleter>> retired_dictionaries;
 
-    cached_zstd_context &operator=( cached_zstd_context const & ) = delete;
-    cached_zstd_context &operator=( cached_zstd_context &&rhs ) noexcept {
-        dictionary_ = std::move( rhs.dictionary_ );
-        if( &rhs == this ) {
-            return *this;
+// Finds the dictionary with the given id in the given folder. Retired dictionaries are
+// kept next to the current one, see WORLD::update_compression_dictionaries.
+const ZSTD_DDict *find_retired_dictionary( const std::filesystem::path &folder, unsigned id )
+{
+    std::lock_guard<std::mutex> lock( retired_dictionaries_mutex );
+    const auto found = retired_dictionaries.find( id );
+    if( found != retired_dictionaries.end() ) {
+        return found->second.get();
+    }
+    std::error_code ec;
+    for( const std::filesystem::directory_entry &entry :
+         std::filesystem::directory_iterator( folder, ec ) ) {
+        if( entry.path().extension() != ".dict" || zzip::dictionary_id( entry.path() ) != id ) {
+            continue;
         }
-        if( cctx ) {
-            ZSTD_freeCCtx( cctx );
+        std::shared_ptr<const mmap_file> file = mmap_file::map_file( entry.path() );
+        if( !file ) {
+            continue;
         }
-        cctx = rhs.cctx;
-        rhs.cctx = nullptr;
-
-        if( dctx ) {
-            ZSTD_freeDCtx( dctx );
+        ZSTD_DDict *ddict = ZSTD_createDDict( file->base(), file->len() );
+        if( !ddict ) {
+            continue;
         }
-        dctx = rhs.dctx;
-        rhs.dctx = nullptr;
-        return *this;
-    }
-
-    ~cached_zstd_context() {
-        ZSTD_freeCCtx( cctx );
-        ZSTD_freeDCtx( dctx );
+        return retired_dictionaries.emplace( id, ddict ).first->second.get();
     }
-};
-
-std::unordered_map<std::string, cached_zstd_context> cached_contexts;
+    return nullptr;
+}
 
 } // namespace
 
@@ -167,9 +195,13 @@ constexpr const std::string_view kEntryLenKey = "len";
 constexpr const std::string_view kMetaKey = "meta";
 constexpr const std::string_view kMetaContentEndKey = "content_end";
 constexpr const std::string_view kMetaTotalContentSizeKey = "total_content_size";
+constexpr const std::string_view kMetaDictionaryIdKey = "dictionary_id";
 
 constexpr size_t kAssumedPageSize = 4 * 1024;
 
+// Parallel compression in add_files. Past a few threads the disk is the limit.
+constexpr size_t kMaxCompressionThreads = 4;
+
 struct zzip_file_entry {
     size_t offset = 0;
     size_t len = 0;
@@ -178,6 +210,8 @@ struct zzip_file_entry {
 struct zzip_meta {
     size_t content_end = 0;
     size_t total_content_size = 0;
+    // Dictionary the zzip was last written with. Older zzips do not record it.
+    unsigned dictionary_id = 0;
 };
 
 
@@ -194,7 +228,8 @@ struct zzip_footer {
         meta_obj.allow_omitted_members();
         size_t content_end = meta_obj.get_int( kMetaContentEndKey );
         size_t total_content_size = meta_obj.get_int( kMetaTotalContentSizeKey );
-        return zzip_meta{ content_end, total_content_size };
+        unsigned dictionary_id = meta_obj.get_int( kMetaDictionaryIdKey, 0 );
+        return zzip_meta{ content_end, total_content_size, dictionary_id };
     }
 
     std::optional<zzip_file_entry> get_entry( std::filesystem::path const &path ) const {
@@ -328,14 +363,121 @@ std::pair<void *, size_t> read_and_skip_entry_metadata(
     return { base, entry_len };
 }
 
+// Upper bound of the encoded size of an entry, see encode_entry.
+size_t entry_size_bound( std::string_view filename, std::string_view content )
+{
+    return ZSTD_SKIPPABLEHEADERSIZE + filename.length() + kEntryChecksumFrameSize +
+           ZSTD_compressBound( content.length() );
+}
+
+// Compresses and encodes a file entry into dest.
+size_t encode_entry( ZSTD_CCtx *cctx, void *dest, size_t dest_len, std::string_view filename,
+                     std::string_view content )
+{
+    // The format of a compressed entry is a series of zstd frames.
+    // There are an unbounded number of leading skippable frames of unspecified content.
+    // At present, we write two skippable frames per entry:
+    //   - A frame for the filename of the entry.
+    //   - A frame for a 64 bit XXH checksum of the entire compressed frame.
+    //   - The actual compressed frame.
+    // Returns the size of the entire file entry, or the return zstd error.
+    // (i.e. from the start of the first skippable frame to the end of the compressed data).
+    char *base = static_cast<char *>( dest );
+    size_t header_size = ZSTD_writeSkippableFrame(
+                             base,
+                             dest_len,
+                             filename.data(),
+                             filename.length(),
+                             kEntryFileNameMagic
+                         );
+    if( ZSTD_isError( header_size ) ) {
+        return header_size;
+    }
+    size_t offset = header_size;
+    // Make room for the checksum frame before the file.
+    offset += kEntryChecksumFrameSize;
+    if( offset > dest_len ) {
+        return static_cast<size_t>( -ZSTD_error_dstSize_tooSmall );
+    }
+    size_t file_size = ZSTD_compress2(
+                           cctx,
+                           base + offset,
+                           dest_len - offset,
+                           content.data(),
+                           content.size()
+                       );
+    if( ZSTD_isError( file_size ) ) {
+        return file_size;
+    }
+    uint64_t checksum = XXH64( base + offset, file_size, kCheckumSeed );
+    uint64_t checksum_le = 0;
+    MEM_writeLE64( &checksum_le, checksum );
+    size_t checksum_size = ZSTD_writeSkippableFrame(
+                               base + offset - kEntryChecksumFrameSize,
+                               kEntryChecksumFrameSize,
+                               reinterpret_cast<const char *>( &checksum_le ),
+                               sizeof( checksum_le ),
+                               kEntryChecksumMagic
+                           );
+    if( ZSTD_isError( checksum_size ) || checksum_size != kEntryChecksumFrameSize ) {
+        return checksum_size;
+    }
+    return header_size + checksum_size + file_size;
+}
+
 } // namespace
 
 struct zzip::context {
-    context( ZSTD_CCtx *cctx, ZSTD_DCtx *dctx )
-        : cctx{ cctx }, dctx{ dctx }
-    {}
-    ZSTD_CCtx *cctx;
-    ZSTD_DCtx *dctx;
+    // Takes a pair of contexts for the dictionary from the pool, or makes a new one.
+    explicit context( std::filesystem::path dictionary_path ) : dictionary_path{ std::move( dictionary_path ) } {
+        if( this->dictionary_path.empty() ) {
+            cctx = ZSTD_createCCtx();
+            dctx = ZSTD_createDCtx();
+            return;
+        }
+        pool_key = context_pool_key( this->dictionary_path );
+        std::lock_guard<std::mutex> lock( context_pools_mutex );
+        zstd_context_pool &pool = context_pools[pool_key];
+        if( !pool.dictionary_ ) {
+            std::shared_ptr<const mmap_file> dictionary_file = mmap_file::map_file( this->dictionary_path );
+            std::vector<char> dictionary( dictionary_file->len() );
+            memcpy( dictionary.data(), dictionary_file->base(), dictionary_file->len() );
+            pool.dictionary_id_ = ZSTD_getDictID_fromDict( dictionary.data(), dictionary.size() );
+            pool.dictionary_ = std::make_shared<const std::vector<char>>( std::move( dictionary ) );
+        }
+        dictionary_id = pool.dictionary_id_;
+        if( !pool.idle_.empty() ) {
+            std::tie( cctx, dctx ) = pool.idle_.back();
+            pool.idle_.pop_back();
+            return;
+        }
+        const std::vector<char> &dictionary = *pool.dictionary_;
+        cctx = ZSTD_createCCtx();
+        ZSTD_CCtx_setParameter( cctx, ZSTD_c_compressionLevel, 7 );
+        ZSTD_CCtx_loadDictionary_byReference( cctx, dictionary.data(), dictionary.size() );
+        dctx = ZSTD_createDCtx();
+        ZSTD_DCtx_loadDictionary_byReference( dctx, dictionary.data(), dictionary.size() );
+    }
+
+    ~context() {
+        if( dictionary_path.empty() ) {
+            ZSTD_freeCCtx( cctx );
+            ZSTD_freeDCtx( dctx );
+            return;
+        }
+        std::lock_guard<std::mutex> lock( context_pools_mutex );
+        context_pools[pool_key].idle_.emplace_back( cctx, dctx );
+    }
+
+    context( context const & ) = delete;
+    context &operator=( context const & ) = delete;
+
+    std::filesystem::path dictionary_path;
+    std::string pool_key;
+    // zstd id of the dictionary, 0 for none or a raw content dictionary.
+    unsigned dictionary_id = 0;
+    ZSTD_CCtx *cctx = nullptr;
+    ZSTD_DCtx *dctx = nullptr;
 };
 
 zzip::zzip( std::filesystem::path path, std::shared_ptr<mmap_file> file, JsonObject footer )
@@ -385,33 +527,7 @@ std::shared_ptr<zzip> zzip::load( std::filesystem::path const &path,
 
     zip = std::shared_ptr<zzip>( new zzip( path, std::move( file ), std::move( footer ) ) );
 
-    ZSTD_CCtx *cctx;
-    ZSTD_DCtx *dctx;
-    if( dictionary_path.empty() ) {
-        cctx = ZSTD_createCCtx();
-        dctx = ZSTD_createDCtx();
-    } else if( auto it = cached_contexts.find( dictionary_path.string() );
-               it != cached_contexts.end() ) {
-        cctx = it->second.cctx;
-        dctx = it->second.dctx;
-    } else {
-        cctx = ZSTD_createCCtx();
-        ZSTD_CCtx_setParameter( cctx, ZSTD_c_compressionLevel, 7 );
-        dctx = ZSTD_createDCtx();
-
-        std::vector<char> dictionary;
-        if( !dictionary_path.empty() ) {
-            std::shared_ptr<const mmap_file> dictionary_file = mmap_file::map_file( dictionary_path );
-            dictionary.resize( dictionary_file->len() );
-            memcpy( dictionary.data(), dictionary_file->base(), dictionary_file->len() );
-            ZSTD_CCtx_loadDictionary_byReference( cctx, dictionary.data(), dictionary.size() );
-            ZSTD_DCtx_loadDictionary_byReference( dctx, dictionary.data(), dictionary.size() );
-        }
-
-        cached_contexts.emplace( dictionary_path.string(), cached_zstd_context{ std::move( dictionary ), cctx, dctx } );
-    }
-
-    zip->ctx_ = std::make_unique<zzip::context>( cctx, dctx );
+    zip->ctx_ = std::make_unique<zzip::context>( dictionary_path );
 
     if( needs_footer && !zip->rewrite_footer() ) {
         return nullptr;
@@ -465,6 +581,74 @@ bool zzip::add_file( std::filesystem::path const &zzip_relative_path, std::strin
     return true;
 }
 
+bool zzip::add_files( std::vector<std::pair<std::filesystem::path, std::string_view>> const
+                      &files )
+{
+    if( files.empty() ) {
+        return true;
+    }
+    std::vector<std::string> names;
+    names.reserve( files.size() );
+    for( const std::pair<std::filesystem::path, std::string_view> &file : files ) {
+        names.emplace_back( file.first.generic_u8string() );
+    }
+
+    // Compress into separate buffers first, so the entries can be compressed in parallel
+    // and appended to the file at once.
+    std::vector<std::vector<char>> encoded( files.size() );
+    std::vector<size_t> encoded_sizes( files.size(), 0 );
+    std::atomic<size_t> next_file{ 0 };
+    const auto compress = [&]( ZSTD_CCtx * cctx ) {
+        for( size_t i = next_file.fetch_add( 1 ); i < files.size(); i = next_file.fetch_add( 1 ) ) {
+            try {
+                encoded[i].resize( entry_size_bound( names[i], files[i].second ) );
+                encoded_sizes[i] = encode_entry( cctx, encoded[i].data(), encoded[i].size(), names[i],
+                                                 files[i].second );
+            } catch( const std::exception & ) {
+                encoded_sizes[i] = 0;
+            }
+        }
+    };
+    const size_t thread_count = std::min<size_t>( { files.size(), kMaxCompressionThreads,
+                                std::max( std::thread::hardware_concurrency(), 1U )
+                                                  } );
+    {
+        std::vector<std::unique_ptr<context>> helper_contexts;
+        std::vector<std::thread> helpers;
+        for( size_t i = 1; i < thread_count; ++i ) {
+            helper_contexts.emplace_back( std::make_unique<context>( ctx_->dictionary_path ) );
+            helpers.emplace_back( compress, helper_contexts.back()->cctx );
+        }
+        compress( ctx_->cctx );
+        for( std::thread &helper : helpers ) {
+            helper.join();
+        }
+    }
+
+    size_t total_size = 0;
+    for( size_t encoded_size : encoded_sizes ) {
+        if( encoded_size == 0 || ZSTD_isError( encoded_size ) ) {
+            return false;
+        }
+        total_size += encoded_size;
+    }
+
+    JsonObject footer_copy = copy_footer();
+    footer_copy.allow_omitted_members();
+    size_t content_end = zzip_footer{ footer_copy }.get_meta().content_end;
+    // One resize of the file for the whole batch.
+    if( !ensure_capacity_for( content_end + total_size + kFixedSizeOverhead ) ) {
+        return false;
+    }
+    std::vector<compressed_entry> new_entries;
+    new_entries.reserve( files.size() );
+    for( size_t i = 0; i < files.size(); ++i ) {
+        memcpy( file_base_plus( content_end ), encoded[i].data(), encoded_sizes[i] );
+        new_entries.emplace_back( compressed_entry{ std::move( names[i] ), content_end, encoded_sizes[i] } );
+        content_end += encoded_sizes[i];
+    }
+    return update_footer( footer_copy, content_end, new_entries );
+}
 
 bool zzip::copy_files( std::vector<std::filesystem::path> const &zzip_relative_paths,
                        std::shared_ptr<zzip> const &from )
@@ -577,7 +761,20 @@ size_t zzip::get_file_to( std::filesystem::path const &zzip_relative_path, std::
     if( dest_len < file_size ) {
         return 0;
     }
-    size_t actual = ZSTD_decompressDCtx( ctx_->dctx, dest, dest_len, file_base, file_len );
+    size_t actual = 0;
+    const unsigned frame_dictionary_id = ZSTD_getDictID_fromFrame( file_base, file_len );
+    if( frame_dictionary_id != 0 && frame_dictionary_id != ctx_->dictionary_id ) {
+        // Written with an older version of the dictionary.
+        const ZSTD_DDict *ddict = find_retired_dictionary( ctx_->dictionary_path.parent_path(),
+                                  frame_dictionary_id );
+        if( !ddict ) {
+            return 0;
+        }
+        actual = ZSTD_decompress_usingDDict( ctx_->dctx, dest, dest_len, file_base, file_len,
+                                             ddict );
+    } else {
+        actual = ZSTD_decompressDCtx( ctx_->dctx, dest, dest_len, file_base, file_len );
+    }
     if( ZSTD_isError( actual ) ) {
         return 0;
     }
@@ -594,6 +791,48 @@ size_t zzip::get_zzip_size() const
     return file_->len();
 }
 
+zzip::stats zzip::get_stats() const
+{
+    zzip_footer footer{ footer_ };
+    const zzip_meta meta = footer.get_meta();
+    stats result;
+    if( footer_.has_object( kEntriesKey ) ) {
+        result.entries = footer_.get_object( kEntriesKey ).size();
+    }
+    result.live_bytes = meta.total_content_size;
+    // Entries start after the footer checksum frame.
+    const size_t written = meta.content_end > kFooterChecksumFrameSize ?
+                           meta.content_end - kFooterChecksumFrameSize : 0;
+    result.dead_bytes = written > meta.total_content_size ? written - meta.total_content_size : 0;
+    result.slack_bytes = file_->len() - std::min( file_->len(), meta.content_end );
+    result.dictionary_id = meta.dictionary_id;
+    return result;
+}
+
+unsigned zzip::dictionary_id( std::filesystem::path const &dictionary )
+{
+    std::ifstream file( dictionary, std::ios::binary );
+    std::array<char, 8> header{};
+    if( !file.read( header.data(), header.size() ) ) {
+        return 0;
+    }
+    return ZSTD_getDictID_fromDict( header.data(), header.size() );
+}
+
+double zzip::stats::dead_ratio() const
+{
+    const size_t content = live_bytes + dead_bytes;
+    return content == 0 ? 0.0 : static_cast<double>( dead_bytes ) / content;
+}
+
+bool zzip::compact_if_dead( double max_dead_ratio )
+{
+    if( get_stats().dead_ratio() <= max_dead_ratio ) {
+        return false;
+    }
+    return compact( 0 );
+}
+
 std::filesystem::path const &zzip::get_path() const
 {
     return path_;
@@ -660,56 +899,11 @@ size_t zzip::ensure_capacity_for( size_t bytes )
 // Actually performs the compression and encoding of a file into the zzip.
 size_t zzip::write_file_at( std::string_view filename, std::string_view content, size_t offset )
 {
-    // The format of a compressed entry is a series of zstd frames.
-    // There are an unbounded number of leading skippable frames of unspecified content.
-    // At present, we write two skippable frames per entry:
-    //   - A frame for the filename of the entry.
-    //   - A frame for a 64 bit XXH checksum of the entire compressed frame.
-    //   - The actual compressed frame.
-    // Returns the size of the entire file entry, or the return zstd error.
-    // (i.e. from the start of the first skippable frame to the end of the compressed data).
-
     if( file_->len() <= offset ) {
         return 0;
     }
-
-    size_t header_size = ZSTD_writeSkippableFrame(
-                             file_base_plus( offset ),
-                             file_capacity_at( offset ),
-                             filename.data(),
-                             filename.length(),
-                             kEntryFileNameMagic
-                         );
-    if( ZSTD_isError( header_size ) ) {
-        return header_size;
-    }
-    offset += header_size;
-    // Make room for the checksum frame before the file.
-    offset += kEntryChecksumFrameSize;
-    size_t file_size = ZSTD_compress2(
-                           ctx_->cctx,
-                           file_base_plus( offset ),
-                           file_capacity_at( offset ),
-                           content.data(),
-                           content.size()
-                       );
-    if( ZSTD_isError( file_size ) ) {
-        return file_size;
-    }
-    uint64_t checksum = XXH64( file_base_plus( offset ), file_size, kCheckumSeed );
-    uint64_t checksum_le = 0;
-    MEM_writeLE64( &checksum_le, checksum );
-    size_t checksum_size = ZSTD_writeSkippableFrame(
-                               file_base_plus( offset - kEntryChecksumFrameSize ),
-                               kEntryChecksumFrameSize,
-                               reinterpret_cast<const char *>( &checksum_le ),
-                               sizeof( checksum_le ),
-                               kEntryChecksumMagic
-                           );
-    if( ZSTD_isError( checksum_size ) || checksum_size != kEntryChecksumFrameSize ) {
-        return checksum_size;
-    }
-    return header_size + checksum_size + file_size;
+    return encode_entry( ctx_->cctx, file_base_plus( offset ), file_capacity_at( offset ), filename,
+                         content );
 }
 
 // Writes a new footer at the end of the zzip, copying old entries from the given
@@ -758,6 +952,7 @@ bool zzip::update_footer( JsonObject const &original_footer, size_t content_end,
         size_t meta_start = builder.StartMap( kMetaKey.data() );
         builder.UInt( kMetaContentEndKey.data(), content_end );
         builder.UInt( kMetaTotalContentSizeKey.data(), total_content_size );
+        builder.UInt( kMetaDictionaryIdKey.data(), ctx_ ? ctx_->dictionary_id : 0 );
         builder.EndMap( meta_start );
     }
     builder.EndMap( root_start );
@@ -9,6 +9,7 @@
 #include <memory>
 #include <string_view>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "flexbuffer_json.h"
@@ -56,10 +57,12 @@ class zzip
 
         /**
          * Create a zzip at the given path, using the given dictionary to de/compress files in the zzip.
-         * The same dictionary must be used every time the zzip is loaded.
          * A dictionary can either be arbitrary reference data or a dictionary created with the zstd cli.
          * See https://github.com/facebook/zstd/blob/dev/programs/README.md#dictionary-builder-in-command-line-interface
          * for more details.
+         * Entries record the id of a dictionary made with the zstd cli, so such a dictionary can be
+         * replaced by a newer version as long as the old one is kept in the same folder, under any
+         * name ending in `.dict`. Raw content dictionaries have no id and must never change.
          */
         static std::shared_ptr<zzip> load( std::filesystem::path const &path,
                                            std::filesystem::path const &dictionary = {} );
@@ -70,6 +73,14 @@ class zzip
          */
         bool add_file( std::filesystem::path const &zzip_relative_path, std::string_view content );
 
+        /**
+         * Writes many files at once. The files are compressed in parallel and appended
+         * with a single resize of the zzip and a single footer update, which is much
+         * cheaper than calling add_file for each of them.
+         * Returns true on success, false on any error, in which case nothing was added.
+         */
+        bool add_files( std::vector<std::pair<std::filesystem::path, std::string_view>> const &files );
+
         /**
          * Directly copies a compressed entry from one zzip to another. Both zzips
          * must have been opened using the same dictionary. The relative path is
@@ -101,6 +112,29 @@ class zzip
          */
         size_t get_zzip_size() const;
 
+        /** Space usage of the zzip, see get_stats. */
+        struct stats {
+            size_t entries = 0;
+            // Compressed size of the current version of each entry.
+            size_t live_bytes = 0;
+            // Replaced and deleted entries that are still in the file.
+            size_t dead_bytes = 0;
+            // Padding and footer.
+            size_t slack_bytes = 0;
+            // zstd id of the dictionary the zzip was last written with, see dictionary_id.
+            unsigned dictionary_id = 0;
+
+            /** Share of the written entries that is dead. */
+            double dead_ratio() const;
+        };
+
+        stats get_stats() const;
+
+        /**
+         * Returns the zstd id of the given dictionary file, or 0 if it has none or can't be read.
+         */
+        static unsigned dictionary_id( std::filesystem::path const &dictionary );
+
         /**
          * Returns the compressed file size of the entry including metadata.
          */
@@ -150,6 +184,14 @@ class zzip
          */
         bool compact( double bloat_factor = 1.0 );
 
+        /**
+         * Rewrites the zzip without its dead entries if they are more than the given share
+         * of its content, see stats::dead_ratio. Meant to run after writes, so an archive
+         * that is written to over a long game does not keep growing.
+         * Returns true if compaction occurred.
+         */
+        bool compact_if_dead( double max_dead_ratio );
+
         /**
          * Create a zzip from a folder of existing files.
          * The files in the zzip are indexed based on their relative path inside the folder.
@@ -44,6 +44,34 @@ bool zzip_stack::add_file( std::filesystem::path const &zzip_relative_path,
     return ret;
 }
 
+bool zzip_stack::add_files( std::vector<std::pair<std::filesystem::path, std::string_view>> const
+                            &files )
+{
+    bool ret = hot()->add_files( files );
+    if( ret ) {
+        for( const std::pair<std::filesystem::path, std::string_view> &file : files ) {
+            path_temp_map_[file.first] = file_temp::hot;
+        }
+    }
+    return ret;
+}
+
+zzip::stats zzip_stack::get_stats() const
+{
+    zzip::stats total;
+    for( const zzip::stats &part : {
+             cold()->get_stats(), warm()->get_stats(), hot()->get_stats()
+         } ) {
+        total.entries += part.entries;
+        total.live_bytes += part.live_bytes;
+        total.dead_bytes += part.dead_bytes;
+        total.slack_bytes += part.slack_bytes;
+        // The hot zzip comes last and is the one written to.
+        total.dictionary_id = part.dictionary_id;
+    }
+    return total;
+}
+
 bool zzip_stack::has_file( std::filesystem::path const &zzip_relative_path ) const
 {
     return temp_of_file( zzip_relative_path ) != file_temp::unknown;
@@ -10,11 +10,11 @@
 #include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "std_hash_fs_path.h"
-
-class zzip;
+#include "zzip.h"
 
 /**
  * A zzip_stack uses multiple zzips to handle frequent updates to only a small portion of the stored data.
@@ -48,6 +48,18 @@ class zzip_stack
          */
         bool add_file( std::filesystem::path const &zzip_relative_path, std::string_view content );
 
+        /**
+         * Writes many files at once, see zzip::add_files.
+         * Returns true on success, false on any error.
+         */
+        bool add_files( std::vector<std::pair<std::filesystem::path, std::string_view>> const &files );
+
+        /**
+         * Space usage of the zzips of the stack added up. An entry that has a newer version
+         * higher up in the stack still counts as live in the lower zzip.
+         */
+        zzip::stats get_stats() const;
+
         /**
          * Returns true if the zzip contains the given path. Paths are checked through exact string
          * matches. Normalizing paths, and using generic u8 paths, is recommended.
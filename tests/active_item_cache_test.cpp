@@ -1,5 +1,8 @@
+#include <algorithm>
 #include <set>
+#include <vector>
 
+#include "active_item_cache.h"
 #include "calendar.h"
 #include "cata_catch.h"
 #include "coordinates.h"
@@ -11,6 +14,7 @@
 #include "type_id.h"
 
 static const itype_id itype_firecracker_act( "firecracker_act" );
+static const itype_id itype_meat_cooked( "meat_cooked" );
 
 TEST_CASE( "place_active_item_at_various_coordinates", "[item]" )
 {
@@ -44,3 +48,61 @@ TEST_CASE( "place_active_item_at_various_coordinates", "[item]" )
         }
     }
 }
+
+TEST_CASE( "active_item_cache_wakes_items_when_due", "[item]" )
+{
+    const time_point start = calendar::turn;
+    item firecracker( itype_firecracker_act, calendar::turn_zero, item::default_charges_tag() );
+    firecracker.activate();
+    REQUIRE( firecracker.processing_speed() == 1 );
+    std::vector<item> meat( 3, item( itype_meat_cooked ) );
+    REQUIRE( meat[0].processing_speed() == to_turns<int>( 10_minutes ) );
+
+    active_item_cache cache;
+    CHECK( cache.empty() );
+    cache.add( firecracker, point_sm_ms( 1, 1 ) );
+    for( item &it : meat ) {
+        cache.add( it, point_sm_ms( 2, 2 ) );
+    }
+    CHECK_FALSE( cache.empty() );
+    CHECK( cache.get().size() == 4 );
+
+    int firecracker_wakes = 0;
+    int meat_wakes = 0;
+    int busiest_turn = 0;
+    const int turns = to_turns<int>( 30_minutes );
+    for( int turn = 0; turn < turns; ++turn ) {
+        const std::vector<item_reference> due = cache.get_for_processing();
+        int meat_due = 0;
+        for( const item_reference &ref : due ) {
+            if( ref.item_ref.get() == &firecracker ) {
+                ++firecracker_wakes;
+            } else {
+                ++meat_due;
+            }
+        }
+        meat_wakes += meat_due;
+        busiest_turn = std::max( busiest_turn, meat_due );
+        calendar::turn += 1_turns;
+    }
+    CHECK( firecracker_wakes == turns );
+    // Every piece of meat once every 10 minutes, and not all of them on the same turn.
+    CHECK( meat_wakes == 9 );
+    CHECK( busiest_turn == 1 );
+
+    // Destroyed items are dropped when they are next due.
+    meat.clear();
+    for( int turn = 0; turn < to_turns<int>( 10_minutes ); ++turn ) {
+        for( const item_reference &ref : cache.get_for_processing() ) {
+            CHECK( ref.item_ref.get() == &firecracker );
+        }
+        calendar::turn += 1_turns;
+    }
+    CHECK( cache.get().size() == 1 );
+
+    // A cache out of the reality bubble for days still wakes its items once.
+    calendar::turn += 3_days;
+    CHECK( cache.get_for_processing().size() == 1 );
+    CHECK( cache.get_for_processing().empty() );
+    calendar::turn = start;
+}
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32) && !defined(_MSC_VER)
+#   include "mingw.thread.h"
+#endif
+
+#include "async_save.h"
+#include "cata_catch.h"
+#include "coordinates.h"
+#include "map.h"
+#include "map_helpers.h"
+#include "map_scale_constants.h"
+#include "mapbuffer.h"
+#include "path_info.h"
+#include "point.h"
+#include "string_formatter.h"
+#include "submap.h"
+#include "type_id.h"
+#include "zzip.h"
+
+static const ter_str_id ter_t_wall( "t_wall" );
+
+TEST_CASE( "async_save_runs_jobs_immediately_outside_a_scope", "[save]" )
+{
+    bool ran = false;
+    async_save::submit( "target", [&ran]() {
+        ran = true;
+    } );
+    CHECK( ran );
+    CHECK_FALSE( async_save::in_progress() );
+}
+
+TEST_CASE( "async_save_defers_jobs_until_the_scope_ends", "[save]" )
+{
+    std::vector<int> first_target;
+    int second_target = 0;
+    {
+        async_save::scope background;
+        CHECK( async_save::enabled() );
+        for( int i = 0; i < 20; ++i ) {
+            async_save::submit( "first", [&first_target, i]() {
+                first_target.push_back( i );
+            } );
+            async_save::submit( "second", [&second_target]() {
+                ++second_target;
+            } );
+        }
+        CHECK( first_target.empty() );
+        CHECK( second_target == 0 );
+    }
+    CHECK_FALSE( async_save::enabled() );
+    CHECK( async_save::wait() );
+    CHECK( second_target == 20 );
+    // Jobs for one target keep their order.
+    REQUIRE( first_target.size() == 20 );
+    CHECK( std::is_sorted( first_target.begin(), first_target.end() ) );
+}
+
+TEST_CASE( "async_save_runs_last_jobs_after_all_others", "[save]" )
+{
+    std::atomic<int> finished( 0 );
+    int finished_before_last = -1;
+    {
+        async_save::scope background;
+        // Queued first, but still has to wait for everything else.
+        async_save::submit_last( "player", [&]() {
+            finished_before_last = finished.load();
+        } );
+        for( int i = 0; i < 8; ++i ) {
+            async_save::submit( string_format( "segment %d", i ), [&finished]() {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+                finished.fetch_add( 1 );
+            } );
+        }
+    }
+    CHECK( async_save::in_progress( "player" ) );
+    CHECK( async_save::wait() );
+    CHECK( finished_before_last == 8 );
+    CHECK_FALSE( async_save::in_progress() );
+}
+
+TEST_CASE( "async_save_reports_failed_jobs", "[save]" )
+{
+    {
+        async_save::scope background;
+        async_save::submit( "target", []() {
+            throw std::runtime_error( "disk full" );
+        } );
+    }
+    CHECK_FALSE( async_save::wait() );
+    // Errors are reported once.
+    CHECK( async_save::wait() );
+}
+
+TEST_CASE( "async_save_waits_for_a_single_target", "[save]" )
+{
+    std::atomic<bool> release( false );
+    std::atomic<bool> quick_done( false );
+    {
+        async_save::scope background;
+        // Queued first, so even a single worker gets to it before the slow one.
+        async_save::submit( "a quick target", [&quick_done]() {
+            quick_done = true;
+        } );
+        async_save::submit( "a slow target", [&release]() {
+            while( !release ) {
+                std::this_thread::yield();
+            }
+        } );
+    }
+    async_save::wait_for( "a quick target" );
+    CHECK( quick_done );
+    CHECK_FALSE( async_save::in_progress( "a quick target" ) );
+    CHECK( async_save::in_progress( "a slow target" ) );
+    release = true;
+    CHECK( async_save::wait() );
+    CHECK_FALSE( async_save::in_progress() );
+}
+
+TEST_CASE( "async_save_compresses_archives_sharing_a_dictionary_in_parallel", "[save][zzip]" )
+{
+    const std::filesystem::path folder = std::filesystem::u8path( PATH_INFO::user_dir() +
+                                         "async_save_zzip_test" );
+    std::filesystem::remove_all( folder );
+    std::filesystem::create_directories( folder );
+    const std::filesystem::path dictionary = ( PATH_INFO::compression_folder_path() /
+            "maps.dict" ).get_unrelative_path();
+    std::string text;
+    for( int i = 0; i < 200; ++i ) {
+        text += string_format( "line %d of a segment\n", i );
+    }
+
+    // One target per archive, like the segments of a map save.
+    constexpr int archives = 8;
+    const auto archive = [&folder]( int i ) {
+        return folder / string_format( "%d.zzip", i );
+    };
+    {
+        async_save::scope background;
+        for( int i = 0; i < archives; ++i ) {
+            async_save::submit( archive( i ).generic_u8string(), [&, i]() {
+                const std::shared_ptr<zzip> z = zzip::load( archive( i ), dictionary );
+                if( !z || !z->add_file( "quad.txt", text ) ) {
+                    throw std::runtime_error( "writing " + archive( i ).generic_u8string() );
+                }
+            } );
+        }
+    }
+    REQUIRE( async_save::wait() );
+
+    for( int i = 0; i < archives; ++i ) {
+        const std::shared_ptr<zzip> z = zzip::load( archive( i ), dictionary );
+        REQUIRE( z );
+        const std::vector<std::byte> contents = z->get_file( "quad.txt" );
+        CHECK( std::string( reinterpret_cast<const char *>( contents.data() ),
+                            contents.size() ) == text );
+    }
+    std::filesystem::remove_all( folder );
+}
+
+TEST_CASE( "async_save_of_the_mapbuffer_can_be_loaded_again", "[save][mapbuffer]" )
+{
+    clear_map();
+    const tripoint_abs_omt away = project_to<coords::omt>( get_map().get_abs_sub() +
+                                  point( 3 * MAPSIZE, 0 ) );
+    const tripoint_abs_sm away_sm = project_to<coords::sm>( away );
+    {
+        tinymap m;
+        m.load( away, false );
+        m.ter_set( tripoint_omt_ms( 2, 3, 0 ), ter_t_wall );
+    }
+    {
+        async_save::scope background;
+        // Unloads everything outside the reality bubble, the files are written afterwards.
+        MAPBUFFER.save();
+    }
+    // Loading has to wait for the background writes of its archive.
+    submap *sm = MAPBUFFER.lookup_submap( away_sm );
+    REQUIRE( sm != nullptr );
+    CHECK( sm->get_ter( point_sm_ms( 2, 3 ) ) == ter_t_wall );
+    CHECK( async_save::wait() );
+}
+
+TEST_CASE( "mapbuffer_evicts_least_recently_used_quads", "[save][mapbuffer]" )
+{
+    clear_map();
+    const tripoint_abs_sm first_sm = get_map().get_abs_sub() + point( 0, 5 * MAPSIZE );
+    const tripoint_abs_sm second_sm = first_sm + point( 2, 0 );
+    {
+        tinymap m;
+        m.load( project_to<coords::omt>( first_sm ), false );
+        m.ter_set( tripoint_omt_ms( 2, 3, 0 ), ter_t_wall );
+    }
+    {
+        tinymap m;
+        m.load( project_to<coords::omt>( second_sm ), false );
+    }
+    // The first quad is the most recently used one now.
+    REQUIRE( MAPBUFFER.lookup_submap( first_sm ) != nullptr );
+    const auto resident = [&first_sm]() {
+        for( auto &elem : MAPBUFFER ) {
+            if( elem.first == first_sm ) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    const size_t submaps_before = MAPBUFFER.submap_count();
+    CHECK( MAPBUFFER.evict_to_budget( MAPBUFFER.memory_usage() - 1 ) == 1 );
+    CHECK( MAPBUFFER.submap_count() == submaps_before - 4 );
+    CHECK( MAPBUFFER.evicted_quad_count() == 1 );
+    CHECK( resident() );
+
+    // Everything outside the reality bubble goes, and comes back with its changes.
+    MAPBUFFER.evict_to_budget( 1 );
+    CHECK_FALSE( resident() );
+    submap *sm = MAPBUFFER.lookup_submap( first_sm );
+    REQUIRE( sm != nullptr );
+    CHECK( sm->get_ter( point_sm_ms( 2, 3 ) ) == ter_t_wall );
+    MAPBUFFER.evict_to_budget( 1 );
+
+    SECTION( "evicted quads are dropped when the game is not saved" ) {
+        MAPBUFFER.clear();
+        CHECK( MAPBUFFER.lookup_submap( first_sm ) == nullptr );
+    }
+    SECTION( "saving moves evicted quads into the world" ) {
+        MAPBUFFER.save();
+        CHECK( MAPBUFFER.evicted_quad_count() == 0 );
+        MAPBUFFER.clear();
+        sm = MAPBUFFER.lookup_submap( first_sm );
+        REQUIRE( sm != nullptr );
+        CHECK( sm->get_ter( point_sm_ms( 2, 3 ) ) == ter_t_wall );
+    }
+    clear_map();
+}
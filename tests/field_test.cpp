@@ -1,4 +1,6 @@
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "avatar.h"
@@ -13,11 +15,14 @@
 #include "map.h"
 #include "map_helpers.h"
 #include "map_iterator.h"
+#include "mapbuffer.h"
 #include "mapdata.h"
 #include "options_helpers.h"
 #include "player_helpers.h"
 #include "point.h"
 #include "string_formatter.h"
+#include "submap.h"
+#include "tile_layer.h"
 #include "type_id.h"
 #include "weather_type.h"
 
@@ -487,6 +492,44 @@ TEST_CASE( "field_API_test", "[field]" )
     fields_test_cleanup();
 }
 
+TEST_CASE( "field_processing_drops_tiles_without_fields", "[field]" )
+{
+    fields_test_setup();
+    const tripoint_bub_ms p{ 33, 33, 0 };
+    map &m = get_map();
+    REQUIRE( m.add_field( p, field_fd_test, 1 ) );
+    tripoint_abs_sm sm_pos;
+    point_sm_ms l;
+    std::tie( sm_pos, l ) = coords::project_remain<coords::sm>( m.get_abs( p ) );
+    const submap *const sm = MAPBUFFER.lookup_submap( sm_pos );
+    REQUIRE( sm != nullptr );
+    CHECK( sm->field_tiles().contains( l ) );
+
+    // Processing removes the dead field and with it the tile.
+    m.remove_field( p, field_fd_test );
+    m.process_fields();
+    CHECK_FALSE( m.field_at( p ).displayed_field_type() );
+    CHECK_FALSE( sm->field_tiles().contains( l ) );
+
+    // Adding a field again brings the tile back.
+    REQUIRE( m.add_field( p, field_fd_test, 1 ) );
+    CHECK( sm->field_tiles().contains( l ) );
+
+    fields_test_cleanup();
+}
+
+TEST_CASE( "uniform_submaps_share_no_field_tiles", "[field]" )
+{
+    submap uniform;
+    submap sm;
+    REQUIRE( sm.is_uniform() );
+    sm.field_tiles().insert( point_sm_ms( 1, 2 ) );
+    CHECK_FALSE( sm.is_uniform() );
+    CHECK( sm.field_tiles().contains( point_sm_ms( 1, 2 ) ) );
+    CHECK( std::as_const( uniform ).field_tiles().empty() );
+    CHECK( uniform.is_uniform() );
+}
+
 TEST_CASE( "player_double_effect_field_test", "[field][player]" )
 {
     fields_test_setup();
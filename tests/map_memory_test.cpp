@@ -1,10 +1,13 @@
 #include <bitset>
 #include <cstdio>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 #include "cata_catch.h"
 #include "coordinates.h"
+#include "json_loader.h"
 #include "lru_cache.h"
 #include "map.h"
 #include "map_memory.h"
@@ -122,6 +125,89 @@ TEST_CASE( "map_memory_forgets", "[map_memory]" )
     CHECK( mt.get_dec_rotation() == 0 );
 }
 
+TEST_CASE( "map_memory_region_file_round_trip", "[map_memory]" )
+{
+    mm_region region;
+    memorized_tile tile;
+    tile.symbol = 'x';
+    tile.set_ter_id( "t_foo" );
+    tile.set_ter_subtile( 43 );
+    tile.set_ter_rotation( 2 );
+    tile.set_dec_id( "vp_foo" );
+    tile.set_dec_subtile( -5 );
+    tile.set_dec_rotation( 3 );
+    mm_submap &sm = *region.get_submap( point( 2, 3 ) );
+    CHECK_FALSE( sm.is_dirty() );
+    sm.set_tile( point_sm_ms( 4, 5 ), tile );
+    sm.set_tile( point_sm_ms( 4, 6 ), tile );
+    CHECK( sm.is_dirty() );
+    CHECK( region.is_dirty() );
+
+    const std::shared_ptr<std::string> data = std::make_shared<std::string>(
+                mm_region_file::write( region ) );
+    REQUIRE( mm_region_file::is_binary( *data ) );
+    mm_region loaded;
+    loaded.file = std::make_shared<const mm_region_file>( data, *data );
+    CHECK( loaded.submaps[2][3] == nullptr );
+
+    const mm_submap &loaded_sm = *loaded.get_submap( point( 2, 3 ) );
+    CHECK_FALSE( loaded.is_dirty() );
+    CHECK( loaded_sm.get_tile( point_sm_ms( 4, 5 ) ) == tile );
+    CHECK( loaded_sm.get_tile( point_sm_ms( 4, 6 ) ) == tile );
+    CHECK( loaded_sm.get_tile( point_sm_ms( 4, 7 ) ) == mm_submap::default_tile );
+    CHECK( loaded_sm.get_tile( point_sm_ms( 4, 5 ) ).get_dec_id() == "vp_foo" );
+    CHECK( loaded_sm.get_tile( point_sm_ms( 4, 5 ) ).get_dec_subtile() == -5 );
+    // Only the submap that was asked for is decoded.
+    CHECK( loaded.submaps[0][0] == nullptr );
+    CHECK( loaded.get_submap( point( 0, 0 ) )->is_empty() );
+}
+
+TEST_CASE( "map_memory_region_file_rejects_corrupt_data", "[map_memory]" )
+{
+    mm_region region;
+    memorized_tile tile;
+    tile.symbol = 'x';
+    region.get_submap( point( 1, 1 ) )->set_tile( point_sm_ms( 0, 0 ), tile );
+    const std::string data = mm_region_file::write( region );
+
+    const std::shared_ptr<std::string> truncated = std::make_shared<std::string>( data.substr( 0,
+            data.size() - 1 ) );
+    const mm_region_file file( truncated, *truncated );
+    CHECK_THROWS( file.load( point( 1, 1 ) ) );
+    CHECK_THROWS( mm_region_file( truncated, std::string_view( *truncated ).substr( 0, 10 ) ) );
+}
+
+TEST_CASE( "map_memory_keeps_regions_of_a_wide_view", "[map_memory]" )
+{
+    // Wider than the area kept around the center of the view.
+    const tripoint_abs_ms corner{ SEEX * 2, SEEY * 2, 0 };
+    const tripoint_abs_ms far_corner{ SEEX * MAPSIZE * 6, SEEY * 4, 0 };
+    map_memory memory;
+    REQUIRE( memory.prepare_region( corner, far_corner ) );
+    memory.set_tile_symbol( corner, 'x' );
+    CHECK( memory.get_tile( corner ).symbol == 'x' );
+
+    // Caching again reads the submaps back from the loaded regions.
+    REQUIRE( memory.prepare_region( tripoint_abs_ms( 0, 0, 0 ), corner ) );
+    CHECK( memory.get_tile( corner ).symbol == 'x' );
+}
+
+TEST_CASE( "map_memory_converts_json_regions", "[map_memory]" )
+{
+    // One submap of the region memorized in full, the others not at all.
+    std::string json = R"({ "version": 1, "data": [ [ [ )" + std::to_string( SEEX * SEEY ) +
+                       R"(, 120, "t_foo", 0, 0 ] ])";
+    for( int i = 1; i < MM_REG_SIZE * MM_REG_SIZE; i++ ) {
+        json += ", null";
+    }
+    json += " ] }";
+    mm_region region;
+    region.deserialize( json_loader::from_string( json ) );
+    CHECK( region.get_submap( point::zero )->get_tile( point_sm_ms( 3, 4 ) ).symbol == 'x' );
+    // Saved in the current format on the next save.
+    CHECK( region.is_dirty() );
+}
+
 // TODO: map memory save / load
 
 #include <chrono>
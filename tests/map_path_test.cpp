@@ -14,6 +14,7 @@
 #include "map_iterator.h"
 #include "monster.h"
 #include "pathfinding.h"
+#include "perf.h"
 #include "point.h"
 #include "type_id.h"
 
@@ -647,3 +648,111 @@ TEST_CASE( "map_route_mon_around_danger", "[map][pathfinding]" )
     }
     clear_map();
 }
+
+static bool is_connected_route( const tripoint_bub_ms &from, const std::vector<tripoint_bub_ms> &path )
+{
+    tripoint_bub_ms cur = from;
+    for( const tripoint_bub_ms &p : path ) {
+        if( square_dist( cur, p ) != 1 ) {
+            return false;
+        }
+        cur = p;
+    }
+    return true;
+}
+
+TEST_CASE( "map_route_shared_by_creatures_with_the_same_target", "[map][pathfinding]" )
+{
+    map &m = setup_map_without_obstacles();
+    const Character &pc = place_player_at( tripoint_bub_ms{ 60, 60, 0 } );
+    pathfinding_settings settings = pc.get_pathfinding_settings();
+    // Settings that avoid traps never share routes
+    settings.avoid_traps = false;
+    /*
+     * A wall at x=70 with a single gap at y=65 between two creatures and their target.
+     */
+    std::vector<tripoint_bub_ms> wall;
+    for( int y = 55; y <= 75; ++y ) {
+        if( y != 65 ) {
+            wall.emplace_back( 70, y, 0 );
+        }
+    }
+    place_obstacle( m, wall );
+    const tripoint_bub_ms gap{ 70, 65, 0 };
+    const pathfinding_target target = pathfinding_target::point( tripoint_bub_ms{ 75, 65, 0 } );
+    const tripoint_bub_ms first{ 65, 62, 0 };
+    const tripoint_bub_ms second{ 65, 68, 0 };
+
+    // The first request searches on its own, the second one builds the shared field
+    const std::vector<tripoint_bub_ms> searched = m.route( first, target, settings );
+    const std::vector<tripoint_bub_ms> shared = m.route( second, target, settings );
+    REQUIRE( !searched.empty() );
+    REQUIRE( !shared.empty() );
+    CHECK( is_connected_route( second, shared ) );
+    CHECK( shared.back() == target.center );
+    CHECK( std::find( shared.begin(), shared.end(), gap ) != shared.end() );
+
+    // Reading the shared field gives a route as short as the one found by searching
+    const std::vector<tripoint_bub_ms> first_shared = m.route( first, target, settings );
+    CHECK( is_connected_route( first, first_shared ) );
+    CHECK( first_shared.size() == searched.size() );
+
+    // Closing the gap invalidates the shared field
+    place_obstacle( m, { gap } );
+    const std::vector<tripoint_bub_ms> rerouted = m.route( first, target, settings );
+    const std::vector<tripoint_bub_ms> shared_rerouted = m.route( second, target, settings );
+    REQUIRE( !rerouted.empty() );
+    REQUIRE( !shared_rerouted.empty() );
+    CHECK( is_connected_route( first, rerouted ) );
+    CHECK( is_connected_route( second, shared_rerouted ) );
+    CHECK( std::find( shared_rerouted.begin(), shared_rerouted.end(), gap ) == shared_rerouted.end() );
+    clear_map();
+}
+
+TEST_CASE( "map_route_long_distance_through_portals", "[map][pathfinding]" )
+{
+    map &m = setup_map_without_obstacles();
+    const Character &pc = place_player_at( tripoint_bub_ms{ 40, 66, 0 } );
+    const ter_id t_floor( "t_floor" );
+    const ter_id t_wall_metal( "t_wall_metal" );
+    /*
+     * A long wall at x=66 crossing several submaps, with a single gap.
+     * Only ter_set marks the tiles that changed, nothing rebuilds the caches wholesale.
+     */
+    const tripoint_bub_ms gap{ 66, 80, 0 };
+    for( int y = 30; y <= 100; ++y ) {
+        if( y != gap.y() ) {
+            m.ter_set( tripoint_bub_ms( gap.x(), y, 0 ), t_wall_metal );
+        }
+    }
+    const pathfinding_target target = pathfinding_target::point( tripoint_bub_ms{ 90, 66, 0 } );
+
+    turn_counters::reset();
+    const std::vector<tripoint_bub_ms> path = m.route( pc, target );
+    CHECK( turn_counters::get( turn_counter::portal_routes ) == 1 );
+    REQUIRE( !path.empty() );
+    CHECK( is_connected_route( pc.pos_bub(), path ) );
+    CHECK( path.back() == target.center );
+    CHECK( std::find( path.begin(), path.end(), gap ) != path.end() );
+    // 26 steps to the gap, 24 more to the target
+    CHECK( path.size() <= 55 );
+
+    // Moving the gap only updates the two submaps of the wall it leaves and enters
+    const tripoint_bub_ms new_gap{ 66, 50, 0 };
+    m.ter_set( gap, t_wall_metal );
+    m.ter_set( new_gap, t_floor );
+    turn_counters::reset();
+    const std::vector<tripoint_bub_ms> rerouted = m.route( pc, target );
+    CHECK( turn_counters::get( turn_counter::portal_routes ) == 1 );
+    CHECK( turn_counters::get( turn_counter::pathfinding_clusters_rebuilt ) == 2 );
+    REQUIRE( !rerouted.empty() );
+    CHECK( is_connected_route( pc.pos_bub(), rerouted ) );
+    CHECK( rerouted.back() == target.center );
+    CHECK( std::find( rerouted.begin(), rerouted.end(), new_gap ) != rerouted.end() );
+
+    // Nothing changed, nothing is rebuilt
+    turn_counters::reset();
+    CHECK_FALSE( m.route( pc, target ).empty() );
+    CHECK( turn_counters::get( turn_counter::pathfinding_clusters_rebuilt ) == 0 );
+    clear_map();
+}
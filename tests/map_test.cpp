@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstddef>
 #include <functional>
 #include <memory>
@@ -8,6 +9,7 @@
 #include <vector>
 
 #include "active_item_cache.h"
+#include "async_save.h"
 #include "avatar.h"
 #include "calendar.h"
 #include "cata_catch.h"
@@ -24,7 +26,9 @@
 #include "map_helpers.h"
 #include "map_scale_constants.h"
 #include "map_selector.h"
+#include "mapbuffer.h"
 #include "monster.h"
+#include "perf.h"
 #include "pocket_type.h"
 #include "point.h"
 #include "ret_val.h"
@@ -40,6 +44,8 @@ static const itype_id itype_bottle_plastic( "bottle_plastic" );
 static const itype_id itype_cookies( "cookies" );
 static const itype_id itype_disinfectant( "disinfectant" );
 
+static const ter_str_id ter_t_wall( "t_wall" );
+
 TEST_CASE( "map_coordinate_conversion_functions" )
 {
     map &here = get_map();
@@ -160,6 +166,47 @@ TEST_CASE( "tinymap_bounds_checking" )
     }
 }
 
+TEST_CASE( "mapbuffer_adopts_prefetched_quads", "[map][mapbuffer]" )
+{
+    clear_map();
+    const tripoint_abs_omt away = project_to<coords::omt>( get_map().get_abs_sub() +
+                                  point( 3 * MAPSIZE, 0 ) );
+    const tripoint_abs_sm away_sm = project_to<coords::sm>( away );
+    {
+        tinymap m;
+        m.load( away, false );
+        // Uniform quads are regenerated instead of saved, make sure this one gets written.
+        m.ter_set( tripoint_omt_ms( 1, 1, 0 ), ter_t_wall );
+    }
+    // Saving unloads everything outside the reality bubble.
+    MAPBUFFER.save();
+    // Nothing is prefetched while the save is still being written.
+    async_save::wait();
+    const auto is_loaded = [&]() {
+        return std::any_of( MAPBUFFER.begin(), MAPBUFFER.end(), [&]( const auto & entry ) {
+            return entry.first == away_sm;
+        } );
+    };
+    REQUIRE( !is_loaded() );
+
+    turn_counters::reset();
+    MAPBUFFER.prefetch( away );
+    MAPBUFFER.prefetch( away );
+    CHECK( turn_counters::get( turn_counter::submap_prefetch_requests ) == 1 );
+    // A quad the worker has not picked up yet would be read again on lookup.
+    MAPBUFFER.finish_prefetch();
+
+    submap *sm = MAPBUFFER.lookup_submap( away_sm );
+    REQUIRE( sm != nullptr );
+    CHECK( turn_counters::get( turn_counter::submap_prefetch_hits ) == 1 );
+    CHECK( turn_counters::get( turn_counter::submap_prefetch_misses ) == 0 );
+    CHECK( sm->get_ter( point_sm_ms( 1, 1 ) ) == ter_t_wall );
+
+    // Already loaded quads are not read again.
+    MAPBUFFER.prefetch( away );
+    CHECK( turn_counters::get( turn_counter::submap_prefetch_requests ) == 1 );
+}
+
 void map::check_submap_active_item_consistency()
 {
     process_items();
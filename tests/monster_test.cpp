@@ -30,9 +30,11 @@
 #include "mtype.h"
 #include "options.h"
 #include "options_helpers.h"
+#include "perf.h"
 #include "point.h"
 #include "test_statistics.h"
 #include "type_id.h"
+#include "weather_type.h"
 
 class item;
 
@@ -725,3 +727,124 @@ TEST_CASE( "monsters_spawn_baby_groups", "[monster][reproduction]" )
     CAPTURE( amount_of_iteration );
     CHECK( test_monster_spawns_baby_mongroup );
 }
+
+// Plans of a parent some way off while the player stands next to its young.
+static bool angered_by_threatened_young( const std::string &parent_type,
+        const std::string &young_type )
+{
+    map &here = get_map();
+    clear_map();
+    clear_creatures();
+    restore_on_out_of_scope restore_calendar_turn( calendar::turn );
+    calendar::turn = daylight_time( calendar::turn ) + 2_hours;
+    scoped_weather_override weather_clear( WEATHER_CLEAR );
+    Character &you = get_player_character();
+    const tripoint_bub_ms center{ 60, 60, 0 };
+    you.setpos( here, center );
+    spawn_test_monster( young_type, center + tripoint::east * 2 );
+    // Too far for the triggers of a player close by.
+    monster &parent = spawn_test_monster( parent_type, center + tripoint::east * 8 );
+    here.build_map_cache( 0 );
+    REQUIRE( parent.sees( here, you ) );
+    parent.aggro_character = false;
+    parent.plan();
+    return parent.aggro_character;
+}
+
+TEST_CASE( "monsters_guard_their_young_only_with_the_trigger", "[monster]" )
+{
+    // PLAYER_NEAR_BABY
+    CHECK( angered_by_threatened_young( "mon_cow", "mon_cow_calf" ) );
+    // Has young, but no such trigger.
+    CHECK_FALSE( angered_by_threatened_young( "mon_pig", "mon_pig_piglet" ) );
+}
+
+TEST_CASE( "creature_tracker_area_queries", "[monster][creature_tracker]" )
+{
+    clear_map();
+    clear_creatures();
+    map &here = get_map();
+    creature_tracker &creatures = get_creature_tracker();
+    const tripoint_bub_ms center = get_avatar().pos_bub();
+    // Spread over several submaps so the queries have to cross cell borders.
+    monster &near_mon = spawn_test_monster( "mon_zombie", center + tripoint( 2, 0, 0 ) );
+    monster &mid_mon = spawn_test_monster( "mon_zombie", center + tripoint( -SEEX, 0, 0 ) );
+    monster &far_mon = spawn_test_monster( "mon_zombie", center + tripoint( 3 * SEEX, 0, 0 ) );
+    const tripoint_abs_ms abs_center = here.get_abs( center );
+
+    const auto in_radius = [&]( int radius ) {
+        std::vector<const monster *> found;
+        creatures.for_each_in_radius( abs_center, radius, [&]( monster & critter ) {
+            found.push_back( &critter );
+        } );
+        return found;
+    };
+    const auto contains = []( const std::vector<const monster *> &found, const monster & critter ) {
+        return std::find( found.begin(), found.end(), &critter ) != found.end();
+    };
+
+    SECTION( "radius queries match rl_dist" ) {
+        const std::vector<const monster *> found = in_radius( SEEX );
+        CHECK( found.size() == 2 );
+        CHECK( contains( found, near_mon ) );
+        CHECK( contains( found, mid_mon ) );
+        CHECK( in_radius( 3 * SEEX ).size() == 3 );
+        CHECK( in_radius( 1 ).empty() );
+    }
+
+    SECTION( "rect queries are inclusive" ) {
+        std::vector<const monster *> found;
+        creatures.for_each_in_rect( far_mon.pos_abs(), far_mon.pos_abs() + tripoint( 5, 5, 0 ),
+        [&]( monster & critter ) {
+            found.push_back( &critter );
+        } );
+        REQUIRE( found.size() == 1 );
+        CHECK( found.front() == &far_mon );
+    }
+
+    SECTION( "nearest is sorted and capped" ) {
+        const std::vector<monster *> closest = creatures.nearest( abs_center, 2, 60 );
+        REQUIRE( closest.size() == 2 );
+        CHECK( closest[0] == &near_mon );
+        CHECK( closest[1] == &mid_mon );
+    }
+
+    SECTION( "moving a monster moves it between cells" ) {
+        far_mon.setpos( here, center + tripoint( 0, 1, 0 ) );
+        CHECK( contains( in_radius( 1 ), far_mon ) );
+        CHECK( creatures.nearest( abs_center, 1, 60 ).front() == &far_mon );
+    }
+
+    SECTION( "queries only look at the submaps they cover" ) {
+        turn_counters::reset();
+        CHECK( in_radius( SEEX ).size() == 2 );
+        // The far monster's submap is not part of the box.
+        CHECK( turn_counters::get( turn_counter::area_query_monsters ) == 2 );
+    }
+
+    SECTION( "small and tall boxes visit in the same order" ) {
+        const auto in_rect = [&]( const tripoint_abs_ms & min, const tripoint_abs_ms & max ) {
+            std::vector<const monster *> found;
+            creatures.for_each_in_rect( min, max, [&]( monster & critter ) {
+                found.push_back( &critter );
+            } );
+            return found;
+        };
+        const tripoint_abs_ms min = mid_mon.pos_abs();
+        const tripoint_abs_ms max = near_mon.pos_abs();
+        // Probes the few cells of the flat box, picks the populated ones for the tall box.
+        const std::vector<const monster *> flat = in_rect( min, max );
+        const std::vector<const monster *> tall = in_rect( min + tripoint( 0, 0, -OVERMAP_DEPTH ),
+                max + tripoint( 0, 0, OVERMAP_HEIGHT ) );
+        CHECK( flat.size() == 2 );
+        CHECK( flat == tall );
+    }
+
+    SECTION( "removed and dead monsters are not visited" ) {
+        mid_mon.die( &here, nullptr );
+        creatures.remove( near_mon );
+        const std::vector<const monster *> found = in_radius( 3 * SEEX );
+        REQUIRE( found.size() == 1 );
+        CHECK( found.front() == &far_mon );
+    }
+}
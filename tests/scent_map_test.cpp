@@ -0,0 +1,177 @@
+#include <array>
+#include <chrono>
+#include <memory>
+#include <sstream>
+
+#include "cata_catch.h"
+#include "coordinates.h"
+#include "game.h"
+#include "map.h"
+#include "map_helpers.h"
+#include "map_scale_constants.h"
+#include "mapdata.h"
+#include "scent_map.h"
+#include "type_id.h"
+
+static const furn_str_id furn_f_generator_broken( "f_generator_broken" );
+
+static const ter_str_id ter_t_wall( "t_wall" );
+
+namespace
+{
+using scent_grid = std::array<std::array<int, MAPSIZE_Y>, MAPSIZE_X>;
+using flag_grid = std::array<std::array<bool, MAPSIZE_X>, MAPSIZE_Y>;
+
+struct scent_flags {
+    flag_grid blocks_scent;
+    flag_grid reduces_scent;
+};
+} // namespace
+
+static constexpr int scent_radius = 40;
+// The squares around the scent radius that scent_map::update looks at.
+static constexpr point_rel_ms margin( scent_radius + 1, scent_radius + 1 );
+
+// scent_map::update as it was before it was vectorized.
+static void reference_scent_update( scent_grid &grscent, const scent_flags &flags,
+                                    const tripoint_bub_ms &center )
+{
+    std::unique_ptr<scent_grid> sum_3_scent_y = std::make_unique<scent_grid>();
+    std::unique_ptr<scent_grid> squares_used_y = std::make_unique<scent_grid>();
+    const flag_grid &blocks_scent = flags.blocks_scent;
+    const flag_grid &reduces_scent = flags.reduces_scent;
+
+    const int scentmap_minx = center.x() - scent_radius;
+    const int scentmap_maxx = center.x() + scent_radius;
+    const int scentmap_miny = center.y() - scent_radius;
+    const int scentmap_maxy = center.y() + scent_radius;
+    const int diffusivity = 100;
+
+    for( int x = scentmap_minx - 1; x <= scentmap_maxx + 1; ++x ) {
+        for( int y = scentmap_miny; y <= scentmap_maxy; ++y ) {
+            ( *sum_3_scent_y )[y][x] = 0;
+            ( *squares_used_y )[y][x] = 0;
+            for( int i = y - 1; i <= y + 1; ++i ) {
+                if( !blocks_scent[x][i] ) {
+                    if( reduces_scent[x][i] ) {
+                        ( *sum_3_scent_y )[y][x] += 2 * grscent[x][i];
+                        ( *squares_used_y )[y][x] += 2;
+                    } else {
+                        ( *sum_3_scent_y )[y][x] += 10 * grscent[x][i];
+                        ( *squares_used_y )[y][x] += 10;
+                    }
+                }
+            }
+        }
+    }
+
+    for( int x = scentmap_minx; x <= scentmap_maxx; ++x ) {
+        for( int y = scentmap_miny; y <= scentmap_maxy; ++y ) {
+            int &scent_here = grscent[x][y];
+            if( !blocks_scent[x][y] ) {
+                const int squares_used = ( *squares_used_y )[y][x - 1]
+                                         + ( *squares_used_y )[y][x]
+                                         + ( *squares_used_y )[y][x + 1];
+                const int this_diffusivity = reduces_scent[x][y] ? diffusivity / 5 : diffusivity;
+                int temp_scent = scent_here * ( 10 * 1000 - squares_used * this_diffusivity );
+                temp_scent -= scent_here * this_diffusivity * ( 90 - squares_used ) / 5;
+                scent_here =
+                    ( temp_scent
+                      + this_diffusivity * ( ( *sum_3_scent_y )[y][x - 1]
+                                             + ( *sum_3_scent_y )[y][x]
+                                             + ( *sum_3_scent_y )[y][x + 1] )
+                    ) / ( 1000 * 10 );
+            } else {
+                scent_here = 0;
+            }
+        }
+    }
+}
+
+// Walls, scent reducing furniture and scent trails spread over the area around the center.
+static void setup_scent_area( scent_map &scent, scent_grid &expected,
+                              const tripoint_bub_ms &center )
+{
+    clear_map();
+    map &here = get_map();
+    scent.reset();
+    for( int x = 0; x < MAPSIZE_X; ++x ) {
+        for( int y = 0; y < MAPSIZE_Y; ++y ) {
+            const tripoint_bub_ms p( x, y, center.z() );
+            if( ( x * 3 + y * 5 ) % 11 == 0 ) {
+                here.ter_set( p, ter_t_wall );
+            } else if( ( x + y * 2 ) % 13 == 0 ) {
+                here.furn_set( p, furn_f_generator_broken );
+            }
+            const int value = ( x * 7919 + y * 104729 ) % 1000;
+            scent.set_unsafe( p, value );
+            expected[x][y] = value;
+        }
+    }
+}
+
+TEST_CASE( "scent_update_matches_the_unvectorized_diffusion", "[scent]" )
+{
+    REQUIRE( ter_t_wall->has_flag( ter_furn_flag::TFLAG_NO_SCENT ) );
+    REQUIRE( furn_f_generator_broken->has_flag( ter_furn_flag::TFLAG_REDUCE_SCENT ) );
+
+    const tripoint_bub_ms center( MAPSIZE_X / 2, MAPSIZE_Y / 2, get_map().get_abs_sub().z() );
+    std::unique_ptr<scent_map> scent = std::make_unique<scent_map>( *g );
+    std::unique_ptr<scent_grid> expected = std::make_unique<scent_grid>();
+    setup_scent_area( *scent, *expected, center );
+    std::unique_ptr<scent_flags> flags = std::make_unique<scent_flags>();
+    get_map().scent_blockers( flags->blocks_scent, flags->reduces_scent, center.xy() - margin,
+                              center.xy() + margin );
+
+    for( int turn = 0; turn < 20; ++turn ) {
+        reference_scent_update( *expected, *flags, center );
+        scent->update( center, get_map() );
+        int mismatches = 0;
+        for( int x = 0; x < MAPSIZE_X; ++x ) {
+            for( int y = 0; y < MAPSIZE_Y; ++y ) {
+                const tripoint_bub_ms p( x, y, center.z() );
+                if( scent->get_unsafe( p ) != ( *expected )[x][y] ) {
+                    ++mismatches;
+                }
+            }
+        }
+        CAPTURE( turn );
+        CHECK( mismatches == 0 );
+    }
+}
+
+TEST_CASE( "scent_update_benchmark", "[.][scent][benchmark]" )
+{
+    const tripoint_bub_ms center( MAPSIZE_X / 2, MAPSIZE_Y / 2, get_map().get_abs_sub().z() );
+    std::unique_ptr<scent_map> scent = std::make_unique<scent_map>( *g );
+    std::unique_ptr<scent_grid> expected = std::make_unique<scent_grid>();
+    setup_scent_area( *scent, *expected, center );
+    std::unique_ptr<scent_flags> flags = std::make_unique<scent_flags>();
+
+    constexpr int turns = 1000;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( int turn = 0; turn < turns; ++turn ) {
+        // The reference looks the flags up every turn too.
+        get_map().scent_blockers( flags->blocks_scent, flags->reduces_scent, center.xy() - margin,
+                                  center.xy() + margin );
+        reference_scent_update( *expected, *flags, center );
+    }
+    const std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+    for( int turn = 0; turn < turns; ++turn ) {
+        scent->update( center, get_map() );
+    }
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    for( int x = 0; x < MAPSIZE_X; ++x ) {
+        for( int y = 0; y < MAPSIZE_Y; ++y ) {
+            const tripoint_bub_ms p( x, y, center.z() );
+            REQUIRE( scent->get_unsafe( p ) == ( *expected )[x][y] );
+        }
+    }
+    const std::chrono::duration<double, std::micro> before = middle - start;
+    const std::chrono::duration<double, std::micro> after = end - middle;
+    std::ostringstream summary;
+    summary << "scent update: " << before.count() / turns << " us per turn before, "
+            << after.count() / turns << " us per turn now";
+    WARN( summary.str() );
+}
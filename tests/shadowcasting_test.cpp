@@ -1099,6 +1099,307 @@ TEST_CASE( "shadowcasting_floating_wall", "[shadowcasting]" )
     run_spot_check( test_case, expected_results, true );
 }
 
+// Recasting only the segments around changed tiles has to give the same result as casting
+// everything again.
+TEST_CASE( "shadowcasting_3d_partial_recast", "[shadowcasting]" )
+{
+    struct test_grids {
+        std::array<cata::mdarray<float, point_bub_ms>, OVERMAP_LAYERS> transparency;
+        std::array<cata::mdarray<bool, point_bub_ms>, OVERMAP_LAYERS> floor;
+        std::array<cata::mdarray<float, point_bub_ms>, OVERMAP_LAYERS> patched;
+        std::array<cata::mdarray<float, point_bub_ms>, OVERMAP_LAYERS> expected;
+    };
+    std::unique_ptr<test_grids> grids = std::make_unique<test_grids>();
+    array_of_grids_of<const float> transparency_caches;
+    array_of_grids_of<const bool> floor_caches;
+    array_of_grids_of<float> patched;
+    array_of_grids_of<float> expected;
+    std::uniform_int_distribution<int> coin( 0, 1 );
+    for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+        randomly_fill_transparency( grids->transparency[z] );
+        for( int x = 0; x < MAPSIZE_X; ++x ) {
+            for( int y = 0; y < MAPSIZE_Y; ++y ) {
+                grids->floor[z][x][y] = coin( rng_get_engine() ) == 0;
+            }
+        }
+        transparency_caches[z] = &grids->transparency[z];
+        floor_caches[z] = &grids->floor[z];
+        patched[z] = &grids->patched[z];
+        expected[z] = &grids->expected[z];
+    }
+    const auto cast = [&]( const array_of_grids_of<float> &output, const tripoint_bub_ms & origin,
+    const zlight_segments & segments ) {
+        cast_zlight<float, sight_calc, sight_check, accumulate_transparency>(
+            output, transparency_caches, floor_caches, origin, 0, 1.0, vertical_direction::BOTH,
+            segments );
+    };
+
+    const tripoint_bub_ms origin( 65, 60, 0 );
+    SECTION( "each segment only reaches the tiles it contains" ) {
+        for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+            grids->transparency[z].fill( LIGHT_TRANSPARENCY_OPEN_AIR );
+            grids->floor[z].fill( false );
+        }
+        for( int segment = 0; segment < zlight_segment_count; ++segment ) {
+            CAPTURE( segment );
+            for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+                grids->patched[z].fill( LIGHT_TRANSPARENCY_SOLID );
+                grids->expected[z].fill( LIGHT_TRANSPARENCY_SOLID );
+            }
+            cast( patched, origin, zlight_segments().set( segment ) );
+            CHECK( reset_zlight_segments( expected, origin, 0, zlight_segments().set( segment ),
+                                          VISIBILITY_FULL ) > 0 );
+            int mismatches = 0;
+            for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+                for( int x = 0; x < MAPSIZE_X; ++x ) {
+                    for( int y = 0; y < MAPSIZE_Y; ++y ) {
+                        const tripoint_rel_ms delta =
+                            tripoint_bub_ms( x, y, z - OVERMAP_DEPTH ) - origin;
+                        const bool reached = grids->patched[z][x][y] > LIGHT_TRANSPARENCY_SOLID;
+                        const bool reset = grids->expected[z][x][y] > LIGHT_TRANSPARENCY_SOLID;
+                        if( reached != reset ||
+                            ( reached && !zlight_segments_containing( delta )[segment] ) ) {
+                            ++mismatches;
+                        }
+                    }
+                }
+            }
+            CHECK( mismatches == 0 );
+        }
+    }
+
+    SECTION( "recasting the segments around changed tiles" ) {
+        for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+            grids->patched[z].fill( LIGHT_TRANSPARENCY_SOLID );
+        }
+        cast( patched, origin, zlight_segments().set() );
+
+        std::uniform_int_distribution<int> offset( -8, 8 );
+        std::uniform_int_distribution<int> z_offset( -1, 1 );
+        zlight_segments changed;
+        for( int i = 0; i < 3; ++i ) {
+            const tripoint_bub_ms p = origin + tripoint( offset( rng_get_engine() ),
+                                      offset( rng_get_engine() ), z_offset( rng_get_engine() ) );
+            float &transparency = grids->transparency[p.z() + OVERMAP_DEPTH][p.x()][p.y()];
+            transparency = transparency == LIGHT_TRANSPARENCY_SOLID ? LIGHT_TRANSPARENCY_OPEN_AIR :
+                           LIGHT_TRANSPARENCY_SOLID;
+            changed |= zlight_segments_containing( p - origin );
+        }
+        reset_zlight_segments( patched, origin, 0, changed, LIGHT_TRANSPARENCY_SOLID );
+        cast( patched, origin, zlight_segments_overlapping( changed ) );
+
+        for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+            grids->expected[z].fill( LIGHT_TRANSPARENCY_SOLID );
+        }
+        cast( expected, origin, zlight_segments().set() );
+        int mismatches = 0;
+        for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+            for( int x = 0; x < MAPSIZE_X; ++x ) {
+                for( int y = 0; y < MAPSIZE_Y; ++y ) {
+                    if( grids->patched[z][x][y] != grids->expected[z][x][y] ) {
+                        ++mismatches;
+                    }
+                }
+            }
+        }
+        CHECK( mismatches == 0 );
+    }
+}
+
+static std::vector<shadowcasting_simd::instruction_set> available_instruction_sets()
+{
+    const shadowcasting_simd::instruction_set original = shadowcasting_simd::active();
+    std::vector<shadowcasting_simd::instruction_set> sets;
+    for( int i = 0; i < static_cast<int>( shadowcasting_simd::instruction_set::num_instruction_sets );
+         ++i ) {
+        const shadowcasting_simd::instruction_set set =
+            static_cast<shadowcasting_simd::instruction_set>( i );
+        if( shadowcasting_simd::set_active( set ) ) {
+            sets.push_back( set );
+        }
+    }
+    shadowcasting_simd::set_active( original );
+    return sets;
+}
+
+// Fills the cache with runs of repeated transparencies, like walls, floors and fields produce.
+static void fill_transparency_runs( cata::mdarray<float, point_bub_ms> &transparency_cache )
+{
+    static constexpr std::array<float, 4> values = { {
+            LIGHT_TRANSPARENCY_OPEN_AIR, LIGHT_TRANSPARENCY_SOLID, 0.2f, 0.05f
+        }
+    };
+    std::uniform_int_distribution<int> run_length( 1, 12 );
+    std::uniform_int_distribution<size_t> value( 0, values.size() - 1 );
+    for( int x = 0; x < MAPSIZE_X; ++x ) {
+        int remaining = 0;
+        float current = LIGHT_TRANSPARENCY_OPEN_AIR;
+        for( int y = 0; y < MAPSIZE_Y; ++y ) {
+            if( remaining-- == 0 ) {
+                remaining = run_length( rng_get_engine() );
+                current = values[value( rng_get_engine() )];
+            }
+            transparency_cache[x][y] = current;
+        }
+    }
+}
+
+TEST_CASE( "shadowcasting_simd_kernels_match_scalar", "[shadowcasting]" )
+{
+    std::array<float, 41> values;
+    std::uniform_int_distribution<int> pick( 0, 3 );
+    for( float &v : values ) {
+        v = pick( rng_get_engine() ) == 0 ? 0.5f : 1.0f;
+    }
+    const shadowcasting_simd::instruction_set original = shadowcasting_simd::active();
+    for( const shadowcasting_simd::instruction_set set : available_instruction_sets() ) {
+        CAPTURE( shadowcasting_simd::name( set ) );
+        for( int start = 0; start < static_cast<int>( values.size() ); ++start ) {
+            for( int count = 0; start + count <= static_cast<int>( values.size() ); ++count ) {
+                CAPTURE( start, count );
+                shadowcasting_simd::set_active( shadowcasting_simd::instruction_set::scalar );
+                const int run = shadowcasting_simd::equal_run( &values[start], count, 1.0f );
+                const int reverse_run = start + 1 >= count ?
+                                        shadowcasting_simd::equal_run_reverse( &values[start], count, 1.0f ) : 0;
+                std::array<float, 41> raised_scalar = values;
+                shadowcasting_simd::raise_to( &raised_scalar[start], count, 0.75f );
+
+                shadowcasting_simd::set_active( set );
+                CHECK( shadowcasting_simd::equal_run( &values[start], count, 1.0f ) == run );
+                if( start + 1 >= count ) {
+                    CHECK( shadowcasting_simd::equal_run_reverse( &values[start], count, 1.0f ) ==
+                           reverse_run );
+                }
+                std::array<float, 41> raised = values;
+                shadowcasting_simd::raise_to( &raised[start], count, 0.75f );
+                CHECK( raised == raised_scalar );
+            }
+        }
+    }
+    shadowcasting_simd::set_active( original );
+}
+
+// The vectorized row spans have to light exactly the same values as the scalar code.
+TEST_CASE( "shadowcasting_simd_matches_scalar", "[shadowcasting]" )
+{
+    struct test_grids {
+        std::array<cata::mdarray<float, point_bub_ms>, OVERMAP_LAYERS> transparency;
+        std::array<cata::mdarray<bool, point_bub_ms>, OVERMAP_LAYERS> floor;
+        std::array<cata::mdarray<float, point_bub_ms>, OVERMAP_LAYERS> seen;
+        std::array<cata::mdarray<float, point_bub_ms>, OVERMAP_LAYERS> expected_seen;
+        cata::mdarray<float, point_bub_ms> lit_float;
+        cata::mdarray<float, point_bub_ms> expected_float;
+        cata::mdarray<four_quadrants, point_bub_ms> lit_quad;
+        cata::mdarray<four_quadrants, point_bub_ms> expected_quad;
+    };
+    std::unique_ptr<test_grids> grids = std::make_unique<test_grids>();
+    array_of_grids_of<const float> transparency_caches;
+    array_of_grids_of<const bool> floor_caches;
+    array_of_grids_of<float> seen;
+    array_of_grids_of<float> expected_seen;
+    std::uniform_int_distribution<int> coin( 0, 3 );
+    for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+        fill_transparency_runs( grids->transparency[z] );
+        for( int x = 0; x < MAPSIZE_X; ++x ) {
+            for( int y = 0; y < MAPSIZE_Y; ++y ) {
+                grids->floor[z][x][y] = coin( rng_get_engine() ) == 0;
+            }
+        }
+        transparency_caches[z] = &grids->transparency[z];
+        floor_caches[z] = &grids->floor[z];
+        seen[z] = &grids->seen[z];
+        expected_seen[z] = &grids->expected_seen[z];
+    }
+    const cata::mdarray<float, point_bub_ms> &ground = grids->transparency[OVERMAP_DEPTH];
+
+    const auto cast_all = [&]( cata::mdarray<float, point_bub_ms> &lit_float,
+                               cata::mdarray<four_quadrants, point_bub_ms> &lit_quad,
+    const array_of_grids_of<float> &seen_caches, const tripoint_bub_ms & origin ) {
+        lit_float.fill( 0.0f );
+        lit_quad.fill( four_quadrants() );
+        for( cata::mdarray<float, point_bub_ms> *cache : seen_caches ) {
+            cache->fill( 0.0f );
+        }
+        castLightAll<float, float, sight_calc, sight_check, update_light,
+                     accumulate_transparency>( lit_float, ground, origin.xy() );
+        castLightAll<float, four_quadrants, sight_calc, sight_check, update_light_quadrants,
+                     accumulate_transparency>( lit_quad, ground, origin.xy() );
+        cast_zlight<float, sight_calc, sight_check, accumulate_transparency>(
+            seen_caches, transparency_caches, floor_caches, origin, 0, 1.0 );
+    };
+
+    const shadowcasting_simd::instruction_set original = shadowcasting_simd::active();
+    std::uniform_int_distribution<int> coordinate( 0, MAPSIZE_X - 1 );
+    for( int i = 0; i < 4; ++i ) {
+        const tripoint_bub_ms origin( coordinate( rng_get_engine() ), coordinate( rng_get_engine() ),
+                                      0 );
+        CAPTURE( origin );
+        shadowcasting_simd::set_active( shadowcasting_simd::instruction_set::scalar );
+        cast_all( grids->expected_float, grids->expected_quad, expected_seen, origin );
+        for( const shadowcasting_simd::instruction_set set : available_instruction_sets() ) {
+            CAPTURE( shadowcasting_simd::name( set ) );
+            shadowcasting_simd::set_active( set );
+            cast_all( grids->lit_float, grids->lit_quad, seen, origin );
+            int mismatches = 0;
+            for( int x = 0; x < MAPSIZE_X; ++x ) {
+                for( int y = 0; y < MAPSIZE_Y; ++y ) {
+                    if( grids->lit_float[x][y] != grids->expected_float[x][y] ||
+                        grids->lit_quad[x][y].values != grids->expected_quad[x][y].values ) {
+                        ++mismatches;
+                    }
+                    for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+                        if( grids->seen[z][x][y] != grids->expected_seen[z][x][y] ) {
+                            ++mismatches;
+                        }
+                    }
+                }
+            }
+            CHECK( mismatches == 0 );
+        }
+    }
+    shadowcasting_simd::set_active( original );
+}
+
+TEST_CASE( "shadowcasting_simd_benchmark", "[.][shadowcasting][benchmark]" )
+{
+    struct test_grids {
+        std::array<cata::mdarray<float, point_bub_ms>, OVERMAP_LAYERS> transparency;
+        std::array<cata::mdarray<bool, point_bub_ms>, OVERMAP_LAYERS> floor;
+        std::array<cata::mdarray<float, point_bub_ms>, OVERMAP_LAYERS> seen;
+        cata::mdarray<float, point_bub_ms> lit;
+    };
+    std::unique_ptr<test_grids> grids = std::make_unique<test_grids>();
+    array_of_grids_of<const float> transparency_caches;
+    array_of_grids_of<const bool> floor_caches;
+    array_of_grids_of<float> seen;
+    for( int z = 0; z < OVERMAP_LAYERS; z++ ) {
+        fill_transparency_runs( grids->transparency[z] );
+        grids->floor[z].fill( z <= OVERMAP_DEPTH );
+        transparency_caches[z] = &grids->transparency[z];
+        floor_caches[z] = &grids->floor[z];
+        seen[z] = &grids->seen[z];
+    }
+    const tripoint_bub_ms origin( 65, 65, 0 );
+
+    const shadowcasting_simd::instruction_set original = shadowcasting_simd::active();
+    for( const shadowcasting_simd::instruction_set set : available_instruction_sets() ) {
+        shadowcasting_simd::set_active( set );
+        const std::string set_name( shadowcasting_simd::name( set ) );
+        BENCHMARK( "castLightAll " + set_name ) {
+            castLightAll<float, float, sight_calc, sight_check, update_light,
+                         accumulate_transparency>( grids->lit, grids->transparency[OVERMAP_DEPTH],
+                                                   origin.xy() );
+            return grids->lit[0][0];
+        };
+        BENCHMARK( "cast_zlight " + set_name ) {
+            cast_zlight<float, sight_calc, sight_check, accumulate_transparency>(
+                seen, transparency_caches, floor_caches, origin, 0, 1.0 );
+            return grids->seen[OVERMAP_DEPTH][0][0];
+        };
+    }
+    shadowcasting_simd::set_active( original );
+}
+
 // Some random edge cases aren't matching.
 TEST_CASE( "shadowcasting_runoff", "[.]" )
 {
@@ -0,0 +1,96 @@
+#include <string>
+#include <vector>
+
+#include "cata_catch.h"
+#include "coordinates.h"
+#include "map.h"
+#include "map_helpers.h"
+#include "map_scale_constants.h"
+#include "monster.h"
+#include "options_helpers.h"
+#include "perf.h"
+#include "point.h"
+#include "sounds.h"
+#include "weather_type.h"
+
+static monster &spawn_listener( const tripoint_bub_ms &p )
+{
+    monster &critter = spawn_test_monster( "mon_zombie", p );
+    critter.anger = 100;
+    critter.morale = 100;
+    critter.wandf = 0;
+    return critter;
+}
+
+TEST_CASE( "sounds_reach_only_listeners_in_earshot", "[sounds]" )
+{
+    clear_map();
+    clear_creatures();
+    sounds::reset_sounds();
+    scoped_weather_override weather_clear( WEATHER_CLEAR );
+
+    const tripoint_bub_ms source( 5, 5, 0 );
+    monster &near_mon = spawn_listener( source + tripoint( 10, 0, 0 ) );
+    monster &far_mon = spawn_listener( tripoint_bub_ms( MAPSIZE_X - 5, 5, 0 ) );
+    // One level down gets a penalty, two levels down is muffled completely.
+    monster &cellar_mon = spawn_listener( source + tripoint( 10, 0, -1 ) );
+    monster &deep_mon = spawn_listener( source + tripoint( 10, 0, -2 ) );
+
+    sounds::sound( source, 40, sounds::sound_t::combat, "BANG!" );
+    sounds::process_sounds();
+
+    CHECK( near_mon.wandf > 0 );
+    CHECK( cellar_mon.wandf > 0 );
+    CHECK( cellar_mon.wandf < near_mon.wandf );
+    CHECK( far_mon.wandf == 0 );
+    CHECK( deep_mon.wandf == 0 );
+}
+
+TEST_CASE( "sounds_only_look_at_monsters_near_the_source", "[sounds]" )
+{
+    clear_map();
+    clear_creatures();
+    sounds::reset_sounds();
+    scoped_weather_override weather_clear( WEATHER_CLEAR );
+
+    const tripoint_bub_ms source( 5, 5, 0 );
+    monster &near_mon = spawn_listener( source + tripoint( 10, 0, 0 ) );
+    // A crowd at the other end of the bubble, well out of earshot.
+    for( int y = 5; y < 25; ++y ) {
+        spawn_listener( tripoint_bub_ms( MAPSIZE_X - 5, y, 0 ) );
+    }
+
+    turn_counters::reset();
+    sounds::sound( source, 40, sounds::sound_t::combat, "BANG!" );
+    sounds::process_sounds();
+
+    CHECK( near_mon.wandf > 0 );
+    // Only the submap of the near monster holds anything inside the earshot box.
+    CHECK( turn_counters::get( turn_counter::area_query_monsters ) == 1 );
+}
+
+TEST_CASE( "sounds_firefight_next_to_horde_benchmark", "[.][sounds][benchmark]" )
+{
+    clear_map();
+    clear_creatures();
+    sounds::reset_sounds();
+    scoped_weather_override weather_clear( WEATHER_CLEAR );
+
+    // A horde spread over the whole bubble and a gunfight in one corner of it.
+    for( int y = 2; y < MAPSIZE_Y - 2; y += 4 ) {
+        for( int x = 2; x < MAPSIZE_X - 2; x += 4 ) {
+            spawn_listener( tripoint_bub_ms( x, y, 0 ) );
+        }
+    }
+    std::vector<tripoint_bub_ms> shots;
+    for( int i = 0; i < 40; ++i ) {
+        shots.emplace_back( 10 + i % 7, 10 + i % 5, 0 );
+    }
+
+    BENCHMARK( "process_sounds" ) {
+        for( const tripoint_bub_ms &p : shots ) {
+            sounds::sound( p, 30, sounds::sound_t::combat, "Bang!" );
+        }
+        sounds::process_sounds();
+    };
+}
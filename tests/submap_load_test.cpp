@@ -5,6 +5,8 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
@@ -18,12 +20,14 @@
 #include "field.h"
 #include "flexbuffer_json.h"
 #include "item.h"
+#include "json.h"
 #include "json_loader.h"
 #include "make_static.h"
 #include "map_scale_constants.h"
 #include "point.h"
 #include "string_formatter.h"
 #include "submap.h"
+#include "submap_binary.h"
 #include "trap.h"
 #include "type_id.h"
 #include "vehicle.h"
@@ -1541,3 +1545,64 @@ TEST_CASE( "submap_fd_migration", "[submap][load]" )
     INFO( string_format( "%d fields found: %s", total_fields, fields_list ) );
     REQUIRE( ( found_field_new_id && total_fields == 1 ) );
 }
+
+static std::string store_to_string( const submap &sm )
+{
+    std::ostringstream os;
+    JsonOut jsout( os );
+    jsout.start_object();
+    sm.store( jsout );
+    jsout.end_object();
+    return os.str();
+}
+
+TEST_CASE( "submap_binary_round_trip", "[submap][load]" )
+{
+    const std::vector<const JsonValue *> sources = {
+        &submap_empty, &submap_terrain_rle, &submap_furniture, &submap_trap, &submap_rad,
+        &submap_item, &submap_field, &submap_cosmetic, &submap_spawns, &submap_construction,
+        &submap_computer, &submap_ter_furn_pre_migration
+    };
+    std::vector<std::unique_ptr<submap>> loaded;
+    submap_binary_writer writer;
+    for( size_t i = 0; i < sources.size(); ++i ) {
+        loaded.emplace_back( std::make_unique<submap>() );
+        load_from_jsin( *loaded.back(), *sources[i] );
+        writer.add( tripoint_abs_sm( static_cast<int>( i ), 0, 0 ), *loaded.back() );
+    }
+    // A uniform submap has no objects at all.
+    submap uniform;
+    uniform.set_all_ter( ter_t_dirt, true );
+    REQUIRE( uniform.is_uniform() );
+    writer.add( tripoint_abs_sm( -1, 0, 0 ), uniform );
+    const std::string file = writer.finish();
+
+    REQUIRE( submap_binary_reader::is_binary( file ) );
+    const submap_binary_reader reader( nullptr, file );
+    REQUIRE( reader.size() == sources.size() + 1 );
+    for( size_t i = 0; i < sources.size(); ++i ) {
+        CAPTURE( i );
+        REQUIRE( reader.position( i ) == tripoint_abs_sm( static_cast<int>( i ), 0, 0 ) );
+        const std::unique_ptr<submap> sm = reader.load( i );
+        CHECK( store_to_string( *sm ) == store_to_string( *loaded[i] ) );
+    }
+    CHECK( reader.find( tripoint_abs_sm( 2, 0, 0 ) ) == std::optional<size_t>( 2 ) );
+    CHECK_FALSE( reader.find( tripoint_abs_sm( 0, 0, 1 ) ) );
+    const std::unique_ptr<submap> from_uniform = reader.load( sources.size() );
+    REQUIRE( is_normal_submap( *from_uniform ) );
+}
+
+TEST_CASE( "submap_binary_rejects_truncated_data", "[submap][load]" )
+{
+    submap sm;
+    load_from_jsin( sm, submap_item );
+    submap_binary_writer writer;
+    writer.add( tripoint_abs_sm::zero, sm );
+    const std::string file = writer.finish();
+
+    CHECK_FALSE( submap_binary_reader::is_binary( "[{\"version\":36}]" ) );
+    CHECK_THROWS_AS( submap_binary_reader( nullptr, std::string_view( file ).substr( 0, 10 ) ),
+                     std::runtime_error );
+    const std::string truncated = file.substr( 0, file.size() - 8 );
+    CHECK_THROWS_AS( submap_binary_reader( nullptr, truncated ), std::runtime_error );
+}
@@ -1,5 +1,6 @@
 #include <string>
 
+#include "active_item_cache.h"
 #include "calendar.h"
 #include "cata_catch.h"
 #include "coordinates.h"
@@ -296,3 +297,67 @@ TEST_CASE( "Temperature_controlled_location", "[temperature]" )
                     temperatures::normal ) ) );
     }
 }
+
+TEST_CASE( "Food_at_the_surrounding_temperature_is_processed_at_each_temperature_check",
+           "[temperature]" )
+{
+    map &here = get_map();
+    item meat( itype_meat_cooked );
+    set_map_temperature( units::from_fahrenheit( 68 ) ); // 20C
+    meat.process( here, nullptr, tripoint_bub_ms::zero );
+    CHECK( meat.processing_delay() == 0 );
+
+    // Already at 20 C, only rot changes until the surroundings do.
+    calendar::turn += 11_minutes;
+    meat.process( here, nullptr, tripoint_bub_ms::zero );
+    CHECK( meat.processing_delay() == to_turns<int>( 10_minutes ) );
+
+    // The rot of an hour processed at once is the same as that of an hour processed in steps.
+    item stepped( meat );
+    for( int i = 0; i < 5; ++i ) {
+        calendar::turn += 12_minutes;
+        stepped.process( here, nullptr, tripoint_bub_ms::zero );
+    }
+    meat.process( here, nullptr, tripoint_bub_ms::zero );
+    CHECK( to_turns<double>( meat.get_rot() ) == Approx( to_turns<double>( stepped.get_rot() ) ) );
+
+    set_map_temperature( units::from_fahrenheit( 131 ) ); // 55 C
+    calendar::turn += 11_minutes;
+    meat.process( here, nullptr, tripoint_bub_ms::zero );
+    CHECK( meat.processing_delay() == 0 );
+}
+
+TEST_CASE( "Food_notices_its_surroundings_warming_up_while_it_sleeps", "[temperature]" )
+{
+    map &here = get_map();
+    item meat( itype_meat_cooked );
+    set_map_temperature( units::from_fahrenheit( 68 ) ); // 20C
+    meat.process( here, nullptr, tripoint_bub_ms::zero );
+    calendar::turn += 11_minutes;
+    meat.process( here, nullptr, tripoint_bub_ms::zero );
+    const int delay = meat.processing_delay();
+    REQUIRE( delay > 0 );
+
+    // A fire is lit next to it, say, which nothing tells the meat about.
+    set_map_temperature( units::from_fahrenheit( 131 ) ); // 55 C
+    calendar::turn += time_duration::from_turns( delay + 1 );
+    meat.process( here, nullptr, tripoint_bub_ms::zero );
+    CHECK( units::to_kelvin( meat.temperature ) > units::to_kelvin( units::from_celsius( 20.5 ) ) );
+    CHECK( meat.processing_delay() == 0 );
+}
+
+TEST_CASE( "Food_moved_elsewhere_waits_for_its_next_temperature_check", "[temperature]" )
+{
+    map &here = get_map();
+    item meat( itype_meat_cooked );
+    set_map_temperature( units::from_fahrenheit( 68 ) ); // 20C
+    meat.process( here, nullptr, tripoint_bub_ms::zero );
+    calendar::turn += 11_minutes;
+    meat.process( here, nullptr, tripoint_bub_ms::zero );
+    REQUIRE( meat.processing_delay() == to_turns<int>( 10_minutes ) );
+
+    // Put into a fridge, say, so it has to be processed again until it cools down.
+    active_item_cache cache;
+    REQUIRE( cache.add( meat, point_sm_ms::zero ) );
+    CHECK( meat.processing_delay() == 0 );
+}
@@ -0,0 +1,194 @@
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+#include "cata_catch.h"
+#include "coordinates.h"
+#include "item.h"
+#include "map.h"
+#include "map_helpers.h"
+#include "map_scale_constants.h"
+#include "mapbuffer.h"
+#include "point.h"
+#include "submap.h"
+#include "tile_layer.h"
+#include "type_id.h"
+
+static const furn_str_id furn_f_chair( "f_chair" );
+static const furn_str_id furn_f_plant_seed( "f_plant_seed" );
+
+static const itype_id itype_rock( "rock" );
+
+static const ter_str_id ter_t_dirt( "t_dirt" );
+static const ter_str_id ter_t_floor( "t_floor" );
+static const ter_str_id ter_t_tree_maple_tapped( "t_tree_maple_tapped" );
+
+static const trap_str_id tr_funnel( "tr_funnel" );
+
+TEST_CASE( "tile_layer_allocates_only_for_different_values", "[submap]" )
+{
+    tile_layer<int> layer( 5 );
+    CHECK( layer.is_uniform() );
+    CHECK( layer.get( point_sm_ms( 3, 4 ) ) == 5 );
+
+    // Writing the shared value keeps it single valued.
+    layer.set( point_sm_ms( 3, 4 ), 5 );
+    CHECK( layer.is_uniform() );
+    CHECK( layer.dense_bytes() == 0 );
+
+    layer.set( point_sm_ms( 3, 4 ), 7 );
+    CHECK_FALSE( layer.is_uniform() );
+    CHECK( layer.get( point_sm_ms( 3, 4 ) ) == 7 );
+    CHECK( layer.get( point_sm_ms( 4, 3 ) ) == 5 );
+
+    // Copies are deep.
+    tile_layer<int> copy = layer;
+    copy.set( point_sm_ms( 0, 0 ), 1 );
+    CHECK( layer.get( point_sm_ms( 0, 0 ) ) == 5 );
+
+    layer.swap_tiles( point_sm_ms( 3, 4 ), point_sm_ms( 4, 3 ) );
+    CHECK( layer.get( point_sm_ms( 3, 4 ) ) == 5 );
+    CHECK( layer.get( point_sm_ms( 4, 3 ) ) == 7 );
+
+    // Nothing to drop while the tiles differ.
+    CHECK( layer.compact() == 0 );
+    layer.set( point_sm_ms( 4, 3 ), 5 );
+    CHECK( layer.compact() > 0 );
+    CHECK( layer.is_uniform() );
+    CHECK( layer.get( point_sm_ms( 4, 3 ) ) == 5 );
+}
+
+TEST_CASE( "tile_set_visits_tiles_in_column_order", "[submap]" )
+{
+    tile_set tiles;
+    CHECK( tiles.empty() );
+    tiles.insert( point_sm_ms( 5, 0 ) );
+    tiles.insert( point_sm_ms( 0, SEEY - 1 ) );
+    tiles.insert( point_sm_ms( SEEX - 1, SEEY - 1 ) );
+    CHECK_FALSE( tiles.empty() );
+    CHECK( tiles.contains( point_sm_ms( 5, 0 ) ) );
+    CHECK_FALSE( tiles.contains( point_sm_ms( 0, 5 ) ) );
+
+    // Tiles inserted ahead of the current one while visiting are visited too.
+    std::vector<point_sm_ms> visited;
+    tiles.for_each( [&]( const point_sm_ms & p ) {
+        visited.push_back( p );
+        if( p == point_sm_ms( 0, SEEY - 1 ) ) {
+            tiles.insert( point_sm_ms( 3, 3 ) );
+            tiles.erase( point_sm_ms( 5, 0 ) );
+        }
+    } );
+    const std::vector<point_sm_ms> expected = {
+        point_sm_ms( 0, SEEY - 1 ), point_sm_ms( 3, 3 ), point_sm_ms( SEEX - 1, SEEY - 1 )
+    };
+    CHECK( visited == expected );
+
+    tiles.swap_tiles( point_sm_ms( 3, 3 ), point_sm_ms( 4, 4 ) );
+    CHECK_FALSE( tiles.contains( point_sm_ms( 3, 3 ) ) );
+    CHECK( tiles.contains( point_sm_ms( 4, 4 ) ) );
+    tiles.clear();
+    CHECK( tiles.empty() );
+}
+
+TEST_CASE( "submap_layers_compact_without_changing_tiles", "[submap]" )
+{
+    submap sm;
+    sm.set_all_ter( ter_t_dirt );
+    sm.set_ter( point_sm_ms( 1, 1 ), ter_t_floor );
+    sm.set_furn( point_sm_ms( 2, 2 ), furn_f_chair );
+    sm.set_radiation( point_sm_ms( 3, 3 ), 10 );
+    const size_t before = sm.tile_memory_usage();
+
+    // Furniture and radiation return to one value, terrain stays mixed.
+    sm.set_furn( point_sm_ms( 2, 2 ), furn_str_id::NULL_ID() );
+    sm.set_radiation( point_sm_ms( 3, 3 ), 0 );
+    CHECK( sm.compact_layers() > 0 );
+    CHECK( sm.tile_memory_usage() < before );
+
+    CHECK( sm.get_ter( point_sm_ms( 1, 1 ) ) == ter_t_floor );
+    CHECK( sm.get_ter( point_sm_ms( 0, 0 ) ) == ter_t_dirt );
+    CHECK( sm.get_furn( point_sm_ms( 2, 2 ) ) == furn_str_id::NULL_ID() );
+    CHECK( sm.get_radiation( point_sm_ms( 3, 3 ) ) == 0 );
+
+    // Writes after compaction expand the layer again.
+    sm.set_furn( point_sm_ms( 2, 2 ), furn_f_chair );
+    CHECK( sm.get_furn( point_sm_ms( 2, 2 ) ) == furn_f_chair );
+    CHECK( sm.get_furn( point_sm_ms( 2, 3 ) ) == furn_str_id::NULL_ID() );
+}
+
+TEST_CASE( "submap_memory_usage_counts_what_the_submap_holds", "[submap]" )
+{
+    submap sm;
+    sm.set_all_ter( ter_t_dirt );
+    const size_t tiles = sm.tile_memory_usage();
+    CHECK( sm.memory_usage() == tiles );
+
+    for( int i = 0; i < 10; ++i ) {
+        sm.get_items( point_sm_ms( 1, 1 ) ).insert( item( itype_rock ) );
+    }
+    CHECK( sm.tile_memory_usage() == tiles );
+    CHECK( sm.memory_usage() >= tiles + 10 * sizeof( item ) );
+}
+
+TEST_CASE( "submap_actualizes_only_tiles_with_something_to_catch_up", "[submap]" )
+{
+    submap sm;
+    sm.set_all_ter( ter_t_dirt, true );
+    CHECK( sm.tiles_to_actualize().empty() );
+
+    sm.set_all_ter( ter_t_dirt );
+    sm.set_furn( point_sm_ms( 1, 1 ), furn_f_chair );
+    sm.set_ter( point_sm_ms( 2, 2 ), ter_t_floor );
+    CHECK( sm.tiles_to_actualize().empty() );
+
+    sm.set_furn( point_sm_ms( 3, 3 ), furn_f_plant_seed );
+    sm.set_ter( point_sm_ms( 4, 4 ), ter_t_tree_maple_tapped );
+    sm.set_trap( point_sm_ms( 5, 5 ), tr_funnel.id() );
+    sm.set_radiation( point_sm_ms( 6, 6 ), 10 );
+    std::vector<point_sm_ms> visited;
+    sm.tiles_to_actualize().for_each( [&]( const point_sm_ms & p ) {
+        visited.push_back( p );
+    } );
+    const std::vector<point_sm_ms> expected = {
+        point_sm_ms( 3, 3 ), point_sm_ms( 4, 4 ), point_sm_ms( 5, 5 ), point_sm_ms( 6, 6 )
+    };
+    CHECK( visited == expected );
+}
+
+TEST_CASE( "mapbuffer_memory_of_explored_world", "[.][submap][benchmark]" )
+{
+    clear_map();
+    const tripoint_abs_omt origin = project_to<coords::omt>( get_map().get_abs_sub() );
+    // Generates a 16x16 overmap terrain area on the surface and below it.
+    for( int z = -1; z <= 0; ++z ) {
+        for( int y = 0; y < 16; ++y ) {
+            for( int x = 0; x < 16; ++x ) {
+                tinymap m;
+                m.load( tripoint_abs_omt( origin.x() + x, origin.y() + y, z ), false );
+            }
+        }
+    }
+
+    // What the same submaps took when every layer was a dense array.
+    constexpr size_t dense_layers = sizeof( tile_layer<ter_id>::array_type ) +
+                                    sizeof( tile_layer<furn_id>::array_type ) + sizeof( tile_layer<uint8_t>::array_type ) +
+                                    sizeof( tile_layer<trap_id>::array_type ) + sizeof( tile_layer<int>::array_type );
+    size_t submaps = 0;
+    size_t dense_total = 0;
+    size_t compact_total = 0;
+    for( auto &elem : MAPBUFFER ) {
+        ++submaps;
+        dense_total += sizeof( submap );
+        if( !elem.second->is_uniform() ) {
+            dense_total += sizeof( maptile_soa ) + dense_layers;
+        }
+        compact_total += elem.second->tile_memory_usage();
+    }
+    CHECK( compact_total <= dense_total );
+
+    std::ostringstream summary;
+    summary << submaps << " submaps, " << dense_total / 1024 << " KiB with dense layers, "
+            << compact_total / 1024 << " KiB with compacted layers";
+    WARN( summary.str() );
+}
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "avatar.h"
+#include "calendar.h"
+#include "cata_catch.h"
+#include "cata_utility.h"
+#include "coordinates.h"
+#include "do_turn.h"
+#include "game.h"
+#include "item.h"
+#include "json.h"
+#include "map.h"
+#include "map_helpers.h"
+#include "map_scale_constants.h"
+#include "options_helpers.h"
+#include "path_info.h"
+#include "perf.h"
+#include "player_activity.h"
+#include "player_helpers.h"
+#include "point.h"
+#include "rng.h"
+#include "type_id.h"
+#include "units.h"
+#include "vehicle.h"
+
+// Headless turn-throughput benchmark.
+//
+// Each scenario builds a deterministic world around the avatar and then drives
+// do_turn() for a fixed number of turns, recording the time spent in the
+// phases listed in turn_phase and the work counted by turn_counters.  The
+// results are written as JSON to turn_benchmark.json in the user directory, so
+// that runs can be compared between builds, along with a Chrome trace of the
+// profiler zones recorded during each scenario.
+//
+// Skipped by default by using the [.] tag; run with
+//   cata_test "[turn_benchmark]"
+// or build the turn_benchmark target.
+
+static const activity_id ACT_WAIT( "ACT_WAIT" );
+
+static const field_type_str_id field_fd_fire( "fd_fire" );
+
+static const itype_id itype_apple( "apple" );
+
+static const ter_str_id ter_t_door_c( "t_door_c" );
+static const ter_str_id ter_t_floor( "t_floor" );
+static const ter_str_id ter_t_pavement( "t_pavement" );
+static const ter_str_id ter_t_reinforced_glass( "t_reinforced_glass" );
+static const ter_str_id ter_t_wall( "t_wall" );
+
+static const vproto_id vehicle_prototype_beetle( "beetle" );
+
+static constexpr unsigned int turn_benchmark_seed = 20240601;
+
+static tripoint_bub_ms bubble_center()
+{
+    return tripoint_bub_ms( MAPSIZE_X / 2, MAPSIZE_Y / 2, 0 );
+}
+
+struct turn_benchmark_scenario {
+    std::string name;
+    int turns;
+    // Builds the world for the scenario, after the map has been cleared.
+    std::function<void()> setup;
+    // Runs before every turn, e.g. to keep a vehicle inside the reality bubble.
+    std::function<void()> before_turn;
+};
+
+struct turn_benchmark_result {
+    std::string name;
+    int turns = 0;
+    uint64_t total_ns = 0;
+    std::vector<turn_phase_stats::phase_totals> phases;
+    std::vector<uint64_t> counters;
+};
+
+// A block of buildings separated by streets, each with a door and some food in it.
+static void build_city_block()
+{
+    map &here = get_map();
+    build_test_map( ter_t_pavement.id() );
+    constexpr int building_size = 10;
+    constexpr int street_width = 4;
+    constexpr int stride = building_size + street_width;
+    const tripoint_bub_ms center = bubble_center();
+    for( int bx = street_width; bx + building_size < MAPSIZE_X; bx += stride ) {
+        for( int by = street_width; by + building_size < MAPSIZE_Y; by += stride ) {
+            const tripoint_bub_ms corner( bx, by, 0 );
+            const tripoint_bub_ms far_corner = corner + tripoint( building_size - 1, building_size - 1, 0 );
+            if( corner.x() <= center.x() && center.x() <= far_corner.x() &&
+                corner.y() <= center.y() && center.y() <= far_corner.y() ) {
+                // Leave the avatar's block open
+                continue;
+            }
+            for( const tripoint_bub_ms &p : here.points_in_rectangle( corner, far_corner ) ) {
+                const bool edge = p.x() == corner.x() || p.x() == far_corner.x() ||
+                                  p.y() == corner.y() || p.y() == far_corner.y();
+                here.ter_set( p, edge ? ter_t_wall : ter_t_floor );
+            }
+            here.ter_set( corner + tripoint( building_size / 2, 0, 0 ), ter_t_door_c );
+            const tripoint_bub_ms pantry = corner + tripoint::south_east;
+            for( int i = 0; i < 10; ++i ) {
+                here.add_item_or_charges( pantry, item( itype_apple ) );
+            }
+        }
+    }
+    here.invalidate_map_cache( 0 );
+    here.build_map_cache( 0, true );
+}
+
+static std::vector<turn_benchmark_scenario> turn_benchmark_scenarios()
+{
+    std::vector<turn_benchmark_scenario> scenarios;
+
+    scenarios.push_back( { "idle_city", 300, []() {
+            build_city_block();
+            // Some street fires to exercise fields and lighting at night
+            map &here = get_map();
+            for( int i = 0; i < 8; ++i ) {
+                here.add_field( bubble_center() + tripoint( 12 * ( i - 4 ), 20, 0 ), field_fd_fire, 3 );
+            }
+        }, nullptr
+    } );
+
+    scenarios.push_back( { "horde_siege", 200, []() {
+            map &here = get_map();
+            build_test_map( ter_t_pavement.id() );
+            const tripoint_bub_ms center = bubble_center();
+            // The avatar watches from inside a glass box the horde can't break
+            for( const tripoint_bub_ms &p : here.points_in_radius( center, 2 ) ) {
+                if( square_dist( p, center ) == 2 ) {
+                    here.ter_set( p, ter_t_reinforced_glass );
+                }
+            }
+            here.invalidate_map_cache( 0 );
+            here.build_map_cache( 0, true );
+            int spawned = 0;
+            for( int radius = 6; spawned < 150; radius += 2 ) {
+                for( const tripoint_bub_ms &p : here.points_in_radius( center, radius ) ) {
+                    if( square_dist( p, center ) == radius && ( p.x() + p.y() ) % 3 == 0 &&
+                        spawned < 150 ) {
+                        spawn_test_monster( "mon_zombie", p );
+                        ++spawned;
+                    }
+                }
+            }
+        }, nullptr
+    } );
+
+    scenarios.push_back( { "driving", 300, []() {
+            map &here = get_map();
+            build_test_map( ter_t_pavement.id() );
+            const tripoint_bub_ms start = bubble_center() + tripoint( -30, 30, 0 );
+            vehicle *veh = here.add_vehicle( vehicle_prototype_beetle, start, -90_degrees, 100, 0 );
+            REQUIRE( veh != nullptr );
+            veh->tags.insert( "IN_CONTROL_OVERRIDE" );
+            veh->engine_on = true;
+            veh->cruise_velocity = std::min( 50 * 100, veh->safe_ground_velocity( here, false ) );
+            veh->velocity = veh->cruise_velocity;
+        }, []() {
+            // Bring the vehicle back to where it started so it never leaves the bubble
+            map &here = get_map();
+            const tripoint_bub_ms start = bubble_center() + tripoint( -30, 30, 0 );
+            for( wrapped_vehicle &wv : here.get_vehicles() ) {
+                here.displace_vehicle( *wv.v, start - wv.v->pos_bub( here ) );
+            }
+        }
+    } );
+
+    scenarios.push_back( { "long_wait", 600, []() {
+            build_city_block();
+            map &here = get_map();
+            const tripoint_bub_ms center = bubble_center();
+            for( const tripoint_bub_ms &p : here.points_in_radius( center, 3 ) ) {
+                here.add_item_or_charges( p, item( itype_apple ) );
+            }
+            // Long enough that the activity never runs out of moves during the benchmark
+            get_avatar().assign_activity( player_activity( ACT_WAIT, 100 * to_turns<int>( 12_hours ), 0 ) );
+        }, nullptr
+    } );
+
+    return scenarios;
+}
+
+static turn_benchmark_result run_turn_benchmark( const turn_benchmark_scenario &scenario )
+{
+    clear_map();
+    clear_avatar();
+    avatar &u = get_avatar();
+    u.setpos( get_map(), bubble_center() );
+    set_time( calendar::turn_zero + 22_hours );
+    rng_set_engine_seed( turn_benchmark_seed );
+    scenario.setup();
+
+    turn_phase_stats::reset();
+    turn_phase_stats::set_enabled( true );
+    turn_counters::reset();
+    cata_profiler::clear();
+    cata_profiler::set_enabled( true );
+    turn_benchmark_result result;
+    result.name = scenario.name;
+    for( int turn = 0; turn < scenario.turns; ++turn ) {
+        if( scenario.before_turn ) {
+            scenario.before_turn();
+        }
+        // Without an activity, a positive move count would make do_turn() wait for input
+        if( !u.activity ) {
+            u.set_moves( 0 );
+        }
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        REQUIRE_FALSE( do_turn() );
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        result.total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>( end - start ).count();
+        ++result.turns;
+    }
+    turn_phase_stats::set_enabled( false );
+    cata_profiler::set_enabled( false );
+    write_to_file( PATH_INFO::user_dir() + "turn_benchmark_" + scenario.name + ".trace.json",
+    []( std::ostream & fout ) {
+        cata_profiler::write_chrome_trace( fout );
+    }, "turn benchmark trace" );
+
+    for( int i = 0; i < static_cast<int>( turn_phase::num_turn_phases ); ++i ) {
+        result.phases.push_back( turn_phase_stats::get( static_cast<turn_phase>( i ) ) );
+    }
+    for( int i = 0; i < static_cast<int>( turn_counter::num_turn_counters ); ++i ) {
+        result.counters.push_back( turn_counters::get( static_cast<turn_counter>( i ) ) );
+    }
+    u.cancel_activity();
+    return result;
+}
+
+static void write_turn_benchmark_results( const std::vector<turn_benchmark_result> &results,
+        const std::string &path )
+{
+    write_to_file( path, [&]( std::ostream & fout ) {
+        JsonOut jsout( fout, true );
+        jsout.start_object();
+        jsout.member( "seed", turn_benchmark_seed );
+        jsout.member( "scenarios" );
+        jsout.start_array();
+        for( const turn_benchmark_result &result : results ) {
+            jsout.start_object();
+            jsout.member( "name", result.name );
+            jsout.member( "turns", result.turns );
+            jsout.member( "total_ms", result.total_ns / 1.0e6 );
+            jsout.member( "turns_per_second", result.total_ns == 0 ? 0.0 :
+                          result.turns * 1.0e9 / result.total_ns );
+            jsout.member( "phases" );
+            jsout.start_object();
+            for( size_t i = 0; i < result.phases.size(); ++i ) {
+                const turn_phase_stats::phase_totals &phase = result.phases[i];
+                jsout.member( std::string( turn_phase_stats::name( static_cast<turn_phase>( i ) ) ) );
+                jsout.start_object();
+                jsout.member( "calls", phase.count );
+                jsout.member( "total_ms", phase.total_ns / 1.0e6 );
+                jsout.member( "mean_us", phase.count == 0 ? 0.0 : phase.total_ns / 1.0e3 / phase.count );
+                jsout.member( "max_us", phase.max_ns / 1.0e3 );
+                jsout.end_object();
+            }
+            jsout.end_object();
+            jsout.member( "counters" );
+            jsout.start_object();
+            for( size_t i = 0; i < result.counters.size(); ++i ) {
+                jsout.member( std::string( turn_counters::name( static_cast<turn_counter>( i ) ) ) );
+                jsout.start_object();
+                jsout.member( "total", result.counters[i] );
+                jsout.member( "per_turn", result.turns == 0 ? 0.0 :
+                              static_cast<double>( result.counters[i] ) / result.turns );
+                jsout.end_object();
+            }
+            jsout.end_object();
+            jsout.end_object();
+        }
+        jsout.end_array();
+        jsout.end_object();
+    }, "turn benchmark results" );
+}
+
+TEST_CASE( "turn_benchmark", "[.][benchmark][turn_benchmark]" )
+{
+    override_option autosave( "AUTOSAVE", "false" );
+    override_option random_npc( "RANDOM_NPC", "false" );
+    override_option wander_spawns( "WANDER_SPAWNS", "false" );
+
+    std::vector<turn_benchmark_result> results;
+    for( const turn_benchmark_scenario &scenario : turn_benchmark_scenarios() ) {
+        CAPTURE( scenario.name );
+        results.push_back( run_turn_benchmark( scenario ) );
+        const turn_benchmark_result &result = results.back();
+        CHECK( result.turns == scenario.turns );
+        std::ostringstream summary;
+        summary << result.name << ": " << result.turns * 1.0e9 / std::max<uint64_t>( result.total_ns, 1 )
+                << " turns/s";
+        for( size_t i = 0; i < result.phases.size(); ++i ) {
+            summary << ", " << turn_phase_stats::name( static_cast<turn_phase>( i ) ) << " "
+                    << result.phases[i].total_ns / 1.0e6 << "ms";
+        }
+        WARN( summary.str() );
+    }
+    clear_map();
+    clear_avatar();
+
+    write_turn_benchmark_results( results, PATH_INFO::user_dir() + "turn_benchmark.json" );
+}
@@ -46,6 +46,63 @@ static void reset_player()
     player_character.add_effect( effect_blind, 1_turns, true );
 }
 
+static void connect_debug_cord( map &here, const tripoint_bub_ms &source,
+                                const tripoint_bub_ms &target )
+{
+    const optional_vpart_position target_vp = here.veh_at( target );
+    const optional_vpart_position source_vp = here.veh_at( source );
+
+    item cord( itype_test_power_cord_25_loss );
+    cord.set_var( "source_x", source.x() );
+    cord.set_var( "source_y", source.y() );
+    cord.set_var( "source_z", source.z() );
+    cord.set_var( "state", "pay_out_cable" );
+    cord.active = true;
+
+    if( !target_vp ) {
+        debugmsg( "missing target at %s", target.to_string() );
+    }
+    vehicle *const target_veh = &target_vp->vehicle();
+    vehicle *const source_veh = &source_vp->vehicle();
+    if( source_veh == target_veh ) {
+        debugmsg( "source same as target" );
+    }
+
+    tripoint_abs_ms target_global = here.get_abs( target );
+    const vpart_id vpid( cord.typeId().str() );
+
+    point_rel_ms vcoords = source_vp->mount_pos();
+    vehicle_part source_part( vpid, item( cord ) );
+    source_part.target.first = target_global;
+    source_part.target.second = target_veh->pos_abs();
+    source_veh->install_part( here, vcoords, std::move( source_part ) );
+
+    vcoords = target_vp->mount_pos();
+    vehicle_part target_part( vpid, item( cord ) );
+    tripoint_bub_ms source_global( cord.get_var( "source_x", 0 ),
+                                   cord.get_var( "source_y", 0 ),
+                                   cord.get_var( "source_z", 0 ) );
+    target_part.target.first = here.get_abs( source_global );
+    target_part.target.second = source_veh->pos_abs();
+    target_veh->install_part( here, vcoords, std::move( target_part ) );
+}
+
+// Places a vehicle of a single frame with a battery. @return The battery.
+static vpart_reference place_battery( map &here, const tripoint_bub_ms &p )
+{
+    REQUIRE( !here.veh_at( p ).has_value() );
+    vehicle *veh = here.add_vehicle( vehicle_prototype_none, p, 0_degrees, 0, 0 );
+    REQUIRE( veh != nullptr );
+    const int frame_part_idx = veh->install_part( here, point_rel_ms::zero, vpart_frame );
+    REQUIRE( frame_part_idx != -1 );
+    const int bat_part_idx = veh->install_part( here, point_rel_ms::zero,
+                             vpart_small_storage_battery );
+    REQUIRE( bat_part_idx != -1 );
+    veh->refresh( );
+    here.add_vehicle_to_cache( veh );
+    return vpart_reference( *veh, bat_part_idx );
+}
+
 TEST_CASE( "power_loss_to_cables", "[vehicle][power]" )
 {
     clear_vehicles();
@@ -53,64 +110,15 @@ TEST_CASE( "power_loss_to_cables", "[vehicle][power]" )
     build_test_map( ter_id( "t_pavement" ) );
     map &here = get_map();
 
-    const auto connect_debug_cord = [&here]( const tripoint_bub_ms & source,
-    const tripoint_bub_ms & target ) {
-        const optional_vpart_position target_vp = here.veh_at( target );
-        const optional_vpart_position source_vp = here.veh_at( source );
-
-        item cord( itype_test_power_cord_25_loss );
-        cord.set_var( "source_x", source.x() );
-        cord.set_var( "source_y", source.y() );
-        cord.set_var( "source_z", source.z() );
-        cord.set_var( "state", "pay_out_cable" );
-        cord.active = true;
-
-        if( !target_vp ) {
-            debugmsg( "missing target at %s", target.to_string() );
-        }
-        vehicle *const target_veh = &target_vp->vehicle();
-        vehicle *const source_veh = &source_vp->vehicle();
-        if( source_veh == target_veh ) {
-            debugmsg( "source same as target" );
-        }
-
-        tripoint_abs_ms target_global = here.get_abs( target );
-        const vpart_id vpid( cord.typeId().str() );
-
-        point_rel_ms vcoords = source_vp->mount_pos();
-        vehicle_part source_part( vpid, item( cord ) );
-        source_part.target.first = target_global;
-        source_part.target.second = target_veh->pos_abs();
-        source_veh->install_part( here, vcoords, std::move( source_part ) );
-
-        vcoords = target_vp->mount_pos();
-        vehicle_part target_part( vpid, item( cord ) );
-        tripoint_bub_ms source_global( cord.get_var( "source_x", 0 ),
-                                       cord.get_var( "source_y", 0 ),
-                                       cord.get_var( "source_z", 0 ) );
-        target_part.target.first = here.get_abs( source_global );
-        target_part.target.second = source_veh->pos_abs();
-        target_veh->install_part( here, vcoords, std::move( target_part ) );
-    };
-
     const std::vector<tripoint_bub_ms> placements { { 4, 10, 0 }, { 6, 10, 0 }, { 8, 10, 0 } };
     std::vector<vpart_reference> batteries;
     for( const tripoint_bub_ms &p : placements ) {
-        REQUIRE( !here.veh_at( p ).has_value() );
-        vehicle *veh = here.add_vehicle( vehicle_prototype_none, p, 0_degrees, 0, 0 );
-        REQUIRE( veh != nullptr );
-        const int frame_part_idx = veh->install_part( here, point_rel_ms::zero, vpart_frame );
-        REQUIRE( frame_part_idx != -1 );
-        const int bat_part_idx = veh->install_part( here, point_rel_ms::zero, vpart_small_storage_battery );
-        REQUIRE( bat_part_idx != -1 );
-        veh->refresh( );
-        here.add_vehicle_to_cache( veh );
-        batteries.emplace_back( *veh, bat_part_idx );
+        batteries.push_back( place_battery( here, p ) );
     }
     // connect first to second and second to third, each cord is 25% lossy
     // third battery will on average take twice as many charges to charge as the first
     for( size_t i = 0; i < placements.size() - 1; i++ ) {
-        connect_debug_cord( placements[i], placements[i + 1] );
+        connect_debug_cord( here, placements[i], placements[i + 1] );
     }
     const optional_vpart_position ovp_first = here.veh_at( placements[0] );
     REQUIRE( ovp_first.has_value() );
@@ -140,6 +148,37 @@ TEST_CASE( "power_loss_to_cables", "[vehicle][power]" )
     }
 }
 
+TEST_CASE( "power_grid_follows_vehicles_leaving_it", "[vehicle][power]" )
+{
+    clear_vehicles();
+    reset_player();
+    build_test_map( ter_id( "t_pavement" ) );
+    map &here = get_map();
+
+    const std::vector<tripoint_bub_ms> placements { { 4, 10, 0 }, { 6, 10, 0 }, { 8, 10, 0 } };
+    std::vector<vpart_reference> batteries;
+    for( const tripoint_bub_ms &p : placements ) {
+        batteries.push_back( place_battery( here, p ) );
+    }
+    vehicle &first = batteries[0].vehicle();
+    const int capacity = first.fuel_capacity( here, fuel_type_battery );
+    REQUIRE( capacity > 0 );
+    CHECK( first.search_connected_vehicles( here ).size() == 1 );
+
+    connect_debug_cord( here, placements[0], placements[1] );
+    connect_debug_cord( here, placements[1], placements[2] );
+    CHECK( first.search_connected_vehicles( here ).size() == 3 );
+    CHECK( first.fuel_capacity( here, fuel_type_battery ) == 3 * capacity );
+    CHECK( first.charge_battery( here, 3 * capacity, false ) == 0 );
+    CHECK( first.battery_left( here, false ) == 3 * capacity );
+
+    // The cached grid must not keep the destroyed vehicle.
+    here.destroy_vehicle( &batteries[2].vehicle() );
+    CHECK( first.search_connected_vehicles( here ).size() == 2 );
+    CHECK( first.fuel_capacity( here, fuel_type_battery ) == 2 * capacity );
+    CHECK( first.discharge_battery( here, 3 * capacity, false ) == capacity );
+}
+
 TEST_CASE( "Solar_power", "[vehicle][power]" )
 {
     clear_vehicles();
@@ -1,7 +1,9 @@
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <functional>
 #include <optional>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -19,6 +21,7 @@
 #include "map.h"
 #include "map_helpers.h"
 #include "map_scale_constants.h"
+#include "perf.h"
 #include "player_activity.h"
 #include "player_helpers.h"
 #include "point.h"
@@ -119,6 +122,60 @@ TEST_CASE( "add_item_to_broken_vehicle_part", "[vehicle]" )
     REQUIRE( !veh_ptr->add_item( here, ovp_cargo->part(), itm2 ) );
 }
 
+// What vehicle::has_part and vehicle::get_parts_at answered before they used the flag index.
+static void check_flag_queries( map &here, vehicle &veh, const std::vector<std::string> &flags )
+{
+    for( const std::string &flag : flags ) {
+        CAPTURE( flag );
+        bool expected_any = false;
+        for( const vpart_reference &vpr : veh.get_all_parts() ) {
+            expected_any |= !vpr.part().removed && !vpr.part().is_broken() &&
+                            vpr.info().has_flag( flag );
+            size_t parts_here = 0;
+            size_t working_parts_here = 0;
+            for( const vpart_reference &other : veh.get_all_parts() ) {
+                if( !other.part().removed && other.info().has_flag( flag ) &&
+                    other.pos_abs() == vpr.pos_abs() ) {
+                    ++parts_here;
+                    working_parts_here += other.part().is_broken() ? 0 : 1;
+                }
+            }
+            const tripoint_bub_ms pos = vpr.pos_bub( here );
+            const std::vector<vehicle_part *> found = veh.get_parts_at( &here, pos, flag,
+                    part_status_flag::any );
+            CHECK( found.size() == parts_here );
+            CHECK( veh.has_part( &here, pos, flag ) == ( working_parts_here > 0 ) );
+        }
+        CHECK( veh.has_part( flag ) == expected_any );
+        CHECK( veh.has_parts( { flag } ).all() == expected_any );
+    }
+}
+
+TEST_CASE( "vehicle_flag_queries_follow_part_changes", "[vehicle]" )
+{
+    clear_map();
+    map &here = get_map();
+    vehicle *veh = here.add_vehicle( vehicle_prototype_car, tripoint_bub_ms( 60, 60, 0 ), 0_degrees,
+                                     0, 0 );
+    REQUIRE( veh != nullptr );
+    const std::vector<std::string> flags = {
+        "CARGO", "ENGINE", "SEAT", "WHEEL", "OBSTACLE", "AUTOPILOT", "NOT_A_PART_FLAG"
+    };
+    check_flag_queries( here, *veh, flags );
+
+    // Removing a part moves the indices of all parts after it.
+    const vehicle_part_with_feature_range<std::string> cargo_parts = veh->get_any_parts( "CARGO" );
+    REQUIRE( !empty( cargo_parts ) );
+    veh->remove_part( cargo_parts.begin()->part() );
+    veh->part_removal_cleanup( here );
+    check_flag_queries( here, *veh, flags );
+
+    REQUIRE_FALSE( veh->has_part( "AUTOPILOT" ) );
+    REQUIRE( veh->install_part( here, point_rel_ms::zero, vpart_programmable_autopilot ) >= 0 );
+    CHECK( veh->has_part( "AUTOPILOT" ) );
+    check_flag_queries( here, *veh, flags );
+}
+
 TEST_CASE( "starting_bicycle_damaged_pedal", "[vehicle]" )
 {
     clear_map();
@@ -805,3 +862,87 @@ TEST_CASE( "autopilot_tests", "[vehicle][autopilot]" )
     CHECK( test_autopilot_moving( vehicle_prototype_car, vpart_id::NULL_ID() ) == 0 );
     CHECK( test_autopilot_moving( vehicle_prototype_car, vpart_programmable_autopilot ) == 9 );
 }
+
+TEST_CASE( "vehicles_look_for_each_other_only_when_close", "[vehicle]" )
+{
+    clear_avatar();
+    clear_map();
+    map &here = get_map();
+    get_player_character().setpos( here, tripoint_bub_ms::zero );
+
+    vehicle *car = here.add_vehicle( vehicle_prototype_car, tripoint_bub_ms( 60, 60, 0 ),
+                                     -90_degrees, 100, 0, false );
+    REQUIRE( car != nullptr );
+    // Far enough for the parts of the car to land on those of a car parked where it goes
+    const tripoint_rel_ms ahead( 0, -20, 0 );
+    std::vector<veh_collision> colls;
+
+    SECTION( "a car far from the path is not looked for" ) {
+        REQUIRE( here.add_vehicle( vehicle_prototype_car, tripoint_bub_ms( 90, 40, 0 ), -90_degrees,
+                                   100, 0, false ) != nullptr );
+        turn_counters::reset();
+        CHECK_FALSE( car->collision( here, colls, ahead, true ) );
+        CHECK( turn_counters::get( turn_counter::vehicle_collision_lookups ) == 0 );
+    }
+
+    SECTION( "a car on the path is hit" ) {
+        vehicle *parked = here.add_vehicle( vehicle_prototype_car, tripoint_bub_ms( 60, 40, 0 ),
+                                            -90_degrees, 100, 0, false );
+        REQUIRE( parked != nullptr );
+        turn_counters::reset();
+        REQUIRE( car->collision( here, colls, ahead, true ) );
+        CHECK( turn_counters::get( turn_counter::vehicle_collision_lookups ) > 0 );
+        REQUIRE( colls.size() == 1 );
+        CHECK( colls.front().type == veh_coll_veh );
+        CHECK( colls.front().target == parked );
+    }
+}
+
+TEST_CASE( "vehicle_traffic_benchmark", "[.][vehicle][benchmark]" )
+{
+    clear_avatar();
+    clear_map();
+    map &here = get_map();
+    get_player_character().setpos( here, tripoint_bub_ms::zero );
+
+    // Five lanes of four cars each, all heading north at the same speed.
+    std::vector<vehicle *> vehicles;
+    for( int lane = 0; lane < 5; ++lane ) {
+        for( int row = 0; row < 4; ++row ) {
+            const tripoint_bub_ms p( 30 + lane * 10, 40 + row * 15, 0 );
+            vehicle *veh = here.add_vehicle( vehicle_prototype_car, p, -90_degrees, 100, 0, false );
+            REQUIRE( veh != nullptr );
+            veh->tags.insert( "IN_CONTROL_OVERRIDE" );
+            veh->engine_on = true;
+            veh->cruise_velocity = 30 * 100;
+            veh->velocity = veh->cruise_velocity;
+            vehicles.push_back( veh );
+        }
+    }
+    REQUIRE( vehicles.size() == 20 );
+    std::vector<tripoint_bub_ms> starting_points;
+    for( vehicle *veh : vehicles ) {
+        starting_points.push_back( veh->pos_bub( here ) );
+    }
+
+    constexpr int turns = 100;
+    int tiles_travelled = 0;
+    std::chrono::duration<double, std::micro> moving( 0 );
+    for( int turn = 0; turn < turns; ++turn ) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        here.vehmove();
+        moving += std::chrono::steady_clock::now() - start;
+        // Bring every car back to where it started to keep the traffic on the map
+        for( size_t i = 0; i < vehicles.size(); ++i ) {
+            const tripoint_bub_ms pos = vehicles[i]->pos_bub( here );
+            tiles_travelled += square_dist( starting_points[i], pos );
+            here.displace_vehicle( *vehicles[i], starting_points[i] - pos );
+        }
+    }
+    CHECK( tiles_travelled > 0 );
+
+    std::ostringstream summary;
+    summary << vehicles.size() << " moving vehicles: " << moving.count() / turns
+            << " us per turn, " << tiles_travelled << " tiles travelled";
+    WARN( summary.str() );
+}
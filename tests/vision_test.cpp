@@ -21,6 +21,7 @@
 #include "monster.h"
 #include "mtype.h"
 #include "options_helpers.h"
+#include "perf.h"
 #include "player_helpers.h"
 #include "point.h"
 #include "string_formatter.h"
@@ -43,6 +44,8 @@ static const mtype_id mon_zombie( "mon_zombie" );
 static const mtype_id mon_zombie_electric( "mon_zombie_electric" );
 
 static const ter_str_id ter_t_brick_wall( "t_brick_wall" );
+static const ter_str_id ter_t_door_c( "t_door_c" );
+static const ter_str_id ter_t_door_o( "t_door_o" );
 static const ter_str_id ter_t_flat_roof( "t_flat_roof" );
 static const ter_str_id ter_t_floor( "t_floor" );
 static const ter_str_id ter_t_utility_light( "t_utility_light" );
@@ -1174,6 +1177,89 @@ TEST_CASE( "vision_inside_meth_lab", "[shadowcasting][vision][moncam]" )
     clear_vehicles();
 }
 
+// Opening a door only recasts the part of the view behind it, which has to end up
+// the same as rebuilding the whole seen cache.
+TEST_CASE( "vision_seen_cache_patched_when_door_opens", "[shadowcasting][vision]" )
+{
+    clear_avatar();
+    clear_map();
+    map &here = get_map();
+    const tripoint_bub_ms center = get_avatar().pos_bub();
+    const tripoint_bub_ms door = center + tripoint( 2, 5, 0 );
+    for( int x = -10; x <= 10; ++x ) {
+        here.ter_set( center + tripoint( x, 5, 0 ), ter_t_brick_wall );
+    }
+    here.ter_set( door, ter_t_door_c );
+    here.build_map_cache( 0 );
+
+    const auto seen_tiles = [&here]() {
+        std::vector<float> seen;
+        for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; ++z ) {
+            const cata::mdarray<float, point_bub_ms> &cache = here.get_cache_ref( z ).seen_cache;
+            seen.insert( seen.end(), &cache[0][0], &cache[0][0] + MAPSIZE_X * MAPSIZE_Y );
+        }
+        return seen;
+    };
+    for( const ter_str_id &door_state : { ter_t_door_o, ter_t_door_c } ) {
+        CAPTURE( door_state.str() );
+        here.ter_set( door, door_state );
+        const uint64_t updates = turn_counters::get( turn_counter::seen_cache_updates );
+        const uint64_t rebuilds = turn_counters::get( turn_counter::seen_cache_rebuilds );
+        here.build_map_cache( 0 );
+        CHECK( turn_counters::get( turn_counter::seen_cache_updates ) == updates + 1 );
+        CHECK( turn_counters::get( turn_counter::seen_cache_rebuilds ) == rebuilds );
+        const tripoint_bub_ms behind_door = door + ( door - center );
+        CHECK( ( here.get_cache_ref( 0 ).seen_cache[behind_door.x()][behind_door.y()] > 0.0f ) ==
+               ( door_state == ter_t_door_o ) );
+
+        const std::vector<float> patched = seen_tiles();
+        here.set_seen_cache_dirty( 0 );
+        here.build_map_cache( 0 );
+        CHECK( turn_counters::get( turn_counter::seen_cache_rebuilds ) == rebuilds + 1 );
+        CHECK( seen_tiles() == patched );
+    }
+}
+
+TEST_CASE( "vision_static_light_reused_until_transparency_changes", "[shadowcasting][vision]" )
+{
+    clear_avatar();
+    clear_map();
+    calendar::turn = midnight;
+    map &here = get_map();
+    const tripoint_bub_ms center = get_avatar().pos_bub();
+    const tripoint_bub_ms light = center + tripoint( 0, 6, 0 );
+    const tripoint_bub_ms lit = center + tripoint( 0, 3, 0 );
+    here.ter_set( light, ter_t_utility_light );
+    here.build_map_cache( 0 );
+    const auto light_at_lit = [&here, &lit]() {
+        return here.get_cache_ref( 0 ).lm[lit.x()][lit.y()].max();
+    };
+    const float open_light = light_at_lit();
+    CHECK( open_light > LIGHT_AMBIENT_LIT );
+
+    const uint64_t cast = turn_counters::get( turn_counter::static_lights_cast );
+    const uint64_t reused = turn_counters::get( turn_counter::static_lights_reused );
+    here.build_map_cache( 0 );
+    CHECK( turn_counters::get( turn_counter::static_lights_cast ) == cast );
+    CHECK( turn_counters::get( turn_counter::static_lights_reused ) == reused + 1 );
+    CHECK( light_at_lit() == open_light );
+
+    const ter_id ground = here.ter( lit );
+    for( int x = -20; x <= 20; ++x ) {
+        here.ter_set( center + tripoint( x, 4, 0 ), ter_t_brick_wall );
+    }
+    here.build_map_cache( 0 );
+    CHECK( turn_counters::get( turn_counter::static_lights_cast ) == cast + 1 );
+    CHECK( light_at_lit() < open_light );
+
+    for( int x = -20; x <= 20; ++x ) {
+        here.ter_set( center + tripoint( x, 4, 0 ), ground );
+    }
+    here.build_map_cache( 0 );
+    CHECK( turn_counters::get( turn_counter::static_lights_cast ) == cast + 2 );
+    CHECK( light_at_lit() == open_light );
+}
+
 TEST_CASE( "pl_sees-oob-nocrash", "[vision]" )
 {
     const map &here = get_map();
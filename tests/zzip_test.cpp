@@ -0,0 +1,289 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32) && !defined(_MSC_VER)
+#   include "mingw.thread.h"
+#endif
+
+#include "cata_catch.h"
+#include "coordinates.h"
+#include "map.h"
+#include "map_helpers.h"
+#include "mapbuffer.h"
+#include "overmap.h"
+#include "overmapbuffer.h"
+#include "path_info.h"
+#include "string_formatter.h"
+#include "submap.h"
+#include "submap_binary.h"
+#include "zzip.h"
+
+static std::string contents_of( const std::shared_ptr<zzip> &z, const std::filesystem::path &file )
+{
+    const std::vector<std::byte> contents = z->get_file( file );
+    return std::string( reinterpret_cast<const char *>( contents.data() ), contents.size() );
+}
+
+TEST_CASE( "zzip_batched_writes_and_compaction", "[zzip]" )
+{
+    const std::filesystem::path path = std::filesystem::u8path( PATH_INFO::user_dir() +
+                                       "zzip_batch_test.zzip" );
+    std::filesystem::remove( path );
+
+    std::vector<std::pair<std::filesystem::path, std::string>> entries;
+    for( int i = 0; i < 20; ++i ) {
+        std::string text;
+        for( int j = 0; j < 100; ++j ) {
+            text += string_format( "entry %d line %d\n", i, j );
+        }
+        entries.emplace_back( std::filesystem::u8path( string_format( "%d.txt", i ) ), text );
+    }
+    std::vector<std::pair<std::filesystem::path, std::string_view>> files;
+    for( const std::pair<std::filesystem::path, std::string> &entry : entries ) {
+        files.emplace_back( entry.first, entry.second );
+    }
+
+    {
+        std::shared_ptr<zzip> z = zzip::load( path );
+        REQUIRE( z );
+        REQUIRE( z->add_files( files ) );
+        const zzip::stats stats = z->get_stats();
+        CHECK( stats.entries == entries.size() );
+        CHECK( stats.live_bytes > 0 );
+        CHECK( stats.dead_bytes == 0 );
+    }
+
+    std::shared_ptr<zzip> z = zzip::load( path );
+    REQUIRE( z );
+    for( const std::pair<std::filesystem::path, std::string> &entry : entries ) {
+        CHECK( contents_of( z, entry.first ) == entry.second );
+    }
+
+    // Writing every entry again leaves the old versions behind as dead bytes.
+    REQUIRE( z->add_files( files ) );
+    zzip::stats stats = z->get_stats();
+    CHECK( stats.entries == entries.size() );
+    CHECK( stats.dead_bytes == stats.live_bytes );
+    CHECK( stats.dead_ratio() == Approx( 0.5 ) );
+
+    CHECK_FALSE( z->compact_if_dead( 0.6 ) );
+    CHECK( z->compact_if_dead( 0.4 ) );
+    stats = z->get_stats();
+    CHECK( stats.dead_bytes == 0 );
+    for( const std::pair<std::filesystem::path, std::string> &entry : entries ) {
+        CHECK( contents_of( z, entry.first ) == entry.second );
+    }
+
+    z.reset();
+    std::filesystem::remove( path );
+}
+
+// The map prefetcher and the background save use zzips from worker threads while the
+// main thread uses others, all with the same dictionary.
+TEST_CASE( "zzip_archives_sharing_a_dictionary_work_from_several_threads", "[zzip]" )
+{
+    const std::filesystem::path folder = std::filesystem::u8path( PATH_INFO::user_dir() +
+                                         "zzip_thread_test" );
+    std::filesystem::remove_all( folder );
+    std::filesystem::create_directories( folder );
+    const std::filesystem::path dictionary = ( PATH_INFO::compression_folder_path() /
+            "maps.dict" ).get_unrelative_path();
+    std::string text;
+    for( int i = 0; i < 200; ++i ) {
+        text += string_format( "line %d of a quad\n", i );
+    }
+
+    constexpr int threads = 4;
+    const auto archive = [&]( int thread, const char *kind ) {
+        return folder / string_format( "%d.%s.zzip", thread, kind );
+    };
+    for( int thread = 0; thread < threads; ++thread ) {
+        std::shared_ptr<zzip> z = zzip::load( archive( thread, "read" ), dictionary );
+        REQUIRE( z );
+        REQUIRE( z->add_file( "quad.txt", text ) );
+    }
+
+    // Each thread writes one archive and reads another, counting what went wrong.
+    std::vector<int> failures( threads, 0 );
+    std::vector<std::thread> workers;
+    for( int thread = 0; thread < threads; ++thread ) {
+        workers.emplace_back( [&, thread]() {
+            for( int round = 0; round < 20; ++round ) {
+                const std::filesystem::path name = std::filesystem::u8path( string_format( "%d.txt",
+                                                   round ) );
+                std::shared_ptr<zzip> target = zzip::load( archive( thread, "write" ), dictionary );
+                std::shared_ptr<zzip> source = zzip::load( archive( thread, "read" ), dictionary );
+                if( !target || !source || !target->add_file( name, text ) ||
+                    contents_of( target, name ) != text ||
+                    contents_of( source, "quad.txt" ) != text ) {
+                    ++failures[thread];
+                }
+            }
+        } );
+    }
+    for( std::thread &worker : workers ) {
+        worker.join();
+    }
+    CHECK( failures == std::vector<int>( threads, 0 ) );
+
+    std::filesystem::remove_all( folder );
+}
+
+static std::string read_binary_file( const std::filesystem::path &path )
+{
+    std::ifstream file( path, std::ios::binary );
+    return std::string( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+}
+
+// A shipped dictionary under a different id, standing in for a retrained version.
+static void write_dictionary_version( const std::filesystem::path &path, uint32_t id )
+{
+    std::string dictionary = read_binary_file( ( PATH_INFO::compression_folder_path() /
+                             "maps.dict" ).get_unrelative_path() );
+    REQUIRE( dictionary.size() > 8 );
+    std::memcpy( &dictionary[4], &id, sizeof( id ) );
+    std::ofstream file( path, std::ios::binary );
+    file.write( dictionary.data(), dictionary.size() );
+}
+
+TEST_CASE( "zzip_reads_entries_written_with_a_retired_dictionary", "[zzip]" )
+{
+    const std::filesystem::path folder = std::filesystem::u8path( PATH_INFO::user_dir() +
+                                         "zzip_dictionary_test" );
+    std::filesystem::remove_all( folder );
+    std::filesystem::create_directories( folder );
+    const std::filesystem::path dictionary = folder / "maps.dict";
+    const std::filesystem::path path = folder / "test.zzip";
+    constexpr uint32_t old_id = 0x7e000001;
+    constexpr uint32_t new_id = 0x7e000002;
+    const std::string old_text = "written with the old dictionary";
+    const std::string new_text = "written with the new dictionary";
+
+    write_dictionary_version( dictionary, old_id );
+    CHECK( zzip::dictionary_id( dictionary ) == old_id );
+    {
+        std::shared_ptr<zzip> z = zzip::load( path, dictionary );
+        REQUIRE( z );
+        REQUIRE( z->add_file( "old.txt", old_text ) );
+        CHECK( z->get_stats().dictionary_id == old_id );
+    }
+
+    // What WORLD::update_compression_dictionaries does with a newer shipped version.
+    std::filesystem::rename( dictionary, folder / string_format( "maps.%u.dict", old_id ) );
+    write_dictionary_version( dictionary, new_id );
+    {
+        std::shared_ptr<zzip> z = zzip::load( path, dictionary );
+        REQUIRE( z );
+        CHECK( contents_of( z, "old.txt" ) == old_text );
+        REQUIRE( z->add_file( "new.txt", new_text ) );
+        CHECK( z->get_stats().dictionary_id == new_id );
+        CHECK( contents_of( z, "old.txt" ) == old_text );
+        CHECK( contents_of( z, "new.txt" ) == new_text );
+    }
+
+    std::filesystem::remove_all( folder );
+}
+
+namespace
+{
+struct compression_result {
+    size_t raw_bytes = 0;
+    size_t compressed_bytes = 0;
+    double decompress_seconds = 0.0;
+};
+} // namespace
+
+static compression_result compress_samples( const std::vector<std::string> &samples,
+        const std::filesystem::path &dictionary )
+{
+    const std::filesystem::path path = std::filesystem::u8path( PATH_INFO::user_dir() +
+                                       "zzip_dictionary_benchmark.zzip" );
+    std::filesystem::remove( path );
+    compression_result result;
+    std::vector<std::pair<std::filesystem::path, std::string_view>> files;
+    for( size_t i = 0; i < samples.size(); ++i ) {
+        files.emplace_back( std::filesystem::u8path( string_format( "%d", i ) ), samples[i] );
+        result.raw_bytes += samples[i].size();
+    }
+    {
+        std::shared_ptr<zzip> z = zzip::load( path, dictionary );
+        REQUIRE( z );
+        REQUIRE( z->add_files( files ) );
+        result.compressed_bytes = z->get_stats().live_bytes;
+
+        constexpr int repetitions = 20;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for( int i = 0; i < repetitions; ++i ) {
+            for( const std::pair<std::filesystem::path, std::string_view> &file : files ) {
+                CHECK( z->get_file( file.first ).size() == file.second.size() );
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result.decompress_seconds = elapsed.count() / repetitions;
+    }
+    std::filesystem::remove( path );
+    return result;
+}
+
+static void report_compression( const std::string &kind, const std::vector<std::string> &samples,
+                                const std::string &dictionary_name )
+{
+    const std::filesystem::path dictionary = ( PATH_INFO::compression_folder_path() /
+            dictionary_name ).get_unrelative_path();
+    const std::vector<std::pair<std::string, compression_result>> results = {
+        { "no dictionary", compress_samples( samples, {} ) },
+        { dictionary_name, compress_samples( samples, dictionary ) },
+    };
+    for( const std::pair<std::string, compression_result> &result : results ) {
+        const compression_result &r = result.second;
+        WARN( string_format( "%s with %s: %d samples, %d KiB to %d KiB, ratio %.2f, "
+                             "decompressed at %.1f MB/s", kind, result.first, samples.size(),
+                             r.raw_bytes / 1024, r.compressed_bytes / 1024,
+                             static_cast<double>( r.raw_bytes ) / r.compressed_bytes,
+                             r.raw_bytes / r.decompress_seconds / 1e6 ) );
+    }
+}
+
+// There is no save to ship in tests/data, so the reference data is generated: the quads
+// of a freshly generated area and the overmap it is on, in the format they are saved in.
+// tools/train_compression_dictionaries.py compares new dictionaries on real saves.
+TEST_CASE( "zzip_dictionary_compression_of_generated_saves", "[.][zzip][benchmark]" )
+{
+    clear_map();
+    const tripoint_abs_omt origin = project_to<coords::omt>( get_map().get_abs_sub() );
+    for( int z = -1; z <= 0; ++z ) {
+        for( int y = 0; y < 8; ++y ) {
+            for( int x = 0; x < 8; ++x ) {
+                tinymap m;
+                m.load( tripoint_abs_omt( origin.x() + x, origin.y() + y, z ), false );
+            }
+        }
+    }
+
+    std::map<tripoint_abs_omt, submap_binary_writer> quads;
+    for( auto &elem : MAPBUFFER ) {
+        quads[project_to<coords::omt>( elem.first )].add( elem.first, *elem.second );
+    }
+    std::vector<std::string> quad_samples;
+    for( const std::pair<const tripoint_abs_omt, submap_binary_writer> &quad : quads ) {
+        quad_samples.push_back( quad.second.finish() );
+    }
+    report_compression( "submap quads", quad_samples, "maps.dict" );
+
+    std::ostringstream overmap_data;
+    overmap_buffer.get( project_to<coords::om>( origin.xy() ) ).serialize( overmap_data );
+    report_compression( "overmap", { overmap_data.str() }, "overmaps.dict" );
+}
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Train the zstd dictionaries used to compress save games.
+
+Compressed worlds keep each kind of save data in zzips that share a dictionary:
+submap quads use maps.dict, overmaps (which include the NPCs on them) use
+overmaps.dict and map memory regions use mmr.dict. The dictionaries shipped in
+data/raw/compression are copied into a world when compression is enabled, and
+replace the world's copy on load when their id changes. Entries written with an
+older version keep being read with it, so every new dictionary needs a new id:
+bump --version whenever the shipped dictionaries are retrained.
+
+Train from worlds saved without compression. Compressed worlds can be
+decompressed from the world menu first.
+
+Example:
+    tools/train_compression_dictionaries.py --version 2 \\
+        --compare data/raw/compression save/SomeWorld save/OtherWorld
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+# zstd reserves ids below 32768 and from 2^31 on, so each kind gets its own
+# range starting at 2^24.
+KIND_ID_BASE = {
+    "maps": 1 << 24,
+    "mmr": 2 << 24,
+    "overmaps": 3 << 24,
+}
+
+DICTIONARY_SIZE = 100 * 1024
+# zstd --train needs far less than a whole save to converge.
+MAX_SAMPLES = 20000
+
+
+def samples_of_world(world):
+    samples = {kind: [] for kind in KIND_ID_BASE}
+    for root, dirs, files in os.walk(world):
+        for name in files:
+            path = os.path.join(root, name)
+            if name.endswith(".map"):
+                samples["maps"].append(path)
+            elif name.endswith(".mmr"):
+                samples["mmr"].append(path)
+            elif root == world and name.startswith("o."):
+                samples["overmaps"].append(path)
+    return samples
+
+
+def run_zstd(zstd, args):
+    result = subprocess.run([zstd] + args, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT, text=True)
+    if result.returncode != 0:
+        sys.exit("{} {} failed:\n{}".format(zstd, " ".join(args),
+                                             result.stdout))
+    return result.stdout
+
+
+def benchmark(zstd, dictionary, file_list):
+    # zstd -b prints one line per level with the ratio and the speeds.
+    output = run_zstd(zstd, ["-b7", "-q", "-D", dictionary,
+                             "--filelist", file_list])
+    return output.strip().splitlines()[-1]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Train zstd dictionaries for compressed save games.")
+    parser.add_argument("worlds", nargs="+",
+                        help="uncompressed world folders to sample")
+    parser.add_argument("--version", type=int, required=True,
+                        help="dictionary version, part of the dictionary id")
+    parser.add_argument("--output", default="data/raw/compression",
+                        help="folder to write maps.dict, mmr.dict and "
+                        "overmaps.dict to")
+    parser.add_argument("--compare", metavar="FOLDER",
+                        help="folder with the current dictionaries to "
+                        "benchmark the new ones against")
+    parser.add_argument("--zstd", default="zstd",
+                        help="zstd executable")
+    args = parser.parse_args()
+
+    if not 0 < args.version < 1 << 24:
+        sys.exit("--version must be between 1 and {}".format((1 << 24) - 1))
+
+    samples = {kind: [] for kind in KIND_ID_BASE}
+    for world in args.worlds:
+        for kind, files in samples_of_world(world).items():
+            samples[kind] += files
+
+    os.makedirs(args.output, exist_ok=True)
+    with tempfile.TemporaryDirectory() as tmp:
+        for kind, files in sorted(samples.items()):
+            if not files:
+                print("{}: no samples, skipped".format(kind))
+                continue
+            random.seed(kind)
+            if len(files) > MAX_SAMPLES:
+                files = random.sample(files, MAX_SAMPLES)
+            file_list = os.path.join(tmp, kind + ".txt")
+            with open(file_list, "w", encoding="utf-8") as f:
+                f.write("\n".join(files))
+
+            dictionary = os.path.join(args.output, kind + ".dict")
+            if args.compare:
+                current = os.path.join(args.compare, kind + ".dict")
+                before = benchmark(args.zstd, current, file_list) \
+                    if os.path.exists(current) else None
+            dictionary_id = KIND_ID_BASE[kind] + args.version
+            run_zstd(args.zstd, ["--train", "--filelist", file_list,
+                                 "--maxdict={}".format(DICTIONARY_SIZE),
+                                 "--dictID={}".format(dictionary_id),
+                                 "-f", "-o", dictionary])
+            print("{}: {} samples, id {}".format(kind, len(files),
+                                                 dictionary_id))
+            if args.compare:
+                if before:
+                    print("  current: {}".format(before))
+                print("  new:     {}".format(
+                    benchmark(args.zstd, dictionary, file_list)))
+
+
+if __name__ == "__main__":
+    main()